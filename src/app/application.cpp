@@ -76,6 +76,7 @@
 #include "base/scanfoldersmodel.h"
 #include "base/search/searchpluginmanager.h"
 #include "base/settingsstorage.h"
+#include "base/tracer.h"
 #include "base/utils/fs.h"
 #include "base/utils/misc.h"
 #include "base/utils/string.h"
@@ -135,6 +136,7 @@ Application::Application(const QString &id, int &argc, char **argv)
                         m_commandLineArgs.relativeFastresumePaths || m_commandLineArgs.portableMode);
 
     Logger::initInstance();
+    Tracer::initInstance();
     SettingsStorage::initInstance();
     Preferences::initInstance();
 
@@ -748,6 +750,7 @@ void Application::cleanup()
     Preferences::freeInstance();
     SettingsStorage::freeInstance();
     delete m_fileLogger;
+    Tracer::freeInstance();
     Logger::freeInstance();
     IconProvider::freeInstance();
     SearchPluginManager::freeInstance();
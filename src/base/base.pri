@@ -7,13 +7,27 @@ HEADERS += \
     $$PWD/bittorrent/infohash.h \
     $$PWD/bittorrent/magneturi.h \
     $$PWD/bittorrent/peerinfo.h \
+    $$PWD/bittorrent/private/alertdispatcher.h \
+    $$PWD/bittorrent/private/announcescheduler.h \
+    $$PWD/bittorrent/private/bandwidthallocator.h \
     $$PWD/bittorrent/private/bandwidthscheduler.h \
+    $$PWD/bittorrent/private/crossseedindex.h \
+    $$PWD/bittorrent/private/diskcachetuner.h \
+    $$PWD/bittorrent/private/fastrecheckworker.h \
     $$PWD/bittorrent/private/filterparserthread.h \
+    $$PWD/bittorrent/private/metadatacache.h \
+    $$PWD/bittorrent/private/peerbehaviourtracker.h \
     $$PWD/bittorrent/private/resumedatasavingmanager.h \
     $$PWD/bittorrent/private/speedmonitor.h \
     $$PWD/bittorrent/private/statistics.h \
+    $$PWD/bittorrent/private/storagejobscheduler.h \
+    $$PWD/bittorrent/private/storageworker.h \
+    $$PWD/bittorrent/private/torrentdecoder.h \
+    $$PWD/bittorrent/private/trackerhealthregistry.h \
+    $$PWD/bittorrent/private/uploadratecontroller.h \
     $$PWD/bittorrent/session.h \
     $$PWD/bittorrent/sessionstatus.h \
+    $$PWD/bittorrent/timeseriesstore.h \
     $$PWD/bittorrent/torrentcreatorthread.h \
     $$PWD/bittorrent/torrenthandle.h \
     $$PWD/bittorrent/torrentinfo.h \
@@ -23,6 +37,8 @@ HEADERS += \
     $$PWD/filesystemwatcher.h \
     $$PWD/global.h \
     $$PWD/http/connection.h \
+    $$PWD/http/contentsource.h \
+    $$PWD/http/eventstream.h \
     $$PWD/http/httperror.h \
     $$PWD/http/irequesthandler.h \
     $$PWD/http/requestparser.h \
@@ -33,6 +49,7 @@ HEADERS += \
     $$PWD/iconprovider.h \
     $$PWD/indexrange.h \
     $$PWD/logger.h \
+    $$PWD/memoryusage.h \
     $$PWD/net/dnsupdater.h \
     $$PWD/net/downloadhandler.h \
     $$PWD/net/downloadmanager.h \
@@ -59,8 +76,10 @@ HEADERS += \
     $$PWD/search/searchpluginmanager.h \
     $$PWD/settingsstorage.h \
     $$PWD/settingvalue.h \
+    $$PWD/stringpool.h \
     $$PWD/torrentfileguard.h \
     $$PWD/torrentfilter.h \
+    $$PWD/tracer.h \
     $$PWD/tristatebool.h \
     $$PWD/types.h \
     $$PWD/unicodestrings.h \
@@ -80,12 +99,26 @@ SOURCES += \
     $$PWD/bittorrent/infohash.cpp \
     $$PWD/bittorrent/magneturi.cpp \
     $$PWD/bittorrent/peerinfo.cpp \
+    $$PWD/bittorrent/private/alertdispatcher.cpp \
+    $$PWD/bittorrent/private/announcescheduler.cpp \
+    $$PWD/bittorrent/private/bandwidthallocator.cpp \
     $$PWD/bittorrent/private/bandwidthscheduler.cpp \
+    $$PWD/bittorrent/private/crossseedindex.cpp \
+    $$PWD/bittorrent/private/diskcachetuner.cpp \
+    $$PWD/bittorrent/private/fastrecheckworker.cpp \
     $$PWD/bittorrent/private/filterparserthread.cpp \
+    $$PWD/bittorrent/private/metadatacache.cpp \
+    $$PWD/bittorrent/private/peerbehaviourtracker.cpp \
     $$PWD/bittorrent/private/resumedatasavingmanager.cpp \
     $$PWD/bittorrent/private/speedmonitor.cpp \
     $$PWD/bittorrent/private/statistics.cpp \
+    $$PWD/bittorrent/private/storagejobscheduler.cpp \
+    $$PWD/bittorrent/private/storageworker.cpp \
+    $$PWD/bittorrent/private/torrentdecoder.cpp \
+    $$PWD/bittorrent/private/trackerhealthregistry.cpp \
+    $$PWD/bittorrent/private/uploadratecontroller.cpp \
     $$PWD/bittorrent/session.cpp \
+    $$PWD/bittorrent/timeseriesstore.cpp \
     $$PWD/bittorrent/torrentcreatorthread.cpp \
     $$PWD/bittorrent/torrenthandle.cpp \
     $$PWD/bittorrent/torrentinfo.cpp \
@@ -94,6 +127,7 @@ SOURCES += \
     $$PWD/exceptions.cpp \
     $$PWD/filesystemwatcher.cpp \
     $$PWD/http/connection.cpp \
+    $$PWD/http/eventstream.cpp \
     $$PWD/http/httperror.cpp \
     $$PWD/http/requestparser.cpp \
     $$PWD/http/responsebuilder.cpp \
@@ -101,6 +135,7 @@ SOURCES += \
     $$PWD/http/server.cpp \
     $$PWD/iconprovider.cpp \
     $$PWD/logger.cpp \
+    $$PWD/memoryusage.cpp \
     $$PWD/net/dnsupdater.cpp \
     $$PWD/net/downloadhandler.cpp \
     $$PWD/net/downloadmanager.cpp \
@@ -126,8 +161,10 @@ SOURCES += \
     $$PWD/search/searchhandler.cpp \
     $$PWD/search/searchpluginmanager.cpp \
     $$PWD/settingsstorage.cpp \
+    $$PWD/stringpool.cpp \
     $$PWD/torrentfileguard.cpp \
     $$PWD/torrentfilter.cpp \
+    $$PWD/tracer.cpp \
     $$PWD/tristatebool.cpp \
     $$PWD/utils/bytearray.cpp \
     $$PWD/utils/foreignapps.cpp \
@@ -28,7 +28,6 @@
 
 #include "peerinfo.h"
 
-#include "base/bittorrent/torrenthandle.h"
 #include "base/net/geoipmanager.h"
 #include "base/unicodestrings.h"
 #include "base/utils/string.h"
@@ -51,10 +50,10 @@ PeerAddress::PeerAddress(QHostAddress ip, ushort port)
 
 // PeerInfo
 
-PeerInfo::PeerInfo(const TorrentHandle *torrent, const libt::peer_info &nativeInfo)
+PeerInfo::PeerInfo(const QBitArray &allPieces, const libt::peer_info &nativeInfo)
     : m_nativeInfo(nativeInfo)
 {
-    calcRelevance(torrent);
+    calcRelevance(allPieces);
     determineFlags();
 }
 
@@ -259,9 +258,8 @@ QString PeerInfo::connectionType() const
     return connection;
 }
 
-void PeerInfo::calcRelevance(const TorrentHandle *torrent)
+void PeerInfo::calcRelevance(const QBitArray &allPieces)
 {
-    const QBitArray allPieces = torrent->pieces();
     const QBitArray peerPieces = pieces();
 
     int localMissing = 0;
@@ -38,8 +38,6 @@
 
 namespace BitTorrent
 {
-    class TorrentHandle;
-
     struct PeerAddress
     {
         QHostAddress ip;
@@ -54,7 +52,7 @@ namespace BitTorrent
         Q_DECLARE_TR_FUNCTIONS(PeerInfo)
 
     public:
-        PeerInfo(const TorrentHandle *torrent, const libtorrent::peer_info &nativeInfo);
+        PeerInfo(const QBitArray &allPieces, const libtorrent::peer_info &nativeInfo);
 
         bool fromDHT() const;
         bool fromPeX() const;
@@ -106,7 +104,7 @@ namespace BitTorrent
         int downloadingPieceIndex() const;
 
     private:
-        void calcRelevance(const TorrentHandle *torrent);
+        void calcRelevance(const QBitArray &allPieces);
         void determineFlags();
 
         libtorrent::peer_info m_nativeInfo;
@@ -0,0 +1,236 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "alertdispatcher.h"
+
+#include <algorithm>
+
+#include <QHash>
+#include <QSet>
+
+#include <libtorrent/alert_types.hpp>
+
+namespace libt = libtorrent;
+
+namespace
+{
+    const ulong WAIT_TIMEOUT = 500; // ms
+}
+
+size_t AlertBatch::size() const
+{
+    size_t size = sessionAlerts.size();
+    for (const TorrentAlerts &torrent : torrentAlerts)
+        size += torrent.alerts.size();
+    return size;
+}
+
+void AlertBatch::clear()
+{
+    sessionAlerts.clear();
+    torrentAlerts.clear();
+}
+
+AlertDispatcher::AlertDispatcher(const AlertPopper &popAlerts, QObject *parent)
+    : QThread(parent)
+    , m_popAlerts(popAlerts)
+    , m_batchReleased(1)
+{
+}
+
+AlertDispatcher::~AlertDispatcher()
+{
+    stop();
+}
+
+bool AlertDispatcher::isTorrentAlert(const int type)
+{
+    switch (type) {
+    case libt::stats_alert::alert_type:
+    case libt::file_renamed_alert::alert_type:
+    case libt::file_completed_alert::alert_type:
+    case libt::torrent_finished_alert::alert_type:
+    case libt::save_resume_data_alert::alert_type:
+    case libt::save_resume_data_failed_alert::alert_type:
+    case libt::storage_moved_alert::alert_type:
+    case libt::storage_moved_failed_alert::alert_type:
+    case libt::torrent_paused_alert::alert_type:
+    case libt::torrent_resumed_alert::alert_type:
+    case libt::tracker_announce_alert::alert_type:
+    case libt::tracker_error_alert::alert_type:
+    case libt::tracker_reply_alert::alert_type:
+    case libt::tracker_warning_alert::alert_type:
+    case libt::fastresume_rejected_alert::alert_type:
+    case libt::torrent_checked_alert::alert_type:
+    case libt::metadata_received_alert::alert_type:
+    case libt::read_piece_alert::alert_type:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool AlertDispatcher::takeBatch(AlertBatch &batch)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_hasBatch) return false;
+
+    std::swap(batch, m_batch);
+    m_batch.clear();
+    m_hasBatch = false;
+    return true;
+}
+
+void AlertDispatcher::releaseBatch()
+{
+    m_batchReleased.release();
+}
+
+void AlertDispatcher::stop()
+{
+    if (!isRunning()) return;
+
+    requestInterruption();
+    m_batchReleased.release();
+    wait();
+}
+
+BitTorrent::AlertStatistics AlertDispatcher::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_statistics;
+}
+
+void AlertDispatcher::run()
+{
+    while (!isInterruptionRequested()) {
+        // the alerts of the previous batch stay valid until it's released
+        m_batchReleased.acquire();
+        if (isInterruptionRequested()) break;
+
+        std::vector<libt::alert *> alerts;
+        while (alerts.empty() && !isInterruptionRequested())
+            m_popAlerts(alerts, WAIT_TIMEOUT);
+        if (alerts.empty()) break;
+
+        const quint64 received = alerts.size();
+        AlertBatch batch;
+        classify(alerts, batch);
+
+        {
+            QMutexLocker locker(&m_mutex);
+            std::swap(m_batch, batch);
+            m_hasBatch = true;
+
+            m_statistics.received += received;
+            m_statistics.collapsed += received - m_batch.size();
+            ++m_statistics.batches;
+            m_statistics.largestBatch = std::max(m_statistics.largestBatch, received);
+        }
+
+        emit batchReady();
+    }
+}
+
+// Only snapshots are left out. The alerts carrying deltas or events
+// (transferred bytes, tracker replies, etc.) are all needed by the main thread.
+void AlertDispatcher::classify(const std::vector<libt::alert *> &alerts, AlertBatch &batch)
+{
+    // popped alerts are owned by the caller before libtorrent 1.1
+    const auto drop = [](libt::alert *a)
+    {
+#if LIBTORRENT_VERSION_NUM < 10100
+        delete a;
+#else
+        Q_UNUSED(a);
+#endif
+    };
+
+    QHash<BitTorrent::InfoHash, size_t> torrentIndexes;
+    libt::state_update_alert *stateUpdate = nullptr;
+#if LIBTORRENT_VERSION_NUM >= 10100
+    libt::alert *sessionStats = nullptr;
+#endif
+
+    for (libt::alert *const a : alerts) {
+        const int type = a->type();
+        if (isTorrentAlert(type)) {
+            const BitTorrent::InfoHash hash = static_cast<libt::torrent_alert *>(a)->handle.info_hash();
+            auto indexIt = torrentIndexes.find(hash);
+            if (indexIt == torrentIndexes.end()) {
+                indexIt = torrentIndexes.insert(hash, batch.torrentAlerts.size());
+                batch.torrentAlerts.push_back({hash, {}});
+            }
+
+            std::vector<libt::alert *> &torrentAlerts = batch.torrentAlerts[indexIt.value()].alerts;
+            // each one is the rate over the last second, the latest is the current one
+            if (type == libt::stats_alert::alert_type) {
+                const auto statsIt = std::find_if(torrentAlerts.begin(), torrentAlerts.end()
+                    , [](const libt::alert *torrentAlert) { return (torrentAlert->type() == libt::stats_alert::alert_type); });
+                if (statsIt != torrentAlerts.end()) {
+                    drop(*statsIt);
+                    torrentAlerts.erase(statsIt);
+                }
+            }
+            torrentAlerts.push_back(a);
+        }
+        else if (type == libt::state_update_alert::alert_type) {
+            // the statuses of the earlier updates are carried over to the latest one,
+            // unless it has a newer status of the same torrent
+            auto *const update = static_cast<libt::state_update_alert *>(a);
+            if (stateUpdate) {
+                QSet<BitTorrent::InfoHash> updatedTorrents;
+                for (const libt::torrent_status &status : update->status)
+                    updatedTorrents.insert(status.info_hash);
+                for (const libt::torrent_status &status : stateUpdate->status) {
+                    if (!updatedTorrents.contains(status.info_hash))
+                        update->status.push_back(status);
+                }
+                batch.sessionAlerts.erase(std::find(batch.sessionAlerts.begin(), batch.sessionAlerts.end(), stateUpdate));
+                drop(stateUpdate);
+            }
+            stateUpdate = update;
+            batch.sessionAlerts.push_back(a);
+        }
+#if LIBTORRENT_VERSION_NUM >= 10100
+        else if (type == libt::session_stats_alert::alert_type) {
+            // counters are cumulative, the latest snapshot covers the earlier ones
+            if (sessionStats) {
+                batch.sessionAlerts.erase(std::find(batch.sessionAlerts.begin(), batch.sessionAlerts.end(), sessionStats));
+                drop(sessionStats);
+            }
+            sessionStats = a;
+            batch.sessionAlerts.push_back(a);
+        }
+#endif
+        else {
+            batch.sessionAlerts.push_back(a);
+        }
+    }
+}
@@ -0,0 +1,106 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <QMutex>
+#include <QSemaphore>
+#include <QThread>
+
+#include "base/bittorrent/infohash.h"
+#include "base/bittorrent/session.h"
+
+namespace libtorrent
+{
+    class alert;
+}
+
+// Alerts of a batch, classified by the dispatcher thread
+struct AlertBatch
+{
+    struct TorrentAlerts
+    {
+        BitTorrent::InfoHash hash;
+        std::vector<libtorrent::alert *> alerts; // in order
+    };
+
+    // The session alerts (in order) are handled first, so that
+    // the torrents they add are known to the torrent alerts
+    std::vector<libtorrent::alert *> sessionAlerts;
+    // by torrent, in order of their first alert
+    std::vector<TorrentAlerts> torrentAlerts;
+
+    size_t size() const;
+    void clear();
+};
+
+// Pops alerts on its own thread and hands them to the main thread in batches,
+// grouped by torrent and leaving out the ones made redundant by a later alert
+// of the same batch.
+// Only one batch is in flight at a time: libtorrent frees popped alerts
+// on the next pop, so the main thread has to release a batch once handled.
+class AlertDispatcher : public QThread
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(AlertDispatcher)
+
+public:
+    using AlertPopper = std::function<void (std::vector<libtorrent::alert *> &out, ulong time)>;
+
+    explicit AlertDispatcher(const AlertPopper &popAlerts, QObject *parent = nullptr);
+    ~AlertDispatcher() override;
+
+    // Whether the alert is handled by the torrent it is about
+    static bool isTorrentAlert(int type);
+
+    bool takeBatch(AlertBatch &batch);
+    void releaseBatch();
+    // After it returns the caller may pop alerts itself
+    void stop();
+
+    BitTorrent::AlertStatistics statistics() const;
+
+signals:
+    void batchReady();
+
+protected:
+    void run() override;
+
+private:
+    static void classify(const std::vector<libtorrent::alert *> &alerts, AlertBatch &batch);
+
+    const AlertPopper m_popAlerts;
+    QSemaphore m_batchReleased;
+    mutable QMutex m_mutex;
+    AlertBatch m_batch;
+    bool m_hasBatch = false;
+    BitTorrent::AlertStatistics m_statistics;
+};
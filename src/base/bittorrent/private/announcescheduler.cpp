@@ -0,0 +1,190 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "announcescheduler.h"
+
+#include <algorithm>
+
+#include <QUrl>
+
+namespace
+{
+    // fewer torrents than that don't make a crowd
+    const int MIN_CROWDED_TORRENTS = 20;
+    // the announces are spread over that share of the announce interval,
+    // so none of them is more than half an interval late
+    const int SPREAD_DIVIDER = 2;
+
+    const qint64 MINUTE = 60 * 1000; // msecs
+    // shorter gaps between the announces of a torrent are forced reannounces
+    const qint64 MIN_ANNOUNCE_INTERVAL = 5 * 60 * 1000; // msecs
+    const qint64 TORRENT_TIMEOUT = 2 * 60 * 60 * 1000; // msecs
+    const qint64 ANNOUNCE_TIMEOUT = 5 * 60 * 1000; // msecs
+    const qint64 CLEANUP_INTERVAL = MINUTE;
+}
+
+AnnounceScheduler::AnnounceScheduler()
+{
+    m_clock.start();
+}
+
+void AnnounceScheduler::addAnnounce(const QString &trackerUrl, const QString &torrentHash)
+{
+    const qint64 now = m_clock.elapsed();
+    Host &host = m_hosts[this->host(trackerUrl)];
+
+    // The tracker interval isn't in the alerts, so it is learned from the torrents
+    // announcing again. A stale estimate is replaced, since trackers may raise it.
+    const auto torrentIt = host.torrents.constFind(torrentHash);
+    if (torrentIt != host.torrents.constEnd()) {
+        const qint64 gap = now - torrentIt.value();
+        if ((gap >= MIN_ANNOUNCE_INTERVAL)
+            && ((host.interval == 0) || (gap < host.interval) || ((now - host.intervalTime) > TORRENT_TIMEOUT))) {
+            host.interval = gap;
+            host.intervalTime = now;
+        }
+    }
+
+    host.torrents[torrentHash] = now;
+    host.pendingAnnounces[torrentHash] = now;
+
+    if ((now - host.minuteStart) >= MINUTE) {
+        host.lastMinuteAnnounces = ((now - host.minuteStart) < (2 * MINUTE)) ? host.minuteAnnounces : 0;
+        host.minuteStart = now;
+        host.minuteAnnounces = 0;
+    }
+    ++host.minuteAnnounces;
+
+    if ((now - m_lastCleanup) >= CLEANUP_INTERVAL)
+        removeStale(now);
+}
+
+void AnnounceScheduler::addReply(const QString &trackerUrl, const QString &torrentHash)
+{
+    const auto it = m_hosts.find(host(trackerUrl));
+    if (it != m_hosts.end())
+        it->pendingAnnounces.remove(torrentHash);
+}
+
+void AnnounceScheduler::addFailure(const QString &trackerUrl, const QString &torrentHash)
+{
+    addReply(trackerUrl, torrentHash);
+}
+
+void AnnounceScheduler::forgetTorrent(const QString &torrentHash)
+{
+    for (Host &host : m_hosts) {
+        host.torrents.remove(torrentHash);
+        host.pendingAnnounces.remove(torrentHash);
+    }
+}
+
+bool AnnounceScheduler::isCrowded(const QString &trackerUrl) const
+{
+    const auto it = m_hosts.constFind(host(trackerUrl));
+    return ((it != m_hosts.constEnd()) && (it->torrents.size() >= MIN_CROWDED_TORRENTS));
+}
+
+int AnnounceScheduler::reschedule(const QString &trackerUrl)
+{
+    const auto it = m_hosts.find(host(trackerUrl));
+    if ((it == m_hosts.end()) || (it->interval <= 0)) return -1;
+
+    // The torrents that announced in the last interval get an even share of
+    // the spread, the ones announcing on time keep their place
+    const qint64 now = m_clock.elapsed();
+    const qint64 interval = it->interval;
+    const qint64 spacing = interval / SPREAD_DIVIDER / std::max(it->torrents.size(), 1);
+    const qint64 desiredTime = now + interval;
+    const qint64 slot = std::min(std::max(desiredTime, it->nextSlot), (desiredTime + (interval / SPREAD_DIVIDER)));
+    it->nextSlot = std::max(it->nextSlot, (slot + spacing));
+
+    if ((slot - desiredTime) < 1000)
+        return -1;
+    return static_cast<int>((slot - now + 999) / 1000);
+}
+
+QHash<QString, BitTorrent::TrackerLoad> AnnounceScheduler::loads() const
+{
+    const qint64 now = m_clock.elapsed();
+
+    QHash<QString, BitTorrent::TrackerLoad> result;
+    result.reserve(m_hosts.size());
+    for (auto it = m_hosts.cbegin(); it != m_hosts.cend(); ++it) {
+        BitTorrent::TrackerLoad load;
+        load.torrents = it->torrents.size();
+        load.announceRate = announceRate(it.value(), now);
+        load.backlog = it->pendingAnnounces.size();
+        result.insert(it.key(), load);
+    }
+    return result;
+}
+
+QString AnnounceScheduler::host(const QString &trackerUrl) const
+{
+    auto it = m_urlHosts.find(trackerUrl);
+    if (it == m_urlHosts.end())
+        it = m_urlHosts.insert(trackerUrl, QUrl(trackerUrl).host());
+    return it.value();
+}
+
+// announces of the last complete minute
+int AnnounceScheduler::announceRate(const Host &host, const qint64 now) const
+{
+    if ((now - host.minuteStart) >= (2 * MINUTE))
+        return 0;
+    if ((now - host.minuteStart) >= MINUTE)
+        return host.minuteAnnounces;
+    return host.lastMinuteAnnounces;
+}
+
+void AnnounceScheduler::removeStale(const qint64 now)
+{
+    m_lastCleanup = now;
+
+    for (auto hostIt = m_hosts.begin(); hostIt != m_hosts.end();) {
+        Host &host = hostIt.value();
+        for (auto it = host.torrents.begin(); it != host.torrents.end();) {
+            if ((now - it.value()) > TORRENT_TIMEOUT)
+                it = host.torrents.erase(it);
+            else
+                ++it;
+        }
+        for (auto it = host.pendingAnnounces.begin(); it != host.pendingAnnounces.end();) {
+            if ((now - it.value()) > ANNOUNCE_TIMEOUT)
+                it = host.pendingAnnounces.erase(it);
+            else
+                ++it;
+        }
+
+        if (host.torrents.isEmpty() && ((now - host.minuteStart) >= (2 * MINUTE)))
+            hostIt = m_hosts.erase(hostIt);
+        else
+            ++hostIt;
+    }
+}
@@ -0,0 +1,80 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+
+#include "base/bittorrent/session.h"
+
+// Spreads the announces of the torrents to a same tracker host over time, so that
+// the torrents started together, e.g. on startup, don't keep announcing together
+// every interval. It also keeps the announce rate and backlog of every host.
+class AnnounceScheduler
+{
+public:
+    AnnounceScheduler();
+
+    void addAnnounce(const QString &trackerUrl, const QString &torrentHash);
+    void addReply(const QString &trackerUrl, const QString &torrentHash);
+    void addFailure(const QString &trackerUrl, const QString &torrentHash);
+    void forgetTorrent(const QString &torrentHash);
+
+    // Whether the host of the tracker has enough torrents for their announces to be spread
+    bool isCrowded(const QString &trackerUrl) const;
+    // Returns the delay in secs of the next announce to the tracker that keeps the
+    // announces to its host apart, or -1 if the host interval already does or isn't known yet
+    int reschedule(const QString &trackerUrl);
+
+    // by host
+    QHash<QString, BitTorrent::TrackerLoad> loads() const;
+
+private:
+    struct Host
+    {
+        QHash<QString, qint64> torrents; // last announce time by torrent
+        QHash<QString, qint64> pendingAnnounces; // start time by torrent
+        qint64 nextSlot = 0; // msecs
+        qint64 interval = 0; // msecs, shortest gap between the announces of a torrent
+        qint64 intervalTime = 0; // msecs
+        qint64 minuteStart = 0;
+        int minuteAnnounces = 0;
+        int lastMinuteAnnounces = 0;
+    };
+
+    QString host(const QString &trackerUrl) const;
+    int announceRate(const Host &host, qint64 now) const;
+    void removeStale(qint64 now);
+
+    QHash<QString, Host> m_hosts;
+    mutable QHash<QString, QString> m_urlHosts;
+    QElapsedTimer m_clock;
+    qint64 m_lastCleanup = 0;
+};
@@ -0,0 +1,145 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "bandwidthallocator.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "base/global.h"
+
+namespace
+{
+    // A torrent is allowed to grow past its current rate by that much
+    // every time, so a class converges to its share in a few rounds
+    const int MIN_HEADROOM = 8 * 1024;
+    // What an idle torrent gets at least, so it can start transferring
+    const int MIN_IDLE_LIMIT = 1024;
+
+    int demandOf(const BandwidthAllocator::Member &member)
+    {
+        if (member.rate <= 0) return 0;
+        return member.rate + std::max((member.rate / 2), MIN_HEADROOM);
+    }
+
+    int stricterLimit(const int left, const int right)
+    {
+        if (left <= 0) return right;
+        if (right <= 0) return left;
+        return std::min(left, right);
+    }
+
+    // Max-min fair split of `capacity` between the members: the ones that want
+    // less than their fair share get what they want, the rest is split evenly
+    void fillLimits(qint64 capacity, const QVector<int> &memberIndexes, const QVector<int> &demands, QVector<int> &limits)
+    {
+        QVector<int> active;
+        QVector<int> idle;
+        for (const int index : memberIndexes) {
+            if (demands[index] > 0)
+                active.append(index);
+            else
+                idle.append(index);
+        }
+
+        std::sort(active.begin(), active.end(), [&demands](const int left, const int right)
+        {
+            return demands[left] < demands[right];
+        });
+
+        for (int i = 0; i < active.size(); ++i) {
+            const int index = active[i];
+            const qint64 share = capacity / (active.size() - i);
+            const int limit = std::max<int>(std::min<qint64>(demands[index], share), 1);
+            capacity = std::max<qint64>((capacity - limit), 0);
+            limits[index] = stricterLimit(limits[index], limit);
+        }
+
+        if (idle.isEmpty()) return;
+
+        const int idleLimit = std::max<int>((capacity / idle.size()), MIN_IDLE_LIMIT);
+        for (const int index : asConst(idle))
+            limits[index] = stricterLimit(limits[index], idleLimit);
+    }
+}
+
+QVector<int> BandwidthAllocator::allocate(const QVector<Class> &classes, const QVector<Member> &members, const int globalLimit)
+{
+    QVector<int> demands(members.size());
+    QVector<QVector<int>> classMembers(classes.size());
+    QVector<qint64> classDemands(classes.size(), 0);
+    for (int i = 0; i < members.size(); ++i) {
+        demands[i] = demandOf(members[i]);
+        for (const int classIndex : members[i].classes) {
+            classMembers[classIndex].append(i);
+            classDemands[classIndex] += demands[i];
+        }
+    }
+
+    // Guarantees are relative to the global limit and they are scaled
+    // down if they add up to more than it. Only the part a class uses
+    // is reserved, so an unused guarantee is lent to everyone else.
+    QVector<qint64> reserved(classes.size(), 0);
+    if (globalLimit > 0) {
+        const int totalShare = std::accumulate(classes.cbegin(), classes.cend(), 0
+            , [](const int sum, const Class &bandwidthClass) { return sum + bandwidthClass.minShare; });
+        for (int i = 0; i < classes.size(); ++i) {
+            if (classes[i].minShare <= 0) continue;
+            const qint64 guarantee = static_cast<qint64>(globalLimit) * classes[i].minShare / std::max(totalShare, 100);
+            reserved[i] = std::min(guarantee, classDemands[i]);
+        }
+    }
+    const qint64 totalReserved = std::accumulate(reserved.cbegin(), reserved.cend(), qint64 {0});
+
+    QVector<int> limits(members.size(), 0);
+    for (int i = 0; i < classes.size(); ++i) {
+        qint64 capacity = classes[i].limit;
+        if (totalReserved > 0) {
+            // what the other classes reserved isn't available to this one
+            const qint64 available = std::max<qint64>((globalLimit - (totalReserved - reserved[i])), 0);
+            capacity = (capacity > 0) ? std::min(capacity, available) : available;
+        }
+        if (capacity > 0)
+            fillLimits(capacity, classMembers[i], demands, limits);
+    }
+
+    if (totalReserved > 0) {
+        // The torrents without a guarantee share what is left
+        QVector<int> others;
+        for (int i = 0; i < members.size(); ++i) {
+            const QVector<int> &memberClasses = members[i].classes;
+            const bool isGuaranteed = std::any_of(memberClasses.cbegin(), memberClasses.cend()
+                , [&classes](const int classIndex) { return (classes[classIndex].minShare > 0); });
+            if (!isGuaranteed)
+                others.append(i);
+        }
+        fillLimits(std::max<qint64>((globalLimit - totalReserved), 1), others, demands, limits);
+    }
+
+    return limits;
+}
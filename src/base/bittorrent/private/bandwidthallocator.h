@@ -0,0 +1,55 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QVector>
+
+// Splits the bandwidth of hierarchical classes (categories, their subcategories
+// and tags) into per torrent limits, for one direction. A torrent may belong to
+// several classes and gets the strictest of their limits. Every class caps the sum
+// of its members and may be guaranteed a share of the global limit, which is
+// taken from the torrents outside of it as long as the class actually uses it.
+class BandwidthAllocator
+{
+public:
+    struct Class
+    {
+        int limit = 0; // bytes per second, 0 if unlimited
+        int minShare = 0; // percent of the global limit
+    };
+
+    struct Member
+    {
+        int rate = 0; // current rate, bytes per second
+        QVector<int> classes; // indexes of the classes it belongs to
+    };
+
+    // Returns the limit of every member in bytes per second, 0 if not limited
+    static QVector<int> allocate(const QVector<Class> &classes, const QVector<Member> &members, int globalLimit);
+};
@@ -0,0 +1,206 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "crossseedindex.h"
+
+#include <algorithm>
+
+#include <QDir>
+#include <QFileInfo>
+
+#include <libtorrent/torrent_info.hpp>
+
+#include "base/bittorrent/torrenthandle.h"
+#include "base/bittorrent/torrentinfo.h"
+#include "base/global.h"
+#include "base/utils/fs.h"
+
+using namespace BitTorrent;
+
+namespace
+{
+#ifdef Q_OS_WIN
+    const Qt::CaseSensitivity PATH_CASE_SENSITIVITY = Qt::CaseInsensitive;
+#else
+    const Qt::CaseSensitivity PATH_CASE_SENSITIVITY = Qt::CaseSensitive;
+#endif
+
+    // Pad files and empty ones have nothing to be found by
+    bool isIndexable(const TorrentInfo &torrentInfo, const int index)
+    {
+        return !torrentInfo.nativeInfo()->files().pad_file_at(index) && (torrentInfo.fileSize(index) > 0);
+    }
+}
+
+void CrossSeedIndex::addTorrent(const TorrentHandle *torrent)
+{
+    if (!torrent->hasMetadata()) return;
+
+    addTorrent(torrent, torrent->info());
+}
+
+void CrossSeedIndex::addTorrent(const TorrentHandle *torrent, const TorrentInfo &torrentInfo)
+{
+    if (!torrentInfo.isValid()) return;
+
+    removeTorrent(torrent->hash());
+
+    const bool isDormant = torrent->isDormant();
+    QVector<Key> &keys = m_torrentKeys[torrent->hash()];
+    for (int i = 0; i < torrentInfo.filesCount(); ++i) {
+        if (!isIndexable(torrentInfo, i)) continue;
+
+        const Key key = makeKey(torrentInfo.fileSize(i), torrentInfo.fileName(i));
+        m_locations[key].append({torrent->hash(), i, (isDormant ? torrentInfo.filePath(i) : QString())});
+        keys.append(key);
+    }
+}
+
+void CrossSeedIndex::removeTorrent(const InfoHash &hash)
+{
+    const QVector<Key> keys = m_torrentKeys.take(hash);
+    for (const Key &key : keys) {
+        const auto it = m_locations.find(key);
+        if (it == m_locations.end()) continue;
+
+        QVector<Location> &locations = it.value();
+        locations.erase(std::remove_if(locations.begin(), locations.end()
+            , [&hash](const Location &location) { return location.hash == hash; })
+            , locations.end());
+        if (locations.isEmpty())
+            m_locations.erase(it);
+    }
+}
+
+void CrossSeedIndex::clear()
+{
+    m_locations.clear();
+    m_torrentKeys.clear();
+}
+
+QString CrossSeedIndex::findSavePath(const TorrentInfo &torrentInfo, const Torrents &torrents) const
+{
+    // The largest file has the fewest namesakes
+    int anchor = -1;
+    for (int i = 0; i < torrentInfo.filesCount(); ++i) {
+        if (isIndexable(torrentInfo, i)
+            && ((anchor < 0) || (torrentInfo.fileSize(i) > torrentInfo.fileSize(anchor))))
+            anchor = i;
+    }
+    if (anchor < 0) return QString();
+
+    const QString anchorPath = torrentInfo.filePath(anchor);
+    const Key key = makeKey(torrentInfo.fileSize(anchor), torrentInfo.fileName(anchor));
+    for (const Location &location : asConst(m_locations.value(key))) {
+        // The file is found at <save path>/<its path in the new torrent>
+        const QString path = filePath(location, key, torrents, true);
+        if (!path.endsWith('/' + anchorPath, PATH_CASE_SENSITIVITY)) continue;
+
+        const QString savePath = path.left(path.size() - anchorPath.size());
+        const QDir saveDir(savePath);
+        bool isComplete = true;
+        for (int i = 0; (i < torrentInfo.filesCount()) && isComplete; ++i) {
+            if (!isIndexable(torrentInfo, i)) continue;
+
+            const QFileInfo fileInfo(saveDir.absoluteFilePath(torrentInfo.filePath(i)));
+            isComplete = fileInfo.isFile() && (fileInfo.size() == torrentInfo.fileSize(i));
+        }
+
+        if (isComplete)
+            return savePath;
+    }
+
+    return QString();
+}
+
+bool CrossSeedIndex::sharesFiles(const TorrentHandle *torrent, const Torrents &torrents) const
+{
+    if (!torrent->hasMetadata()) return false;
+
+    const TorrentInfo torrentInfo = torrent->info();
+    const QDir saveDir(torrent->savePath(true));
+    for (int i = 0; i < torrentInfo.filesCount(); ++i) {
+        if (!isIndexable(torrentInfo, i)) continue;
+
+        const Key key = makeKey(torrentInfo.fileSize(i), torrentInfo.fileName(i));
+        const auto it = m_locations.constFind(key);
+        if (it == m_locations.constEnd()) continue;
+
+        const QString path = Utils::Fs::expandPathAbs(saveDir.absoluteFilePath(torrentInfo.filePath(i)));
+        for (const Location &location : it.value()) {
+            if (location.hash == torrent->hash()) continue;
+
+            if (QString::compare(filePath(location, key, torrents, false), path, PATH_CASE_SENSITIVITY) == 0)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+CrossSeedIndex::Key CrossSeedIndex::makeKey(const qint64 size, const QString &fileName)
+{
+#ifdef Q_OS_WIN
+    return {size, fileName.toLower()};
+#else
+    return {size, fileName};
+#endif
+}
+
+QString CrossSeedIndex::filePath(const Location &location, const Key &key, const Torrents &torrents, const bool completedOnly)
+{
+    const TorrentHandle *torrent = torrents.value(location.hash);
+    if (!torrent) return QString();
+
+    if (torrent->isDormant()) {
+        // Its files can't be renamed without waking it up, which indexes it again.
+        // The file priorities aren't known either, so only a complete torrent counts.
+        if (location.filePath.isEmpty()) return QString();
+        if (completedOnly && (torrent->hasMissingFiles() || torrent->hasError()
+                              || (torrent->completedSize() != torrent->totalSize())))
+            return QString();
+
+        return Utils::Fs::expandPathAbs(QDir(torrent->savePath(true)).absoluteFilePath(location.filePath));
+    }
+
+    if (location.fileIndex >= torrent->filesCount())
+        return QString();
+
+    const int index = location.fileIndex;
+    // Files renamed since they were indexed aren't the ones looked for
+    if (makeKey(torrent->fileSize(index), torrent->fileName(index)) != key)
+        return QString();
+
+    if (completedOnly) {
+        if (!torrent->isSeed() || torrent->hasMissingFiles() || torrent->hasError()
+            || (torrent->filePriorities().value(index) == 0))
+            return QString();
+    }
+
+    return Utils::Fs::expandPathAbs(QDir(torrent->savePath(true)).absoluteFilePath(torrent->filePath(index)));
+}
@@ -0,0 +1,83 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+#include "base/bittorrent/infohash.h"
+
+namespace BitTorrent
+{
+    class TorrentHandle;
+    class TorrentInfo;
+}
+
+// Finds the torrents whose files are already on disk as a part of
+// another torrent (i.e. the same content released with another info hash).
+// Files are looked up by their size and name, the candidates are then
+// confirmed by checking that the whole layout of the new torrent is there.
+class CrossSeedIndex
+{
+public:
+    typedef QHash<BitTorrent::InfoHash, BitTorrent::TorrentHandle *> Torrents;
+
+    // The torrent must have its metadata
+    void addTorrent(const BitTorrent::TorrentHandle *torrent);
+    // Dormant torrents are indexed from their stored metadata,
+    // so that it doesn't have to be kept in memory
+    void addTorrent(const BitTorrent::TorrentHandle *torrent, const BitTorrent::TorrentInfo &torrentInfo);
+    void removeTorrent(const BitTorrent::InfoHash &hash);
+    void clear();
+
+    // Returns the save path where all the files of the torrent are
+    // found in the completed torrents, empty string if there is none
+    QString findSavePath(const BitTorrent::TorrentInfo &torrentInfo, const Torrents &torrents) const;
+    // Whether any file of the torrent is also a file of another torrent
+    bool sharesFiles(const BitTorrent::TorrentHandle *torrent, const Torrents &torrents) const;
+
+private:
+    typedef QPair<qint64, QString> Key; // file size, file name
+
+    struct Location
+    {
+        BitTorrent::InfoHash hash;
+        int fileIndex;
+        QString filePath; // within the save path, only kept for dormant torrents
+    };
+
+    static Key makeKey(qint64 size, const QString &fileName);
+    // Absolute path of the file if it is still the one it was indexed as, empty string otherwise
+    static QString filePath(const Location &location, const Key &key, const Torrents &torrents, bool completedOnly);
+
+    QHash<Key, QVector<Location>> m_locations;
+    QHash<BitTorrent::InfoHash, QVector<Key>> m_torrentKeys;
+};
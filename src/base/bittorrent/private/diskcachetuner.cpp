@@ -0,0 +1,217 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "diskcachetuner.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "base/logger.h"
+#include "base/utils/misc.h"
+
+namespace
+{
+    const qint64 WINDOW_DURATION = 30 * 1000; // msecs
+
+    // MiB
+#if defined(__x86_64__) || defined(_M_X64)
+    const int MAX_CACHE_SIZE = 33554431;
+#else
+    const int MAX_CACHE_SIZE = 1536;
+#endif
+    const int MIN_CACHE_STEP = 16;
+    const qint64 LOW_MEMORY = 256;
+    // reads that hit the cache, the cache isn't grown above it
+    const qreal GOOD_HIT_RATIO = 0.9;
+
+    const int MAX_ASYNC_IO_THREADS = 32;
+    // queued disk jobs per I/O thread
+    const qreal BUSY_QUEUE_LENGTH = 4;
+    const qreal IDLE_QUEUE_LENGTH = 0.5;
+
+    const int MAX_SEND_BUFFER_WATERMARK = 8192; // KiB
+}
+
+void DiskCacheTuner::reset(const Settings &baseline, const bool canTuneThreads)
+{
+    m_baseline = baseline;
+    m_settings = baseline;
+    m_canTuneThreads = canTuneThreads;
+
+    m_window = Window();
+    m_windowTimer.invalidate();
+    m_hasLastSample = false;
+    m_jobTimeBeforeThreadIncrease = -1;
+    m_maxAsyncIOThreads = std::max(MAX_ASYNC_IO_THREADS, baseline.asyncIOThreads);
+}
+
+const DiskCacheTuner::Settings &DiskCacheTuner::settings() const
+{
+    return m_settings;
+}
+
+bool DiskCacheTuner::addSample(const Sample &sample)
+{
+    if (m_hasLastSample) {
+        m_window.cacheHits += std::max<qint64>(0, (sample.cacheHits - m_lastSample.cacheHits));
+        m_window.cacheMisses += std::max<qint64>(0, (sample.cacheMisses - m_lastSample.cacheMisses));
+        if (sample.diskJobs > 0) {
+            m_window.jobs += std::max<qint64>(0, (sample.diskJobs - m_lastSample.diskJobs));
+            m_window.jobTime += std::max<qint64>(0, (sample.diskJobTime - m_lastSample.diskJobTime));
+        }
+        else {
+            ++m_window.jobs;
+            m_window.jobTime += sample.averageJobTime;
+        }
+    }
+    m_lastSample = sample;
+    m_hasLastSample = true;
+
+    ++m_window.samples;
+    m_window.cacheUsedBlocks += sample.cacheUsedBlocks;
+    m_window.jobQueueLength += sample.jobQueueLength;
+    m_window.peersWaitingForDisk += sample.peersWaitingForDisk;
+    m_window.unchokedPeers += sample.unchokedPeers;
+    m_window.uploadRate += sample.uploadRate;
+    m_window.maxCacheUsedBlocks = std::max(m_window.maxCacheUsedBlocks, sample.cacheUsedBlocks);
+
+    if (!m_windowTimer.isValid())
+        m_windowTimer.start();
+    if (m_windowTimer.elapsed() < WINDOW_DURATION)
+        return false;
+
+    const bool cacheSizeChanged = tuneCacheSize(sample.availableMemory);
+    const bool threadsChanged = tuneAsyncIOThreads();
+    const bool watermarkChanged = tuneSendBufferWatermark(sample.availableMemory);
+
+    m_window = Window();
+    m_windowTimer.start();
+    return (cacheSizeChanged || threadsChanged || watermarkChanged);
+}
+
+bool DiskCacheTuner::tuneCacheSize(const qint64 availableMemory)
+{
+    // The cache is disabled or sized by libtorrent itself
+    if (m_baseline.cacheSize <= 0) return false;
+
+    const int current = m_settings.cacheSize;
+    const int maxUsed = m_window.maxCacheUsedBlocks / 64;
+    const qint64 accesses = m_window.cacheHits + m_window.cacheMisses;
+    const qreal hitRatio = (accesses > 0) ? (static_cast<qreal>(m_window.cacheHits) / accesses) : 1;
+    const qint64 availableMiB = (availableMemory >= 0) ? (availableMemory / (1024 * 1024)) : -1;
+
+    int target = current;
+    QString reason;
+    if ((availableMiB >= 0) && (availableMiB < LOW_MEMORY)) {
+        target = std::max(m_baseline.cacheSize, (current * 3 / 4));
+        reason = tr("%1 MiB of memory available").arg(availableMiB);
+    }
+    else if ((maxUsed >= (current * 9 / 10)) && (hitRatio < GOOD_HIT_RATIO) && (m_window.uploadRate > 0)) {
+        // Seeding reads miss the full cache, a larger one keeps more of the requested pieces.
+        // It never takes more than a quarter of the memory left.
+        qint64 growth = std::max((current / 2), MIN_CACHE_STEP);
+        if (availableMiB >= 0)
+            growth = std::min(growth, (availableMiB / 4));
+        target = static_cast<int>(std::min<qint64>((current + growth), MAX_CACHE_SIZE));
+        reason = tr("cache is full, %1% of the reads hit it").arg(qRound(hitRatio * 100));
+    }
+    else if ((maxUsed < (current / 2)) && (current > m_baseline.cacheSize)) {
+        target = std::max(m_baseline.cacheSize, std::max((current * 3 / 4), (maxUsed * 2)));
+        reason = tr("at most %1 MiB used").arg(maxUsed);
+    }
+
+    if (target == current) return false;
+
+    LogMsg(tr("Disk cache size changed from %1 MiB to %2 MiB: %3.").arg(current).arg(target).arg(reason));
+    m_settings.cacheSize = target;
+    return true;
+}
+
+bool DiskCacheTuner::tuneAsyncIOThreads()
+{
+    if (!m_canTuneThreads) return false;
+
+    const int current = m_settings.asyncIOThreads;
+    const qreal queueLength = static_cast<qreal>(m_window.jobQueueLength) / m_window.samples / current;
+    const qint64 jobTime = (m_window.jobs > 0) ? (m_window.jobTime / m_window.jobs) : 0;
+
+    int target = current;
+    QString reason;
+    if (m_jobTimeBeforeThreadIncrease >= 0) {
+        // More threads only help if the storage serves requests in parallel, if the jobs
+        // got much slower since the last increase the disk is saturated
+        if (jobTime > (2 * std::max<qint64>(m_jobTimeBeforeThreadIncrease, 1000))) {
+            target = m_threadsBeforeIncrease;
+            m_maxAsyncIOThreads = target;
+            reason = tr("disk jobs took %1 ms instead of %2 ms").arg(jobTime / 1000).arg(m_jobTimeBeforeThreadIncrease / 1000);
+        }
+        m_jobTimeBeforeThreadIncrease = -1;
+    }
+    else if ((queueLength > BUSY_QUEUE_LENGTH) && (current < m_maxAsyncIOThreads)) {
+        target = std::min((current + std::max(1, (current / 4))), m_maxAsyncIOThreads);
+        m_jobTimeBeforeThreadIncrease = jobTime;
+        m_threadsBeforeIncrease = current;
+        reason = tr("%1 disk jobs queued per thread").arg(queueLength, 0, 'f', 1);
+    }
+    else if ((queueLength < IDLE_QUEUE_LENGTH) && (current > m_baseline.asyncIOThreads)) {
+        target = current - 1;
+        reason = tr("%1 disk jobs queued per thread").arg(queueLength, 0, 'f', 1);
+    }
+
+    if (target == current) return false;
+
+    LogMsg(tr("Disk I/O threads changed from %1 to %2: %3.").arg(current).arg(target).arg(reason));
+    m_settings.asyncIOThreads = target;
+    return true;
+}
+
+bool DiskCacheTuner::tuneSendBufferWatermark(const qint64 availableMemory)
+{
+    const int current = m_settings.sendBufferWatermark;
+    const qreal unchokedPeers = static_cast<qreal>(m_window.unchokedPeers) / m_window.samples;
+    const qint64 peerUploadRate = (unchokedPeers >= 1) ? static_cast<qint64>(m_window.uploadRate / m_window.samples / unchokedPeers) : 0;
+
+    // Buffering about a second of upload for each peer hides the disk round trip from fast peers.
+    // Together the buffers never take more than an eighth of the memory left.
+    qint64 target = std::min<qint64>((peerUploadRate / 1024), MAX_SEND_BUFFER_WATERMARK);
+    if ((availableMemory >= 0) && (unchokedPeers >= 1))
+        target = std::min<qint64>(target, (availableMemory / 8 / 1024 / unchokedPeers));
+    target = std::max<qint64>(target, m_baseline.sendBufferWatermark);
+
+    // Peers already wait for the disk, reading further ahead would only add to its load
+    const bool isDiskBusy = ((static_cast<qreal>(m_window.peersWaitingForDisk) / m_window.samples) > (unchokedPeers / 2));
+    if (isDiskBusy && (target > current))
+        target = current;
+
+    if (std::abs(target - current) <= (current / 4)) return false;
+
+    LogMsg(tr("Send buffer watermark changed from %1 KiB to %2 KiB: %3 uploaded per unchoked peer.")
+           .arg(current).arg(target).arg(Utils::Misc::friendlyUnit(peerUploadRate, true)));
+    m_settings.sendBufferWatermark = static_cast<int>(target);
+    return true;
+}
@@ -0,0 +1,106 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+// Closed-loop controller of the disk cache size, the number of disk I/O threads
+// and the send buffer watermark. Session statistics are collected over a window
+// and one decision is made per window, starting from (and never going below)
+// the configured values.
+class DiskCacheTuner
+{
+    Q_DECLARE_TR_FUNCTIONS(DiskCacheTuner)
+
+public:
+    struct Settings
+    {
+        int cacheSize = 0; // MiB
+        int asyncIOThreads = 0;
+        int sendBufferWatermark = 0; // KiB
+    };
+
+    struct Sample
+    {
+        // cumulative counters
+        qint64 cacheHits = 0;
+        qint64 cacheMisses = 0;
+        qint64 diskJobs = 0; // 0 if only averageJobTime is known
+        qint64 diskJobTime = 0; // microseconds
+        // gauges
+        int averageJobTime = 0; // microseconds
+        int cacheUsedBlocks = 0; // 16 KiB blocks
+        int jobQueueLength = 0;
+        int peersWaitingForDisk = 0;
+        int unchokedPeers = 0;
+        quint64 uploadRate = 0; // bytes per second
+        qint64 availableMemory = -1; // bytes, -1 if unknown
+    };
+
+    void reset(const Settings &baseline, bool canTuneThreads);
+    const Settings &settings() const;
+
+    // Returns true if the settings were changed
+    bool addSample(const Sample &sample);
+
+private:
+    bool tuneCacheSize(qint64 availableMemory);
+    bool tuneAsyncIOThreads();
+    bool tuneSendBufferWatermark(qint64 availableMemory);
+
+    Settings m_baseline;
+    Settings m_settings;
+    bool m_canTuneThreads = false;
+
+    // Averages over the current window
+    struct Window
+    {
+        int samples = 0;
+        qint64 cacheHits = 0;
+        qint64 cacheMisses = 0;
+        qint64 jobs = 0;
+        qint64 jobTime = 0;
+        qint64 cacheUsedBlocks = 0;
+        qint64 jobQueueLength = 0;
+        qint64 peersWaitingForDisk = 0;
+        qint64 unchokedPeers = 0;
+        quint64 uploadRate = 0;
+        int maxCacheUsedBlocks = 0;
+    } m_window;
+    QElapsedTimer m_windowTimer;
+    Sample m_lastSample;
+    bool m_hasLastSample = false;
+
+    // Job time before the last I/O thread increase, to detect a saturated disk
+    qint64 m_jobTimeBeforeThreadIncrease = -1;
+    int m_threadsBeforeIncrease = 0;
+    int m_maxAsyncIOThreads = 0;
+};
@@ -0,0 +1,302 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "fastrecheckworker.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+#ifndef Q_OS_WIN
+#include <sys/stat.h>
+#endif
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QVector>
+
+#include <libtorrent/bencode.hpp>
+#include <libtorrent/entry.hpp>
+#include <libtorrent/torrent_info.hpp>
+
+#include "base/global.h"
+#include "base/utils/fs.h"
+
+namespace libt = libtorrent;
+
+namespace
+{
+    const int MAX_SAMPLED_PIECES = 32;
+
+    bool readFileStat(const libt::entry &entry, FastRecheckFileStat &stat)
+    {
+        if ((entry.type() != libt::entry::list_t) || (entry.list().size() != 3))
+            return false;
+
+        const auto isInteger = [](const libt::entry &e) { return e.type() == libt::entry::int_t; };
+        if (!std::all_of(entry.list().cbegin(), entry.list().cend(), isInteger))
+            return false;
+
+        auto it = entry.list().cbegin();
+        stat.size = (it++)->integer();
+        stat.mtime = (it++)->integer();
+        stat.inode = static_cast<quint64>(it->integer());
+        return true;
+    }
+
+    // Reads pieces from the files of a torrent and checks them against their hashes
+    class PieceVerifier
+    {
+    public:
+        PieceVerifier(const BitTorrent::TorrentInfo &torrentInfo, const QString &savePath)
+            : m_torrentInfo(torrentInfo)
+            , m_saveDir(savePath)
+        {
+        }
+
+        bool verify(const int piece)
+        {
+            const libt::torrent_info &nativeInfo = *m_torrentInfo.nativeInfo();
+            const int pieceSize = nativeInfo.piece_size(piece);
+            m_buffer.resize(pieceSize);
+
+            int pos = 0;
+            for (const libt::file_slice &slice : nativeInfo.map_block(piece, 0, pieceSize)) {
+                const int size = static_cast<int>(slice.size);
+                if (nativeInfo.files().pad_file_at(slice.file_index))
+                    std::fill_n(m_buffer.data() + pos, size, '\0');
+                else if (!read(slice.file_index, slice.offset, m_buffer.data() + pos, size))
+                    return false;
+                pos += size;
+            }
+
+            m_hashedBytes += pieceSize;
+            const QByteArray expectedHash = QByteArray::fromRawData(nativeInfo.hash_for_piece_ptr(piece), libt::sha1_hash::size);
+            return (QCryptographicHash::hash(m_buffer, QCryptographicHash::Sha1) == expectedHash);
+        }
+
+        qint64 hashedBytes() const
+        {
+            return m_hashedBytes;
+        }
+
+    private:
+        bool read(const int fileIndex, const qint64 offset, char *data, const int size)
+        {
+            if (fileIndex != m_fileIndex) {
+                m_file.close();
+                m_file.setFileName(m_saveDir.absoluteFilePath(m_torrentInfo.filePath(fileIndex)));
+                m_file.open(QIODevice::ReadOnly);
+                m_fileIndex = fileIndex;
+            }
+
+            return m_file.isOpen() && m_file.seek(offset) && (m_file.read(data, size) == size);
+        }
+
+        const BitTorrent::TorrentInfo m_torrentInfo;
+        const QDir m_saveDir;
+        QFile m_file;
+        int m_fileIndex = -1;
+        QByteArray m_buffer;
+        qint64 m_hashedBytes = 0;
+    };
+}
+
+FastRecheckFileStat FastRecheckWorker::statFile(const QString &path)
+{
+    FastRecheckFileStat stat;
+
+    const QFileInfo fileInfo(path);
+    if (!fileInfo.isFile()) return stat;
+
+    stat.size = fileInfo.size();
+    stat.mtime = fileInfo.lastModified().toMSecsSinceEpoch() / 1000;
+#ifndef Q_OS_WIN
+    struct ::stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) == 0)
+        stat.inode = st.st_ino;
+#endif
+
+    return stat;
+}
+
+void FastRecheckWorker::abort()
+{
+    m_aborted.store(1);
+}
+
+void FastRecheckWorker::check(const FastRecheckJob &job)
+{
+    FastRecheckResult result;
+    result.hash = job.hash;
+    result.torrentInfo = job.torrentInfo;
+
+    libt::entry resumeData = libt::bdecode(job.resumeData.constData(), (job.resumeData.constData() + job.resumeData.size()));
+    const libt::entry storedResumeData = libt::bdecode(job.storedResumeData.constData()
+                                                       , (job.storedResumeData.constData() + job.storedResumeData.size()));
+    if (m_aborted.load() || (resumeData.type() != libt::entry::dictionary_t)
+        || (storedResumeData.type() != libt::entry::dictionary_t)) {
+        emit finished(result);
+        return;
+    }
+
+    const BitTorrent::TorrentInfo &torrentInfo = job.torrentInfo;
+    const libt::file_storage &files = torrentInfo.nativeInfo()->files();
+    const int filesCount = torrentInfo.filesCount();
+    const QDir saveDir(job.savePath);
+
+    // Inodes are only comparable if the files weren't relocated in the meantime
+    const libt::entry *statsPathEntry = storedResumeData.find_key("qBt-fileStatsPath");
+    const bool isSamePath = statsPathEntry && (statsPathEntry->type() == libt::entry::string_t)
+            && (QDir(QString::fromStdString(statsPathEntry->string())) == saveDir);
+
+    QVector<FastRecheckFileStat> recordedStats(filesCount);
+    const libt::entry *statsEntry = storedResumeData.find_key("qBt-fileStats");
+    if (statsEntry && (statsEntry->type() == libt::entry::list_t)) {
+        int i = 0;
+        for (const libt::entry &fileEntry : statsEntry->list()) {
+            if (i == filesCount) break;
+            readFileStat(fileEntry, recordedStats[i]);
+            ++i;
+        }
+    }
+
+    QVector<bool> isTrusted(filesCount);
+    libt::entry::list_type fileSizes;
+    for (int i = 0; i < filesCount; ++i) {
+        // libtorrent validates the resume data against the current file sizes and times
+        libt::entry::integer_type size = 0;
+        libt::entry::integer_type mtime = 0;
+        if (files.pad_file_at(i)) {
+            isTrusted[i] = true;
+        }
+        else {
+            const FastRecheckFileStat stat = statFile(saveDir.absoluteFilePath(torrentInfo.filePath(i)));
+            const FastRecheckFileStat &recordedStat = recordedStats[i];
+            isTrusted[i] = (recordedStat.size >= 0) && (stat.size == recordedStat.size)
+                    && (stat.mtime == recordedStat.mtime)
+                    && (!isSamePath || (stat.inode == recordedStat.inode));
+            size = std::max<qint64>(stat.size, 0);
+            mtime = stat.mtime;
+        }
+        fileSizes.push_back(libt::entry::list_type {size, mtime});
+    }
+
+    PieceVerifier verifier(torrentInfo, job.savePath);
+    QHash<int, bool> verifiedPieces;
+    const auto verify = [&verifier, &verifiedPieces](const int piece) -> bool
+    {
+        auto it = verifiedPieces.find(piece);
+        if (it == verifiedPieces.end())
+            it = verifiedPieces.insert(piece, verifier.verify(piece));
+        return it.value();
+    };
+
+    // Unchanged stats don't catch everything (e.g. files truncated and restored
+    // with their timestamps), so the last piece of each trusted file is verified
+    for (int i = 0; i < filesCount; ++i) {
+        if (!isTrusted[i] || files.pad_file_at(i) || (torrentInfo.fileSize(i) == 0))
+            continue;
+        if (m_aborted.load()) return;
+
+        if (!verify(torrentInfo.filePieces(i).last()))
+            isTrusted[i] = false;
+    }
+
+    const int piecesCount = torrentInfo.piecesCount();
+    std::string pieces(piecesCount, '\0');
+    for (int piece = 0; piece < piecesCount; ++piece) {
+        if (m_aborted.load()) return;
+
+        const QVector<int> fileIndices = torrentInfo.fileIndicesForPiece(piece);
+        const bool isPieceTrusted = std::all_of(fileIndices.cbegin(), fileIndices.cend()
+            , [&isTrusted](const int index) { return isTrusted[index]; });
+        if (isPieceTrusted && !verifiedPieces.contains(piece)) {
+            pieces[piece] = 1;
+            result.skippedBytes += torrentInfo.pieceLength(piece);
+        }
+        else if (verify(piece)) {
+            pieces[piece] = 1;
+        }
+    }
+    result.hashedBytes = verifier.hashedBytes();
+
+    resumeData["pieces"] = pieces;
+    resumeData["file_sizes"] = fileSizes;
+    resumeData["save_path"] = Utils::Fs::toNativePath(job.savePath).toStdString();
+    resumeData["seed_mode"] = 0;
+    // The torrent will be checked against its resume data and then paused
+    // to perform some service jobs on it, the same way as on restoring
+    resumeData["paused"] = 1;
+    resumeData["auto_managed"] = 1;
+    resumeData.dict().erase("unfinished");
+
+    libt::bencode(std::back_inserter(result.resumeData), resumeData);
+    emit finished(result);
+}
+
+void FastRecheckWorker::verifySample(const FastRecheckJob &job)
+{
+    const BitTorrent::TorrentInfo &torrentInfo = job.torrentInfo;
+    const libt::file_storage &files = torrentInfo.nativeInfo()->files();
+
+    // The first and the last piece of each file catch the files of the same
+    // size but of another content, as well as the misaligned ones
+    QVector<int> pieces;
+    for (int i = 0; i < torrentInfo.filesCount(); ++i) {
+        if (files.pad_file_at(i) || (torrentInfo.fileSize(i) == 0)) continue;
+
+        const BitTorrent::TorrentInfo::PieceRange filePieces = torrentInfo.filePieces(i);
+        pieces << filePieces.first() << filePieces.last();
+    }
+    std::sort(pieces.begin(), pieces.end());
+    pieces.erase(std::unique(pieces.begin(), pieces.end()), pieces.end());
+
+    if (pieces.size() > MAX_SAMPLED_PIECES) {
+        QVector<int> sample;
+        sample.reserve(MAX_SAMPLED_PIECES);
+        for (int i = 0; i < MAX_SAMPLED_PIECES; ++i)
+            sample << pieces[static_cast<int>(static_cast<qint64>(i) * (pieces.size() - 1) / (MAX_SAMPLED_PIECES - 1))];
+        pieces = sample;
+    }
+
+    PieceVerifier verifier(torrentInfo, job.savePath);
+    bool valid = !pieces.isEmpty();
+    for (const int piece : asConst(pieces)) {
+        if (m_aborted.load() || !verifier.verify(piece)) {
+            valid = false;
+            break;
+        }
+    }
+
+    emit sampleVerified(job.hash, valid);
+}
@@ -0,0 +1,101 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QMetaType>
+#include <QObject>
+#include <QString>
+
+#include "base/bittorrent/infohash.h"
+#include "base/bittorrent/torrentinfo.h"
+
+// What a file looked like when its pieces were last known to be complete
+struct FastRecheckFileStat
+{
+    qint64 size = -1; // -1 if the file doesn't exist
+    qint64 mtime = 0;
+    quint64 inode = 0; // 0 if unknown
+};
+
+struct FastRecheckJob
+{
+    BitTorrent::InfoHash hash;
+    // private copy, the one of the torrent can change while checking (e.g. on file rename)
+    BitTorrent::TorrentInfo torrentInfo;
+    QString savePath;
+    // up-to-date resume data, the verified pieces are added to it
+    QByteArray resumeData;
+    // resume data with the file stats recorded when the files were last known complete
+    QByteArray storedResumeData;
+};
+
+struct FastRecheckResult
+{
+    BitTorrent::InfoHash hash;
+    BitTorrent::TorrentInfo torrentInfo;
+    // resume data describing the verified pieces, empty if the job couldn't be done
+    QByteArray resumeData;
+    qint64 skippedBytes = 0;
+    qint64 hashedBytes = 0;
+};
+
+Q_DECLARE_METATYPE(FastRecheckJob)
+Q_DECLARE_METATYPE(FastRecheckResult)
+
+// Verifies torrent data using the file stats recorded in the resume data:
+// pieces of files that are unchanged since then (and whose sampled piece
+// matches its hash) are trusted, only the rest are read and hashed.
+class FastRecheckWorker : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(FastRecheckWorker)
+
+public:
+    FastRecheckWorker() = default;
+
+    static FastRecheckFileStat statFile(const QString &path);
+
+    // thread-safe, makes the current and all queued jobs end early
+    void abort();
+
+public slots:
+    void check(const FastRecheckJob &job);
+    // Checks a few pieces spread over all the files (no resume data needed),
+    // e.g. to tell whether some files found on disk are the torrent content
+    void verifySample(const FastRecheckJob &job);
+
+signals:
+    void finished(const FastRecheckResult &result);
+    void sampleVerified(const QString &hash, bool valid);
+
+private:
+    QAtomicInt m_aborted;
+};
@@ -0,0 +1,147 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "metadatacache.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include "base/logger.h"
+#include "base/utils/fs.h"
+
+MetadataCache::MetadataCache(const QString &folderPath, const qint64 maxSize)
+    : m_dir(folderPath)
+    , m_maxSize(maxSize)
+{
+    if (!m_dir.exists() && !m_dir.mkpath(m_dir.absolutePath())) {
+        Logger::instance()->addMessage(QString("Couldn't create metadata cache folder '%1'.")
+                                       .arg(m_dir.absolutePath()), Log::WARNING);
+        return;
+    }
+
+    // The files were last used when they were written as far as we can know
+    const QFileInfoList files = m_dir.entryInfoList(QStringList(QLatin1String("*.torrent")), QDir::Files, QDir::Unsorted);
+    for (const QFileInfo &file : files) {
+        const BitTorrent::InfoHash hash {file.completeBaseName()};
+        if (!hash.isValid()) continue;
+
+        m_entries.insert(hash, {file.size(), file.lastModified().toMSecsSinceEpoch()});
+        m_size += file.size();
+    }
+
+    prune();
+}
+
+BitTorrent::TorrentInfo MetadataCache::load(const BitTorrent::InfoHash &hash)
+{
+    const auto it = m_entries.find(hash);
+    if (it == m_entries.end()) {
+        ++m_misses;
+        return BitTorrent::TorrentInfo();
+    }
+
+    const BitTorrent::TorrentInfo info = BitTorrent::TorrentInfo::loadFromFile(filePath(hash));
+    if (!info.isValid() || (info.hash() != hash)) {
+        // damaged or removed behind our back
+        remove(hash);
+        ++m_misses;
+        return BitTorrent::TorrentInfo();
+    }
+
+    it->lastUsed = QDateTime::currentMSecsSinceEpoch();
+    ++m_hits;
+    return info;
+}
+
+void MetadataCache::store(const BitTorrent::TorrentInfo &info)
+{
+    if ((m_maxSize <= 0) || !info.isValid()) return;
+
+    const BitTorrent::InfoHash hash = info.hash();
+    if (m_entries.contains(hash)) return;
+
+    // The info dictionary is kept as is, so that its hash doesn't change
+    const QByteArray data = "d4:info" + info.metadata() + 'e';
+    if (data.size() > m_maxSize) return;
+
+    QSaveFile file {filePath(hash)};
+    if (!file.open(QIODevice::WriteOnly) || (file.write(data) != data.size()) || !file.commit()) {
+        Logger::instance()->addMessage(QString("Couldn't save metadata in '%1'. Error: %2")
+                                       .arg(file.fileName(), file.errorString()), Log::WARNING);
+        return;
+    }
+
+    m_entries.insert(hash, {data.size(), QDateTime::currentMSecsSinceEpoch()});
+    m_size += data.size();
+    prune();
+}
+
+void MetadataCache::setMaxSize(const qint64 maxSize)
+{
+    m_maxSize = maxSize;
+    prune();
+}
+
+MetadataCache::Statistics MetadataCache::statistics() const
+{
+    Statistics statistics;
+    statistics.hits = m_hits;
+    statistics.misses = m_misses;
+    statistics.entries = m_entries.size();
+    statistics.size = m_size;
+    return statistics;
+}
+
+QString MetadataCache::filePath(const BitTorrent::InfoHash &hash) const
+{
+    return m_dir.absoluteFilePath(QString("%1.torrent").arg(hash));
+}
+
+void MetadataCache::remove(const BitTorrent::InfoHash &hash)
+{
+    const auto it = m_entries.find(hash);
+    if (it == m_entries.end()) return;
+
+    m_size -= it->size;
+    m_entries.erase(it);
+    Utils::Fs::forceRemove(filePath(hash));
+}
+
+void MetadataCache::prune()
+{
+    while (!m_entries.isEmpty() && (m_size > m_maxSize)) {
+        auto oldest = m_entries.cbegin();
+        for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+            if (it->lastUsed < oldest->lastUsed)
+                oldest = it;
+        }
+        const BitTorrent::InfoHash hash = oldest.key();
+        remove(hash);
+    }
+}
@@ -0,0 +1,79 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QDir>
+#include <QHash>
+
+#include "base/bittorrent/infohash.h"
+#include "base/bittorrent/torrentinfo.h"
+
+// Keeps the metadata downloaded for the magnet links, one .torrent file
+// by info hash, so that adding the same magnet link again doesn't need
+// to download it from the swarm. The least recently used files are
+// removed when the cache outgrows its size limit.
+class MetadataCache
+{
+public:
+    struct Statistics
+    {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        int entries = 0;
+        qint64 size = 0; // bytes
+    };
+
+    MetadataCache(const QString &folderPath, qint64 maxSize);
+
+    // Returns an invalid TorrentInfo if the metadata isn't cached
+    BitTorrent::TorrentInfo load(const BitTorrent::InfoHash &hash);
+    void store(const BitTorrent::TorrentInfo &info);
+    // bytes, 0 disables the cache and clears it
+    void setMaxSize(qint64 maxSize);
+
+    Statistics statistics() const;
+
+private:
+    struct Entry
+    {
+        qint64 size;
+        qint64 lastUsed; // msecs since epoch
+    };
+
+    QString filePath(const BitTorrent::InfoHash &hash) const;
+    void remove(const BitTorrent::InfoHash &hash);
+    void prune();
+
+    QDir m_dir;
+    qint64 m_maxSize;
+    qint64 m_size = 0;
+    QHash<BitTorrent::InfoHash, Entry> m_entries;
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+};
@@ -0,0 +1,214 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "peerbehaviourtracker.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // progress is kept in units of 1/65535 of the torrent
+    const int PROGRESS_SCALE = 0xFFFF;
+
+    // A peer is judged once we sent it that much since the last judgement,
+    // less is within the pieces it has yet to complete
+    const qint64 MIN_JUDGED_UPLOAD = 16 * 1024 * 1024;
+    const int MIN_JUDGED_PIECES = 4;
+    // share of the sent data its progress has to grow by
+    const int MIN_PROGRESS_DIVIDER = 4;
+    // pieces a peer may lose from its bitfield, e.g. on a failed hash check
+    const int MAX_LOST_PIECES = 2;
+
+    const quint32 STALE_TIME = 10 * 60; // secs
+    const quint32 CLEANUP_INTERVAL = 60; // secs
+
+    enum PeerFlag : quint8
+    {
+        Flagged = 0x1,
+        InterestedSeed = 0x2
+    };
+}
+
+bool operator==(const PeerBehaviourTracker::Endpoint &left, const PeerBehaviourTracker::Endpoint &right)
+{
+    return (left.address[0] == right.address[0])
+            && (left.address[1] == right.address[1])
+            && (left.port == right.port);
+}
+
+uint qHash(const PeerBehaviourTracker::Endpoint &key, const uint seed)
+{
+    return ::qHash(key.address[0], seed) ^ ::qHash(key.address[1], seed) ^ ::qHash(key.port, seed);
+}
+
+PeerBehaviourTracker::PeerBehaviourTracker()
+{
+    m_clock.start();
+}
+
+PeerBehaviourTracker::Verdict PeerBehaviourTracker::observe(const QString &torrentHash, const QHostAddress &ip, const ushort port
+                                                            , const Observation &observation, const qint64 torrentSize, const int pieceLength)
+{
+    if ((torrentSize <= 0) || (pieceLength <= 0))
+        return Verdict::Normal;
+
+    const quint16 progress = static_cast<quint16>(qBound<qreal>(0, observation.progress, 1) * PROGRESS_SCALE);
+    const quint32 currentTime = now();
+
+    QHash<Endpoint, PeerState> &peers = m_torrents[torrentHash];
+    const Endpoint endpoint = toEndpoint(ip, port);
+    auto it = peers.find(endpoint);
+    if ((it == peers.end()) || (observation.totalUpload < it->baselineUpload)) {
+        // a new connection starts counting from scratch
+        PeerState state;
+        state.baselineUpload = observation.totalUpload;
+        state.lastSeen = currentTime;
+        state.baselineProgress = progress;
+        state.lastProgress = progress;
+        state.flags = 0;
+        if (it == peers.end())
+            peers.insert(endpoint, state);
+        else
+            *it = state;
+        return Verdict::Normal;
+    }
+
+    PeerState &state = *it;
+    state.lastSeen = currentTime;
+
+    // Pieces never disappear from a real peer, and a seed has nothing to be interested in.
+    // The latter has to be seen twice since "not interested" follows the last piece.
+    const qint64 lostBytes = (static_cast<qint64>(state.lastProgress) - progress) * torrentSize / PROGRESS_SCALE;
+    const bool isInterestedSeed = (progress == PROGRESS_SCALE) && observation.isRemoteInterested;
+    if ((lostBytes > (static_cast<qint64>(pieceLength) * MAX_LOST_PIECES))
+        || (isInterestedSeed && (state.flags & InterestedSeed))) {
+        peers.erase(it);
+        ++m_statistics.reported;
+        return Verdict::FakeProgress;
+    }
+    if (isInterestedSeed)
+        state.flags |= InterestedSeed;
+    else
+        state.flags &= ~InterestedSeed;
+    state.lastProgress = progress;
+
+    const qint64 judgedUpload = std::max(MIN_JUDGED_UPLOAD, (static_cast<qint64>(pieceLength) * MIN_JUDGED_PIECES));
+    const qint64 sent = observation.totalUpload - state.baselineUpload;
+    if (sent < judgedUpload)
+        return Verdict::Normal;
+
+    const qint64 gained = std::max(0, (progress - state.baselineProgress)) * torrentSize / PROGRESS_SCALE;
+    if ((gained * MIN_PROGRESS_DIVIDER) >= sent) {
+        if (state.flags & Flagged) {
+            state.flags &= ~Flagged;
+            ++m_statistics.falsePositives;
+        }
+        state.baselineUpload = observation.totalUpload;
+        state.baselineProgress = progress;
+        return Verdict::Normal;
+    }
+
+    if (!(state.flags & Flagged)) {
+        state.flags |= Flagged;
+        ++m_statistics.flagged;
+        return Verdict::Normal;
+    }
+
+    if (sent < (judgedUpload * 2))
+        return Verdict::Normal;
+
+    peers.erase(it);
+    ++m_statistics.reported;
+    return Verdict::Leecher;
+}
+
+void PeerBehaviourTracker::forgetTorrent(const QString &torrentHash)
+{
+    m_torrents.remove(torrentHash);
+}
+
+void PeerBehaviourTracker::clear()
+{
+    m_torrents.clear();
+}
+
+void PeerBehaviourTracker::removeStale()
+{
+    const quint32 currentTime = now();
+    if ((currentTime - m_lastCleanup) < CLEANUP_INTERVAL)
+        return;
+    m_lastCleanup = currentTime;
+
+    for (auto torrentIt = m_torrents.begin(); torrentIt != m_torrents.end();) {
+        QHash<Endpoint, PeerState> &peers = torrentIt.value();
+        for (auto it = peers.begin(); it != peers.end();) {
+            if ((currentTime - it->lastSeen) > STALE_TIME)
+                it = peers.erase(it);
+            else
+                ++it;
+        }
+
+        if (peers.isEmpty())
+            torrentIt = m_torrents.erase(torrentIt);
+        else
+            ++torrentIt;
+    }
+}
+
+PeerBehaviourTracker::Statistics PeerBehaviourTracker::statistics() const
+{
+    Statistics statistics = m_statistics;
+    statistics.trackedPeers = 0;
+    for (const QHash<Endpoint, PeerState> &peers : m_torrents)
+        statistics.trackedPeers += peers.size();
+    return statistics;
+}
+
+PeerBehaviourTracker::Endpoint PeerBehaviourTracker::toEndpoint(const QHostAddress &ip, const ushort port)
+{
+    Endpoint endpoint;
+    bool isIPv4 = false;
+    const quint32 ipv4 = ip.toIPv4Address(&isIPv4);
+    if (isIPv4) {
+        // stored as an IPv4-mapped IPv6 address
+        endpoint.address[0] = 0;
+        endpoint.address[1] = Q_UINT64_C(0xFFFF00000000) | ipv4;
+    }
+    else {
+        const Q_IPV6ADDR ipv6 = ip.toIPv6Address();
+        std::memcpy(endpoint.address, ipv6.c, sizeof(endpoint.address));
+    }
+    endpoint.port = port;
+    return endpoint;
+}
+
+quint32 PeerBehaviourTracker::now() const
+{
+    return static_cast<quint32>(m_clock.elapsed() / 1000);
+}
@@ -0,0 +1,105 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QString>
+
+// Tells leeching and fake peers from their behaviour rather than from their ID:
+// it compares the bytes we sent to a peer with the growth of the progress it
+// reports, and checks that the reported progress stays possible.
+// A peer that gets data without its progress growing is flagged first and only
+// reported when that goes on for as much data again, a flagged peer that
+// catches up counts as a false positive.
+class PeerBehaviourTracker
+{
+public:
+    enum class Verdict
+    {
+        Normal,
+        Leecher,
+        FakeProgress
+    };
+
+    struct Observation
+    {
+        qreal progress = 0;
+        qint64 totalUpload = 0; // bytes we sent over the current connection
+        bool isRemoteInterested = false;
+    };
+
+    struct Statistics
+    {
+        int trackedPeers = 0;
+        quint64 flagged = 0;
+        quint64 reported = 0;
+        quint64 falsePositives = 0;
+    };
+
+    PeerBehaviourTracker();
+
+    // torrentSize and pieceLength are those of the torrent the peer is connected for
+    Verdict observe(const QString &torrentHash, const QHostAddress &ip, ushort port
+                    , const Observation &observation, qint64 torrentSize, int pieceLength);
+    void forgetTorrent(const QString &torrentHash);
+    void clear();
+    // Forgets the peers that weren't observed for a while
+    void removeStale();
+
+    Statistics statistics() const;
+
+private:
+    struct Endpoint
+    {
+        quint64 address[2];
+        quint16 port;
+    };
+
+    struct PeerState
+    {
+        qint64 baselineUpload;
+        quint32 lastSeen; // secs
+        quint16 baselineProgress;
+        quint16 lastProgress;
+        quint8 flags;
+    };
+
+    friend bool operator==(const Endpoint &left, const Endpoint &right);
+    friend uint qHash(const Endpoint &key, uint seed);
+
+    static Endpoint toEndpoint(const QHostAddress &ip, ushort port);
+    quint32 now() const;
+
+    QHash<QString, QHash<Endpoint, PeerState>> m_torrents;
+    QElapsedTimer m_clock;
+    quint32 m_lastCleanup = 0;
+    Statistics m_statistics;
+};
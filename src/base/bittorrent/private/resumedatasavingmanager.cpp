@@ -28,11 +28,20 @@
 
 #include "resumedatasavingmanager.h"
 
+#include <iterator>
+
 #include <QDebug>
+#include <QFile>
 #include <QSaveFile>
 
+#include <libtorrent/bencode.hpp>
+#include <libtorrent/entry.hpp>
+
 #include "base/logger.h"
 #include "base/utils/fs.h"
+#include "fastrecheckworker.h"
+
+namespace libt = libtorrent;
 
 ResumeDataSavingManager::ResumeDataSavingManager(const QString &resumeFolderPath)
     : m_resumeDataDir(resumeFolderPath)
@@ -53,9 +62,86 @@ void ResumeDataSavingManager::save(const QString &filename, const QByteArray &da
     }
 }
 
+void ResumeDataSavingManager::saveWithFileStats(const QString &filename, const QByteArray &data
+                                                , const QString &savePath, const QStringList &filePaths) const
+{
+    libt::entry resumeData = libt::bdecode(data.constData(), (data.constData() + data.size()));
+    if (resumeData.type() != libt::entry::dictionary_t) {
+        save(filename, data);
+        return;
+    }
+
+    const QDir saveDir(savePath);
+    libt::entry::list_type fileStats;
+    for (const QString &filePath : filePaths) {
+        libt::entry::list_type fileStat;
+        if (!filePath.isEmpty()) {
+            const FastRecheckFileStat stat = FastRecheckWorker::statFile(saveDir.absoluteFilePath(filePath));
+            if (stat.size >= 0)
+                fileStat = {stat.size, stat.mtime, static_cast<libt::entry::integer_type>(stat.inode)};
+        }
+        fileStats.push_back(fileStat);
+    }
+
+    resumeData["qBt-fileStats"] = fileStats;
+    resumeData["qBt-fileStatsPath"] = savePath.toStdString();
+
+    QByteArray out;
+    libt::bencode(std::back_inserter(out), resumeData);
+    save(filename, out);
+}
+
 void ResumeDataSavingManager::remove(const QString &filename) const
 {
     const QString filepath = m_resumeDataDir.absoluteFilePath(filename);
 
     Utils::Fs::forceRemove(filepath);
 }
+
+void ResumeDataSavingManager::saveTorrentFile(const QString &filename, const BitTorrent::TorrentInfo &torrentInfo)
+{
+    m_pendingTorrentFiles.ref();
+    QMetaObject::invokeMethod(this, "doSaveTorrentFile", Qt::QueuedConnection
+                              , Q_ARG(QString, filename), Q_ARG(BitTorrent::TorrentInfo, torrentInfo));
+}
+
+void ResumeDataSavingManager::exportTorrentFile(const QString &filename, const QString &folderPath, const QString &name)
+{
+    m_pendingTorrentFiles.ref();
+    QMetaObject::invokeMethod(this, "doExportTorrentFile", Qt::QueuedConnection
+                              , Q_ARG(QString, filename), Q_ARG(QString, folderPath), Q_ARG(QString, name));
+}
+
+int ResumeDataSavingManager::pendingTorrentFiles() const
+{
+    return m_pendingTorrentFiles.load();
+}
+
+void ResumeDataSavingManager::doSaveTorrentFile(const QString &filename, const BitTorrent::TorrentInfo &torrentInfo)
+{
+    const QByteArray data = torrentInfo.torrentFileData();
+    if (data.isEmpty())
+        Logger::instance()->addMessage(QString("Couldn't save '%1'").arg(filename), Log::CRITICAL);
+    else
+        save(filename, data);
+    m_pendingTorrentFiles.deref();
+}
+
+void ResumeDataSavingManager::doExportTorrentFile(const QString &filename, const QString &folderPath, const QString &name)
+{
+    const QString torrentPath = m_resumeDataDir.absoluteFilePath(filename);
+    const QDir exportDir {folderPath};
+    if (exportDir.exists() || exportDir.mkpath(exportDir.absolutePath())) {
+        QString newTorrentPath = exportDir.absoluteFilePath(QString("%1.torrent").arg(name));
+        int counter = 0;
+        while (QFile::exists(newTorrentPath) && !Utils::Fs::sameFiles(torrentPath, newTorrentPath)) {
+            // Append number to torrent name to make it unique
+            newTorrentPath = exportDir.absoluteFilePath(QString("%1 %2.torrent").arg(name).arg(++counter));
+        }
+
+        if (!QFile::exists(newTorrentPath))
+            QFile::copy(torrentPath, newTorrentPath);
+    }
+
+    m_pendingTorrentFiles.deref();
+}
@@ -28,9 +28,13 @@
 
 #pragma once
 
+#include <QAtomicInt>
 #include <QByteArray>
 #include <QDir>
 #include <QObject>
+#include <QStringList>
+
+#include "base/bittorrent/torrentinfo.h"
 
 class ResumeDataSavingManager : public QObject
 {
@@ -40,10 +44,27 @@ class ResumeDataSavingManager : public QObject
 public:
     explicit ResumeDataSavingManager(const QString &resumeFolderPath);
 
+    // The .torrent file writes are queued to the thread of the manager
+    // and counted until they are done, these are safe to call from any thread
+    // The file data is generated here, torrentInfo must not be shared with libtorrent
+    void saveTorrentFile(const QString &filename, const BitTorrent::TorrentInfo &torrentInfo);
+    // Copies a saved .torrent file to the folder, named after the torrent
+    void exportTorrentFile(const QString &filename, const QString &folderPath, const QString &name);
+    int pendingTorrentFiles() const;
+
 public slots:
     void save(const QString &filename, const QByteArray &data) const;
+    // Records the stats of the complete files of a torrent in its resume data before saving it,
+    // see FastRecheckWorker. `filePaths` are relative to `savePath`, empty for incomplete files.
+    void saveWithFileStats(const QString &filename, const QByteArray &data
+                           , const QString &savePath, const QStringList &filePaths) const;
     void remove(const QString &filename) const;
 
+private slots:
+    void doSaveTorrentFile(const QString &filename, const BitTorrent::TorrentInfo &torrentInfo);
+    void doExportTorrentFile(const QString &filename, const QString &folderPath, const QString &name);
+
 private:
     QDir m_resumeDataDir;
+    QAtomicInt m_pendingTorrentFiles;
 };
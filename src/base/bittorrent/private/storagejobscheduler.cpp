@@ -0,0 +1,264 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "storagejobscheduler.h"
+
+#include <algorithm>
+
+#include <QDir>
+
+#include "base/global.h"
+
+namespace
+{
+    // the mounted volumes are listed again after that long
+    const qint64 VOLUMES_UPDATE_INTERVAL = 60 * 1000; // msecs
+
+#if defined(Q_OS_WIN) || defined(Q_OS_OS2)
+    const Qt::CaseSensitivity CASE_SENSITIVITY = Qt::CaseInsensitive;
+#else
+    const Qt::CaseSensitivity CASE_SENSITIVITY = Qt::CaseSensitive;
+#endif
+
+    bool isInFolder(const QString &path, QString folderPath)
+    {
+        if (!folderPath.endsWith('/'))
+            folderPath += '/';
+        return (path + '/').startsWith(folderPath, CASE_SENSITIVITY);
+    }
+}
+
+StorageJobScheduler::StorageJobScheduler()
+{
+    m_clock.start();
+}
+
+int StorageJobScheduler::addJob(BitTorrent::StorageJob job)
+{
+    job.id = ++m_lastJobId;
+    job.doneSize = 0;
+    job.isRunning = false;
+
+    Job &queuedJob = m_jobs[job.id];
+    queuedJob.info = job;
+    const QString sourceDevice = device(job.sourcePath);
+    queuedJob.devices << sourceDevice;
+    if (job.type == BitTorrent::StorageJob::Move) {
+        const QString destinationDevice = device(job.destinationPath);
+        if (destinationDevice != sourceDevice) {
+            queuedJob.devices << destinationDevice;
+            queuedJob.isCopy = true;
+        }
+    }
+
+    m_torrentJobs[job.hash] = job.id;
+    return job.id;
+}
+
+QList<BitTorrent::StorageJob> StorageJobScheduler::takeStartableJobs()
+{
+    refillBudget();
+
+    QList<Job *> queuedJobs;
+    for (Job &job : m_jobs) {
+        if (!job.info.isRunning)
+            queuedJobs << &job;
+    }
+    // the jobs of a same priority stay in the order they were added
+    std::stable_sort(queuedJobs.begin(), queuedJobs.end(), [](const Job *left, const Job *right)
+    {
+        return (left->info.priority > right->info.priority);
+    });
+
+    QList<BitTorrent::StorageJob> startableJobs;
+    for (Job *job : asConst(queuedJobs)) {
+        if (!canStart(*job)) continue;
+
+        job->info.isRunning = true;
+        for (const QString &device : asConst(job->devices))
+            ++m_runningJobsByDevice[device];
+        if (job->isCopy && (m_rateLimit > 0))
+            m_budget -= job->info.size;
+        startableJobs << job->info;
+    }
+
+    return startableJobs;
+}
+
+void StorageJobScheduler::finishJob(const int id)
+{
+    const auto it = m_jobs.find(id);
+    if (it == m_jobs.end()) return;
+
+    if (it->info.isRunning) {
+        for (const QString &device : asConst(it->devices)) {
+            if (--m_runningJobsByDevice[device] <= 0)
+                m_runningJobsByDevice.remove(device);
+        }
+    }
+
+    m_finishedSize += it->info.size;
+    if (m_torrentJobs.value(it->info.hash) == id)
+        m_torrentJobs.remove(it->info.hash);
+    m_jobs.erase(it);
+
+    if (m_jobs.isEmpty())
+        m_finishedSize = 0;
+}
+
+bool StorageJobScheduler::cancelJob(const int id)
+{
+    const auto it = m_jobs.find(id);
+    if ((it == m_jobs.end()) || it->info.isRunning) return false;
+
+    if (m_torrentJobs.value(it->info.hash) == id)
+        m_torrentJobs.remove(it->info.hash);
+    m_jobs.erase(it);
+
+    if (m_jobs.isEmpty())
+        m_finishedSize = 0;
+    return true;
+}
+
+bool StorageJobScheduler::setJobPriority(const int id, const int priority)
+{
+    const auto it = m_jobs.find(id);
+    if (it == m_jobs.end()) return false;
+
+    it->info.priority = priority;
+    return true;
+}
+
+void StorageJobScheduler::setJobProgress(const int id, const qint64 doneSize)
+{
+    const auto it = m_jobs.find(id);
+    if (it == m_jobs.end()) return;
+
+    it->info.doneSize = qBound<qint64>(0, doneSize, it->info.size);
+}
+
+int StorageJobScheduler::findJob(const BitTorrent::InfoHash &hash) const
+{
+    return m_torrentJobs.value(hash);
+}
+
+BitTorrent::StorageJob StorageJobScheduler::job(const int id) const
+{
+    return m_jobs.value(id).info;
+}
+
+QList<BitTorrent::StorageJob> StorageJobScheduler::jobs() const
+{
+    QList<BitTorrent::StorageJob> jobs;
+    jobs.reserve(m_jobs.size());
+    for (const Job &job : m_jobs)
+        jobs << job.info;
+    return jobs;
+}
+
+bool StorageJobScheduler::isEmpty() const
+{
+    return m_jobs.isEmpty();
+}
+
+BitTorrent::StorageQueueStatus StorageJobScheduler::status() const
+{
+    BitTorrent::StorageQueueStatus status;
+    status.totalSize = m_finishedSize;
+    status.doneSize = m_finishedSize;
+    for (const Job &job : m_jobs) {
+        if (job.info.isRunning)
+            ++status.running;
+        else
+            ++status.queued;
+        status.totalSize += job.info.size;
+        status.doneSize += job.info.doneSize;
+    }
+
+    return status;
+}
+
+void StorageJobScheduler::setMaxJobsPerDevice(const int max)
+{
+    m_maxJobsPerDevice = std::max(1, max);
+}
+
+void StorageJobScheduler::setRateLimit(const qint64 limit)
+{
+    refillBudget();
+    m_rateLimit = std::max<qint64>(0, limit);
+    if (m_rateLimit == 0)
+        m_budget = 0;
+}
+
+QString StorageJobScheduler::device(const QString &path)
+{
+    const qint64 now = m_clock.elapsed();
+    if (m_volumes.isEmpty() || ((now - m_volumesUpdateTime) > VOLUMES_UPDATE_INTERVAL)) {
+        m_volumes = QStorageInfo::mountedVolumes();
+        m_volumesUpdateTime = now;
+    }
+
+    // the path is held by the volume mounted the deepest in it
+    const QString cleanPath = QDir::cleanPath(QDir::fromNativeSeparators(path));
+    const QStorageInfo *volume = nullptr;
+    for (const QStorageInfo &candidate : asConst(m_volumes)) {
+        if (!isInFolder(cleanPath, candidate.rootPath())) continue;
+        if (!volume || (candidate.rootPath().size() > volume->rootPath().size()))
+            volume = &candidate;
+    }
+
+    if (!volume) return QString();
+    // network volumes may have no device name
+    return volume->device().isEmpty() ? volume->rootPath() : QString::fromLocal8Bit(volume->device());
+}
+
+bool StorageJobScheduler::canStart(const Job &job) const
+{
+    if (job.isCopy && (m_rateLimit > 0) && (m_budget < 0))
+        return false;
+
+    for (const QString &device : job.devices) {
+        if (m_runningJobsByDevice.value(device) >= m_maxJobsPerDevice)
+            return false;
+    }
+
+    return true;
+}
+
+void StorageJobScheduler::refillBudget()
+{
+    const qint64 now = m_clock.elapsed();
+    // the unused rate doesn't pile up beyond a second of copying
+    // (in floating point, as the elapsed msecs times a large limit overflow)
+    if (m_rateLimit > 0) {
+        const double refill = (now - m_lastRefill) * (m_rateLimit / 1000.);
+        m_budget += static_cast<qint64>(std::min(refill, static_cast<double>(m_rateLimit - m_budget)));
+    }
+    m_lastRefill = now;
+}
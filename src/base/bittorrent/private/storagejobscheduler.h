@@ -0,0 +1,98 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QStorageInfo>
+#include <QString>
+#include <QStringList>
+
+#include "base/bittorrent/infohash.h"
+#include "base/bittorrent/session.h"
+
+// Queues the moves and removals of torrent files and decides which ones may run:
+// at most a few at once on every storage device, in priority order, and the
+// moves across devices no faster on average than the rate limit.
+// libtorrent copies the files itself and can't be throttled, so the rate limit
+// delays the start of the next copy until the bytes of the previous ones are paid for.
+class StorageJobScheduler
+{
+public:
+    StorageJobScheduler();
+
+    // Returns the id given to the job
+    int addJob(BitTorrent::StorageJob job);
+    // Marks the queued jobs allowed to run now as running and returns them
+    QList<BitTorrent::StorageJob> takeStartableJobs();
+    void finishJob(int id);
+    // Only the queued jobs can be cancelled
+    bool cancelJob(int id);
+    bool setJobPriority(int id, int priority);
+    void setJobProgress(int id, qint64 doneSize);
+
+    // 0 if the torrent has no job
+    int findJob(const BitTorrent::InfoHash &hash) const;
+    BitTorrent::StorageJob job(int id) const;
+    QList<BitTorrent::StorageJob> jobs() const;
+    bool isEmpty() const;
+    // Counts the jobs finished since the queue was last empty too
+    BitTorrent::StorageQueueStatus status() const;
+
+    void setMaxJobsPerDevice(int max);
+    // bytes per second, 0 if unlimited
+    void setRateLimit(qint64 limit);
+
+private:
+    struct Job
+    {
+        BitTorrent::StorageJob info;
+        QStringList devices;
+        bool isCopy = false; // moves across devices, paid for against the rate limit
+    };
+
+    QString device(const QString &path);
+    bool canStart(const Job &job) const;
+    void refillBudget();
+
+    QMap<int, Job> m_jobs; // by id, i.e. in the order they were added
+    QHash<BitTorrent::InfoHash, int> m_torrentJobs;
+    QHash<QString, int> m_runningJobsByDevice;
+    int m_lastJobId = 0;
+    int m_maxJobsPerDevice = 1;
+    qint64 m_rateLimit = 0;
+    qint64 m_budget = 0; // bytes the rate limit lets be copied now, may be negative
+    qint64 m_lastRefill = 0;
+    qint64 m_finishedSize = 0;
+    QList<QStorageInfo> m_volumes;
+    qint64 m_volumesUpdateTime = 0;
+    QElapsedTimer m_clock;
+};
@@ -0,0 +1,66 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "storageworker.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#include "base/utils/fs.h"
+
+void StorageWorker::removeFolderTree(const int jobId, const QString &path)
+{
+    if (!path.isEmpty())
+        Utils::Fs::smartRemoveEmptyFolderTree(path);
+
+    emit folderTreeRemoved(jobId);
+}
+
+void StorageWorker::removeFiles(const QStringList &filePaths)
+{
+    for (const QString &filePath : filePaths) {
+        qDebug("Removing unwanted file: %s", qUtf8Printable(filePath));
+        Utils::Fs::forceRemove(filePath);
+        const QString parentFolder = Utils::Fs::branchPath(filePath);
+        qDebug("Attempt to remove parent folder (if empty): %s", qUtf8Printable(parentFolder));
+        QDir().rmdir(parentFolder);
+    }
+}
+
+void StorageWorker::measure(const int jobId, const QString &folderPath, const QStringList &filePaths)
+{
+    const QDir folder(folderPath);
+    qint64 size = 0;
+    for (const QString &filePath : filePaths) {
+        const QFileInfo fileInfo(folder.absoluteFilePath(filePath));
+        if (fileInfo.isFile())
+            size += fileInfo.size();
+    }
+
+    emit measured(jobId, size);
+}
@@ -0,0 +1,56 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+// Does the file system work of the storage jobs away from the main thread
+class StorageWorker : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(StorageWorker)
+
+public:
+    StorageWorker() = default;
+
+public slots:
+    // Removes what is left of the folder tree once its files are deleted,
+    // jobId may be 0 if no job waits for it
+    void removeFolderTree(int jobId, const QString &path);
+    // Removes the files along with their parent folder if left empty
+    void removeFiles(const QStringList &filePaths);
+    // Sums the sizes of the files found in the folder
+    void measure(int jobId, const QString &folderPath, const QStringList &filePaths);
+
+signals:
+    void folderTreeRemoved(int jobId);
+    void measured(int jobId, qint64 size);
+};
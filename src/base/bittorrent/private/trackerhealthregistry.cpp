@@ -0,0 +1,190 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "trackerhealthregistry.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QVector>
+
+namespace
+{
+    // weight of the latest announce in the smoothed values
+    const qreal SMOOTHING = 0.1;
+    // latency that halves the score
+    const qreal REFERENCE_LATENCY = 1000; // msecs
+
+    const int DEAD_FAILURES = 10;
+    const qint64 DEAD_TIME = 6 * 60 * 60 * 1000; // msecs
+    // a dead tracker is given another chance after that
+    const qint64 RETRY_TIME = 24 * 60 * 60 * 1000; // msecs
+    const qint64 ANNOUNCE_TIMEOUT = 5 * 60 * 1000; // msecs
+
+    const int EXPLORED_TRACKERS = 2;
+
+    qreal smooth(const qreal value, const qreal sample)
+    {
+        return value + (SMOOTHING * (sample - value));
+    }
+}
+
+TrackerHealthRegistry::TrackerHealthRegistry()
+{
+    m_clock.start();
+}
+
+void TrackerHealthRegistry::addAnnounce(const QString &trackerUrl, const QString &torrentHash)
+{
+    m_pendingAnnounces[qMakePair(trackerUrl, torrentHash)] = m_clock.elapsed();
+}
+
+void TrackerHealthRegistry::addReply(const QString &trackerUrl, const QString &torrentHash, const int numPeers)
+{
+    const qint64 now = m_clock.elapsed();
+    Entry &entry = m_entries[trackerUrl];
+
+    const qint64 announceTime = m_pendingAnnounces.take(qMakePair(trackerUrl, torrentHash));
+    if (announceTime > 0) {
+        const qreal latency = now - announceTime;
+        entry.latency = (entry.latency < 0) ? latency : smooth(entry.latency, latency);
+    }
+
+    ++entry.replies;
+    entry.failureStreak = 0;
+    entry.successRate = smooth(entry.successRate, 1);
+    entry.peers = smooth(entry.peers, numPeers);
+    entry.failingSince = -1;
+    entry.lastResult = now;
+}
+
+void TrackerHealthRegistry::addFailure(const QString &trackerUrl, const QString &torrentHash)
+{
+    const qint64 now = m_clock.elapsed();
+    Entry &entry = m_entries[trackerUrl];
+
+    m_pendingAnnounces.remove(qMakePair(trackerUrl, torrentHash));
+
+    ++entry.failures;
+    ++entry.failureStreak;
+    entry.successRate = smooth(entry.successRate, 0);
+    if (entry.failingSince < 0)
+        entry.failingSince = now;
+    entry.lastResult = now;
+}
+
+void TrackerHealthRegistry::removeExpiredAnnounces()
+{
+    const qint64 now = m_clock.elapsed();
+    for (auto it = m_pendingAnnounces.begin(); it != m_pendingAnnounces.end();) {
+        if ((now - it.value()) > ANNOUNCE_TIMEOUT)
+            it = m_pendingAnnounces.erase(it);
+        else
+            ++it;
+    }
+}
+
+BitTorrent::TrackerHealth TrackerHealthRegistry::health(const QString &trackerUrl) const
+{
+    const auto it = m_entries.constFind(trackerUrl);
+    return (it != m_entries.constEnd()) ? toHealth(it.value()) : BitTorrent::TrackerHealth();
+}
+
+QHash<QString, BitTorrent::TrackerHealth> TrackerHealthRegistry::trackers() const
+{
+    QHash<QString, BitTorrent::TrackerHealth> result;
+    result.reserve(m_entries.size());
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it)
+        result.insert(it.key(), toHealth(it.value()));
+    return result;
+}
+
+QStringList TrackerHealthRegistry::select(const QStringList &candidates, const int count) const
+{
+    if ((count <= 0) || (candidates.size() <= count))
+        return candidates;
+
+    QVector<QPair<qreal, QString>> scored;
+    QStringList untried;
+    for (const QString &trackerUrl : candidates) {
+        if (isUntried(trackerUrl)) {
+            untried << trackerUrl;
+            continue;
+        }
+
+        const BitTorrent::TrackerHealth trackerHealth = health(trackerUrl);
+        if (!trackerHealth.isDead)
+            scored.append(qMakePair(trackerHealth.score, trackerUrl));
+    }
+    std::stable_sort(scored.begin(), scored.end()
+                     , [](const QPair<qreal, QString> &left, const QPair<qreal, QString> &right)
+    {
+        return (left.first > right.first);
+    });
+
+    const int exploredCount = std::min(EXPLORED_TRACKERS, untried.size());
+    QStringList selected;
+    for (int i = 0; (i < scored.size()) && (selected.size() < (count - exploredCount)); ++i)
+        selected << scored[i].second;
+    for (int i = 0; (i < untried.size()) && (selected.size() < count); ++i)
+        selected << untried[i];
+
+    return selected;
+}
+
+BitTorrent::TrackerHealth TrackerHealthRegistry::toHealth(const Entry &entry) const
+{
+    BitTorrent::TrackerHealth trackerHealth;
+    trackerHealth.replies = entry.replies;
+    trackerHealth.failures = entry.failures;
+    trackerHealth.successRate = entry.successRate;
+    trackerHealth.latency = (entry.latency < 0) ? -1 : qRound(entry.latency);
+    trackerHealth.peers = entry.peers;
+    trackerHealth.isDead = isDead(entry);
+    if (!trackerHealth.isDead) {
+        const qreal latency = std::max<qreal>(entry.latency, 0);
+        trackerHealth.score = entry.successRate * (1 + std::log2(1 + entry.peers))
+                * REFERENCE_LATENCY / (REFERENCE_LATENCY + latency);
+    }
+    return trackerHealth;
+}
+
+bool TrackerHealthRegistry::isDead(const Entry &entry) const
+{
+    return (entry.failingSince >= 0) && (entry.failureStreak >= DEAD_FAILURES)
+            && ((m_clock.elapsed() - entry.failingSince) >= DEAD_TIME);
+}
+
+bool TrackerHealthRegistry::isUntried(const QString &trackerUrl) const
+{
+    const auto it = m_entries.constFind(trackerUrl);
+    if (it == m_entries.constEnd())
+        return true;
+
+    return isDead(it.value()) && ((m_clock.elapsed() - it->lastResult) >= RETRY_TIME);
+}
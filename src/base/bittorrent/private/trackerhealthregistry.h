@@ -0,0 +1,82 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+
+#include "base/bittorrent/session.h"
+
+// Scores the trackers by the outcome of the announces of all the torrents:
+// the share of them that succeed, how long they take and how many peers
+// they return. A tracker that keeps failing for hours is reported dead.
+class TrackerHealthRegistry
+{
+public:
+    TrackerHealthRegistry();
+
+    void addAnnounce(const QString &trackerUrl, const QString &torrentHash);
+    void addReply(const QString &trackerUrl, const QString &torrentHash, int numPeers);
+    void addFailure(const QString &trackerUrl, const QString &torrentHash);
+    // Forgets the announces that never got an answer, e.g. of removed torrents
+    void removeExpiredAnnounces();
+
+    BitTorrent::TrackerHealth health(const QString &trackerUrl) const;
+    QHash<QString, BitTorrent::TrackerHealth> trackers() const;
+
+    // Picks up to count of the candidates: the best scored ones and a few untried
+    // ones (never used or dead for long), so that they get the chance to be scored.
+    // All the candidates are picked if count is 0.
+    QStringList select(const QStringList &candidates, int count) const;
+
+private:
+    struct Entry
+    {
+        quint64 replies = 0;
+        quint64 failures = 0;
+        int failureStreak = 0;
+        qreal successRate = 0.5;
+        qreal latency = -1; // msecs, -1 if unknown
+        qreal peers = 0;
+        qint64 failingSince = -1; // msecs, -1 if the last announce succeeded
+        qint64 lastResult = -1;
+    };
+
+    BitTorrent::TrackerHealth toHealth(const Entry &entry) const;
+    bool isDead(const Entry &entry) const;
+    bool isUntried(const QString &trackerUrl) const;
+
+    QHash<QString, Entry> m_entries;
+    // announce start time by tracker and torrent
+    QHash<QPair<QString, QString>, qint64> m_pendingAnnounces;
+    QElapsedTimer m_clock;
+};
@@ -0,0 +1,108 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "uploadratecontroller.h"
+
+#include <algorithm>
+
+namespace
+{
+    const qint64 WINDOW_DURATION = 5 * 1000; // msecs
+    // fewer delay samples than that are too few uTP packets to tell anything
+    const qint64 MIN_DELAY_SAMPLES = 20;
+
+    // share of the delay samples above the target
+    const qreal CONGESTED_RATIO = 0.5;
+    const qreal UNCONGESTED_RATIO = 0.1;
+
+    // The limit is cut below the rate that caused the delay to drain the queue,
+    // it is raised slowly as long as the link keeps up with it
+    const qreal DECREASE_FACTOR = 0.8;
+    const int INCREASE_DIVIDER = 20;
+    const int MIN_INCREASE = 4 * 1024;
+    // the rate reaches that share of the limit when the limit holds it back
+    const qreal LIMITED_RATIO = 0.85;
+}
+
+void UploadRateController::reset(const int minLimit)
+{
+    m_minLimit = std::max(minLimit, 1);
+    m_limit = 0;
+    m_hasLastSample = false;
+    m_windowTimer.invalidate();
+    m_windowAbove = 0;
+    m_windowBelow = 0;
+    m_windowRate = 0;
+    m_windowSamples = 0;
+}
+
+int UploadRateController::limit() const
+{
+    return m_limit;
+}
+
+bool UploadRateController::addSample(const Sample &sample)
+{
+    if (m_hasLastSample) {
+        m_windowAbove += std::max<qint64>(0, (sample.samplesAboveTarget - m_lastSample.samplesAboveTarget));
+        m_windowBelow += std::max<qint64>(0, (sample.samplesBelowTarget - m_lastSample.samplesBelowTarget));
+    }
+    m_lastSample = sample;
+    m_hasLastSample = true;
+    m_windowRate += sample.uploadRate;
+    ++m_windowSamples;
+
+    if (!m_windowTimer.isValid())
+        m_windowTimer.start();
+    if (m_windowTimer.elapsed() < WINDOW_DURATION)
+        return false;
+
+    const int oldLimit = m_limit;
+    const int rate = static_cast<int>(m_windowRate / m_windowSamples);
+    const qint64 samples = m_windowAbove + m_windowBelow;
+    if (samples >= MIN_DELAY_SAMPLES) {
+        const qreal congestion = static_cast<qreal>(m_windowAbove) / samples;
+        if (congestion > CONGESTED_RATIO) {
+            const int base = (m_limit > 0) ? std::min(m_limit, rate) : rate;
+            m_limit = std::max(static_cast<int>(base * DECREASE_FACTOR), m_minLimit);
+        }
+        else if ((congestion < UNCONGESTED_RATIO) && (m_limit > 0) && (rate >= (m_limit * LIMITED_RATIO))) {
+            m_limit += std::max((m_limit / INCREASE_DIVIDER), MIN_INCREASE);
+        }
+    }
+
+    if ((sample.maxLimit > 0) && (m_limit > 0))
+        m_limit = std::max(std::min(m_limit, sample.maxLimit), std::min(m_minLimit, sample.maxLimit));
+
+    m_windowAbove = 0;
+    m_windowBelow = 0;
+    m_windowRate = 0;
+    m_windowSamples = 0;
+    m_windowTimer.start();
+    return (m_limit != oldLimit);
+}
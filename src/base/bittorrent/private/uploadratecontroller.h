@@ -0,0 +1,68 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+// Feedback loop that keeps the queueing delay of the uplink under the uTP target
+// by limiting the upload rate. The delay is estimated from the uTP delay samples
+// of the session statistics: when most of them are above the target, the link is
+// saturated and the limit is cut, else it is raised while the limit is reached.
+class UploadRateController
+{
+public:
+    struct Sample
+    {
+        // cumulative counters
+        qint64 samplesAboveTarget = 0;
+        qint64 samplesBelowTarget = 0;
+        int uploadRate = 0; // bytes per second, including the overhead
+        int maxLimit = 0; // bytes per second, 0 if none
+    };
+
+    void reset(int minLimit);
+    // bytes per second, 0 if not limiting
+    int limit() const;
+
+    // Returns true if the limit was changed
+    bool addSample(const Sample &sample);
+
+private:
+    int m_minLimit = 0;
+    int m_limit = 0;
+
+    Sample m_lastSample;
+    bool m_hasLastSample = false;
+    QElapsedTimer m_windowTimer;
+    qint64 m_windowAbove = 0;
+    qint64 m_windowBelow = 0;
+    qint64 m_windowRate = 0;
+    int m_windowSamples = 0;
+};
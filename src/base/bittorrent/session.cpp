@@ -31,7 +31,8 @@
 
 #include <algorithm>
 #include <cstdlib>
-#include <queue>
+#include <iterator>
+#include <limits>
 #include <string>
 
 #include <QCoreApplication>
@@ -46,6 +47,7 @@
 #include <QString>
 #include <QThread>
 #include <QTimer>
+#include <QUrl>
 #include <QUuid>
 
 #include <libtorrent/alert_types.hpp>
@@ -81,6 +83,7 @@
 #include "base/profile.h"
 #include "base/torrentfileguard.h"
 #include "base/torrentfilter.h"
+#include "base/tracer.h"
 #include "base/unicodestrings.h"
 #include "base/utils/fs.h"
 #include "base/utils/misc.h"
@@ -89,10 +92,24 @@
 #include "base/utils/string.h"
 #include "base/preferences.h"
 #include "magneturi.h"
+#include "private/alertdispatcher.h"
+#include "private/announcescheduler.h"
+#include "private/bandwidthallocator.h"
 #include "private/bandwidthscheduler.h"
+#include "private/crossseedindex.h"
+#include "private/diskcachetuner.h"
+#include "private/fastrecheckworker.h"
 #include "private/filterparserthread.h"
+#include "private/metadatacache.h"
+#include "private/peerbehaviourtracker.h"
 #include "private/resumedatasavingmanager.h"
 #include "private/statistics.h"
+#include "private/storagejobscheduler.h"
+#include "private/storageworker.h"
+#include "private/torrentdecoder.h"
+#include "private/trackerhealthregistry.h"
+#include "private/uploadratecontroller.h"
+#include "timeseriesstore.h"
 #include "torrenthandle.h"
 #include "tracker.h"
 #include "trackerentry.h"
@@ -108,6 +125,12 @@ using NETIO_STATUS = LONG;
 
 static const char PEER_ID[] = "qB";
 static const char RESUME_FOLDER[] = "BT_backup";
+static const char TRANSFER_HISTORY_FILE[] = "transferhistory.dat";
+static const char METADATA_CACHE_FOLDER[] = "metadata";
+// Torrents being loaded or waiting to be added at most, the others are refused
+static const int MAX_PENDING_TORRENTS = 10000;
+// Loaded torrents handed to libtorrent at once
+static const int MAX_ADDING_TORRENTS = 100;
 static const char USER_AGENT[] = "qBittorrent Enhanced/" QBT_VERSION_2;
 
 namespace libt = libtorrent;
@@ -127,6 +150,13 @@ namespace
     QString convertIfaceNameToGuid(const QString &name);
 #endif
 
+    // idle torrents are refreshed once per this many state updates
+    const int SLOW_REFRESH_RATIO = 10;
+
+    // public trackers of this many torrents are updated at a time
+    const int PUBLIC_TRACKERS_BATCH_SIZE = 20;
+    const int PUBLIC_TRACKERS_BATCH_INTERVAL = 1000; // ms
+
     QStringMap map_cast(const QVariantMap &map)
     {
         QStringMap result;
@@ -143,6 +173,51 @@ namespace
         return result;
     }
 
+    bool isUnlimited(const BandwidthClass &bandwidthClass)
+    {
+        return ((bandwidthClass.uploadLimit <= 0) && (bandwidthClass.downloadLimit <= 0)
+                && (bandwidthClass.minUploadShare <= 0) && (bandwidthClass.minDownloadShare <= 0));
+    }
+
+    QMap<QString, BandwidthClass> bandwidthClassesFromVariant(const QVariantMap &map)
+    {
+        QMap<QString, BandwidthClass> result;
+        for (auto i = map.cbegin(); i != map.cend(); ++i) {
+            const QVariantMap value = i.value().toMap();
+            BandwidthClass bandwidthClass;
+            bandwidthClass.uploadLimit = value.value("UploadLimit").toInt();
+            bandwidthClass.downloadLimit = value.value("DownloadLimit").toInt();
+            bandwidthClass.minUploadShare = value.value("MinUploadShare").toInt();
+            bandwidthClass.minDownloadShare = value.value("MinDownloadShare").toInt();
+            if (!isUnlimited(bandwidthClass))
+                result[i.key()] = bandwidthClass;
+        }
+        return result;
+    }
+
+    QVariantMap bandwidthClassesToVariant(const QMap<QString, BandwidthClass> &classes)
+    {
+        QVariantMap result;
+        for (auto i = classes.cbegin(); i != classes.cend(); ++i) {
+            QVariantMap value;
+            value["UploadLimit"] = i.value().uploadLimit;
+            value["DownloadLimit"] = i.value().downloadLimit;
+            value["MinUploadShare"] = i.value().minUploadShare;
+            value["MinDownloadShare"] = i.value().minDownloadShare;
+            result[i.key()] = value;
+        }
+        return result;
+    }
+
+    BandwidthClass normalizedBandwidthClass(BandwidthClass bandwidthClass)
+    {
+        bandwidthClass.uploadLimit = std::max(bandwidthClass.uploadLimit, 0);
+        bandwidthClass.downloadLimit = std::max(bandwidthClass.downloadLimit, 0);
+        bandwidthClass.minUploadShare = qBound(0, bandwidthClass.minUploadShare, 100);
+        bandwidthClass.minDownloadShare = qBound(0, bandwidthClass.minDownloadShare, 100);
+        return bandwidthClass;
+    }
+
     template <typename Entry>
     QSet<QString> entryListToSetImpl(const Entry &entry)
     {
@@ -255,6 +330,87 @@ namespace
             return value;
         };
     }
+
+#if LIBTORRENT_VERSION_NUM >= 10100
+    const int SHARD_REBALANCE_INTERVAL = 5000; // ms
+
+    // Each native session listens on its own port next to the configured one
+    // and gets an even share of the global limits, except the rate limits
+    // which follow the demand (see Session::rebalanceShardRateLimits())
+    void adjustShardSettings(libt::settings_pack &settingsPack, const int shard, const int shardCount)
+    {
+        if (settingsPack.has_val(libt::settings_pack::listen_interfaces)) {
+            const QString interfaces = QString::fromStdString(settingsPack.get_str(libt::settings_pack::listen_interfaces));
+            const int portPos = interfaces.lastIndexOf(':') + 1;
+            const int port = interfaces.midRef(portPos).toInt();
+            if (port > 0)
+                settingsPack.set_str(libt::settings_pack::listen_interfaces
+                                     , (interfaces.left(portPos) + QString::number(port + shard)).toStdString());
+        }
+
+        const int sharedLimits[] = {
+            libt::settings_pack::connections_limit,
+            libt::settings_pack::unchoke_slots_limit,
+            libt::settings_pack::active_downloads,
+            libt::settings_pack::active_seeds,
+            libt::settings_pack::active_limit,
+            libt::settings_pack::cache_size
+        };
+        for (const int name : sharedLimits) {
+            if (!settingsPack.has_val(name)) continue;
+
+            // zero and negative values mean "unlimited" or "automatic"
+            const int limit = settingsPack.get_int(name);
+            if (limit > 0)
+                settingsPack.set_int(name, std::max(1, (limit + shardCount - 1) / shardCount));
+        }
+    }
+
+    // Splits a global rate limit between native sessions proportionally to their demand.
+    // Every session keeps a small floor so that it can pick up new transfers,
+    // and the shares add up to the limit.
+    QVector<int> splitRateLimit(const int limit, const QVector<qreal> &demands)
+    {
+        const int count = demands.size();
+        // zero and negative values mean "unlimited"
+        if (limit <= 0)
+            return QVector<int>(count, limit);
+
+        qreal totalDemand = 0;
+        for (const qreal demand : demands)
+            totalDemand += demand;
+
+        const int floor = limit / (count * 4);
+        const int rest = limit - (floor * count);
+        QVector<int> shares(count, floor);
+        int assigned = floor * count;
+        int busiest = 0;
+        for (int i = 0; i < count; ++i) {
+            const qreal weight = (totalDemand > 0) ? (demands[i] / totalDemand) : (1. / count);
+            const int share = static_cast<int>(rest * weight);
+            shares[i] += share;
+            assigned += share;
+            if (demands[i] > demands[busiest])
+                busiest = i;
+        }
+        // rounding leftovers go to the busiest session
+        shares[busiest] += limit - assigned;
+
+        // a zero share would mean "unlimited"
+        for (int &share : shares)
+            share = std::max(1, share);
+        return shares;
+    }
+
+    // A session that uses (almost) all of its share may want more,
+    // so it asks for more than it gets to be able to grow
+    qreal shardDemand(const qreal rate, const int limit)
+    {
+        if ((limit > 0) && (rate >= (limit * 0.9)))
+            return rate * 1.5;
+        return rate;
+    }
+#endif
 }
 
 // Session
@@ -294,6 +450,7 @@ Session::Session(QObject *parent)
     , m_sendBufferWatermark(BITTORRENT_SESSION_KEY("SendBufferWatermark"), 500)
     , m_sendBufferLowWatermark(BITTORRENT_SESSION_KEY("SendBufferLowWatermark"), 10)
     , m_sendBufferWatermarkFactor(BITTORRENT_SESSION_KEY("SendBufferWatermarkFactor"), 50)
+    , m_isDiskAutoTuningEnabled(BITTORRENT_SESSION_KEY("DiskAutoTuning"), false)
     , m_isAnonymousModeEnabled(BITTORRENT_SESSION_KEY("AnonymousModeEnabled"), false)
     , m_isQueueingEnabled(BITTORRENT_SESSION_KEY("QueueingSystemEnabled"), true)
     , m_maxActiveDownloads(BITTORRENT_SESSION_KEY("MaxActiveDownloads"), 3, lowerLimited(-1))
@@ -324,9 +481,20 @@ Session::Session(QObject *parent)
     , m_isAutoUpdateTrackersEnabled(BITTORRENT_SESSION_KEY("AutoUpdateTrackersEnabled"), false)
     , m_publicTrackers(BITTORRENT_SESSION_KEY("PublicTrackersList"))
     , m_additionalTrackers(BITTORRENT_SESSION_KEY("AdditionalTrackers"))
+    , m_publicTrackersLimit(BITTORRENT_SESSION_KEY("PublicTrackersLimit"), 10, lowerLimited(0))
+    , m_isAnnounceSpreadingEnabled(BITTORRENT_SESSION_KEY("AnnounceSpreadingEnabled"), true)
     , m_globalMaxRatio(BITTORRENT_SESSION_KEY("GlobalMaxRatio"), -1, [](qreal r) { return r < 0 ? -1. : r;})
     , m_globalMaxSeedingMinutes(BITTORRENT_SESSION_KEY("GlobalMaxSeedingMinutes"), -1, lowerLimited(-1))
     , m_isAddTorrentPaused(BITTORRENT_SESSION_KEY("AddTorrentPaused"), false)
+    , m_isDormantTorrentsEnabled(BITTORRENT_SESSION_KEY("DormantTorrentsEnabled"), false)
+    , m_nativeSessionCount(BITTORRENT_SESSION_KEY("NativeSessionCount"), 1, clampValue(1, 16))
+    , m_isFastRecheckEnabled(BITTORRENT_SESSION_KEY("FastRecheckEnabled"), false)
+    , m_isCrossSeedingEnabled(BITTORRENT_SESSION_KEY("CrossSeedingEnabled"), false)
+    , m_metadataCacheSize(BITTORRENT_SESSION_KEY("MetadataCacheSize"), 32, lowerLimited(0))
+    , m_maxActiveMetadataFetches(BITTORRENT_SESSION_KEY("MaxActiveMetadataFetches"), 4, lowerLimited(1))
+    , m_metadataFetchTimeout(BITTORRENT_SESSION_KEY("MetadataFetchTimeout"), 300, lowerLimited(0))
+    , m_maxStorageJobsPerDevice(BITTORRENT_SESSION_KEY("MaxStorageJobsPerDevice"), 1, lowerLimited(1))
+    , m_storageJobRateLimit(BITTORRENT_SESSION_KEY("StorageJobRateLimit"), 0, lowerLimited(0))
     , m_isCreateTorrentSubfolder(BITTORRENT_SESSION_KEY("CreateTorrentSubfolder"), true)
     , m_isAppendExtensionEnabled(BITTORRENT_SESSION_KEY("AddExtensionToIncompleteFiles"), false)
     , m_refreshInterval(BITTORRENT_SESSION_KEY("RefreshInterval"), 1500)
@@ -339,9 +507,14 @@ Session::Session(QObject *parent)
     , m_altGlobalUploadSpeedLimit(BITTORRENT_SESSION_KEY("AlternativeGlobalUPSpeedLimit"), 10, lowerLimited(0))
     , m_isAltGlobalSpeedLimitEnabled(BITTORRENT_SESSION_KEY("UseAlternativeGlobalSpeedLimit"), false)
     , m_isBandwidthSchedulerEnabled(BITTORRENT_SESSION_KEY("BandwidthSchedulerEnabled"), false)
+    , m_isUploadRateControllerEnabled(BITTORRENT_SESSION_KEY("UploadRateControllerEnabled"), false)
+    , m_uploadRateControllerTargetDelay(BITTORRENT_SESSION_KEY("UploadRateControllerTargetDelay"), 75)
+    , m_uploadRateControllerMinLimit(BITTORRENT_SESSION_KEY("UploadRateControllerMinLimit"), 16)
+    , m_uploadRateControllerMaxLimit(BITTORRENT_SESSION_KEY("UploadRateControllerMaxLimit"), 0)
     , m_saveResumeDataInterval(BITTORRENT_SESSION_KEY("SaveResumeDataInterval"), 60)
     , m_autoBanUnknownPeer(BITTORRENT_SESSION_KEY("AutoBanUnknownPeer"), false)
     , m_autoBanBTPlayerPeer(BITTORRENT_SESSION_KEY("AutoBanBTPlayerPeer"), false)
+    , m_autoBanLeecherPeer(BITTORRENT_SESSION_KEY("AutoBanLeecherPeer"), false)
     , m_showTrackerAuthWindow(BITTORRENT_SESSION_KEY("ShowTrackerAuthWindow"), true)
     , m_port(BITTORRENT_SESSION_KEY("Port"), 8999)
     , m_useRandomPort(BITTORRENT_SESSION_KEY("UseRandomPort"), false)
@@ -358,6 +531,8 @@ Session::Session(QObject *parent)
         , clampValue(SeedChokingAlgorithm::RoundRobin, SeedChokingAlgorithm::AntiLeech))
     , m_storedCategories(BITTORRENT_SESSION_KEY("Categories"))
     , m_storedTags(BITTORRENT_SESSION_KEY("Tags"))
+    , m_storedCategoryBandwidthClasses(BITTORRENT_SESSION_KEY("CategoryBandwidthClasses"))
+    , m_storedTagBandwidthClasses(BITTORRENT_SESSION_KEY("TagBandwidthClasses"))
     , m_maxRatioAction(BITTORRENT_SESSION_KEY("MaxRatioAction"), Pause)
     , m_defaultSavePath(BITTORRENT_SESSION_KEY("DefaultSavePath"), specialFolderLocation(SpecialFolder::Downloads), normalizePath)
     , m_tempPath(BITTORRENT_SESSION_KEY("TempPath"), defaultSavePath() + "temp/", normalizePath)
@@ -387,6 +562,20 @@ Session::Session(QObject *parent)
 
     initResumeFolder();
 
+    m_diskCacheTuner = new DiskCacheTuner;
+    resetDiskCacheTuner();
+    m_uploadRateController = new UploadRateController;
+    resetUploadRateController();
+    m_peerBehaviourTracker = new PeerBehaviourTracker;
+    m_trackerHealthRegistry = new TrackerHealthRegistry;
+    m_announceScheduler = new AnnounceScheduler;
+    m_metadataCache = new MetadataCache(Utils::Fs::expandPathAbs(specialFolderLocation(SpecialFolder::Cache) + METADATA_CACHE_FOLDER)
+        , (static_cast<qint64>(metadataCacheSize()) * 1024 * 1024));
+    m_storageJobScheduler = new StorageJobScheduler;
+    m_storageJobScheduler->setMaxJobsPerDevice(maxStorageJobsPerDevice());
+    m_storageJobScheduler->setRateLimit(storageJobRateLimit() * 1024LL);
+    m_crossSeedIndex = new CrossSeedIndex;
+
     m_recentErroredTorrentsTimer->setSingleShot(true);
     m_recentErroredTorrentsTimer->setInterval(1000);
     connect(m_recentErroredTorrentsTimer, &QTimer::timeout, this, [this]() { m_recentErroredTorrents.clear(); });
@@ -417,6 +606,8 @@ Session::Session(QObject *parent)
     std::pair<int, int> ports(port, port);
     const QString ip = getListeningIPs().first();
     m_nativeSession = new libt::session(fingerprint, ports, ip.isEmpty() ? 0 : ip.toLatin1().constData(), 0, alertMask);
+    m_nativeShards.resize(1);
+    m_nativeShards[0].session = m_nativeSession;
 
     libt::session_settings sessionSettings = m_nativeSession->settings();
     sessionSettings.user_agent = USER_AGENT;
@@ -472,21 +663,37 @@ Session::Session(QObject *parent)
     pack.set_bool(libt::settings_pack::upnp_ignore_nonrouters, true);
     configure(pack);
 
-    m_nativeSession = new libt::session(pack, 0);
-    m_nativeSession->set_alert_notify([this]()
-    {
-        QMetaObject::invokeMethod(this, "readAlerts", Qt::QueuedConnection);
-    });
+    m_nativeShards.resize(nativeSessionCount());
+    for (int i = 0; i < m_nativeShards.size(); ++i) {
+        libt::settings_pack shardPack = pack;
+        adjustShardSettings(shardPack, i, m_nativeShards.size());
+        adjustShardRateLimits(shardPack, i);
+        m_nativeShards[i].session = new libt::session(shardPack, 0);
+    }
+    m_nativeSession = m_nativeShards.first().session;
 
     configurePeerClasses();
 #endif // LIBTORRENT_VERSION_NUM < 10100
 
-    // Enabling plugins
-    //m_nativeSession->add_extension(&libt::create_metadata_plugin);
-    m_nativeSession->add_extension(&libt::create_ut_metadata_plugin);
-    if (isPeXEnabled())
-        m_nativeSession->add_extension(&libt::create_ut_pex_plugin);
-    m_nativeSession->add_extension(&libt::create_smart_ban_plugin);
+    for (int i = 0; i < m_nativeShards.size(); ++i) {
+        libt::session *const nativeSession = m_nativeShards[i].session;
+        auto alertDispatcher = new AlertDispatcher([this, nativeSession](std::vector<libt::alert *> &out, ulong time)
+        {
+            getPendingAlerts(nativeSession, out, time);
+        }, this);
+        connect(alertDispatcher, &AlertDispatcher::batchReady, this, [this, i]() { readShardAlerts(i); });
+        m_nativeShards[i].alertDispatcher = alertDispatcher;
+    }
+    for (const NativeShard &shard : asConst(m_nativeShards)) {
+        shard.alertDispatcher->start();
+
+        // Enabling plugins
+        //shard.session->add_extension(&libt::create_metadata_plugin);
+        shard.session->add_extension(&libt::create_ut_metadata_plugin);
+        if (isPeXEnabled())
+            shard.session->add_extension(&libt::create_ut_pex_plugin);
+        shard.session->add_extension(&libt::create_smart_ban_plugin);
+    }
 
     logger->addMessage(tr("Peer ID: ") + QString::fromStdString(peerId));
     logger->addMessage(tr("HTTP User-Agent is '%1'").arg(USER_AGENT));
@@ -509,7 +716,7 @@ Session::Session(QObject *parent)
         // Add the banned IPs
         libt::ip_filter filter;
         processBannedIPs(filter);
-        m_nativeSession->set_ip_filter(filter);
+        setNativeIPFilter(filter);
         loadOfflineFilter();
     }
 
@@ -522,6 +729,9 @@ Session::Session(QObject *parent)
 
     m_tags = QSet<QString>::fromList(m_storedTags.value());
 
+    m_categoryBandwidthClasses = bandwidthClassesFromVariant(m_storedCategoryBandwidthClasses);
+    m_tagBandwidthClasses = bandwidthClassesFromVariant(m_storedTagBandwidthClasses);
+
     m_refreshTimer = new QTimer(this);
     m_refreshTimer->setInterval(refreshInterval());
     connect(m_refreshTimer, &QTimer::timeout, this, &Session::refresh);
@@ -547,7 +757,29 @@ Session::Session(QObject *parent)
         m_updateTimer->start();
     }
 
+    // Tracker scores
+    m_trackerEvaluationTimer = new QTimer(this);
+    m_trackerEvaluationTimer->setInterval(30 * 60 * 1000);
+    connect(m_trackerEvaluationTimer, &QTimer::timeout, this, &Session::evaluatePublicTrackers);
+    m_trackerEvaluationTimer->start();
+
+    m_publicTrackersTimer = new QTimer(this);
+    m_publicTrackersTimer->setInterval(PUBLIC_TRACKERS_BATCH_INTERVAL);
+    connect(m_publicTrackersTimer, &QTimer::timeout, this, &Session::applyQueuedPublicTrackers);
+
+    // Metadata fetches
+    m_metadataFetchClock.start();
+    m_metadataFetchTimer = new QTimer(this);
+    m_metadataFetchTimer->setInterval(5000);
+    connect(m_metadataFetchTimer, &QTimer::timeout, this, &Session::checkMetadataFetchTimeouts);
+
+    // Storage jobs held back by the rate limit are retried and the running ones measured
+    m_storageJobTimer = new QTimer(this);
+    m_storageJobTimer->setInterval(1000);
+    connect(m_storageJobTimer, &QTimer::timeout, this, &Session::updateStorageJobs);
+
     m_statistics = new Statistics(this);
+    m_transferHistory = new TimeSeriesStore(Utils::Fs::expandPathAbs(specialFolderLocation(SpecialFolder::Data) + TRANSFER_HISTORY_FILE));
 
     updateSeedingLimitTimer();
     populateAdditionalTrackers();
@@ -564,12 +796,39 @@ Session::Session(QObject *parent)
     connect(&m_networkManager, &QNetworkConfigurationManager::configurationRemoved, this, &Session::networkConfigurationChange);
     connect(&m_networkManager, &QNetworkConfigurationManager::configurationChanged, this, &Session::networkConfigurationChange);
 
+    qRegisterMetaType<TorrentInfo>();
     m_ioThread = new QThread(this);
     m_resumeDataSavingManager = new ResumeDataSavingManager {m_resumeFolderPath};
     m_resumeDataSavingManager->moveToThread(m_ioThread);
     connect(m_ioThread, &QThread::finished, m_resumeDataSavingManager, &QObject::deleteLater);
     m_ioThread->start();
 
+    qRegisterMetaType<FastRecheckJob>("FastRecheckJob");
+    qRegisterMetaType<FastRecheckResult>();
+    m_recheckThread = new QThread(this);
+    m_fastRecheckWorker = new FastRecheckWorker;
+    m_fastRecheckWorker->moveToThread(m_recheckThread);
+    connect(m_recheckThread, &QThread::finished, m_fastRecheckWorker, &QObject::deleteLater);
+    connect(m_fastRecheckWorker, &FastRecheckWorker::finished, this, &Session::handleFastRecheckFinished);
+    connect(m_fastRecheckWorker, &FastRecheckWorker::sampleVerified, this, &Session::handleCrossSeedVerified);
+    m_recheckThread->start();
+
+    qRegisterMetaType<TorrentDecodeResult>();
+    m_decodeThread = new QThread(this);
+    m_torrentDecoder = new TorrentDecoder;
+    m_torrentDecoder->moveToThread(m_decodeThread);
+    connect(m_decodeThread, &QThread::finished, m_torrentDecoder, &QObject::deleteLater);
+    connect(m_torrentDecoder, &TorrentDecoder::decoded, this, &Session::handleTorrentDecoded);
+    m_decodeThread->start();
+
+    m_storageThread = new QThread(this);
+    m_storageWorker = new StorageWorker;
+    m_storageWorker->moveToThread(m_storageThread);
+    connect(m_storageThread, &QThread::finished, m_storageWorker, &QObject::deleteLater);
+    connect(m_storageWorker, &StorageWorker::folderTreeRemoved, this, &Session::handleStorageFolderTreeRemoved);
+    connect(m_storageWorker, &StorageWorker::measured, this, &Session::handleStorageJobMeasured);
+    m_storageThread->start();
+
     // Regular saving of fastresume data
     m_resumeDataTimer = new QTimer(this);
     connect(m_resumeDataTimer, &QTimer::timeout, this, [this]() { generateResumeData(); });
@@ -848,6 +1107,12 @@ bool Session::removeCategory(const QString &name)
         // update stored categories
         m_storedCategories = map_cast(m_categories);
         emit categoryRemoved(name);
+
+        Dict::removeIf(m_categoryBandwidthClasses, [this](const QString &category, const BandwidthClass &)
+        {
+            return !m_categories.contains(category);
+        });
+        storeBandwidthClasses();
     }
 
     return result;
@@ -913,11 +1178,164 @@ bool Session::removeTag(const QString &tag)
             torrent->removeTag(tag);
         m_storedTags = m_tags.toList();
         emit tagRemoved(tag);
+        if (m_tagBandwidthClasses.remove(tag) > 0)
+            storeBandwidthClasses();
         return true;
     }
     return false;
 }
 
+const QMap<QString, BandwidthClass> &Session::categoryBandwidthClasses() const
+{
+    return m_categoryBandwidthClasses;
+}
+
+bool Session::setCategoryBandwidthClass(const QString &category, const BandwidthClass &bandwidthClass)
+{
+    if (!m_categories.contains(category)) return false;
+
+    const BandwidthClass normalized = normalizedBandwidthClass(bandwidthClass);
+    if (isUnlimited(normalized))
+        m_categoryBandwidthClasses.remove(category);
+    else
+        m_categoryBandwidthClasses[category] = normalized;
+    storeBandwidthClasses();
+    return true;
+}
+
+const QMap<QString, BandwidthClass> &Session::tagBandwidthClasses() const
+{
+    return m_tagBandwidthClasses;
+}
+
+bool Session::setTagBandwidthClass(const QString &tag, const BandwidthClass &bandwidthClass)
+{
+    if (!hasTag(tag)) return false;
+
+    const BandwidthClass normalized = normalizedBandwidthClass(bandwidthClass);
+    if (isUnlimited(normalized))
+        m_tagBandwidthClasses.remove(tag);
+    else
+        m_tagBandwidthClasses[tag] = normalized;
+    storeBandwidthClasses();
+    return true;
+}
+
+const QMap<QString, BandwidthClassStatus> &Session::categoryBandwidthStatus() const
+{
+    return m_categoryBandwidthStatus;
+}
+
+const QMap<QString, BandwidthClassStatus> &Session::tagBandwidthStatus() const
+{
+    return m_tagBandwidthStatus;
+}
+
+void Session::storeBandwidthClasses()
+{
+    m_storedCategoryBandwidthClasses = bandwidthClassesToVariant(m_categoryBandwidthClasses);
+    m_storedTagBandwidthClasses = bandwidthClassesToVariant(m_tagBandwidthClasses);
+}
+
+// Torrents can't be put in libtorrent peer classes with the public API,
+// so the bandwidth of every class is split into per torrent limits instead.
+// It follows the demand since the limits are updated with every statistics update.
+void Session::applyBandwidthClasses()
+{
+    m_categoryBandwidthStatus.clear();
+    m_tagBandwidthStatus.clear();
+    if (m_categoryBandwidthClasses.isEmpty() && m_tagBandwidthClasses.isEmpty()
+            && !m_hasBandwidthClassLimits) {
+        return;
+    }
+
+    QVector<BandwidthAllocator::Class> uploadClasses;
+    QVector<BandwidthAllocator::Class> downloadClasses;
+    bool hasGuarantees = false;
+    const auto addClass = [&](const BandwidthClass &bandwidthClass) -> int
+    {
+        BandwidthAllocator::Class uploadClass;
+        uploadClass.limit = bandwidthClass.uploadLimit;
+        uploadClass.minShare = bandwidthClass.minUploadShare;
+        uploadClasses.append(uploadClass);
+        BandwidthAllocator::Class downloadClass;
+        downloadClass.limit = bandwidthClass.downloadLimit;
+        downloadClass.minShare = bandwidthClass.minDownloadShare;
+        downloadClasses.append(downloadClass);
+        hasGuarantees = hasGuarantees || (bandwidthClass.minUploadShare > 0) || (bandwidthClass.minDownloadShare > 0);
+        return (uploadClasses.size() - 1);
+    };
+
+    QHash<QString, int> categoryClasses;
+    for (auto i = m_categoryBandwidthClasses.cbegin(); i != m_categoryBandwidthClasses.cend(); ++i) {
+        categoryClasses[i.key()] = addClass(i.value());
+        m_categoryBandwidthStatus[i.key()] = BandwidthClassStatus();
+    }
+    QHash<QString, int> tagClasses;
+    for (auto i = m_tagBandwidthClasses.cbegin(); i != m_tagBandwidthClasses.cend(); ++i) {
+        tagClasses[i.key()] = addClass(i.value());
+        m_tagBandwidthStatus[i.key()] = BandwidthClassStatus();
+    }
+
+    QVector<TorrentHandle *> limitedTorrents;
+    QVector<BandwidthAllocator::Member> uploadMembers;
+    QVector<BandwidthAllocator::Member> downloadMembers;
+    for (TorrentHandle *const torrent : asConst(m_torrents)) {
+        if (torrent->isDormant()) continue;
+
+        const int uploadRate = torrent->uploadPayloadRate();
+        const int downloadRate = torrent->downloadPayloadRate();
+        const auto addStatus = [uploadRate, downloadRate](BandwidthClassStatus &status)
+        {
+            status.uploadRate += uploadRate;
+            status.downloadRate += downloadRate;
+            ++status.torrentsCount;
+        };
+
+        QVector<int> classes;
+        if (!torrent->category().isEmpty()) {
+            const QStringList categories = isSubcategoriesEnabled()
+                ? expandCategory(torrent->category()) : QStringList {torrent->category()};
+            for (const QString &category : categories) {
+                const auto it = categoryClasses.constFind(category);
+                if (it == categoryClasses.cend()) continue;
+                classes.append(it.value());
+                addStatus(m_categoryBandwidthStatus[category]);
+            }
+        }
+        for (const QString &tag : asConst(torrent->tags())) {
+            const auto it = tagClasses.constFind(tag);
+            if (it == tagClasses.cend()) continue;
+            classes.append(it.value());
+            addStatus(m_tagBandwidthStatus[tag]);
+        }
+
+        // The torrents outside of any class only give way to the guaranteed ones
+        if (torrent->isPaused() || (classes.isEmpty() && !hasGuarantees)) {
+            torrent->setBandwidthClassLimits(0, 0);
+            continue;
+        }
+
+        limitedTorrents.append(torrent);
+        BandwidthAllocator::Member uploadMember;
+        uploadMember.rate = uploadRate;
+        uploadMember.classes = classes;
+        uploadMembers.append(uploadMember);
+        BandwidthAllocator::Member downloadMember;
+        downloadMember.rate = downloadRate;
+        downloadMember.classes = classes;
+        downloadMembers.append(downloadMember);
+    }
+
+    const QVector<int> uploadLimits = BandwidthAllocator::allocate(uploadClasses, uploadMembers, effectiveUploadSpeedLimit());
+    const QVector<int> downloadLimits = BandwidthAllocator::allocate(downloadClasses, downloadMembers
+        , (isAltGlobalSpeedLimitEnabled() ? altGlobalDownloadSpeedLimit() : globalDownloadSpeedLimit()));
+    for (int i = 0; i < limitedTorrents.size(); ++i)
+        limitedTorrents[i]->setBandwidthClassLimits(uploadLimits[i], downloadLimits[i]);
+
+    m_hasBandwidthClassLimits = !limitedTorrents.isEmpty();
+}
+
 bool Session::isAutoTMMDisabledByDefault() const
 {
     return m_isAutoTMMDisabledByDefault;
@@ -968,6 +1386,131 @@ void Session::setAddTorrentPaused(bool value)
     m_isAddTorrentPaused = value;
 }
 
+bool Session::isDormantTorrentsEnabled() const
+{
+    return m_isDormantTorrentsEnabled;
+}
+
+void Session::setDormantTorrentsEnabled(bool enabled)
+{
+    m_isDormantTorrentsEnabled = enabled;
+}
+
+int Session::nativeSessionCount() const
+{
+#if LIBTORRENT_VERSION_NUM < 10100
+    return 1;
+#else
+    return m_nativeSessionCount;
+#endif
+}
+
+void Session::setNativeSessionCount(const int count)
+{
+    m_nativeSessionCount = count;
+}
+
+bool Session::isFastRecheckEnabled() const
+{
+    return m_isFastRecheckEnabled;
+}
+
+void Session::setFastRecheckEnabled(const bool enabled)
+{
+    m_isFastRecheckEnabled = enabled;
+}
+
+bool Session::isCrossSeedingEnabled() const
+{
+    return m_isCrossSeedingEnabled;
+}
+
+// The files are indexed only while it is enabled
+void Session::setCrossSeedingEnabled(const bool enabled)
+{
+    if (enabled == isCrossSeedingEnabled()) return;
+
+    m_isCrossSeedingEnabled = enabled;
+    m_crossSeedIndex->clear();
+    if (enabled) {
+        for (const TorrentHandle *torrent : asConst(m_torrents))
+            indexCrossSeedFiles(torrent);
+    }
+}
+
+void Session::indexCrossSeedFiles(const TorrentHandle *torrent)
+{
+    // Loading the metadata of a dormant torrent would keep it in memory
+    if (torrent->isDormant())
+        m_crossSeedIndex->addTorrent(torrent, storedTorrentInfo(torrent));
+    else
+        m_crossSeedIndex->addTorrent(torrent);
+}
+
+int Session::metadataCacheSize() const
+{
+    return m_metadataCacheSize;
+}
+
+void Session::setMetadataCacheSize(const int size)
+{
+    if (size == metadataCacheSize()) return;
+
+    m_metadataCacheSize = size;
+    m_metadataCache->setMaxSize(static_cast<qint64>(metadataCacheSize()) * 1024 * 1024);
+}
+
+int Session::maxActiveMetadataFetches() const
+{
+    return m_maxActiveMetadataFetches;
+}
+
+void Session::setMaxActiveMetadataFetches(const int max)
+{
+    if (max == maxActiveMetadataFetches()) return;
+
+    m_maxActiveMetadataFetches = max;
+    startMetadataFetches();
+}
+
+int Session::metadataFetchTimeout() const
+{
+    return m_metadataFetchTimeout;
+}
+
+void Session::setMetadataFetchTimeout(const int timeout)
+{
+    m_metadataFetchTimeout = timeout;
+}
+
+int Session::maxStorageJobsPerDevice() const
+{
+    return m_maxStorageJobsPerDevice;
+}
+
+void Session::setMaxStorageJobsPerDevice(const int max)
+{
+    if (max == maxStorageJobsPerDevice()) return;
+
+    m_maxStorageJobsPerDevice = max;
+    m_storageJobScheduler->setMaxJobsPerDevice(maxStorageJobsPerDevice());
+    startStorageJobs();
+}
+
+int Session::storageJobRateLimit() const
+{
+    return m_storageJobRateLimit;
+}
+
+void Session::setStorageJobRateLimit(const int limit)
+{
+    if (limit == storageJobRateLimit()) return;
+
+    m_storageJobRateLimit = limit;
+    m_storageJobScheduler->setRateLimit(storageJobRateLimit() * 1024LL);
+    startStorageJobs();
+}
+
 bool Session::isTrackerEnabled() const
 {
     return m_isTrackerEnabled;
@@ -1030,12 +1573,40 @@ Session::~Session()
     // we delete libtorrent::session
     Net::PortForwarder::freeInstance();
 
+    // The removed torrents must not leave their files behind
+    for (auto it = m_queuedRemovals.cbegin(); it != m_queuedRemovals.cend(); ++it) {
+        const libt::torrent_handle &nativeHandle = it.value();
+        nativeSessionFor(nativeHandle.info_hash())->remove_torrent(nativeHandle, libt::session::delete_files);
+    }
+
     qDebug("Deleting the session");
-    delete m_nativeSession;
+    for (const NativeShard &shard : asConst(m_nativeShards))
+        delete shard.session;
 
     m_ioThread->quit();
     m_ioThread->wait();
 
+    // Don't wait for the data of large torrents to be verified
+    m_fastRecheckWorker->abort();
+    m_recheckThread->quit();
+    m_recheckThread->wait();
+
+    m_decodeThread->quit();
+    m_decodeThread->wait();
+
+    m_storageThread->quit();
+    m_storageThread->wait();
+
+    delete m_transferHistory;
+    delete m_diskCacheTuner;
+    delete m_uploadRateController;
+    delete m_peerBehaviourTracker;
+    delete m_trackerHealthRegistry;
+    delete m_announceScheduler;
+    delete m_metadataCache;
+    delete m_storageJobScheduler;
+    delete m_crossSeedIndex;
+
     m_resumeFolderLock.close();
     m_resumeFolderLock.remove();
 }
@@ -1067,13 +1638,40 @@ void Session::adjustLimits()
         adjustLimits(sessionSettings);
         m_nativeSession->set_settings(sessionSettings);
 #else
-        libt::settings_pack settingsPack = m_nativeSession->get_settings();
+        libt::settings_pack settingsPack;
         adjustLimits(settingsPack);
-        m_nativeSession->apply_settings(settingsPack);
+        applyNativeSettings(settingsPack);
 #endif
     }
 }
 
+void Session::applyDiskTuning()
+{
+#if LIBTORRENT_VERSION_NUM < 10100
+    libt::session_settings sessionSettings(m_nativeSession->settings());
+    applyDiskTuning(sessionSettings);
+    m_nativeSession->set_settings(sessionSettings);
+#else
+    libt::settings_pack settingsPack;
+    applyDiskTuning(settingsPack);
+    applyNativeSettings(settingsPack);
+#endif
+}
+
+// The configured values are the starting point of the tuning
+void Session::resetDiskCacheTuner()
+{
+    DiskCacheTuner::Settings baseline;
+    baseline.cacheSize = diskCacheSize();
+    baseline.asyncIOThreads = asyncIOThreads();
+    baseline.sendBufferWatermark = sendBufferWatermark();
+#if LIBTORRENT_VERSION_NUM < 10100
+    m_diskCacheTuner->reset(baseline, false);
+#else
+    m_diskCacheTuner->reset(baseline, true);
+#endif
+}
+
 void Session::applyBandwidthLimits()
 {
 #if LIBTORRENT_VERSION_NUM < 10100
@@ -1081,9 +1679,9 @@ void Session::applyBandwidthLimits()
         applyBandwidthLimits(sessionSettings);
         m_nativeSession->set_settings(sessionSettings);
 #else
-        libt::settings_pack settingsPack = m_nativeSession->get_settings();
+        libt::settings_pack settingsPack;
         applyBandwidthLimits(settingsPack);
-        m_nativeSession->apply_settings(settingsPack);
+        applyNativeSettings(settingsPack);
 #endif
 }
 
@@ -1096,9 +1694,9 @@ void Session::configure()
     configure(sessionSettings);
     m_nativeSession->set_settings(sessionSettings);
 #else
-    libt::settings_pack settingsPack = m_nativeSession->get_settings();
+    libt::settings_pack settingsPack;
     configure(settingsPack);
-    m_nativeSession->apply_settings(settingsPack);
+    applyNativeSettings(settingsPack);
     configurePeerClasses();
 #endif
 
@@ -1140,15 +1738,96 @@ void Session::adjustLimits(libt::settings_pack &settingsPack)
                          , maxActive > -1 ? maxActive + m_extraLimit : maxActive);
 }
 
+// Native sessions share the settings, only their ports and the global limits differ
+void Session::applyNativeSettings(const libt::settings_pack &settingsPack)
+{
+    for (int i = 0; i < m_nativeShards.size(); ++i) {
+        libt::settings_pack shardPack = settingsPack;
+        adjustShardSettings(shardPack, i, m_nativeShards.size());
+        adjustShardRateLimits(shardPack, i);
+        m_nativeShards[i].session->apply_settings(shardPack);
+    }
+}
+
+void Session::adjustShardRateLimits(libt::settings_pack &settingsPack, const int shard)
+{
+    NativeShard &nativeShard = m_nativeShards[shard];
+    if (settingsPack.has_val(libt::settings_pack::download_rate_limit)) {
+        QVector<qreal> demands;
+        for (const NativeShard &otherShard : asConst(m_nativeShards))
+            demands.append(otherShard.downloadDemand);
+        nativeShard.downloadRateLimit = splitRateLimit(settingsPack.get_int(libt::settings_pack::download_rate_limit), demands)[shard];
+        settingsPack.set_int(libt::settings_pack::download_rate_limit, nativeShard.downloadRateLimit);
+    }
+    if (settingsPack.has_val(libt::settings_pack::upload_rate_limit)) {
+        QVector<qreal> demands;
+        for (const NativeShard &otherShard : asConst(m_nativeShards))
+            demands.append(otherShard.uploadDemand);
+        nativeShard.uploadRateLimit = splitRateLimit(settingsPack.get_int(libt::settings_pack::upload_rate_limit), demands)[shard];
+        settingsPack.set_int(libt::settings_pack::upload_rate_limit, nativeShard.uploadRateLimit);
+    }
+}
+
+// Moves the global rate limits towards the native sessions that actually transfer,
+// measured from their own payload counters since the last rebalance
+void Session::rebalanceShardRateLimits()
+{
+    if (m_nativeShards.size() < 2) return;
+
+    if (!m_shardRebalanceTimer.isValid()) {
+        m_shardRebalanceTimer.start();
+    }
+    else {
+        if (m_shardRebalanceTimer.elapsed() < SHARD_REBALANCE_INTERVAL) return;
+
+        const qreal interval = m_shardRebalanceTimer.restart() / 1000.;
+        for (NativeShard &shard : m_nativeShards) {
+            const qint64 downloaded = shard.counters[m_metricIndices.net.recvPayloadBytes] - shard.rebalanceDownload;
+            const qint64 uploaded = shard.counters[m_metricIndices.net.sentPayloadBytes] - shard.rebalanceUpload;
+            shard.downloadDemand = shardDemand(std::max<qint64>(0, downloaded) / interval, shard.downloadRateLimit);
+            shard.uploadDemand = shardDemand(std::max<qint64>(0, uploaded) / interval, shard.uploadRateLimit);
+        }
+    }
+
+    for (NativeShard &shard : m_nativeShards) {
+        shard.rebalanceDownload = shard.counters[m_metricIndices.net.recvPayloadBytes];
+        shard.rebalanceUpload = shard.counters[m_metricIndices.net.sentPayloadBytes];
+    }
+
+    libt::settings_pack settingsPack;
+    applyBandwidthLimits(settingsPack);
+    if ((settingsPack.get_int(libt::settings_pack::download_rate_limit) <= 0)
+        && (settingsPack.get_int(libt::settings_pack::upload_rate_limit) <= 0))
+        return;
+
+    applyNativeSettings(settingsPack);
+}
+
+void Session::applyDiskTuning(libtorrent::settings_pack &settingsPack)
+{
+    const DiskCacheTuner::Settings &settings = m_diskCacheTuner->settings();
+    settingsPack.set_int(libt::settings_pack::aio_threads, settings.asyncIOThreads);
+    settingsPack.set_int(libt::settings_pack::cache_size, ((settings.cacheSize > -1) ? (settings.cacheSize * 64) : -1));
+    settingsPack.set_int(libt::settings_pack::send_buffer_watermark, settings.sendBufferWatermark * 1024);
+}
+
 void Session::applyBandwidthLimits(libtorrent::settings_pack &settingsPack)
 {
     const bool altSpeedLimitEnabled = isAltGlobalSpeedLimitEnabled();
     settingsPack.set_int(libt::settings_pack::download_rate_limit, altSpeedLimitEnabled ? altGlobalDownloadSpeedLimit() : globalDownloadSpeedLimit());
-    settingsPack.set_int(libt::settings_pack::upload_rate_limit, altSpeedLimitEnabled ? altGlobalUploadSpeedLimit() : globalUploadSpeedLimit());
+    settingsPack.set_int(libt::settings_pack::upload_rate_limit, effectiveUploadSpeedLimit());
 }
 
 void Session::initMetrics()
 {
+    const std::vector<libt::stats_metric> metrics = libt::session_stats_metrics();
+    m_sessionMetrics.reserve(static_cast<int>(metrics.size()));
+    for (const libt::stats_metric &metric : metrics)
+        m_sessionMetrics.append({metric.name, metric.value_index, (metric.type == libt::stats_metric::type_gauge)});
+    m_sessionCounters.fill(0, libt::counters::num_counters);
+    for (NativeShard &shard : m_nativeShards)
+        shard.counters.fill(0, libt::counters::num_counters);
+
     m_metricIndices.net.hasIncomingConnections = libt::find_metric_idx("net.has_incoming_connections");
     Q_ASSERT(m_metricIndices.net.hasIncomingConnections >= 0);
 
@@ -1191,6 +1870,9 @@ void Session::initMetrics()
     m_metricIndices.peer.numPeersUpDisk = libt::find_metric_idx("peer.num_peers_up_disk");
     Q_ASSERT(m_metricIndices.peer.numPeersUpDisk >= 0);
 
+    m_metricIndices.peer.numPeersUpUnchoked = libt::find_metric_idx("peer.num_peers_up_unchoked");
+    Q_ASSERT(m_metricIndices.peer.numPeersUpUnchoked >= 0);
+
     m_metricIndices.dht.dhtBytesIn = libt::find_metric_idx("dht.dht_bytes_in");
     Q_ASSERT(m_metricIndices.dht.dhtBytesIn >= 0);
 
@@ -1200,6 +1882,12 @@ void Session::initMetrics()
     m_metricIndices.dht.dhtNodes = libt::find_metric_idx("dht.dht_nodes");
     Q_ASSERT(m_metricIndices.dht.dhtNodes >= 0);
 
+    m_metricIndices.utp.samplesAboveTarget = libt::find_metric_idx("utp.utp_samples_above_target");
+    Q_ASSERT(m_metricIndices.utp.samplesAboveTarget >= 0);
+
+    m_metricIndices.utp.samplesBelowTarget = libt::find_metric_idx("utp.utp_samples_below_target");
+    Q_ASSERT(m_metricIndices.utp.samplesBelowTarget >= 0);
+
     m_metricIndices.disk.diskBlocksInUse = libt::find_metric_idx("disk.disk_blocks_in_use");
     Q_ASSERT(m_metricIndices.disk.diskBlocksInUse >= 0);
 
@@ -1374,6 +2062,8 @@ void Session::configure(libtorrent::settings_pack &settingsPack)
     settingsPack.set_int(libt::settings_pack::send_buffer_watermark, sendBufferWatermark() * 1024);
     settingsPack.set_int(libt::settings_pack::send_buffer_low_watermark, sendBufferLowWatermark() * 1024);
     settingsPack.set_int(libt::settings_pack::send_buffer_watermark_factor, sendBufferWatermarkFactor());
+    if (isDiskAutoTuningEnabled())
+        applyDiskTuning(settingsPack);
 
     settingsPack.set_bool(libt::settings_pack::anonymous_mode, isAnonymousModeEnabled());
 
@@ -1446,6 +2136,10 @@ void Session::configure(libtorrent::settings_pack &settingsPack)
         break;
     }
 
+    // 100 ms is the default of libtorrent
+    settingsPack.set_int(libt::settings_pack::utp_target_delay
+                         , (isUploadRateControllerEnabled() ? uploadRateControllerTargetDelay() : 100));
+
     settingsPack.set_bool(libt::settings_pack::allow_multiple_connections_per_ip, multiConnectionsPerIpEnabled());
 
     settingsPack.set_bool(libt::settings_pack::apply_ip_filter_to_trackers, isTrackerFilteringEnabled());
@@ -1539,7 +2233,8 @@ void Session::configurePeerClasses()
         catch (std::exception &) {}
 #endif // TORRENT_USE_IPV6
     }
-    m_nativeSession->set_peer_class_filter(f);
+    for (const NativeShard &shard : asConst(m_nativeShards))
+        shard.session->set_peer_class_filter(f);
 
     libt::peer_class_type_filter peerClassTypeFilter;
     peerClassTypeFilter.add(libt::peer_class_type_filter::tcp_socket, libt::session::tcp_peer_class_id);
@@ -1551,7 +2246,8 @@ void Session::configurePeerClasses()
         peerClassTypeFilter.disallow(libt::peer_class_type_filter::ssl_utp_socket
             , libt::session::global_peer_class_id);
     }
-    m_nativeSession->set_peer_class_type_filter(peerClassTypeFilter);
+    for (const NativeShard &shard : asConst(m_nativeShards))
+        shard.session->set_peer_class_type_filter(peerClassTypeFilter);
 }
 
 #else // LIBTORRENT_VERSION_NUM >= 10100
@@ -1566,11 +2262,18 @@ void Session::adjustLimits(libt::session_settings &sessionSettings)
     sessionSettings.active_limit = (maxActive > -1) ? (maxActive + m_extraLimit) : maxActive;
 }
 
+void Session::applyDiskTuning(libt::session_settings &sessionSettings)
+{
+    const DiskCacheTuner::Settings &settings = m_diskCacheTuner->settings();
+    sessionSettings.cache_size = (settings.cacheSize > -1) ? (settings.cacheSize * 64) : -1;
+    sessionSettings.send_buffer_watermark = settings.sendBufferWatermark * 1024;
+}
+
 void Session::applyBandwidthLimits(libt::session_settings &sessionSettings)
 {
     const bool altSpeedLimitEnabled = isAltGlobalSpeedLimitEnabled();
     sessionSettings.download_rate_limit = altSpeedLimitEnabled ? altGlobalDownloadSpeedLimit() : globalDownloadSpeedLimit();
-    sessionSettings.upload_rate_limit = altSpeedLimitEnabled ? altGlobalUploadSpeedLimit() : globalUploadSpeedLimit();
+    sessionSettings.upload_rate_limit = effectiveUploadSpeedLimit();
 }
 
 void Session::configure(libtorrent::session_settings &sessionSettings)
@@ -1652,6 +2355,8 @@ void Session::configure(libtorrent::session_settings &sessionSettings)
     sessionSettings.send_buffer_watermark = sendBufferWatermark() * 1024;
     sessionSettings.send_buffer_low_watermark = sendBufferLowWatermark() * 1024;
     sessionSettings.send_buffer_watermark_factor = sendBufferWatermarkFactor();
+    if (isDiskAutoTuningEnabled())
+        applyDiskTuning(sessionSettings);
 
     sessionSettings.anonymous_mode = isAnonymousModeEnabled();
 
@@ -1821,10 +2526,88 @@ void Session::populatePublicTrackers()
         if (!tracker.isEmpty())
             m_publicTrackerList << tracker;
     }
+    selectPublicTrackers();
+}
+
+void Session::selectPublicTrackers()
+{
+    QStringList candidates;
+    for (const TrackerEntry &tracker : asConst(m_publicTrackerList))
+        candidates << tracker.url();
+
+    m_selectedPublicTrackers.clear();
+    for (const QString &trackerUrl : asConst(m_trackerHealthRegistry->select(candidates, publicTrackersLimit())))
+        m_selectedPublicTrackers << trackerUrl;
+}
+
+// Public trackers that aren't selected anymore are replaced with the selected ones,
+// the other trackers of the torrents are left alone.
+// The torrents are updated a few at a time, since removing trackers restarts their announces.
+void Session::applyPublicTrackers()
+{
+    if (!isAutoUpdateTrackersEnabled()) return;
+
+    // trackers deselected earlier may still be waiting to be removed
+    for (const TrackerEntry &tracker : asConst(m_publicTrackerList))
+        m_deselectedPublicTrackers.insert(tracker.url());
+    for (const TrackerEntry &tracker : asConst(m_selectedPublicTrackers))
+        m_deselectedPublicTrackers.remove(tracker.url());
+    if (isAddTrackersEnabled()) {
+        for (const TrackerEntry &tracker : asConst(m_additionalTrackerList))
+            m_deselectedPublicTrackers.remove(tracker.url());
+    }
+
+    m_publicTrackersQueue.clear();
+    for (TorrentHandle *const torrent : asConst(m_torrents)) {
+        // dormant torrents get the trackers once they are woken up for other reasons
+        if (!torrent->isDormant() && !torrent->isPrivate())
+            m_publicTrackersQueue.enqueue(torrent->hash());
+    }
+
+    m_arePublicTrackersApplied = false;
+    applyQueuedPublicTrackers();
+    if (!m_publicTrackersQueue.isEmpty())
+        m_publicTrackersTimer->start();
+}
+
+void Session::applyQueuedPublicTrackers()
+{
+    for (int i = 0; (i < PUBLIC_TRACKERS_BATCH_SIZE) && !m_publicTrackersQueue.isEmpty(); ++i) {
+        TorrentHandle *const torrent = m_torrents.value(m_publicTrackersQueue.dequeue());
+        if (!torrent || torrent->isDormant()) continue;
+
+        QStringList removedTrackers;
+        for (const QString &trackerUrl : asConst(m_deselectedPublicTrackers)) {
+            if (torrent->hasTracker(trackerUrl))
+                removedTrackers << trackerUrl;
+        }
+        if (!removedTrackers.isEmpty())
+            torrent->removeTrackers(removedTrackers);
+
+        // adding trackers doesn't disturb the announces to the other ones
+        torrent->addTrackers(m_selectedPublicTrackers);
+    }
+
+    if (m_publicTrackersQueue.isEmpty()) {
+        m_publicTrackersTimer->stop();
+        m_deselectedPublicTrackers.clear();
+        m_arePublicTrackersApplied = true;
+    }
+}
+
+void Session::evaluatePublicTrackers()
+{
+    m_trackerHealthRegistry->removeExpiredAnnounces();
+
+    const QList<TrackerEntry> previouslySelected = m_selectedPublicTrackers;
+    selectPublicTrackers();
+    if ((m_selectedPublicTrackers != previouslySelected) || !m_arePublicTrackersApplied)
+        applyPublicTrackers();
 }
 
 void Session::processShareLimits()
 {
+    QBT_TRACE_SCOPE("session", "processShareLimits");
     qDebug("Processing share limits...");
 
     for (TorrentHandle *const torrent : asConst(torrents())) {
@@ -1895,7 +2678,7 @@ void Session::handleRedirectedToMagnet(const QString &url, const QString &magnet
 void Session::handleDownloadFinished(const QString &url, const QByteArray &data)
 {
     emit downloadFromUrlFinished(url);
-    addTorrent_impl(m_downloadedTorrents.take(url), MagnetUri(), TorrentInfo::load(data));
+    enqueueTorrentDecoding(url, data, m_downloadedTorrents.take(url), false);
 }
 
 // Return the torrent handle, given its hash
@@ -1938,7 +2721,7 @@ void Session::banIP(const QString &ip)
         Q_ASSERT(!ec);
         if (ec) return;
         filter.add_rule(addr, addr, libt::ip_filter::blocked);
-        m_nativeSession->set_ip_filter(filter);
+        setNativeIPFilter(filter);
 
         bannedIPs << ip;
         bannedIPs.sort();
@@ -1964,7 +2747,7 @@ void Session::tempblockIP(const QString &ip)
     Q_ASSERT(!ec);
     if (ec) return;
     filter.add_rule(addr, addr, libt::ip_filter::blocked);
-    m_nativeSession->set_ip_filter(filter);
+    setNativeIPFilter(filter);
     insertQueue(ip);
 }
 
@@ -1976,7 +2759,7 @@ void Session::removeBlockedIP(const QString &ip)
     Q_ASSERT(!ec);
     if (ec) return;
     filter.add_rule(addr, addr, 0);
-    m_nativeSession->set_ip_filter(filter);
+    setNativeIPFilter(filter);
 }
 
 void Session::eraseIPFilter()
@@ -1993,13 +2776,16 @@ void Session::eraseIPFilter()
 
 void Session::autoBanBadClient()
 {
+    QBT_TRACE_SCOPE("session", "autoBanBadClient");
     const auto *session = BitTorrent::Session::instance();
     const BitTorrent::SessionStatus tStatus = session->status();
     if (tStatus.peersCount > 0) {
         bool m_AutoBanUnknown = session->isAutoBanUnknownPeerEnabled();
         bool m_AutoBanPlayer = session->isAutoBanBTPlayerPeerEnabled();
+        bool m_AutoBanLeecher = session->isAutoBanLeecherPeerEnabled();
         foreach (BitTorrent::TorrentHandle *const torrent, BitTorrent::Session::instance()->torrents()) {
             if (!torrent->isPrivate()) {
+                const bool isLeecherDetectionEnabled = m_AutoBanLeecher && torrent->hasMetadata();
                 QList<BitTorrent::PeerInfo> peers = torrent->peers();
                 foreach (const BitTorrent::PeerInfo &peer, peers) {
                     BitTorrent::PeerAddress addr = peer.address();
@@ -2040,11 +2826,32 @@ void Session::autoBanBadClient()
                             qDebug("Auto Banning BitTorrent Media Player Peer %s...", ip.toLocal8Bit().data());
                             Logger::instance()->addMessage(tr("Auto banning BitTorrent Media Player Peer '%1'...'%2'...'%3'...'%4'").arg(ip).arg(pid).arg(ptoc).arg(country));
                             tempblockIP(ip);
+                            continue;
+                        }
+                    }
+                    if (isLeecherDetectionEnabled) {
+                        PeerBehaviourTracker::Observation observation;
+                        observation.progress = peer.progress();
+                        observation.totalUpload = peer.totalUpload();
+                        observation.isRemoteInterested = peer.isRemoteInterested();
+                        const PeerBehaviourTracker::Verdict verdict = m_peerBehaviourTracker->observe(torrent->hash(), addr.ip, port
+                            , observation, torrent->totalSize(), torrent->pieceLength());
+                        if (verdict == PeerBehaviourTracker::Verdict::Leecher) {
+                            qDebug("Auto Banning Leeching Peer %s...", ip.toLocal8Bit().data());
+                            Logger::instance()->addMessage(tr("Auto banning Leeching Peer '%1'...'%2'...'%3'...'%4'").arg(ip).arg(pid).arg(ptoc).arg(country));
+                            tempblockIP(ip);
+                        }
+                        else if (verdict == PeerBehaviourTracker::Verdict::FakeProgress) {
+                            qDebug("Auto Banning Fake Progress Peer %s...", ip.toLocal8Bit().data());
+                            Logger::instance()->addMessage(tr("Auto banning Peer reporting impossible progress '%1'...'%2'...'%3'...'%4'").arg(ip).arg(pid).arg(ptoc).arg(country));
+                            tempblockIP(ip);
                         }
                     }
                 }
             }
         }
+        if (m_AutoBanLeecher)
+            m_peerBehaviourTracker->removeStale();
     }
 }
 
@@ -2079,11 +2886,38 @@ bool Session::deleteTorrent(const QString &hash, bool deleteLocalFiles)
     TorrentHandle *const torrent = m_torrents.take(hash);
     if (!torrent) return false;
 
+    m_torrentQueue.removeOne(torrent);
+    m_isTorrentQueueDirty = true;
+    m_deferredStatusUpdates.remove(torrent->hash());
+    m_updatedTorrents.remove(torrent);
+    m_pendingFastRechecks.remove(torrent->hash());
+    m_peerBehaviourTracker->forgetTorrent(torrent->hash());
+    m_announceScheduler->forgetTorrent(torrent->hash());
+    // A running move can't be stopped but is no reason to hold its devices anymore
+    m_storageJobScheduler->finishJob(m_storageJobScheduler->findJob(torrent->hash()));
+    if (deleteLocalFiles && torrentSharesFiles(torrent)) {
+        LogMsg(tr("The files of '%1' are kept since other torrents use them.").arg(torrent->name()), Log::WARNING);
+        deleteLocalFiles = false;
+    }
+
     qDebug("Deleting torrent with hash: %s", qUtf8Printable(torrent->hash()));
     emit torrentAboutToBeRemoved(torrent);
 
     // Remove it from session
-    if (deleteLocalFiles) {
+    if (torrent->isDormant() && !(deleteLocalFiles && wakeUpTorrent(torrent))) {
+        // libtorrent doesn't know the torrent so there is no alert to wait for
+        if (deleteLocalFiles) {
+            LogMsg(tr("Couldn't load '%1' to delete its files, deleting them from its save path instead.")
+                   .arg(torrent->name()), Log::WARNING);
+            const QStringList filePaths = torrent->absoluteFilePaths();
+            if (!filePaths.isEmpty())
+                QMetaObject::invokeMethod(m_storageWorker, "removeFiles", Q_ARG(QStringList, filePaths));
+            else
+                LogMsg(tr("The files of '%1' are unknown and were kept.").arg(torrent->name()), Log::CRITICAL);
+        }
+        LogMsg(tr("'%1' was removed from the transfer list.", "'xxx.avi' was removed...").arg(torrent->name()));
+    }
+    else if (deleteLocalFiles) {
         QString rootPath = torrent->rootPath(true);
         if (!rootPath.isEmpty())
             // torrent with root folder
@@ -2093,7 +2927,21 @@ bool Session::deleteTorrent(const QString &hash, bool deleteLocalFiles)
             m_removingTorrents[torrent->hash()] = {torrent->name(), torrent->savePath(true), deleteLocalFiles};
         else
             m_removingTorrents[torrent->hash()] = {torrent->name(), "", deleteLocalFiles};
-        m_nativeSession->remove_torrent(torrent->nativeHandle(), libt::session::delete_files);
+
+        // libtorrent deletes the files once the storage devices are free,
+        // meanwhile the torrent only waits, out of the way of the others
+        libt::torrent_handle nativeHandle = torrent->nativeHandle();
+        nativeHandle.auto_managed(false);
+        nativeHandle.pause();
+        nativeHandle.queue_position_bottom();
+
+        StorageJob job;
+        job.type = StorageJob::Removal;
+        job.hash = torrent->hash();
+        job.name = torrent->name();
+        job.sourcePath = torrent->savePath(true);
+        job.size = torrent->wantedSize();
+        m_queuedRemovals[m_storageJobScheduler->addJob(job)] = nativeHandle;
     }
     else {
         m_removingTorrents[torrent->hash()] = {torrent->name(), "", deleteLocalFiles};
@@ -2101,18 +2949,13 @@ bool Session::deleteTorrent(const QString &hash, bool deleteLocalFiles)
         if (torrent->hasMetadata())
             unwantedFiles = torrent->absoluteFilePathsUnwanted();
 #if LIBTORRENT_VERSION_NUM < 10100
-        m_nativeSession->remove_torrent(torrent->nativeHandle());
+        nativeSessionFor(torrent->hash())->remove_torrent(torrent->nativeHandle());
 #else
-        m_nativeSession->remove_torrent(torrent->nativeHandle(), libt::session::delete_partfile);
+        nativeSessionFor(torrent->hash())->remove_torrent(torrent->nativeHandle(), libt::session::delete_partfile);
 #endif
         // Remove unwanted and incomplete files
-        for (const QString &unwantedFile : asConst(unwantedFiles)) {
-            qDebug("Removing unwanted file: %s", qUtf8Printable(unwantedFile));
-            Utils::Fs::forceRemove(unwantedFile);
-            const QString parentFolder = Utils::Fs::branchPath(unwantedFile);
-            qDebug("Attempt to remove parent folder (if empty): %s", qUtf8Printable(parentFolder));
-            QDir().rmdir(parentFolder);
-        }
+        if (!unwantedFiles.isEmpty())
+            QMetaObject::invokeMethod(m_storageWorker, "removeFiles", Q_ARG(QStringList, unwantedFiles));
     }
 
     // Remove it from torrent resume directory
@@ -2123,8 +2966,12 @@ bool Session::deleteTorrent(const QString &hash, bool deleteLocalFiles)
     for (const QString &file : files)
         Utils::Fs::forceRemove(resumeDataDir.absoluteFilePath(file));
 
+    // Only now since waking it up above indexes it
+    m_crossSeedIndex->removeTorrent(torrent->hash());
     delete torrent;
     qDebug("Torrent deleted.");
+
+    startStorageJobs();
     return true;
 }
 
@@ -2133,7 +2980,11 @@ bool Session::cancelLoadMetadata(const InfoHash &hash)
     if (!m_loadedMetadata.contains(hash)) return false;
 
     m_loadedMetadata.remove(hash);
-    libt::torrent_handle torrent = m_nativeSession->find_torrent(hash);
+    // Nothing to remove if it didn't get its turn yet
+    if (removeQueuedMetadataFetch(hash)) return true;
+
+    m_activeMetadataFetches.remove(hash);
+    libt::torrent_handle torrent = nativeSessionFor(hash)->find_torrent(hash);
     if (!torrent.is_valid()) return false;
 
     if (!torrent.status(0).has_metadata) {
@@ -2143,107 +2994,229 @@ bool Session::cancelLoadMetadata(const InfoHash &hash)
     }
 
     // Remove it from session
-    m_nativeSession->remove_torrent(torrent, libt::session::delete_files);
+    nativeSessionFor(hash)->remove_torrent(torrent, libt::session::delete_files);
     qDebug("Preloaded torrent deleted.");
+    startMetadataFetches();
     return true;
 }
 
-void Session::increaseTorrentsPriority(const QStringList &hashes)
+// Returns the queue positions of the given torrents in ascending order
+QVector<int> Session::torrentQueuePositions(const QStringList &hashes)
 {
-    std::priority_queue<QPair<int, TorrentHandle *>,
-            std::vector<QPair<int, TorrentHandle *>>,
-            std::greater<QPair<int, TorrentHandle *>>> torrentQueue;
+    refreshTorrentQueue();
 
-    // Sort torrents by priority
+    QVector<int> positions;
+    positions.reserve(hashes.size());
     for (const InfoHash infoHash : hashes) {
-        TorrentHandle *const torrent = m_torrents.value(infoHash);
-        if (torrent && !torrent->isSeed())
-            torrentQueue.push(qMakePair(torrent->queuePosition(), torrent));
+        const TorrentHandle *torrent = m_torrents.value(infoHash);
+        if (torrent && (torrent->queuePosition() > 0))
+            positions.append(torrent->queuePosition() - 1);
     }
 
-    // Increase torrents priority (starting with the ones with highest priority)
-    while (!torrentQueue.empty()) {
-        TorrentHandle *const torrent = torrentQueue.top().second;
-        torrentQueuePositionUp(torrent->nativeHandle());
-        torrentQueue.pop();
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+    return positions;
+}
+
+void Session::increaseTorrentsPriority(const QStringList &hashes)
+{
+    // Starting with the ones with highest priority, so a selected torrent
+    // never overtakes another selected one that can't move any further
+    int firstFreePosition = 0;
+    for (const int position : asConst(torrentQueuePositions(hashes))) {
+        if (position == firstFreePosition) {
+            ++firstFreePosition;
+            continue;
+        }
+
+        if (isSameNativeQueue(m_torrentQueue[position], m_torrentQueue[position - 1]))
+            torrentQueuePositionUp(m_torrentQueue[position]->nativeHandle());
+        std::swap(m_torrentQueue[position], m_torrentQueue[position - 1]);
+        updateTorrentQueuePositions(position - 1, position + 1);
     }
 
-    saveTorrentsQueue();
+    scheduleTorrentsQueueSave();
 }
 
 void Session::decreaseTorrentsPriority(const QStringList &hashes)
 {
-    std::priority_queue<QPair<int, TorrentHandle *>,
-            std::vector<QPair<int, TorrentHandle *>>,
-            std::less<QPair<int, TorrentHandle *>>> torrentQueue;
+    const QVector<int> positions = torrentQueuePositions(hashes);
 
-    // Sort torrents by priority
-    for (const InfoHash infoHash : hashes) {
-        TorrentHandle *const torrent = m_torrents.value(infoHash);
-        if (torrent && !torrent->isSeed())
-            torrentQueue.push(qMakePair(torrent->queuePosition(), torrent));
-    }
+    // Starting with the ones with lowest priority
+    int lastFreePosition = m_torrentQueue.size() - 1;
+    for (auto it = positions.crbegin(); it != positions.crend(); ++it) {
+        const int position = *it;
+        if (position == lastFreePosition) {
+            --lastFreePosition;
+            continue;
+        }
 
-    // Decrease torrents priority (starting with the ones with lowest priority)
-    while (!torrentQueue.empty()) {
-        TorrentHandle *const torrent = torrentQueue.top().second;
-        torrentQueuePositionDown(torrent->nativeHandle());
-        torrentQueue.pop();
+        if (isSameNativeQueue(m_torrentQueue[position], m_torrentQueue[position + 1]))
+            torrentQueuePositionDown(m_torrentQueue[position]->nativeHandle());
+        std::swap(m_torrentQueue[position], m_torrentQueue[position + 1]);
+        updateTorrentQueuePositions(position, position + 2);
     }
 
-    for (auto i = m_loadedMetadata.cbegin(); i != m_loadedMetadata.cend(); ++i)
-        torrentQueuePositionBottom(m_nativeSession->find_torrent(i.key()));
-
-    saveTorrentsQueue();
+    moveUnlistedTorrentsToBottom();
+    scheduleTorrentsQueueSave();
 }
 
 void Session::topTorrentsPriority(const QStringList &hashes)
 {
-    std::priority_queue<QPair<int, TorrentHandle *>,
-            std::vector<QPair<int, TorrentHandle *>>,
-            std::less<QPair<int, TorrentHandle *>>> torrentQueue;
+    const QVector<int> positions = torrentQueuePositions(hashes);
+    // Nothing to do if they are on the top already
+    if (positions.isEmpty() || (positions.last() == (positions.size() - 1))) return;
 
-    // Sort torrents by priority
-    for (const InfoHash infoHash : hashes) {
-        TorrentHandle *const torrent = m_torrents.value(infoHash);
-        if (torrent && !torrent->isSeed())
-            torrentQueue.push(qMakePair(torrent->queuePosition(), torrent));
-    }
+    // Starting with the ones with lowest priority, so the selection keeps its order
+    for (auto it = positions.crbegin(); it != positions.crend(); ++it)
+        torrentQueuePositionTop(m_torrentQueue[*it]->nativeHandle());
 
-    // Top torrents priority (starting with the ones with lowest priority)
-    while (!torrentQueue.empty()) {
-        TorrentHandle *const torrent = torrentQueue.top().second;
-        torrentQueuePositionTop(torrent->nativeHandle());
-        torrentQueue.pop();
-    }
+    QVector<bool> isSelected(m_torrentQueue.size(), false);
+    for (const int position : positions)
+        isSelected[position] = true;
+    const auto firstChanged = m_torrentQueue.begin() + positions.first();
+    const auto lastChanged = m_torrentQueue.begin() + positions.last() + 1;
+    std::stable_partition(firstChanged, lastChanged, [&isSelected](TorrentHandle *torrent)
+    {
+        return isSelected[torrent->queuePosition() - 1];
+    });
+    std::rotate(m_torrentQueue.begin(), firstChanged, firstChanged + positions.size());
+    updateTorrentQueuePositions(0, (positions.last() + 1));
 
-    saveTorrentsQueue();
+    scheduleTorrentsQueueSave();
 }
 
 void Session::bottomTorrentsPriority(const QStringList &hashes)
 {
-    std::priority_queue<QPair<int, TorrentHandle *>,
-            std::vector<QPair<int, TorrentHandle *>>,
-            std::greater<QPair<int, TorrentHandle *>>> torrentQueue;
+    const QVector<int> positions = torrentQueuePositions(hashes);
+    if (!positions.isEmpty() && (positions.first() != (m_torrentQueue.size() - positions.size()))) {
+        // Starting with the ones with highest priority, so the selection keeps its order
+        for (const int position : positions)
+            torrentQueuePositionBottom(m_torrentQueue[position]->nativeHandle());
+
+        QVector<bool> isSelected(m_torrentQueue.size(), false);
+        for (const int position : positions)
+            isSelected[position] = true;
+        const auto firstChanged = m_torrentQueue.begin() + positions.first();
+        const auto lastChanged = m_torrentQueue.begin() + positions.last() + 1;
+        std::stable_partition(firstChanged, lastChanged, [&isSelected](TorrentHandle *torrent)
+        {
+            return !isSelected[torrent->queuePosition() - 1];
+        });
+        std::rotate((lastChanged - positions.size()), lastChanged, m_torrentQueue.end());
+        updateTorrentQueuePositions(positions.first(), m_torrentQueue.size());
+    }
 
-    // Sort torrents by priority
-    for (const InfoHash infoHash : hashes) {
-        TorrentHandle *const torrent = m_torrents.value(infoHash);
-        if (torrent && !torrent->isSeed())
-            torrentQueue.push(qMakePair(torrent->queuePosition(), torrent));
+    moveUnlistedTorrentsToBottom();
+    scheduleTorrentsQueueSave();
+}
+
+// The planned order is kept, libtorrent only tells which torrents are queued:
+// the ones which left its queue (e.g. finished) are dropped and the ones
+// which joined it are appended, as libtorrent appends them too
+void Session::refreshTorrentQueue()
+{
+    if (!m_isTorrentQueueDirty) return;
+
+    QSet<const TorrentHandle *> listedTorrents;
+    QVector<TorrentHandle *> queue;
+    queue.reserve(m_torrentQueue.size());
+    for (TorrentHandle *const torrent : asConst(m_torrentQueue)) {
+        listedTorrents.insert(torrent);
+        if (torrent->isQueued())
+            queue.append(torrent);
+        else
+            setTorrentQueuePosition(torrent, -1);
     }
 
-    // Bottom torrents priority (starting with the ones with highest priority)
-    while (!torrentQueue.empty()) {
-        TorrentHandle *const torrent = torrentQueue.top().second;
-        torrentQueuePositionBottom(torrent->nativeHandle());
-        torrentQueue.pop();
+    const int joinedCount = queue.size();
+    for (TorrentHandle *const torrent : asConst(m_torrents)) {
+        if (listedTorrents.contains(torrent)) continue;
+
+        if (torrent->isQueued())
+            queue.append(torrent);
+        else if (torrent->queuePosition() > 0)
+            setTorrentQueuePosition(torrent, -1);
     }
+    // Restored torrents come with the position they were saved with
+    std::sort((queue.begin() + joinedCount), queue.end()
+        , [](const TorrentHandle *left, const TorrentHandle *right)
+    {
+        const int leftPosition = (left->queuePosition() > 0) ? left->queuePosition() : std::numeric_limits<int>::max();
+        const int rightPosition = (right->queuePosition() > 0) ? right->queuePosition() : std::numeric_limits<int>::max();
+        if (leftPosition != rightPosition)
+            return (leftPosition < rightPosition);
+        return (left->nativeQueuePosition() < right->nativeQueuePosition());
+    });
+
+    m_torrentQueue = queue;
+    updateTorrentQueuePositions(0, m_torrentQueue.size());
+    m_isTorrentQueueDirty = false;
+}
+
+// libtorrent also queues preloaded magnets and the torrents waiting to be removed.
+// They are kept below the others, so that moving a torrent by one native
+// position moves it past its neighbour in the planned queue.
+void Session::moveUnlistedTorrentsToBottom()
+{
+    for (auto it = m_activeMetadataFetches.cbegin(); it != m_activeMetadataFetches.cend(); ++it)
+        torrentQueuePositionBottom(nativeSessionFor(it.key())->find_torrent(it.key()));
+    for (const libt::torrent_handle &nativeHandle : asConst(m_queuedRemovals))
+        torrentQueuePositionBottom(nativeHandle);
+}
+
+// libtorrent appends a torrent added again to its queue,
+// so it's moved back up to where the plan has it
+void Session::restoreNativeQueuePosition(TorrentHandle *const torrent)
+{
+    refreshTorrentQueue();
+
+    const int position = torrent->queuePosition() - 1;
+    if (position < 0) return;
+
+    int moves = 0;
+    for (int i = position + 1; i < m_torrentQueue.size(); ++i) {
+        if (isSameNativeQueue(torrent, m_torrentQueue[i]))
+            ++moves;
+    }
+    for (; moves > 0; --moves)
+        torrentQueuePositionUp(torrent->nativeHandle());
+}
+
+// Neighbours in the planned queue are neighbours in the queue of their
+// native session only if both are in the same one. Moving a torrent past a
+// neighbour from another native session (or a dormant one) moves it only in the plan.
+bool Session::isSameNativeQueue(const TorrentHandle *left, const TorrentHandle *right) const
+{
+    return (!left->isDormant() && !right->isDormant()
+            && (nativeSessionFor(left->hash()) == nativeSessionFor(right->hash())));
+}
+
+void Session::updateTorrentQueuePositions(const int from, const int to)
+{
+    for (int position = from; position < to; ++position)
+        setTorrentQueuePosition(m_torrentQueue[position], position);
+}
 
-    for (auto i = m_loadedMetadata.cbegin(); i != m_loadedMetadata.cend(); ++i)
-        torrentQueuePositionBottom(m_nativeSession->find_torrent(i.key()));
+void Session::setTorrentQueuePosition(TorrentHandle *const torrent, const int position)
+{
+    if (torrent->queuePosition() == (position + 1)) return;
 
-    saveTorrentsQueue();
+    torrent->handleQueuePositionChanged(position);
+    m_updatedTorrents.insert(torrent);
+}
+
+void Session::scheduleTorrentsQueueSave()
+{
+    if (m_isTorrentsQueueSaveScheduled) return;
+
+    // coalesces bursts of reordering into a single write
+    m_isTorrentsQueueSaveScheduled = true;
+    QTimer::singleShot(0, this, [this]()
+    {
+        m_isTorrentsQueueSaveScheduled = false;
+        saveTorrentsQueue();
+    });
 }
 
 void Session::handleTorrentSaveResumeDataRequested(TorrentHandle *const torrent)
@@ -2252,11 +3225,166 @@ void Session::handleTorrentSaveResumeDataRequested(TorrentHandle *const torrent)
     ++m_numResumeData;
 }
 
+// Add a dormant torrent to libtorrent using its stored metadata and resume data.
+// It is added synchronously because the caller is about to use its native handle.
+bool Session::wakeUpTorrent(TorrentHandle *const torrent)
+{
+    qDebug("Waking up torrent '%s'...", qUtf8Printable(torrent->name()));
+
+    const TorrentInfo torrentInfo = torrent->info();
+    const QByteArray data = storedResumeData(torrent);
+    if (!torrentInfo.isValid() || data.isEmpty()) {
+        LogMsg(tr("Unable to resume torrent '%1'.", "e.g: Unable to resume torrent 'hash'.")
+               .arg(torrent->hash()), Log::CRITICAL);
+        return false;
+    }
+
+    libt::add_torrent_params p;
+    p.ti = torrentInfo.nativeInfo();
+    p.resume_data = std::vector<char> {data.constData(), (data.constData() + data.size())};
+    p.flags |= libt::add_torrent_params::flag_use_resume_save_path;
+    p.flags |= libt::add_torrent_params::flag_paused;
+    p.flags &= ~libt::add_torrent_params::flag_auto_managed;
+    p.flags &= ~libt::add_torrent_params::flag_duplicate_is_error;
+    p.storage_mode = isPreallocationEnabled() ? libt::storage_mode_allocate : libt::storage_mode_sparse;
+    p.max_connections = maxConnectionsPerTorrent();
+    p.max_uploads = maxUploadsPerTorrent();
+    p.save_path = Utils::Fs::toNativePath(torrent->savePath(true)).toStdString();
+
+    libt::error_code ec;
+    const libt::torrent_handle nativeHandle = nativeSessionFor(torrent->hash())->add_torrent(p, ec);
+    if (ec) {
+        LogMsg(tr("Couldn't add torrent. Reason: %1").arg(QString::fromLocal8Bit(ec.message().c_str()))
+               , Log::WARNING);
+        return false;
+    }
+
+    torrent->handleWokenUp(nativeHandle);
+    m_isTorrentQueueDirty = true;
+    moveUnlistedTorrentsToBottom();
+    restoreNativeQueuePosition(torrent);
+    if (isCrossSeedingEnabled())
+        m_crossSeedIndex->addTorrent(torrent);
+    return true;
+}
+
+// Returns false if the torrent has no resume data to compare its files with
+bool Session::fastRecheckTorrent(TorrentHandle *const torrent)
+{
+    if (torrent->isFastRechecking()) return true;
+
+    // The files are compared with the stats recorded when they were last known complete
+    const QByteArray storedData = storedResumeData(torrent);
+    if (storedData.isEmpty()) return false;
+
+    torrent->handleFastRecheckStarted();
+    // The stored copy can be older than the torrent state (file priorities, trackers, etc.),
+    // the job is started with up-to-date resume data, see handleTorrentResumeDataReady()
+    m_pendingFastRechecks[torrent->hash()] = storedData;
+    torrent->saveResumeData();
+    return true;
+}
+
+void Session::startFastRecheck(TorrentHandle *const torrent, const QByteArray &resumeData)
+{
+    FastRecheckJob job;
+    job.hash = torrent->hash();
+    job.torrentInfo = TorrentInfo {TorrentInfo::NativeConstPtr {new libt::torrent_info(*torrent->info().nativeInfo())}};
+    job.savePath = torrent->savePath(true);
+    job.resumeData = resumeData;
+    job.storedResumeData = m_pendingFastRechecks.take(torrent->hash());
+
+    QMetaObject::invokeMethod(m_fastRecheckWorker, "check", Q_ARG(FastRecheckJob, job));
+}
+
+void Session::handleFastRecheckFinished(const FastRecheckResult &result)
+{
+    TorrentHandle *const torrent = m_torrents.value(result.hash);
+    // The torrent could be removed or rechecked fully in the meantime
+    if (!torrent || !torrent->isFastRechecking()) return;
+
+    if (result.resumeData.isEmpty()) {
+        LogMsg(tr("Couldn't use the resume data of torrent '%1' to recheck it, checking all its data...")
+               .arg(torrent->name()), Log::WARNING);
+        torrent->handleFastRecheckFailed();
+        return;
+    }
+
+    // libtorrent can be told which pieces are valid only with resume data,
+    // so the torrent is added again the same way it is restored on startup
+    libt::session *const nativeSession = nativeSessionFor(torrent->hash());
+    nativeSession->remove_torrent(torrent->nativeHandle());
+
+    libt::add_torrent_params p;
+    p.ti = result.torrentInfo.nativeInfo();
+    p.resume_data = std::vector<char> {result.resumeData.constData(), (result.resumeData.constData() + result.resumeData.size())};
+    p.flags |= libt::add_torrent_params::flag_use_resume_save_path;
+    p.flags |= libt::add_torrent_params::flag_paused;
+    p.flags |= libt::add_torrent_params::flag_auto_managed;
+    p.flags |= libt::add_torrent_params::flag_stop_when_ready;
+    p.storage_mode = isPreallocationEnabled() ? libt::storage_mode_allocate : libt::storage_mode_sparse;
+    p.max_connections = maxConnectionsPerTorrent();
+    p.max_uploads = maxUploadsPerTorrent();
+    p.save_path = Utils::Fs::toNativePath(torrent->savePath(true)).toStdString();
+
+    libt::error_code ec;
+    const libt::torrent_handle nativeHandle = nativeSession->add_torrent(p, ec);
+    if (ec) {
+        LogMsg(tr("Couldn't add torrent. Reason: %1").arg(QString::fromLocal8Bit(ec.message().c_str()))
+               , Log::CRITICAL);
+        return;
+    }
+
+    torrent->handleFastRecheckFinished(nativeHandle);
+    m_isTorrentQueueDirty = true;
+    moveUnlistedTorrentsToBottom();
+    restoreNativeQueuePosition(torrent);
+
+    LogMsg(tr("'%1' was rechecked: %2 of unchanged files trusted, %3 hashed."
+              , "'xxx.avi' was rechecked: 10 GiB of unchanged files trusted, 20 MiB hashed.")
+           .arg(torrent->name(), Utils::Misc::friendlyUnit(result.skippedBytes)
+                , Utils::Misc::friendlyUnit(result.hashedBytes)));
+}
+
+QByteArray Session::storedResumeData(const TorrentHandle *torrent) const
+{
+    QByteArray data;
+    readFile(QDir(m_resumeFolderPath).absoluteFilePath(QString("%1.fastresume").arg(torrent->hash())), data);
+    return data;
+}
+
+TorrentInfo Session::storedTorrentInfo(const TorrentHandle *torrent) const
+{
+    return TorrentInfo::loadFromFile(QDir(m_resumeFolderPath).absoluteFilePath(QString("%1.torrent").arg(torrent->hash())));
+}
+
 QHash<InfoHash, TorrentHandle *> Session::torrents() const
 {
     return m_torrents;
 }
 
+const QVector<SessionMetric> &Session::sessionMetrics() const
+{
+    return m_sessionMetrics;
+}
+
+const QVector<qint64> &Session::sessionCounters() const
+{
+    return m_sessionCounters;
+}
+
+// Number of alerts handled in the last batch
+int Session::alertQueueDepth() const
+{
+    return m_alertQueueDepth;
+}
+
+// Number of torrents whose resume data was requested but not received yet
+int Session::pendingResumeDataCount() const
+{
+    return m_numResumeData;
+}
+
 TorrentStatusReport Session::torrentStatusReport() const
 {
     return m_torrentStatusReport;
@@ -2282,22 +3410,242 @@ bool Session::addTorrent(QString source, const AddTorrentParams &params)
         return true;
     }
 
-    TorrentFileGuard guard(source);
-    if (addTorrent_impl(params, MagnetUri(), TorrentInfo::loadFromFile(source))) {
-        guard.markAsAddedToSession();
-        return true;
+    return enqueueTorrentDecoding(source, QByteArray(), params, true);
+}
+
+// Loads the torrent file (from data if given) on the decoding thread,
+// then it waits in the queue for its turn to be added
+bool Session::enqueueTorrentDecoding(const QString &source, const QByteArray &data, const AddTorrentParams &params
+                                     , const bool isLocalFile)
+{
+    if ((m_decodingTorrents.size() + m_decodedTorrents.size()) >= MAX_PENDING_TORRENTS) {
+        ++m_failedTorrentCount;
+        const QString msg = tr("Too many torrents are waiting to be added");
+        LogMsg(tr("Couldn't add torrent '%1'. Reason: %2").arg(source, msg), Log::WARNING);
+        emit addTorrentFailed(msg);
+        if (isLocalFile) {
+            // removes the file if it's set to be removed anyway
+            const TorrentFileGuard guard {source};
+        }
+        return false;
     }
 
-    return false;
+    PendingTorrent pendingTorrent;
+    pendingTorrent.source = source;
+    pendingTorrent.isLocalFile = isLocalFile;
+    pendingTorrent.params = params;
+
+    const int id = ++m_lastDecodingId;
+    m_decodingTorrents.insert(id, pendingTorrent);
+    QMetaObject::invokeMethod(m_torrentDecoder, "decode"
+                              , Q_ARG(int, id), Q_ARG(QString, source), Q_ARG(QByteArray, data));
+    return true;
+}
+
+void Session::handleTorrentDecoded(const TorrentDecodeResult &result)
+{
+    PendingTorrent pendingTorrent = m_decodingTorrents.take(result.id);
+    if (!result.torrentInfo.isValid()) {
+        ++m_failedTorrentCount;
+        LogMsg(tr("Couldn't add torrent '%1'. Reason: %2").arg(pendingTorrent.source, result.error), Log::WARNING);
+        emit addTorrentFailed(result.error);
+        if (pendingTorrent.isLocalFile) {
+            // removes the file if it's set to be removed anyway
+            const TorrentFileGuard guard {pendingTorrent.source};
+        }
+        return;
+    }
+
+    pendingTorrent.torrentInfo = result.torrentInfo;
+    m_decodedTorrents.enqueue(pendingTorrent);
+    submitDecodedTorrents();
+}
+
+// Few at a time, so that the torrents are created without
+// blocking the main thread for long when their alerts come
+void Session::submitDecodedTorrents()
+{
+    while (!m_decodedTorrents.isEmpty() && (m_addingTorrents.size() < MAX_ADDING_TORRENTS)) {
+        const PendingTorrent pendingTorrent = m_decodedTorrents.dequeue();
+        if (!startCrossSeedCheck(pendingTorrent))
+            addPendingTorrent(pendingTorrent);
+    }
+}
+
+bool Session::addPendingTorrent(const PendingTorrent &pendingTorrent)
+{
+    const bool added = addTorrent_impl(pendingTorrent.params, MagnetUri(), pendingTorrent.torrentInfo);
+    if (pendingTorrent.isLocalFile) {
+        TorrentFileGuard guard {pendingTorrent.source};
+        if (added)
+            guard.markAsAddedToSession();
+    }
+    return added;
+}
+
+// Looks for the files of the torrent among the ones of the completed torrents.
+// Returns true if they are found, the torrent is then added once they are verified.
+bool Session::startCrossSeedCheck(const PendingTorrent &pendingTorrent)
+{
+    if (!isCrossSeedingEnabled()) return false;
+
+    // The known ones are handled (i.e. merged or refused) by addTorrent_impl()
+    const InfoHash hash = pendingTorrent.torrentInfo.hash();
+    if (m_torrents.contains(hash) || m_addingTorrents.contains(hash) || m_loadedMetadata.contains(hash)
+        || m_removingTorrents.contains(hash) || m_crossSeedChecks.contains(hash))
+        return false;
+
+    // The files are looked for in the layout the torrent will have
+    const bool hasRootFolder = CreateTorrentParams(pendingTorrent.params).hasRootFolder;
+    TorrentInfo torrentInfo {TorrentInfo::NativeConstPtr {new libt::torrent_info(*pendingTorrent.torrentInfo.nativeInfo())}};
+    if (!hasRootFolder)
+        torrentInfo.stripRootFolder();
+
+    const QString savePath = m_crossSeedIndex->findSavePath(torrentInfo, m_torrents);
+    if (savePath.isEmpty()) return false;
+
+    CrossSeedCheck check;
+    check.torrent = pendingTorrent;
+    check.torrent.params.createSubfolder = (hasRootFolder ? TriStateBool::True : TriStateBool::False);
+    check.savePath = savePath;
+    m_crossSeedChecks.insert(hash, check);
+
+    LogMsg(tr("Found the files of '%1' in '%2', verifying them...")
+           .arg(torrentInfo.name(), Utils::Fs::toNativePath(savePath)));
+
+    FastRecheckJob job;
+    job.hash = hash;
+    job.torrentInfo = torrentInfo;
+    job.savePath = savePath;
+    QMetaObject::invokeMethod(m_fastRecheckWorker, "verifySample", Q_ARG(FastRecheckJob, job));
+    return true;
+}
+
+void Session::handleCrossSeedVerified(const QString &hash, const bool valid)
+{
+    if (!m_crossSeedChecks.contains(hash)) return;
+
+    CrossSeedCheck check = m_crossSeedChecks.take(hash);
+    AddTorrentParams &params = check.torrent.params;
+    const QString name = check.torrent.torrentInfo.name();
+    if (valid) {
+        // Only a sample of the pieces was verified, libtorrent checks
+        // them all before the torrent is seeded
+        params.savePath = check.savePath;
+        params.useAutoTMM = TriStateBool::False;
+        params.disableTempPath = true;
+        params.skipChecking = false;
+        LogMsg(tr("'%1' uses the existing files in '%2'.")
+               .arg(name, Utils::Fs::toNativePath(check.savePath)));
+    }
+    else {
+        LogMsg(tr("The files found for '%1' don't match it, it is downloaded as usual.").arg(name), Log::INFO);
+    }
+
+    addPendingTorrent(check.torrent);
+    submitDecodedTorrents();
+}
+
+AddTorrentPipelineStatus Session::addTorrentPipelineStatus() const
+{
+    AddTorrentPipelineStatus status;
+    status.decoding = m_decodingTorrents.size();
+    status.waiting = m_decodedTorrents.size();
+    status.adding = m_addingTorrents.size();
+    status.writing = m_resumeDataSavingManager->pendingTorrentFiles();
+    status.verifying = m_crossSeedChecks.size();
+    status.added = m_addedTorrentCount;
+    status.failed = m_failedTorrentCount;
+    return status;
+}
+
+QList<StorageJob> Session::storageJobs() const
+{
+    return m_storageJobScheduler->jobs();
+}
+
+StorageQueueStatus Session::storageQueueStatus() const
+{
+    return m_storageJobScheduler->status();
+}
+
+bool Session::cancelStorageJob(const int id)
+{
+    const StorageJob job = m_storageJobScheduler->job(id);
+    if (!m_storageJobScheduler->cancelJob(id)) return false;
+
+    if (job.type == StorageJob::Removal) {
+        // The torrent is removed anyway, only its files are kept
+        const libt::torrent_handle nativeHandle = m_queuedRemovals.take(id);
+        m_removingTorrents[job.hash].requestedFileDeletion = false;
+#if LIBTORRENT_VERSION_NUM < 10100
+        nativeSessionFor(job.hash)->remove_torrent(nativeHandle);
+#else
+        nativeSessionFor(job.hash)->remove_torrent(nativeHandle, libt::session::delete_partfile);
+#endif
+    }
+    else {
+        TorrentHandle *const torrent = m_torrents.value(job.hash);
+        if (torrent)
+            torrent->cancelStorageMove();
+    }
+
+    startStorageJobs();
+    return true;
+}
+
+bool Session::setStorageJobPriority(const int id, const int priority)
+{
+    if (!m_storageJobScheduler->setJobPriority(id, priority)) return false;
+
+    startStorageJobs();
+    return true;
 }
 
 bool Session::addTorrent(const TorrentInfo &torrentInfo, const AddTorrentParams &params)
 {
     if (!torrentInfo.isValid()) return false;
 
+    PendingTorrent pendingTorrent;
+    pendingTorrent.source = torrentInfo.name();
+    pendingTorrent.isLocalFile = false;
+    pendingTorrent.params = params;
+    pendingTorrent.torrentInfo = torrentInfo;
+    if (startCrossSeedCheck(pendingTorrent)) return true;
+
     return addTorrent_impl(params, MagnetUri(), torrentInfo);
 }
 
+// Restore a paused torrent without adding it to libtorrent, see TorrentHandle::createDormant()
+bool Session::restoreDormantTorrent(CreateTorrentParams params, const InfoHash &hash, const QByteArray &fastresumeData)
+{
+    params.savePath = normalizeSavePath(params.savePath, "");
+
+    if (!params.category.isEmpty()) {
+        if (!m_categories.contains(params.category) && !addCategory(params.category)) {
+            qWarning() << "Couldn't create category" << params.category;
+            params.category = "";
+        }
+    }
+
+    TorrentHandle *const torrent = TorrentHandle::createDormant(this, hash, params, fastresumeData);
+    if (!torrent) return false;
+
+    m_torrents.insert(hash, torrent);
+    m_isTorrentQueueDirty = true;
+    // Its files are still in place, so other torrents must not move or delete them
+    if (isCrossSeedingEnabled())
+        indexCrossSeedFiles(torrent);
+    Logger::instance()->addMessage(tr("'%1' restored.", "'torrent name' restored.").arg(torrent->name()));
+
+    if (((torrent->ratioLimit() >= 0) || (torrent->seedingTimeLimit() >= 0))
+        && !m_seedingLimitTimer->isActive())
+        m_seedingLimitTimer->start();
+
+    emit torrentAdded(torrent);
+    return true;
+}
+
 // Add a torrent to the BitTorrent session
 bool Session::addTorrent_impl(CreateTorrentParams params, const MagnetUri &magnetUri,
                               TorrentInfo torrentInfo, const QByteArray &fastresumeData)
@@ -2331,21 +3679,36 @@ bool Session::addTorrent_impl(CreateTorrentParams params, const MagnetUri &magne
                     , MagnetUri {}, metadata, fastresumeData);
             }
 
-            // Reuse existing torrent_handle
-            lt::torrent_handle handle = m_nativeSession->find_torrent(hash);
-            // We need to pause it first to create TorrentHandle within the same
-            // underlying state as in other cases.
-            handle.auto_managed(false);
-            handle.pause();
-
             m_loadedMetadata.remove(hash);
-            m_addingTorrents.insert(hash, params);
-            return true;
+            if (!removeQueuedMetadataFetch(hash)) {
+                // Reuse existing torrent_handle
+                lt::torrent_handle handle = nativeSessionFor(hash)->find_torrent(hash);
+                // We need to pause it first to create TorrentHandle within the same
+                // underlying state as in other cases.
+                handle.auto_managed(false);
+                handle.pause();
+
+                m_activeMetadataFetches.remove(hash);
+                startMetadataFetches();
+                m_addingTorrents.insert(hash, params);
+                return true;
+            }
+            // Its metadata fetch didn't start yet, so the torrent downloads it itself
         }
 
         p = magnetUri.addTorrentParams();
+        // The metadata may be cached since the same magnet link was added before
+        if (!params.restored)
+            torrentInfo = m_metadataCache->load(hash);
+    }
+    else if (!torrentInfo.isValid()) {
+        // We can have an invalid torrentInfo when there isn't a matching
+        // .torrent file to the .fastresume we loaded. Possibly from a
+        // failed upgrade.
+        return false;
     }
-    else if (torrentInfo.isValid()) {
+
+    if (torrentInfo.isValid()) {
         if (!params.restored) {
             if (!params.hasRootFolder)
                 torrentInfo.stripRootFolder();
@@ -2369,16 +3732,11 @@ bool Session::addTorrent_impl(CreateTorrentParams params, const MagnetUri &magne
         p.ti = torrentInfo.nativeInfo();
         hash = torrentInfo.hash();
     }
-    else {
-        // We can have an invalid torrentInfo when there isn't a matching
-        // .torrent file to the .fastresume we loaded. Possibly from a
-        // failed upgrade.
-        return false;
-    }
 
     // We should not add torrent if it already
-    // processed or adding to session
-    if (m_addingTorrents.contains(hash) || m_loadedMetadata.contains(hash)) return false;
+    // processed or adding to session or still being removed
+    if (m_addingTorrents.contains(hash) || m_loadedMetadata.contains(hash)
+        || m_removingTorrents.contains(hash) || m_crossSeedChecks.contains(hash)) return false;
 
     TorrentHandle *const torrent = m_torrents.value(hash);
     if (torrent) {
@@ -2431,6 +3789,23 @@ bool Session::addTorrent_impl(CreateTorrentParams params, const MagnetUri &magne
         }
     }
 
+#if LIBTORRENT_VERSION_NUM >= 10100
+    // Added along with the torrent rather than one by one once it's created
+    if (!params.restored && !(torrentInfo.isValid() && torrentInfo.isPrivate())) {
+        QList<TrackerEntry> trackers;
+        if (isAddTrackersEnabled())
+            trackers += m_additionalTrackerList;
+        if (isAutoUpdateTrackersEnabled())
+            trackers += m_selectedPublicTrackers;
+
+        p.tracker_tiers.resize(p.trackers.size(), 0);
+        for (const TrackerEntry &tracker : asConst(trackers)) {
+            p.trackers.push_back(tracker.url().toStdString());
+            p.tracker_tiers.push_back(tracker.tier());
+        }
+    }
+#endif
+
     // Limits
     p.max_connections = maxConnectionsPerTorrent();
     p.max_uploads = maxUploadsPerTorrent();
@@ -2440,7 +3815,7 @@ bool Session::addTorrent_impl(CreateTorrentParams params, const MagnetUri &magne
 
     m_addingTorrents.insert(hash, params);
     // Adding torrent to BitTorrent session
-    m_nativeSession->async_add_torrent(p);
+    nativeSessionFor(hash)->async_add_torrent(p);
     return true;
 }
 
@@ -2461,36 +3836,164 @@ bool Session::findIncompleteFiles(TorrentInfo &torrentInfo, QString &savePath) c
             }
         }
 
-        return found;
-    };
+        return found;
+    };
+
+    bool found = findInDir(savePath, torrentInfo);
+    if (!found && isTempPathEnabled()) {
+        savePath = torrentTempPath(torrentInfo);
+        found = findInDir(savePath, torrentInfo);
+    }
+
+    return found;
+}
+
+// Load the metadata from the cache or queue the magnet link
+// to download its metadata
+bool Session::loadMetadata(const MagnetUri &magnetUri)
+{
+    if (!magnetUri.isValid()) return false;
+
+    const InfoHash hash = magnetUri.hash();
+
+    // We should not add torrent if it's already
+    // processed or adding to session
+    if (m_torrents.contains(hash)) return false;
+    if (m_addingTorrents.contains(hash)) return false;
+    if (m_loadedMetadata.contains(hash)) return false;
+
+    const TorrentInfo cachedMetadata = m_metadataCache->load(hash);
+    if (cachedMetadata.isValid()) {
+        // Delivered later, as it would be once downloaded
+        QTimer::singleShot(0, this, [this, cachedMetadata]() { emit metadataLoaded(cachedMetadata); });
+        return true;
+    }
+
+    m_queuedMetadataFetches.append({magnetUri.url(), hash});
+    m_loadedMetadata.insert(hash, TorrentInfo());
+
+    startMetadataFetches();
+    return true;
+}
+
+void Session::startMetadataFetches()
+{
+    while (!m_queuedMetadataFetches.isEmpty()
+           && (m_activeMetadataFetches.size() < maxActiveMetadataFetches())) {
+        const MagnetUri magnetUri {m_queuedMetadataFetches.takeFirst().magnetUri};
+        if (!startMetadataFetch(magnetUri)) {
+            m_loadedMetadata.remove(magnetUri.hash());
+            emit metadataLoadFailed(magnetUri.hash());
+        }
+    }
+
+    if (m_activeMetadataFetches.isEmpty())
+        m_metadataFetchTimer->stop();
+    else if (!m_metadataFetchTimer->isActive())
+        m_metadataFetchTimer->start();
+}
+
+bool Session::removeQueuedMetadataFetch(const InfoHash &hash)
+{
+    for (auto it = m_queuedMetadataFetches.begin(); it != m_queuedMetadataFetches.end(); ++it) {
+        if (it->hash == hash) {
+            m_queuedMetadataFetches.erase(it);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Session::checkMetadataFetchTimeouts()
+{
+    if (metadataFetchTimeout() <= 0) return;
+
+    const qint64 deadline = m_metadataFetchClock.elapsed() - (metadataFetchTimeout() * 1000);
+    QVector<InfoHash> expiredHashes;
+    for (auto it = m_activeMetadataFetches.cbegin(); it != m_activeMetadataFetches.cend(); ++it) {
+        if (it.value() < deadline)
+            expiredHashes.append(it.key());
+    }
+
+    for (const InfoHash &hash : asConst(expiredHashes)) {
+        cancelLoadMetadata(hash);
+        ++m_timedOutMetadataCount;
+        LogMsg(tr("Couldn't download the metadata of '%1' in time.").arg(hash), Log::WARNING);
+        emit metadataLoadFailed(hash);
+    }
+}
+
+void Session::startStorageJobs()
+{
+    const QList<StorageJob> startableJobs = m_storageJobScheduler->takeStartableJobs();
+    for (const StorageJob &job : startableJobs) {
+        if (job.type == StorageJob::Removal) {
+            nativeSessionFor(job.hash)->remove_torrent(m_queuedRemovals.take(job.id), libt::session::delete_files);
+            continue;
+        }
+
+        TorrentHandle *const torrent = m_torrents.value(job.hash);
+        if (torrent)
+            torrent->startStorageMove();
+        else
+            m_storageJobScheduler->finishJob(job.id);
+    }
+
+    if (m_storageJobScheduler->isEmpty())
+        m_storageJobTimer->stop();
+    else if (!m_storageJobTimer->isActive())
+        m_storageJobTimer->start();
+}
 
-    bool found = findInDir(savePath, torrentInfo);
-    if (!found && isTempPathEnabled()) {
-        savePath = torrentTempPath(torrentInfo);
-        found = findInDir(savePath, torrentInfo);
+void Session::updateStorageJobs()
+{
+    // libtorrent doesn't tell how far a move is, so the files already in the destination are measured
+    const QList<StorageJob> jobs = m_storageJobScheduler->jobs();
+    for (const StorageJob &job : jobs) {
+        if (!job.isRunning || (job.type != StorageJob::Move)
+            || m_measuringStorageJobs.contains(job.id)) continue;
+
+        const TorrentHandle *torrent = m_torrents.value(job.hash);
+        if (!torrent || !torrent->hasMetadata()) continue;
+
+        QStringList filePaths;
+        filePaths.reserve(torrent->filesCount());
+        for (int i = 0; i < torrent->filesCount(); ++i)
+            filePaths << torrent->filePath(i);
+
+        m_measuringStorageJobs.insert(job.id);
+        QMetaObject::invokeMethod(m_storageWorker, "measure"
+                                  , Q_ARG(int, job.id), Q_ARG(QString, job.destinationPath)
+                                  , Q_ARG(QStringList, filePaths));
     }
 
-    return found;
+    startStorageJobs();
 }
 
-// Add a torrent to the BitTorrent session in hidden mode
-// and force it to load its metadata
-bool Session::loadMetadata(const MagnetUri &magnetUri)
+void Session::handleStorageFolderTreeRemoved(const int jobId)
 {
-    if (!magnetUri.isValid()) return false;
+    if (jobId <= 0) return;
 
-    InfoHash hash = magnetUri.hash();
-    QString name = magnetUri.name();
+    m_storageJobScheduler->finishJob(jobId);
+    startStorageJobs();
+}
 
-    // We should not add torrent if it's already
-    // processed or adding to session
-    if (m_torrents.contains(hash)) return false;
-    if (m_addingTorrents.contains(hash)) return false;
-    if (m_loadedMetadata.contains(hash)) return false;
+void Session::handleStorageJobMeasured(const int jobId, const qint64 size)
+{
+    m_measuringStorageJobs.remove(jobId);
+    m_storageJobScheduler->setJobProgress(jobId, size);
+}
+
+// Add a torrent to the BitTorrent session in hidden mode
+// and force it to load its metadata
+bool Session::startMetadataFetch(const MagnetUri &magnetUri)
+{
+    const InfoHash hash = magnetUri.hash();
 
     qDebug("Adding torrent to preload metadata...");
     qDebug(" -> Hash: %s", qUtf8Printable(hash));
-    qDebug(" -> Name: %s", qUtf8Printable(name));
+    qDebug(" -> Name: %s", qUtf8Printable(magnetUri.name()));
 
     libt::add_torrent_params p = magnetUri.addTorrentParams();
 
@@ -2516,11 +4019,11 @@ bool Session::loadMetadata(const MagnetUri &magnetUri)
 
     // Adding torrent to BitTorrent session
     libt::error_code ec;
-    libt::torrent_handle h = m_nativeSession->add_torrent(p, ec);
+    nativeSessionFor(hash)->add_torrent(p, ec);
     if (ec) return false;
 
     // waiting for metadata...
-    m_loadedMetadata.insert(h.info_hash(), TorrentInfo());
+    m_activeMetadataFetches.insert(hash, m_metadataFetchClock.elapsed());
     ++m_extraLimit;
     adjustLimits();
 
@@ -2532,27 +4035,31 @@ void Session::exportTorrentFile(TorrentHandle *const torrent, TorrentExportFolde
     Q_ASSERT(((folder == TorrentExportFolder::Regular) && !torrentExportDirectory().isEmpty()) ||
              ((folder == TorrentExportFolder::Finished) && !finishedTorrentExportDirectory().isEmpty()));
 
-    QString validName = Utils::Fs::toValidFileSystemName(torrent->name());
-    QString torrentFilename = QString("%1.torrent").arg(torrent->hash());
-    QString torrentExportFilename = QString("%1.torrent").arg(validName);
-    QString torrentPath = QDir(m_resumeFolderPath).absoluteFilePath(torrentFilename);
-    QDir exportPath(folder == TorrentExportFolder::Regular ? torrentExportDirectory() : finishedTorrentExportDirectory());
-    if (exportPath.exists() || exportPath.mkpath(exportPath.absolutePath())) {
-        QString newTorrentPath = exportPath.absoluteFilePath(torrentExportFilename);
-        int counter = 0;
-        while (QFile::exists(newTorrentPath) && !Utils::Fs::sameFiles(torrentPath, newTorrentPath)) {
-            // Append number to torrent name to make it unique
-            torrentExportFilename = QString("%1 %2.torrent").arg(validName).arg(++counter);
-            newTorrentPath = exportPath.absoluteFilePath(torrentExportFilename);
-        }
+    // Copied from the backup on the I/O thread, after it's written
+    m_resumeDataSavingManager->exportTorrentFile(QString("%1.torrent").arg(torrent->hash())
+        , (folder == TorrentExportFolder::Regular ? torrentExportDirectory() : finishedTorrentExportDirectory())
+        , Utils::Fs::toValidFileSystemName(torrent->name()));
+}
 
-        if (!QFile::exists(newTorrentPath))
-            QFile::copy(torrentPath, newTorrentPath);
+// Backs up the torrent file in the resume folder and copies it to the export folder
+void Session::saveTorrentFile(TorrentHandle *const torrent)
+{
+    const TorrentInfo torrentInfo = torrent->info();
+    if (!torrentInfo.isValid()) {
+        LogMsg(tr("Couldn't save '%1.torrent'").arg(torrent->hash()), Log::CRITICAL);
+        return;
     }
+
+    // Generated on the I/O thread from a copy, as libtorrent keeps updating its own
+    m_resumeDataSavingManager->saveTorrentFile(QString("%1.torrent").arg(torrent->hash())
+        , TorrentInfo {TorrentInfo::NativeConstPtr {new libt::torrent_info(*torrentInfo.nativeInfo())}});
+    if (!torrentExportDirectory().isEmpty())
+        exportTorrentFile(torrent);
 }
 
 void Session::generateResumeData(bool final)
 {
+    QBT_TRACE_SCOPE("session", "generateResumeData");
     for (TorrentHandle *const torrent : asConst(m_torrents)) {
         if (!torrent->isValid()) continue;
 
@@ -2573,47 +4080,58 @@ void Session::saveResumeData()
     qDebug("Saving resume data...");
 
     // Pause session
-    m_nativeSession->pause();
+    for (const NativeShard &shard : asConst(m_nativeShards))
+        shard.session->pause();
+
+    // From now on alerts are popped here, so take over from the dispatcher threads
+    for (const NativeShard &shard : asConst(m_nativeShards))
+        shard.alertDispatcher->stop();
+    readAlerts();
 
     if (isQueueingSystemEnabled())
         saveTorrentsQueue();
     generateResumeData(true);
 
+    // A single native session can be waited on, several ones are polled in turn
+    const ulong waitTime = (m_nativeShards.size() > 1) ? 100 : (30 * 1000);
+    QElapsedTimer idleTimer;
+    idleTimer.start();
     while (m_numResumeData > 0) {
-        std::vector<libt::alert *> alerts;
-        getPendingAlerts(alerts, 30 * 1000);
-        if (alerts.empty()) {
+        if (idleTimer.hasExpired(30 * 1000)) {
             fprintf(stderr, " aborting with %d outstanding torrents to save resume data for\n", m_numResumeData);
             break;
         }
 
-        for (const auto a : alerts) {
-            switch (a->type()) {
-            case libt::save_resume_data_failed_alert::alert_type:
-            case libt::save_resume_data_alert::alert_type:
-                dispatchTorrentAlert(a);
-                break;
-            }
+        for (const NativeShard &shard : asConst(m_nativeShards)) {
+            std::vector<libt::alert *> alerts;
+            getPendingAlerts(shard.session, alerts, waitTime);
+            if (!alerts.empty())
+                idleTimer.restart();
+
+            for (const auto a : alerts) {
+                switch (a->type()) {
+                case libt::save_resume_data_failed_alert::alert_type:
+                case libt::save_resume_data_alert::alert_type:
+                    dispatchTorrentAlert(a);
+                    break;
+                }
 #if LIBTORRENT_VERSION_NUM < 10100
-            delete a;
+                delete a;
 #endif
+            }
         }
     }
 }
 
 void Session::saveTorrentsQueue()
 {
-    QMap<int, QString> queue; // Use QMap since it should be ordered by key
-    for (const TorrentHandle *torrent : asConst(torrents())) {
-        // We require actual (non-cached) queue position here!
-        const int queuePos = torrent->nativeHandle().queue_position();
-        if (queuePos >= 0)
-            queue[queuePos] = torrent->hash();
-    }
+    // The planned order is authoritative, no need to ask libtorrent for each position
+    refreshTorrentQueue();
 
     QByteArray data;
-    for (const QString &hash : asConst(queue))
-        data += (hash.toLatin1() + '\n');
+    data.reserve(m_torrentQueue.size() * 41);
+    for (const TorrentHandle *torrent : asConst(m_torrentQueue))
+        data += (QString(torrent->hash()).toLatin1() + '\n');
 
     const QString filename = QLatin1String {"queue"};
     QMetaObject::invokeMethod(m_resumeDataSavingManager, "save"
@@ -2933,6 +4451,85 @@ void Session::setBandwidthSchedulerEnabled(bool enabled)
     }
 }
 
+bool Session::isUploadRateControllerEnabled() const
+{
+    return m_isUploadRateControllerEnabled;
+}
+
+void Session::setUploadRateControllerEnabled(const bool enabled)
+{
+    if (enabled == isUploadRateControllerEnabled()) return;
+
+    m_isUploadRateControllerEnabled = enabled;
+    resetUploadRateController();
+    configureDeferred();
+}
+
+int Session::uploadRateControllerTargetDelay() const
+{
+    return m_uploadRateControllerTargetDelay;
+}
+
+void Session::setUploadRateControllerTargetDelay(int delay)
+{
+    delay = std::max(delay, 1);
+    if (delay == uploadRateControllerTargetDelay()) return;
+
+    m_uploadRateControllerTargetDelay = delay;
+    if (isUploadRateControllerEnabled())
+        configureDeferred();
+}
+
+int Session::uploadRateControllerMinLimit() const
+{
+    return m_uploadRateControllerMinLimit;
+}
+
+void Session::setUploadRateControllerMinLimit(int limit)
+{
+    limit = std::max(limit, 1);
+    if (limit == uploadRateControllerMinLimit()) return;
+
+    m_uploadRateControllerMinLimit = limit;
+    resetUploadRateController();
+    configureDeferred();
+}
+
+int Session::uploadRateControllerMaxLimit() const
+{
+    return m_uploadRateControllerMaxLimit;
+}
+
+void Session::setUploadRateControllerMaxLimit(int limit)
+{
+    limit = std::max(limit, 0);
+    if (limit == uploadRateControllerMaxLimit()) return;
+
+    // The next decision of the controller applies it
+    m_uploadRateControllerMaxLimit = limit;
+}
+
+int Session::autoUploadSpeedLimit() const
+{
+    return isUploadRateControllerEnabled() ? m_uploadRateController->limit() : 0;
+}
+
+// The configured limits (normal or alternative, as switched by the scheduler)
+// stay in effect, the controller only lowers them
+int Session::effectiveUploadSpeedLimit() const
+{
+    const int configuredLimit = uploadSpeedLimit();
+    const int autoLimit = autoUploadSpeedLimit();
+    if (autoLimit <= 0) return configuredLimit;
+    if (configuredLimit <= 0) return autoLimit;
+    return std::min(configuredLimit, autoLimit);
+}
+
+void Session::resetUploadRateController()
+{
+    m_uploadRateController->reset(uploadRateControllerMinLimit() * 1024);
+}
+
 uint Session::saveResumeDataInterval() const
 {
     return m_saveResumeDataInterval;
@@ -2978,6 +4575,20 @@ void Session::setAutoBanBTPlayerPeer(bool value)
     }
 }
 
+bool Session::isAutoBanLeecherPeerEnabled() const
+{
+    return m_autoBanLeecherPeer;
+}
+
+void Session::setAutoBanLeecherPeer(bool value)
+{
+    if (value != isAutoBanLeecherPeerEnabled()) {
+        m_autoBanLeecherPeer = value;
+        if (!value)
+            m_peerBehaviourTracker->clear();
+    }
+}
+
 bool Session::isShowTrackerAuthWindow() const
 {
     return m_showTrackerAuthWindow;
@@ -3184,9 +4795,53 @@ void Session::setPublicTrackers(const QString &trackers)
     if (trackers != publicTrackers()) {
         m_publicTrackers = trackers;
         populatePublicTrackers();
+        applyPublicTrackers();
     }
 }
 
+int Session::publicTrackersLimit() const
+{
+    return m_publicTrackersLimit;
+}
+
+void Session::setPublicTrackersLimit(int limit)
+{
+    limit = std::max(limit, 0);
+    if (limit == publicTrackersLimit()) return;
+
+    m_publicTrackersLimit = limit;
+    selectPublicTrackers();
+    applyPublicTrackers();
+}
+
+QStringList Session::selectedPublicTrackers() const
+{
+    QStringList trackers;
+    for (const TrackerEntry &tracker : asConst(m_selectedPublicTrackers))
+        trackers << tracker.url();
+    return trackers;
+}
+
+QHash<QString, TrackerHealth> Session::trackerHealth() const
+{
+    return m_trackerHealthRegistry->trackers();
+}
+
+bool Session::isAnnounceSpreadingEnabled() const
+{
+    return m_isAnnounceSpreadingEnabled;
+}
+
+void Session::setAnnounceSpreadingEnabled(const bool enabled)
+{
+    m_isAnnounceSpreadingEnabled = enabled;
+}
+
+QHash<QString, TrackerLoad> Session::trackerLoads() const
+{
+    return m_announceScheduler->loads();
+}
+
 bool Session::isIPFilteringEnabled() const
 {
     return m_isIPFilteringEnabled;
@@ -3255,6 +4910,11 @@ QStringList Session::bannedIPs() const
     return m_bannedIPs;
 }
 
+int Session::temporaryBannedIPsCount() const
+{
+    return q_bannedIPs.size();
+}
+
 int Session::maxConnectionsPerTorrent() const
 {
     return m_maxConnectionsPerTorrent;
@@ -3267,7 +4927,7 @@ void Session::setMaxConnectionsPerTorrent(int max)
         m_maxConnectionsPerTorrent = max;
 
         // Apply this to all session torrents
-        for (const auto &handle : m_nativeSession->get_torrents()) {
+        for (const auto &handle : nativeTorrents()) {
             if (!handle.is_valid()) continue;
             try {
                 handle.set_max_connections(max);
@@ -3289,7 +4949,7 @@ void Session::setMaxUploadsPerTorrent(int max)
         m_maxUploadsPerTorrent = max;
 
         // Apply this to all session torrents
-        for (const auto &handle : m_nativeSession->get_torrents()) {
+        for (const auto &handle : nativeTorrents()) {
             if (!handle.is_valid()) continue;
             try {
                 handle.set_max_uploads(max);
@@ -3336,6 +4996,7 @@ void Session::setAsyncIOThreads(const int num)
         return;
 
     m_asyncIOThreads = num;
+    resetDiskCacheTuner();
     configureDeferred();
 }
 
@@ -3377,6 +5038,7 @@ void Session::setDiskCacheSize(int size)
 #endif
     if (size != m_diskCacheSize) {
         m_diskCacheSize = size;
+        resetDiskCacheTuner();
         configureDeferred();
     }
 }
@@ -3456,6 +5118,7 @@ void Session::setSendBufferWatermark(int value)
     if (value == m_sendBufferWatermark) return;
 
     m_sendBufferWatermark = value;
+    resetDiskCacheTuner();
     configureDeferred();
 }
 
@@ -3485,6 +5148,20 @@ void Session::setSendBufferWatermarkFactor(int value)
     configureDeferred();
 }
 
+bool Session::isDiskAutoTuningEnabled() const
+{
+    return m_isDiskAutoTuningEnabled;
+}
+
+void Session::setDiskAutoTuningEnabled(const bool enabled)
+{
+    if (enabled == m_isDiskAutoTuningEnabled) return;
+
+    m_isDiskAutoTuningEnabled = enabled;
+    resetDiskCacheTuner();
+    configureDeferred();
+}
+
 bool Session::isAnonymousModeEnabled() const
 {
     return m_isAnonymousModeEnabled;
@@ -3857,6 +5534,47 @@ void Session::handleTorrentSavePathChanged(TorrentHandle *const torrent)
     emit torrentSavePathChanged(torrent);
 }
 
+void Session::handleTorrentStorageMoveRequested(TorrentHandle *const torrent, const QString &newPath)
+{
+    StorageJob job;
+    job.type = StorageJob::Move;
+    job.hash = torrent->hash();
+    job.name = torrent->name();
+    job.sourcePath = torrent->savePath(true);
+    job.destinationPath = newPath;
+    job.size = torrent->wantedSize();
+    m_storageJobScheduler->addJob(job);
+
+    startStorageJobs();
+}
+
+void Session::handleTorrentStorageMoveFinished(TorrentHandle *const torrent)
+{
+    m_storageJobScheduler->finishJob(m_storageJobScheduler->findJob(torrent->hash()));
+    startStorageJobs();
+}
+
+qreal Session::torrentStorageMoveProgress(const TorrentHandle *torrent) const
+{
+    const int jobId = m_storageJobScheduler->findJob(torrent->hash());
+    if (jobId == 0) return -2;
+
+    const StorageJob job = m_storageJobScheduler->job(jobId);
+    if (!job.isRunning) return -1;
+
+    return (job.size > 0) ? (static_cast<qreal>(job.doneSize) / job.size) : 0;
+}
+
+bool Session::torrentSharesFiles(const TorrentHandle *torrent) const
+{
+    return (isCrossSeedingEnabled() && m_crossSeedIndex->sharesFiles(torrent, m_torrents));
+}
+
+void Session::removeEmptyFolderTree(const QString &path)
+{
+    QMetaObject::invokeMethod(m_storageWorker, "removeFolderTree", Q_ARG(int, 0), Q_ARG(QString, path));
+}
+
 void Session::handleTorrentCategoryChanged(TorrentHandle *const torrent, const QString &oldCategory)
 {
     torrent->saveResumeData();
@@ -3928,15 +5646,12 @@ void Session::handleTorrentUrlSeedsRemoved(TorrentHandle *const torrent, const Q
 void Session::handleTorrentMetadataReceived(TorrentHandle *const torrent)
 {
     torrent->saveResumeData();
+    m_metadataCache->store(torrent->info());
+    if (isCrossSeedingEnabled())
+        m_crossSeedIndex->addTorrent(torrent);
 
     // Save metadata
-    const QDir resumeDataDir(m_resumeFolderPath);
-    QString torrentFile = resumeDataDir.absoluteFilePath(QString("%1.torrent").arg(torrent->hash()));
-    if (torrent->saveTorrentFile(torrentFile)) {
-        // Copy the torrent file to the export folder
-        if (!torrentExportDirectory().isEmpty())
-            exportTorrentFile(torrent);
-    }
+    saveTorrentFile(torrent);
 
     emit torrentMetadataLoaded(torrent);
 }
@@ -3963,6 +5678,9 @@ void Session::handleTorrentFinished(TorrentHandle *const torrent)
 {
     if (!torrent->hasError() && !torrent->hasMissingFiles())
         torrent->saveResumeData();
+    // Its files could have been renamed since it was indexed
+    if (isCrossSeedingEnabled())
+        m_crossSeedIndex->addTorrent(torrent);
     emit torrentFinished(torrent);
 
     qDebug("Checking if the torrent contains torrent files to download");
@@ -3994,7 +5712,8 @@ void Session::handleTorrentFinished(TorrentHandle *const torrent)
         emit allTorrentsFinished();
 }
 
-void Session::handleTorrentResumeDataReady(TorrentHandle *const torrent, const libtorrent::entry &data)
+void Session::handleTorrentResumeDataReady(TorrentHandle *const torrent, const libtorrent::entry &data
+                                           , const QStringList &statFilePaths)
 {
     --m_numResumeData;
 
@@ -4005,24 +5724,56 @@ void Session::handleTorrentResumeDataReady(TorrentHandle *const torrent, const l
     QByteArray out;
     libt::bencode(std::back_inserter(out), data);
 
+    // Not saved, the stored file stats are needed until the recheck is done
+    if (m_pendingFastRechecks.contains(torrent->hash())) {
+        startFastRecheck(torrent, out);
+        return;
+    }
+
     const QString filename = QString("%1.fastresume").arg(torrent->hash());
+    if (!statFilePaths.isEmpty()) {
+        QMetaObject::invokeMethod(m_resumeDataSavingManager, "saveWithFileStats"
+                                  , Q_ARG(QString, filename), Q_ARG(QByteArray, out)
+                                  , Q_ARG(QString, torrent->savePath(true)), Q_ARG(QStringList, statFilePaths));
+        return;
+    }
+
     QMetaObject::invokeMethod(m_resumeDataSavingManager, "save",
                               Q_ARG(QString, filename), Q_ARG(QByteArray, out));
 }
 
 void Session::handleTorrentResumeDataFailed(TorrentHandle *const torrent)
 {
-    Q_UNUSED(torrent)
     --m_numResumeData;
+
+    if (m_pendingFastRechecks.remove(torrent->hash()) > 0)
+        torrent->handleFastRecheckFailed();
+}
+
+void Session::handleTorrentTrackerAnnounce(TorrentHandle *const torrent, const QString &trackerUrl)
+{
+    m_trackerHealthRegistry->addAnnounce(trackerUrl, torrent->hash());
+    m_announceScheduler->addAnnounce(trackerUrl, torrent->hash());
 }
 
-void Session::handleTorrentTrackerReply(TorrentHandle *const torrent, const QString &trackerUrl)
+void Session::handleTorrentTrackerReply(TorrentHandle *const torrent, const QString &trackerUrl, const int numPeers)
 {
+    m_trackerHealthRegistry->addReply(trackerUrl, torrent->hash(), numPeers);
+    m_announceScheduler->addReply(trackerUrl, torrent->hash());
+
+    if (isAnnounceSpreadingEnabled() && m_announceScheduler->isCrowded(trackerUrl)) {
+        const int delay = m_announceScheduler->reschedule(trackerUrl);
+        if (delay > 0)
+            torrent->scheduleReannounce(trackerUrl, delay);
+    }
+
     emit trackerSuccess(torrent, trackerUrl);
 }
 
 void Session::handleTorrentTrackerError(TorrentHandle *const torrent, const QString &trackerUrl)
 {
+    m_trackerHealthRegistry->addFailure(trackerUrl, torrent->hash());
+    m_announceScheduler->addFailure(trackerUrl, torrent->hash());
     emit trackerError(torrent, trackerUrl);
 }
 
@@ -4032,6 +5783,11 @@ void Session::handleTorrentTrackerAuthenticationRequired(TorrentHandle *const to
     emit trackerAuthenticationRequired(torrent);
 }
 
+void Session::handleTorrentPieceRead(TorrentHandle *const torrent, const int index, const QByteArray &data)
+{
+    emit torrentPieceRead(torrent, index, data);
+}
+
 void Session::handleTorrentTrackerWarning(TorrentHandle *const torrent, const QString &trackerUrl)
 {
     emit trackerWarning(torrent, trackerUrl);
@@ -4107,7 +5863,7 @@ void Session::disableIPFilter()
     // applied bans.
     libt::ip_filter filter;
     processBannedIPs(filter);
-    m_nativeSession->set_ip_filter(filter);
+    setNativeIPFilter(filter);
 }
 
 // Insert banned IP to Queue
@@ -4318,7 +6074,7 @@ void Session::loadOfflineFilter() {
     Count = parseOfflineFilterFile(QDir::home().absoluteFilePath(".config")+"/qBittorrent/ipfilter.dat", offlineFilter);
 #endif
 
-    m_nativeSession->set_ip_filter(offlineFilter);
+    setNativeIPFilter(offlineFilter);
     Logger::instance()->addMessage(tr("Successfully parsed the offline downloader IP filter: %1 rules were applied.", "%1 is a number").arg(Count));
 }
 
@@ -4374,11 +6130,18 @@ void Session::startUpTorrents()
     } TorrentResumeData;
 
     int resumedTorrentsCount = 0;
-    const auto startupTorrent = [this, logger, &resumeDataDir, &resumedTorrentsCount](const TorrentResumeData &params)
+    int queuedTorrentsCount = 0;
+    const auto startupTorrent = [this, logger, &resumeDataDir, &resumedTorrentsCount, &queuedTorrentsCount](const TorrentResumeData &params)
     {
         QString filePath = resumeDataDir.filePath(QString("%1.torrent").arg(params.hash));
         qDebug() << "Starting up torrent" << params.hash << "...";
-        if (!addTorrent_impl(params.addTorrentData, params.magnetUri, TorrentInfo::loadFromFile(filePath), params.data))
+        CreateTorrentParams torrentParams = params.addTorrentData;
+        // libtorrent queues the torrents in the order they are started up
+        if (torrentParams.queuePosition > 0)
+            torrentParams.queuePosition = ++queuedTorrentsCount;
+        const bool isDormant = isDormantTorrentsEnabled() && torrentParams.paused && !params.magnetUri.isValid()
+                && restoreDormantTorrent(torrentParams, params.hash, params.data);
+        if (!isDormant && !addTorrent_impl(torrentParams, params.magnetUri, TorrentInfo::loadFromFile(filePath), params.data))
             logger->addMessage(tr("Unable to resume torrent '%1'.", "e.g: Unable to resume torrent 'hash'.")
                                .arg(params.hash), Log::CRITICAL);
 
@@ -4491,12 +6254,72 @@ quint64 Session::getAlltimeUL() const
     return m_statistics->getAlltimeUL();
 }
 
+const TimeSeriesStore *Session::transferHistory() const
+{
+    return m_transferHistory;
+}
+
+void Session::recordTransferHistory()
+{
+    if (!m_transferHistory->isValid()) return;
+
+    TimeSeriesStore::Sample sample;
+    sample.values[TimeSeriesStore::Upload] = m_status.uploadRate;
+    sample.values[TimeSeriesStore::Download] = m_status.downloadRate;
+    sample.values[TimeSeriesStore::PayloadUpload] = m_status.payloadUploadRate;
+    sample.values[TimeSeriesStore::PayloadDownload] = m_status.payloadDownloadRate;
+    sample.values[TimeSeriesStore::OverheadUpload] = m_status.ipOverheadUploadRate;
+    sample.values[TimeSeriesStore::OverheadDownload] = m_status.ipOverheadDownloadRate;
+    sample.values[TimeSeriesStore::DHTUpload] = m_status.dhtUploadRate;
+    sample.values[TimeSeriesStore::DHTDownload] = m_status.dhtDownloadRate;
+    sample.values[TimeSeriesStore::TrackerUpload] = m_status.trackerUploadRate;
+    sample.values[TimeSeriesStore::TrackerDownload] = m_status.trackerDownloadRate;
+    sample.values[TimeSeriesStore::UploadLimit] = effectiveUploadSpeedLimit();
+    sample.values[TimeSeriesStore::Peers] = m_status.peersCount;
+    sample.values[TimeSeriesStore::DiskReadQueue] = m_status.diskReadQueue;
+    sample.values[TimeSeriesStore::DiskWriteQueue] = m_status.diskWriteQueue;
+    sample.values[TimeSeriesStore::DiskJobQueue] = m_cacheStatus.jobQueueLength;
+    // the tuner holds the configured values unless it is enabled
+    const DiskCacheTuner::Settings &diskSettings = m_diskCacheTuner->settings();
+    sample.values[TimeSeriesStore::DiskCacheSize] = std::max(diskSettings.cacheSize, 0);
+    sample.values[TimeSeriesStore::DiskCacheUsed] = m_cacheStatus.totalUsedBuffers / 64;
+    sample.values[TimeSeriesStore::DiskReadHitRatio] = qRound(std::max<qreal>(m_cacheStatus.readRatio, 0) * 100);
+    sample.values[TimeSeriesStore::AsyncIOThreads] = diskSettings.asyncIOThreads;
+    sample.values[TimeSeriesStore::SendBufferWatermark] = diskSettings.sendBufferWatermark;
+
+    // only transferring torrents contribute, so idle ones don't cost a tracker URL parse
+    for (const TorrentHandle *torrent : asConst(m_torrents)) {
+        const int uploadRate = torrent->uploadPayloadRate();
+        const int downloadRate = torrent->downloadPayloadRate();
+        if ((uploadRate <= 0) && (downloadRate <= 0)) continue;
+
+        if (!torrent->category().isEmpty()) {
+            TimeSeriesStore::Rates &rates = sample.categories[torrent->category()];
+            rates.first += uploadRate;
+            rates.second += downloadRate;
+        }
+
+        const QString trackerHost = QUrl(torrent->currentTracker()).host();
+        if (!trackerHost.isEmpty()) {
+            TimeSeriesStore::Rates &rates = sample.trackers[trackerHost];
+            rates.first += uploadRate;
+            rates.second += downloadRate;
+        }
+    }
+
+    m_transferHistory->addSample((QDateTime::currentMSecsSinceEpoch() / 1000), sample);
+}
+
 void Session::refresh()
 {
-    m_nativeSession->post_torrent_updates();
-#if LIBTORRENT_VERSION_NUM >= 10100
-    m_nativeSession->post_session_stats();
+    for (const NativeShard &shard : asConst(m_nativeShards)) {
+#if LIBTORRENT_VERSION_NUM < 10100
+        shard.session->post_torrent_updates();
+#else
+        shard.session->post_torrent_updates(TorrentHandle::STATUS_QUERY_FLAGS);
+        shard.session->post_session_stats();
 #endif
+    }
 }
 
 void Session::handleIPFilterParsed(int ruleCount)
@@ -4504,7 +6327,7 @@ void Session::handleIPFilterParsed(int ruleCount)
     if (m_filterParser) {
         libt::ip_filter filter = m_filterParser->IPfilter();
         processBannedIPs(filter);
-        m_nativeSession->set_ip_filter(filter);
+        setNativeIPFilter(filter);
     }
     Logger::instance()->addMessage(tr("Successfully parsed the provided IP filter: %1 rules were applied.", "%1 is a number").arg(ruleCount));
     emit IPFilterParsed(false, ruleCount);
@@ -4515,7 +6338,7 @@ void Session::handleIPFilterError()
 {
     libt::ip_filter filter;
     processBannedIPs(filter);
-    m_nativeSession->set_ip_filter(filter);
+    setNativeIPFilter(filter);
 
     Logger::instance()->addMessage(tr("Error: Failed to parse the provided IP filter."), Log::CRITICAL);
     emit IPFilterParsed(true, 0);
@@ -4530,18 +6353,17 @@ void Session::dispatchAlerts(libt::alert *alertPtr)
 
     m_alerts.push_back(alertPtr);
 
-    if (wasEmpty) {
+    if (wasEmpty)
         m_alertsWaitCondition.wakeAll();
-        QMetaObject::invokeMethod(this, "readAlerts", Qt::QueuedConnection);
-    }
 }
 #endif
 
-void Session::getPendingAlerts(std::vector<libt::alert *> &out, ulong time)
+void Session::getPendingAlerts(libt::session *nativeSession, std::vector<libt::alert *> &out, ulong time)
 {
     Q_ASSERT(out.empty());
 
 #if LIBTORRENT_VERSION_NUM < 10100
+    Q_UNUSED(nativeSession);
     QMutexLocker lock(&m_alertsMutex);
 
     if (m_alerts.empty())
@@ -4550,11 +6372,36 @@ void Session::getPendingAlerts(std::vector<libt::alert *> &out, ulong time)
     m_alerts.swap(out);
 #else
     if (time > 0)
-        m_nativeSession->wait_for_alert(libt::milliseconds(time));
-    m_nativeSession->pop_alerts(&out);
+        nativeSession->wait_for_alert(libt::milliseconds(time));
+    nativeSession->pop_alerts(&out);
 #endif
 }
 
+// Torrents are spread across the native sessions by info hash
+libt::session *Session::nativeSessionFor(const InfoHash &hash) const
+{
+    if (m_nativeShards.size() == 1) return m_nativeSession;
+
+    const libt::sha1_hash nativeHash = hash;
+    return m_nativeShards[nativeHash[0] % m_nativeShards.size()].session;
+}
+
+std::vector<libt::torrent_handle> Session::nativeTorrents() const
+{
+    std::vector<libt::torrent_handle> torrents;
+    for (const NativeShard &shard : m_nativeShards) {
+        const std::vector<libt::torrent_handle> shardTorrents = shard.session->get_torrents();
+        torrents.insert(torrents.end(), shardTorrents.begin(), shardTorrents.end());
+    }
+    return torrents;
+}
+
+void Session::setNativeIPFilter(const libt::ip_filter &filter)
+{
+    for (const NativeShard &shard : asConst(m_nativeShards))
+        shard.session->set_ip_filter(filter);
+}
+
 bool Session::isCreateTorrentSubfolder() const
 {
     return m_isCreateTorrentSubfolder;
@@ -4565,42 +6412,90 @@ void Session::setCreateTorrentSubfolder(bool value)
     m_isCreateTorrentSubfolder = value;
 }
 
-// Read alerts sent by the BitTorrent session
 void Session::readAlerts()
 {
-    std::vector<libt::alert *> alerts;
-    getPendingAlerts(alerts);
+    for (int i = 0; i < m_nativeShards.size(); ++i)
+        readShardAlerts(i);
+}
 
-    for (const auto a : alerts) {
+// Handle the batch of alerts prepared by the alert dispatcher thread of a native session
+void Session::readShardAlerts(const int shard)
+{
+    QBT_TRACE_SCOPE("session", "readAlerts");
+    AlertDispatcher *const alertDispatcher = m_nativeShards[shard].alertDispatcher;
+    AlertBatch batch;
+    if (!alertDispatcher->takeBatch(batch)) return;
+    m_alertQueueDepth = static_cast<int>(batch.size());
+    m_alertShard = shard;
+
+    for (const auto a : batch.sessionAlerts) {
         handleAlert(a);
 #if LIBTORRENT_VERSION_NUM < 10100
         delete a;
 #endif
     }
+
+    for (const AlertBatch::TorrentAlerts &torrentAlerts : batch.torrentAlerts) {
+        handleTorrentAlerts(torrentAlerts.hash, torrentAlerts.alerts);
+#if LIBTORRENT_VERSION_NUM < 10100
+        for (const auto a : torrentAlerts.alerts)
+            delete a;
+#endif
+    }
+
+    alertDispatcher->releaseBatch();
+}
+
+LeecherStatistics Session::leecherStatistics() const
+{
+    const PeerBehaviourTracker::Statistics trackerStatistics = m_peerBehaviourTracker->statistics();
+    LeecherStatistics statistics;
+    statistics.trackedPeers = trackerStatistics.trackedPeers;
+    statistics.flagged = trackerStatistics.flagged;
+    statistics.banned = trackerStatistics.reported;
+    statistics.falsePositives = trackerStatistics.falsePositives;
+    return statistics;
+}
+
+MetadataStatistics Session::metadataStatistics() const
+{
+    const MetadataCache::Statistics cacheStatistics = m_metadataCache->statistics();
+    MetadataStatistics statistics;
+    statistics.cacheHits = cacheStatistics.hits;
+    statistics.cacheMisses = cacheStatistics.misses;
+    statistics.cachedTorrents = cacheStatistics.entries;
+    statistics.cacheSize = cacheStatistics.size;
+    statistics.activeFetches = m_activeMetadataFetches.size();
+    statistics.queuedFetches = m_queuedMetadataFetches.size();
+    statistics.fetched = m_fetchedMetadataCount;
+    statistics.timedOut = m_timedOutMetadataCount;
+    statistics.fetchTime = m_metadataFetchTime;
+    return statistics;
+}
+
+AlertStatistics Session::alertStatistics() const
+{
+    AlertStatistics statistics;
+    for (const NativeShard &shard : m_nativeShards) {
+        const AlertStatistics shardStatistics = shard.alertDispatcher->statistics();
+        statistics.received += shardStatistics.received;
+        statistics.collapsed += shardStatistics.collapsed;
+        statistics.batches += shardStatistics.batches;
+        statistics.largestBatch = std::max(statistics.largestBatch, shardStatistics.largestBatch);
+    }
+    return statistics;
 }
 
 void Session::handleAlert(libt::alert *a)
 {
+    QBT_TRACE_SCOPE("alert", a->what());
     try {
-        switch (a->type()) {
-        case libt::stats_alert::alert_type:
-        case libt::file_renamed_alert::alert_type:
-        case libt::file_completed_alert::alert_type:
-        case libt::torrent_finished_alert::alert_type:
-        case libt::save_resume_data_alert::alert_type:
-        case libt::save_resume_data_failed_alert::alert_type:
-        case libt::storage_moved_alert::alert_type:
-        case libt::storage_moved_failed_alert::alert_type:
-        case libt::torrent_paused_alert::alert_type:
-        case libt::torrent_resumed_alert::alert_type:
-        case libt::tracker_error_alert::alert_type:
-        case libt::tracker_reply_alert::alert_type:
-        case libt::tracker_warning_alert::alert_type:
-        case libt::fastresume_rejected_alert::alert_type:
-        case libt::torrent_checked_alert::alert_type:
-        case libt::metadata_received_alert::alert_type:
+        if (AlertDispatcher::isTorrentAlert(a->type())) {
             dispatchTorrentAlert(a);
-            break;
+            return;
+        }
+
+        switch (a->type()) {
         case libt::state_update_alert::alert_type:
             handleStateUpdateAlert(static_cast<libt::state_update_alert*>(a));
             break;
@@ -4655,9 +6550,29 @@ void Session::handleAlert(libt::alert *a)
     }
 }
 
+// The torrent is looked up once for all its alerts of a batch.
+// It may be deleted while they are handled, the rest are then handled as for an unknown torrent.
+void Session::handleTorrentAlerts(const InfoHash &hash, const std::vector<libt::alert *> &alerts)
+{
+    const QPointer<TorrentHandle> torrent = m_torrents.value(hash);
+    for (const auto a : alerts) {
+        QBT_TRACE_SCOPE("alert", a->what());
+        try {
+            handleTorrentAlert(torrent.data(), a);
+        }
+        catch (std::exception &exc) {
+            qWarning() << "Caught exception in " << Q_FUNC_INFO << ": " << QString::fromStdString(exc.what());
+        }
+    }
+}
+
 void Session::dispatchTorrentAlert(libt::alert *a)
 {
-    TorrentHandle *const torrent = m_torrents.value(static_cast<libt::torrent_alert*>(a)->handle.info_hash());
+    handleTorrentAlert(m_torrents.value(static_cast<libt::torrent_alert*>(a)->handle.info_hash()), a);
+}
+
+void Session::handleTorrentAlert(TorrentHandle *const torrent, libt::alert *a)
+{
     if (torrent) {
         torrent->handleAlert(a);
         return;
@@ -4682,6 +6597,10 @@ void Session::createTorrentHandle(const libt::torrent_handle &nativeHandle)
 
     TorrentHandle *const torrent = new TorrentHandle(this, nativeHandle, params);
     m_torrents.insert(torrent->hash(), torrent);
+    m_isTorrentQueueDirty = true;
+    moveUnlistedTorrentsToBottom();
+    if (isCrossSeedingEnabled())
+        m_crossSeedIndex->addTorrent(torrent);
 
     Logger *const logger = Logger::instance();
 
@@ -4692,25 +6611,16 @@ void Session::createTorrentHandle(const libt::torrent_handle &nativeHandle)
     }
     else {
         // The following is useless for newly added magnet
-        if (!fromMagnetUri) {
-            // Backup torrent file
-            const QDir resumeDataDir(m_resumeFolderPath);
-            const QString newFile = resumeDataDir.absoluteFilePath(QString("%1.torrent").arg(torrent->hash()));
-            if (torrent->saveTorrentFile(newFile)) {
-                // Copy the torrent file to the export folder
-                if (!torrentExportDirectory().isEmpty())
-                    exportTorrentFile(torrent);
-            }
-            else {
-                logger->addMessage(tr("Couldn't save '%1.torrent'").arg(torrent->hash()), Log::CRITICAL);
-            }
-        }
+        if (!fromMagnetUri)
+            saveTorrentFile(torrent);
 
+#if LIBTORRENT_VERSION_NUM < 10100
         if (isAddTrackersEnabled() && !torrent->isPrivate())
             torrent->addTrackers(m_additionalTrackerList);
 
         if (isAutoUpdateTrackersEnabled() && !torrent->isPrivate())
-            torrent->addTrackers(m_publicTrackerList);
+            torrent->addTrackers(m_selectedPublicTrackers);
+#endif
 
         logger->addMessage(tr("'%1' added to download list.", "'torrent name' was added to download list.")
                            .arg(torrent->name()));
@@ -4718,6 +6628,7 @@ void Session::createTorrentHandle(const libt::torrent_handle &nativeHandle)
         // In case of crash before the scheduled generation
         // of the fastresumes.
         torrent->saveResumeData();
+        ++m_addedTorrentCount;
     }
 
     if (((torrent->ratioLimit() >= 0) || (torrent->seedingTimeLimit() >= 0))
@@ -4735,6 +6646,8 @@ void Session::handleAddTorrentAlert(libt::add_torrent_alert *p)
 {
     if (p->error) {
         qDebug("/!\\ Error: Failed to add torrent!");
+        m_addingTorrents.remove(p->params.ti ? p->params.ti->info_hash() : p->params.info_hash);
+        ++m_failedTorrentCount;
         QString msg = QString::fromStdString(p->message());
         Logger::instance()->addMessage(tr("Couldn't add torrent. Reason: %1").arg(msg), Log::WARNING);
         emit addTorrentFailed(msg);
@@ -4742,6 +6655,8 @@ void Session::handleAddTorrentAlert(libt::add_torrent_alert *p)
     else {
         createTorrentHandle(p->handle);
     }
+
+    submitDecodedTorrents();
 }
 
 void Session::handleTorrentRemovedAlert(libt::torrent_removed_alert *p)
@@ -4763,7 +6678,10 @@ void Session::handleTorrentDeletedAlert(libt::torrent_deleted_alert *p)
     if (!m_removingTorrents.contains(p->info_hash))
         return;
     const RemovingTorrentData tmpRemovingTorrentData = m_removingTorrents.take(p->info_hash);
-    Utils::Fs::smartRemoveEmptyFolderTree(tmpRemovingTorrentData.savePathToRemove);
+    // The removal job ends once the leftover folders are removed
+    QMetaObject::invokeMethod(m_storageWorker, "removeFolderTree"
+                              , Q_ARG(int, m_storageJobScheduler->findJob(p->info_hash))
+                              , Q_ARG(QString, tmpRemovingTorrentData.savePathToRemove));
 
     LogMsg(tr("'%1' was removed from the transfer list and hard disk.", "'xxx.avi' was removed...").arg(tmpRemovingTorrentData.name));
 }
@@ -4775,7 +6693,9 @@ void Session::handleTorrentDeleteFailedAlert(libt::torrent_delete_failed_alert *
     const RemovingTorrentData tmpRemovingTorrentData = m_removingTorrents.take(p->info_hash);
     // libtorrent won't delete the directory if it contains files not listed in the torrent,
     // so we remove the directory ourselves
-    Utils::Fs::smartRemoveEmptyFolderTree(tmpRemovingTorrentData.savePathToRemove);
+    QMetaObject::invokeMethod(m_storageWorker, "removeFolderTree"
+                              , Q_ARG(int, m_storageJobScheduler->findJob(p->info_hash))
+                              , Q_ARG(QString, tmpRemovingTorrentData.savePathToRemove));
 
     if (p->error) {
         LogMsg(tr("'%1' was removed from the transfer list but the files couldn't be deleted. Error: %2", "'xxx.avi' was removed...")
@@ -4794,8 +6714,14 @@ void Session::handleMetadataReceivedAlert(const libt::metadata_received_alert *p
     if (m_loadedMetadata.contains(hash)) {
         --m_extraLimit;
         adjustLimits();
-        m_loadedMetadata[hash] = TorrentInfo(p->handle.torrent_file());
-        m_nativeSession->remove_torrent(p->handle, libt::session::delete_files);
+        const TorrentInfo metadata {p->handle.torrent_file()};
+        m_loadedMetadata[hash] = metadata;
+        m_metadataCache->store(metadata);
+        nativeSessionFor(hash)->remove_torrent(p->handle, libt::session::delete_files);
+
+        ++m_fetchedMetadataCount;
+        m_metadataFetchTime += m_metadataFetchClock.elapsed() - m_activeMetadataFetches.take(hash);
+        startMetadataFetches();
     }
 }
 
@@ -4854,30 +6780,30 @@ void Session::handlePeerBlockedAlert(libt::peer_blocked_alert *p)
 {
     boost::system::error_code ec;
     std::string ip = p->ip.to_string(ec);
-    QString reason;
-    switch (p->reason) {
+    if (ec) return;
+
+    // Translated only for the first attempt of each source
+    Logger::instance()->addPeer(QString::fromLatin1(ip.c_str()), true, p->reason, &Session::peerBlockedReason);
+}
+
+QString Session::peerBlockedReason(const int reason)
+{
+    switch (reason) {
     case libt::peer_blocked_alert::ip_filter:
-        reason = tr("due to IP filter.", "this peer was blocked due to ip filter.");
-        break;
+        return tr("due to IP filter.", "this peer was blocked due to ip filter.");
     case libt::peer_blocked_alert::port_filter:
-        reason = tr("due to port filter.", "this peer was blocked due to port filter.");
-        break;
+        return tr("due to port filter.", "this peer was blocked due to port filter.");
     case libt::peer_blocked_alert::i2p_mixed:
-        reason = tr("due to i2p mixed mode restrictions.", "this peer was blocked due to i2p mixed mode restrictions.");
-        break;
+        return tr("due to i2p mixed mode restrictions.", "this peer was blocked due to i2p mixed mode restrictions.");
     case libt::peer_blocked_alert::privileged_ports:
-        reason = tr("because it has a low port.", "this peer was blocked because it has a low port.");
-        break;
+        return tr("because it has a low port.", "this peer was blocked because it has a low port.");
     case libt::peer_blocked_alert::utp_disabled:
-        reason = trUtf8("because %1 is disabled.", "this peer was blocked because uTP is disabled.").arg(QString::fromUtf8(C_UTP)); // don't translate μTP
-        break;
+        return trUtf8("because %1 is disabled.", "this peer was blocked because uTP is disabled.").arg(QString::fromUtf8(C_UTP)); // don't translate μTP
     case libt::peer_blocked_alert::tcp_disabled:
-        reason = tr("because %1 is disabled.", "this peer was blocked because TCP is disabled.").arg("TCP"); // don't translate TCP
-        break;
+        return tr("because %1 is disabled.", "this peer was blocked because TCP is disabled.").arg("TCP"); // don't translate TCP
     }
 
-    if (!ec)
-        Logger::instance()->addPeer(QString::fromLatin1(ip.c_str()), true, reason);
+    return QString();
 }
 
 void Session::handlePeerBanAlert(libt::peer_ban_alert *p)
@@ -4915,7 +6841,7 @@ void Session::handleListenSucceededAlert(libt::listen_succeeded_alert *p)
             .arg(p->endpoint.address().to_string(ec).c_str(), proto, QString::number(p->endpoint.port())), Log::INFO);
 
     // Force reannounce on all torrents because some trackers blacklist some ports
-    std::vector<libt::torrent_handle> torrents = m_nativeSession->get_torrents();
+    std::vector<libt::torrent_handle> torrents = nativeTorrents();
     std::vector<libt::torrent_handle>::iterator it = torrents.begin();
     std::vector<libt::torrent_handle>::iterator itend = torrents.end();
     for ( ; it != itend; ++it)
@@ -4954,20 +6880,38 @@ void Session::handleExternalIPAlert(libt::external_ip_alert *p)
 #if LIBTORRENT_VERSION_NUM >= 10100
 void Session::handleSessionStatsAlert(libt::session_stats_alert *p)
 {
+    // Counters are cumulative per native session, so the global ones
+    // are summed up once every native session has reported
+    NativeShard &shard = m_nativeShards[m_alertShard];
+    std::copy(std::begin(p->values), std::end(p->values), shard.counters.begin());
+    shard.hasStats = true;
+    for (const NativeShard &otherShard : asConst(m_nativeShards)) {
+        if (!otherShard.hasStats) return;
+    }
+
+    m_sessionCounters.fill(0);
+    for (NativeShard &otherShard : m_nativeShards) {
+        for (int i = 0; i < m_sessionCounters.size(); ++i)
+            m_sessionCounters[i] += otherShard.counters[i];
+        otherShard.hasStats = false;
+    }
+    rebalanceShardRateLimits();
+    const QVector<qint64> &values = m_sessionCounters;
+
     qreal interval = m_statsUpdateTimer.restart() / 1000.;
 
-    m_status.hasIncomingConnections = static_cast<bool>(p->values[m_metricIndices.net.hasIncomingConnections]);
+    m_status.hasIncomingConnections = static_cast<bool>(values[m_metricIndices.net.hasIncomingConnections]);
 
-    const auto ipOverheadDownload = p->values[m_metricIndices.net.recvIPOverheadBytes];
-    const auto ipOverheadUpload = p->values[m_metricIndices.net.sentIPOverheadBytes];
-    const auto totalDownload = p->values[m_metricIndices.net.recvBytes] + ipOverheadDownload;
-    const auto totalUpload = p->values[m_metricIndices.net.sentBytes] + ipOverheadUpload;
-    const auto totalPayloadDownload = p->values[m_metricIndices.net.recvPayloadBytes];
-    const auto totalPayloadUpload = p->values[m_metricIndices.net.sentPayloadBytes];
-    const auto trackerDownload = p->values[m_metricIndices.net.recvTrackerBytes];
-    const auto trackerUpload = p->values[m_metricIndices.net.sentTrackerBytes];
-    const auto dhtDownload = p->values[m_metricIndices.dht.dhtBytesIn];
-    const auto dhtUpload = p->values[m_metricIndices.dht.dhtBytesOut];
+    const auto ipOverheadDownload = values[m_metricIndices.net.recvIPOverheadBytes];
+    const auto ipOverheadUpload = values[m_metricIndices.net.sentIPOverheadBytes];
+    const auto totalDownload = values[m_metricIndices.net.recvBytes] + ipOverheadDownload;
+    const auto totalUpload = values[m_metricIndices.net.sentBytes] + ipOverheadUpload;
+    const auto totalPayloadDownload = values[m_metricIndices.net.recvPayloadBytes];
+    const auto totalPayloadUpload = values[m_metricIndices.net.sentPayloadBytes];
+    const auto trackerDownload = values[m_metricIndices.net.recvTrackerBytes];
+    const auto trackerUpload = values[m_metricIndices.net.sentTrackerBytes];
+    const auto dhtDownload = values[m_metricIndices.dht.dhtBytesIn];
+    const auto dhtUpload = values[m_metricIndices.dht.dhtBytesOut];
 
     auto calcRate = [interval](quint64 previous, quint64 current)
     {
@@ -4996,24 +6940,55 @@ void Session::handleSessionStatsAlert(libt::session_stats_alert *p)
     m_status.trackerUpload = trackerUpload;
     m_status.dhtDownload = dhtDownload;
     m_status.dhtUpload = dhtUpload;
-    m_status.totalWasted = p->values[m_metricIndices.net.recvRedundantBytes]
-            + p->values[m_metricIndices.net.recvFailedBytes];
-    m_status.dhtNodes = p->values[m_metricIndices.dht.dhtNodes];
-    m_status.diskReadQueue = p->values[m_metricIndices.peer.numPeersUpDisk];
-    m_status.diskWriteQueue = p->values[m_metricIndices.peer.numPeersDownDisk];
-    m_status.peersCount = p->values[m_metricIndices.peer.numPeersConnected];
-
-    const int numBlocksRead = p->values[m_metricIndices.disk.numBlocksRead];
-    const int numBlocksCacheHits = p->values[m_metricIndices.disk.numBlocksCacheHits];
-    m_cacheStatus.totalUsedBuffers = p->values[m_metricIndices.disk.diskBlocksInUse];
+    m_status.totalWasted = values[m_metricIndices.net.recvRedundantBytes]
+            + values[m_metricIndices.net.recvFailedBytes];
+    m_status.dhtNodes = values[m_metricIndices.dht.dhtNodes];
+    m_status.diskReadQueue = values[m_metricIndices.peer.numPeersUpDisk];
+    m_status.diskWriteQueue = values[m_metricIndices.peer.numPeersDownDisk];
+    m_status.peersCount = values[m_metricIndices.peer.numPeersConnected];
+
+    const int numBlocksRead = values[m_metricIndices.disk.numBlocksRead];
+    const int numBlocksCacheHits = values[m_metricIndices.disk.numBlocksCacheHits];
+    m_cacheStatus.totalUsedBuffers = values[m_metricIndices.disk.diskBlocksInUse];
     m_cacheStatus.readRatio = static_cast<qreal>(numBlocksCacheHits) / std::max(numBlocksCacheHits + numBlocksRead, 1);
-    m_cacheStatus.jobQueueLength = p->values[m_metricIndices.disk.queuedDiskJobs];
+    m_cacheStatus.jobQueueLength = values[m_metricIndices.disk.queuedDiskJobs];
 
-    quint64 totalJobs = p->values[m_metricIndices.disk.writeJobs] + p->values[m_metricIndices.disk.readJobs]
-                  + p->values[m_metricIndices.disk.hashJobs];
+    quint64 totalJobs = values[m_metricIndices.disk.writeJobs] + values[m_metricIndices.disk.readJobs]
+                  + values[m_metricIndices.disk.hashJobs];
     m_cacheStatus.averageJobTime = totalJobs > 0
-                                   ? (p->values[m_metricIndices.disk.diskJobTime] / totalJobs) : 0;
-
+                                   ? (values[m_metricIndices.disk.diskJobTime] / totalJobs) : 0;
+
+    if (isDiskAutoTuningEnabled()) {
+        DiskCacheTuner::Sample sample;
+        sample.cacheHits = values[m_metricIndices.disk.numBlocksCacheHits];
+        sample.cacheMisses = values[m_metricIndices.disk.numBlocksRead];
+        sample.diskJobs = totalJobs;
+        sample.diskJobTime = values[m_metricIndices.disk.diskJobTime];
+        sample.averageJobTime = m_cacheStatus.averageJobTime;
+        sample.cacheUsedBlocks = m_cacheStatus.totalUsedBuffers;
+        sample.jobQueueLength = m_cacheStatus.jobQueueLength;
+        sample.peersWaitingForDisk = m_status.diskReadQueue;
+        sample.unchokedPeers = values[m_metricIndices.peer.numPeersUpUnchoked];
+        sample.uploadRate = m_status.payloadUploadRate;
+        sample.availableMemory = Utils::Misc::availableMemory();
+        if (m_diskCacheTuner->addSample(sample))
+            applyDiskTuning();
+    }
+
+    if (isUploadRateControllerEnabled()) {
+        const int configuredLimit = uploadSpeedLimit();
+        const int maxLimit = uploadRateControllerMaxLimit() * 1024;
+        UploadRateController::Sample sample;
+        sample.samplesAboveTarget = values[m_metricIndices.utp.samplesAboveTarget];
+        sample.samplesBelowTarget = values[m_metricIndices.utp.samplesBelowTarget];
+        sample.uploadRate = m_status.uploadRate;
+        sample.maxLimit = ((configuredLimit > 0) && (maxLimit > 0)) ? std::min(configuredLimit, maxLimit) : std::max(configuredLimit, maxLimit);
+        if (m_uploadRateController->addSample(sample))
+            applyBandwidthLimits();
+    }
+
+    applyBandwidthClasses();
+    recordTransferHistory();
     emit statsUpdated();
 }
 #else // LIBTORRENT_VERSION_NUM >= 10100
@@ -5051,6 +7026,23 @@ void Session::updateStats()
     m_cacheStatus.averageJobTime = cs.average_job_time;
     m_cacheStatus.queuedBytes = cs.queued_bytes; // it seems that it is constantly equal to zero
 
+    if (isDiskAutoTuningEnabled()) {
+        DiskCacheTuner::Sample sample;
+        sample.cacheHits = cs.blocks_read_hit;
+        sample.cacheMisses = cs.blocks_read - cs.blocks_read_hit;
+        sample.averageJobTime = cs.average_job_time;
+        sample.cacheUsedBlocks = cs.total_used_buffers;
+        sample.jobQueueLength = cs.job_queue_length;
+        sample.peersWaitingForDisk = ss.disk_read_queue;
+        sample.unchokedPeers = ss.num_unchoked;
+        sample.uploadRate = ss.payload_upload_rate;
+        sample.availableMemory = Utils::Misc::availableMemory();
+        if (m_diskCacheTuner->addSample(sample))
+            applyDiskTuning();
+    }
+
+    applyBandwidthClasses();
+    recordTransferHistory();
     emit statsUpdated();
 }
 #endif // LIBTORRENT_VERSION_NUM >= 10100
@@ -5061,12 +7053,40 @@ void Session::handleStateUpdateAlert(libt::state_update_alert *p)
     updateStats();
 #endif
 
+    const bool isSlowRefresh = ((++m_stateUpdateCount % SLOW_REFRESH_RATIO) == 0);
+
     for (const libt::torrent_status &status : p->status) {
         TorrentHandle *const torrent = m_torrents.value(status.info_hash);
-        if (torrent)
+        if (!torrent) continue;
+
+        // the torrent joined or left the queue behind our back (finished, rechecked, etc.)
+        if ((status.queue_position >= 0) != (torrent->queuePosition() > 0))
+            m_isTorrentQueueDirty = true;
+
+        if (isSlowRefresh || torrent->needsFastRefresh(status)) {
+            m_deferredStatusUpdates.remove(torrent->hash());
             torrent->handleStateUpdate(status);
+            m_updatedTorrents.insert(torrent);
+        }
+        else {
+            m_deferredStatusUpdates[torrent->hash()] = status;
+            torrent->handleDeferredStateUpdate(status);
+        }
+    }
+
+    if (isSlowRefresh) {
+        for (auto it = m_deferredStatusUpdates.cbegin(); it != m_deferredStatusUpdates.cend(); ++it) {
+            TorrentHandle *const torrent = m_torrents.value(it.key());
+            if (torrent) {
+                torrent->handleStateUpdate(it.value());
+                m_updatedTorrents.insert(torrent);
+            }
+        }
+        m_deferredStatusUpdates.clear();
     }
 
+    refreshTorrentQueue();
+
     m_torrentStatusReport = TorrentStatusReport();
     for (TorrentHandle *const torrent : asConst(m_torrents)) {
         if (torrent->isDownloading())
@@ -5087,7 +7107,9 @@ void Session::handleStateUpdateAlert(libt::state_update_alert *p)
             ++m_torrentStatusReport.nbErrored;
     }
 
-    emit torrentsUpdated();
+    const QVector<TorrentHandle *> updatedTorrents = m_updatedTorrents.toList().toVector();
+    m_updatedTorrents.clear();
+    emit torrentsUpdated(updatedTorrents);
 }
 
 namespace
@@ -5155,6 +7177,7 @@ namespace
         torrentParams.sequential = fast.dict_find_int_value("qBt-sequential");
 
         prio = fast.dict_find_int_value("qBt-queuePosition");
+        torrentParams.queuePosition = prio;
 
         return true;
     }
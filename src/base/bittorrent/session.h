@@ -34,6 +34,7 @@
 
 #include <vector>
 
+#include <QElapsedTimer>
 #include <QFile>
 #include <QHash>
 #include <QList>
@@ -49,8 +50,6 @@
 
 #if LIBTORRENT_VERSION_NUM < 10100
 #include <QMutex>
-#else
-#include <QElapsedTimer>
 #endif
 
 #include "base/settingvalue.h"
@@ -58,6 +57,7 @@
 #include "base/types.h"
 #include "addtorrentparams.h"
 #include "cachestatus.h"
+#include "infohash.h"
 #include "sessionstatus.h"
 #include "torrentinfo.h"
 
@@ -65,6 +65,7 @@ namespace libtorrent
 {
     class session;
     struct torrent_handle;
+    struct torrent_status;
     class entry;
     struct ip_filter;
 #if LIBTORRENT_VERSION_NUM < 10100
@@ -93,6 +94,7 @@ namespace libtorrent
     struct metadata_received_alert;
     struct file_error_alert;
     struct file_completed_alert;
+    struct tracker_announce_alert;
     struct tracker_error_alert;
     struct tracker_reply_alert;
     struct tracker_warning_alert;
@@ -116,10 +118,24 @@ class QStringList;
 class QString;
 class QUrl;
 
+class AlertDispatcher;
 class FilterParserThread;
 class BandwidthScheduler;
+class CrossSeedIndex;
 class Statistics;
 class ResumeDataSavingManager;
+class FastRecheckWorker;
+class AnnounceScheduler;
+class DiskCacheTuner;
+class MetadataCache;
+class PeerBehaviourTracker;
+class StorageJobScheduler;
+class StorageWorker;
+class TorrentDecoder;
+class TrackerHealthRegistry;
+class UploadRateController;
+struct FastRecheckResult;
+struct TorrentDecodeResult;
 
 enum MaxRatioAction
 {
@@ -139,6 +155,7 @@ namespace BitTorrent
     class TorrentHandle;
     class Tracker;
     class MagnetUri;
+    class TimeSeriesStore;
     class TrackerEntry;
     struct CreateTorrentParams;
 
@@ -154,6 +171,123 @@ namespace BitTorrent
         uint nbErrored = 0;
     };
 
+    // Description of a libtorrent session statistics value
+    struct SessionMetric
+    {
+        QByteArray name; // ex. "net.sent_bytes"
+        int valueIndex;
+        bool isGauge;
+    };
+
+    struct AlertStatistics
+    {
+        quint64 received = 0;
+        quint64 collapsed = 0; // left out as superseded by a later alert
+        quint64 batches = 0;
+        quint64 largestBatch = 0;
+    };
+
+    struct LeecherStatistics
+    {
+        int trackedPeers = 0;
+        quint64 flagged = 0; // got data without their progress growing
+        quint64 banned = 0;
+        quint64 falsePositives = 0; // flagged ones that caught up afterwards
+    };
+
+    // Torrents on their way into the session
+    struct AddTorrentPipelineStatus
+    {
+        int decoding = 0; // torrent files being loaded and validated
+        int waiting = 0; // loaded ones waiting for their turn to be added
+        int adding = 0; // being added by libtorrent
+        int writing = 0; // torrent file backups and exports not written yet
+        int verifying = 0; // checking the files of other torrents they could use
+        quint64 added = 0;
+        quint64 failed = 0;
+    };
+
+    // Metadata of the magnet links, downloaded or taken from the cache
+    struct MetadataStatistics
+    {
+        quint64 cacheHits = 0;
+        quint64 cacheMisses = 0;
+        int cachedTorrents = 0;
+        qint64 cacheSize = 0; // bytes
+        int activeFetches = 0;
+        int queuedFetches = 0;
+        quint64 fetched = 0;
+        quint64 timedOut = 0;
+        qint64 fetchTime = 0; // msecs, sum over the fetched ones
+    };
+
+    // Move or removal of the files of a torrent, run in turn with the others
+    // using the same storage devices
+    struct StorageJob
+    {
+        enum Type
+        {
+            Move,
+            Removal
+        };
+
+        int id = 0;
+        Type type = Move;
+        InfoHash hash;
+        QString name;
+        QString sourcePath;
+        QString destinationPath; // empty for removals
+        qint64 size = 0; // bytes
+        qint64 doneSize = 0;
+        int priority = 0; // higher ones run first
+        bool isRunning = false;
+    };
+
+    // Sizes include the jobs finished since the queue was last empty
+    struct StorageQueueStatus
+    {
+        int queued = 0;
+        int running = 0;
+        qint64 totalSize = 0; // bytes
+        qint64 doneSize = 0;
+    };
+
+    // Outcome of the announces of all the torrents to a tracker
+    struct TrackerHealth
+    {
+        quint64 replies = 0;
+        quint64 failures = 0;
+        qreal successRate = 0.5; // smoothed, of the latest announces
+        int latency = -1; // msecs, -1 if unknown
+        qreal peers = 0; // smoothed number of peers per reply
+        qreal score = 0;
+        bool isDead = false;
+    };
+
+    // Announces of all the torrents to a tracker host
+    struct TrackerLoad
+    {
+        int torrents = 0; // that announced in the last two hours
+        int announceRate = 0; // announces in the last minute
+        int backlog = 0; // announces waiting for an answer
+    };
+
+    // Bandwidth shared by the torrents of a category (and its subcategories) or of a tag
+    struct BandwidthClass
+    {
+        int uploadLimit = 0; // bytes per second, 0 if unlimited
+        int downloadLimit = 0;
+        int minUploadShare = 0; // percent of the global limit guaranteed to the class
+        int minDownloadShare = 0;
+    };
+
+    struct BandwidthClassStatus
+    {
+        int uploadRate = 0; // payload, bytes per second
+        int downloadRate = 0;
+        int torrentsCount = 0;
+    };
+
     class SessionSettingsEnums
     {
         Q_GADGET
@@ -218,6 +352,7 @@ namespace BitTorrent
             int numPeersConnected = 0;
             int numPeersUpDisk = 0;
             int numPeersDownDisk = 0;
+            int numPeersUpUnchoked = 0;
         } peer;
 
         struct
@@ -238,6 +373,12 @@ namespace BitTorrent
             int queuedDiskJobs = 0;
             int diskJobTime = 0;
         } disk;
+
+        struct
+        {
+            int samplesAboveTarget = 0;
+            int samplesBelowTarget = 0;
+        } utp;
     };
 #endif // LIBTORRENT_VERSION_NUM >= 10100
 
@@ -277,6 +418,15 @@ namespace BitTorrent
         bool addTag(const QString &tag);
         bool removeTag(const QString &tag);
 
+        // Setting a default constructed bandwidth class removes it
+        const QMap<QString, BandwidthClass> &categoryBandwidthClasses() const;
+        bool setCategoryBandwidthClass(const QString &category, const BandwidthClass &bandwidthClass);
+        const QMap<QString, BandwidthClass> &tagBandwidthClasses() const;
+        bool setTagBandwidthClass(const QString &tag, const BandwidthClass &bandwidthClass);
+        // As of the last statistics update
+        const QMap<QString, BandwidthClassStatus> &categoryBandwidthStatus() const;
+        const QMap<QString, BandwidthClassStatus> &tagBandwidthStatus() const;
+
         // Torrent Management Mode subsystem (TMM)
         //
         // Each torrent can be either in Manual mode or in Automatic mode
@@ -309,6 +459,39 @@ namespace BitTorrent
         void setPeXEnabled(bool enabled);
         bool isAddTorrentPaused() const;
         void setAddTorrentPaused(bool value);
+        // Paused torrents are restored without loading them into libtorrent (1.1 and later)
+        // until they are needed. Takes effect on the next start.
+        bool isDormantTorrentsEnabled() const;
+        void setDormantTorrentsEnabled(bool enabled);
+        // Torrents are spread by info hash across this many native sessions (1.1 and later),
+        // each listening on its own port next to port(). Takes effect on the next start.
+        // The queue order spans all of them but the active torrent limits apply to each one.
+        int nativeSessionCount() const;
+        void setNativeSessionCount(int count);
+        // Rechecking trusts the files that are unchanged since their resume data
+        // was saved (by size, modification time and inode) and hashes only the rest
+        bool isFastRecheckEnabled() const;
+        void setFastRecheckEnabled(bool enabled);
+        // New torrents whose files are already there for other (completed) torrents
+        // use them instead of downloading them again, once a few pieces are verified
+        bool isCrossSeedingEnabled() const;
+        void setCrossSeedingEnabled(bool enabled);
+        // Metadata of the magnet links is kept in a cache of this size (MiB),
+        // so that it isn't downloaded again. 0 disables the cache.
+        int metadataCacheSize() const;
+        void setMetadataCacheSize(int size);
+        // Metadata is downloaded for at most this many magnet links at once
+        int maxActiveMetadataFetches() const;
+        void setMaxActiveMetadataFetches(int max);
+        // secs, 0 if unlimited
+        int metadataFetchTimeout() const;
+        void setMetadataFetchTimeout(int timeout);
+        // Torrent files are moved or deleted by at most this many jobs at once on every device
+        int maxStorageJobsPerDevice() const;
+        void setMaxStorageJobsPerDevice(int max);
+        // KiB/s copied by the moves across devices on average, 0 if unlimited
+        int storageJobRateLimit() const;
+        void setStorageJobRateLimit(int limit);
         bool isCreateTorrentSubfolder() const;
         void setCreateTorrentSubfolder(bool value);
         bool isTrackerEnabled() const;
@@ -340,6 +523,20 @@ namespace BitTorrent
         void setAltGlobalSpeedLimitEnabled(bool enabled);
         bool isBandwidthSchedulerEnabled() const;
         void setBandwidthSchedulerEnabled(bool enabled);
+        // Keeps the queueing delay of the uplink under the target by lowering the
+        // upload limit, as told by the uTP delay samples (libtorrent 1.1 and later)
+        bool isUploadRateControllerEnabled() const;
+        void setUploadRateControllerEnabled(bool enabled);
+        int uploadRateControllerTargetDelay() const; // msecs
+        void setUploadRateControllerTargetDelay(int delay);
+        int uploadRateControllerMinLimit() const; // KiB/s
+        void setUploadRateControllerMinLimit(int limit);
+        int uploadRateControllerMaxLimit() const; // KiB/s, 0 if none
+        void setUploadRateControllerMaxLimit(int limit);
+        // Current limit of the controller in bytes per second, 0 if none
+        int autoUploadSpeedLimit() const;
+        // The upload speed limit lowered by the controller
+        int effectiveUploadSpeedLimit() const;
 
         uint saveResumeDataInterval() const;
         void setSaveResumeDataInterval(uint value);
@@ -347,6 +544,9 @@ namespace BitTorrent
         void setAutoBanUnknownPeer(bool value);
         bool isAutoBanBTPlayerPeerEnabled() const;
         void setAutoBanBTPlayerPeer(bool value);
+        // Bans peers whose reported progress doesn't match the data they get
+        bool isAutoBanLeecherPeerEnabled() const;
+        void setAutoBanLeecherPeer(bool value);
         bool isShowTrackerAuthWindow() const;
         void setShowTrackerAuthWindow(bool value);
         int port() const;
@@ -379,6 +579,16 @@ namespace BitTorrent
         QString publicTrackers() const;
         void setAdditionalTrackers(const QString &trackers);
         void setPublicTrackers(const QString &trackers);
+        // Number of the best scored public trackers added to the torrents, 0 for all of them
+        int publicTrackersLimit() const;
+        void setPublicTrackersLimit(int limit);
+        QStringList selectedPublicTrackers() const;
+        QHash<QString, TrackerHealth> trackerHealth() const;
+        // Keeps the announces to a same tracker host evenly spread over time
+        bool isAnnounceSpreadingEnabled() const;
+        void setAnnounceSpreadingEnabled(bool enabled);
+        // by tracker host
+        QHash<QString, TrackerLoad> trackerLoads() const;
         bool isIPFilteringEnabled() const;
         void setIPFilteringEnabled(bool enabled);
         QString IPFilterFile() const;
@@ -409,6 +619,11 @@ namespace BitTorrent
         void setSendBufferLowWatermark(int value);
         int sendBufferWatermarkFactor() const;
         void setSendBufferWatermarkFactor(int value);
+        // The disk cache size, I/O threads (1.1 and later) and send buffer watermark
+        // are adjusted to the cache statistics and upload demand, starting from
+        // the values above
+        bool isDiskAutoTuningEnabled() const;
+        void setDiskAutoTuningEnabled(bool enabled);
         bool isAnonymousModeEnabled() const;
         void setAnonymousModeEnabled(bool enabled);
         bool isQueueingSystemEnabled() const;
@@ -461,6 +676,8 @@ namespace BitTorrent
         void setTrackerFilteringEnabled(bool enabled);
         QStringList bannedIPs() const;
         void setBannedIPs(const QStringList &newList);
+        // IPs banned automatically until their ban expires
+        int temporaryBannedIPsCount() const;
 
         void startUpTorrents();
         TorrentHandle *findTorrent(const InfoHash &hash) const;
@@ -471,8 +688,24 @@ namespace BitTorrent
         bool hasRunningSeed() const;
         const SessionStatus &status() const;
         const CacheStatus &cacheStatus() const;
+        // All libtorrent session counters as of the last statistics update, indexed by SessionMetric::valueIndex
+        const QVector<SessionMetric> &sessionMetrics() const;
+        const QVector<qint64> &sessionCounters() const;
+        int alertQueueDepth() const;
+        AlertStatistics alertStatistics() const;
+        LeecherStatistics leecherStatistics() const;
+        MetadataStatistics metadataStatistics() const;
+        AddTorrentPipelineStatus addTorrentPipelineStatus() const;
+        QList<StorageJob> storageJobs() const;
+        StorageQueueStatus storageQueueStatus() const;
+        // Only the queued jobs can be cancelled, a cancelled removal keeps the files
+        bool cancelStorageJob(int id);
+        bool setStorageJobPriority(int id, int priority);
+        int pendingResumeDataCount() const;
         quint64 getAlltimeDL() const;
         quint64 getAlltimeUL() const;
+        // Persistent history of transfer rates, peers and disk queues
+        const TimeSeriesStore *transferHistory() const;
         bool isListening() const;
 
         MaxRatioAction maxRatioAction() const;
@@ -486,6 +719,8 @@ namespace BitTorrent
         QTimer *m_unbanTimer;
         QTimer *m_banTimer;
         QTimer *m_updateTimer;
+        QTimer *m_trackerEvaluationTimer;
+        QTimer *m_publicTrackersTimer;
 
         void autoBanBadClient();
         void banIP(const QString &ip);
@@ -512,9 +747,21 @@ namespace BitTorrent
 
         // TorrentHandle interface
         void handleTorrentSaveResumeDataRequested(TorrentHandle *const torrent);
+        bool wakeUpTorrent(TorrentHandle *const torrent);
+        bool fastRecheckTorrent(TorrentHandle *const torrent);
+        QByteArray storedResumeData(const TorrentHandle *torrent) const;
+        TorrentInfo storedTorrentInfo(const TorrentHandle *torrent) const;
         void handleTorrentShareLimitChanged(TorrentHandle *const torrent);
         void handleTorrentNameChanged(TorrentHandle *const torrent);
         void handleTorrentSavePathChanged(TorrentHandle *const torrent);
+        void handleTorrentStorageMoveRequested(TorrentHandle *const torrent, const QString &newPath);
+        void handleTorrentStorageMoveFinished(TorrentHandle *const torrent);
+        // -1 while the move waits for its turn, -2 if it has no job (e.g. its job is
+        // done and libtorrent didn't confirm the move yet)
+        qreal torrentStorageMoveProgress(const TorrentHandle *torrent) const;
+        // Whether other torrents use some of its files, see cross seeding
+        bool torrentSharesFiles(const TorrentHandle *torrent) const;
+        void removeEmptyFolderTree(const QString &path);
         void handleTorrentCategoryChanged(TorrentHandle *const torrent, const QString &oldCategory);
         void handleTorrentTagAdded(TorrentHandle *const torrent, const QString &tag);
         void handleTorrentTagRemoved(TorrentHandle *const torrent, const QString &tag);
@@ -529,16 +776,21 @@ namespace BitTorrent
         void handleTorrentTrackersChanged(TorrentHandle *const torrent);
         void handleTorrentUrlSeedsAdded(TorrentHandle *const torrent, const QList<QUrl> &newUrlSeeds);
         void handleTorrentUrlSeedsRemoved(TorrentHandle *const torrent, const QList<QUrl> &urlSeeds);
-        void handleTorrentResumeDataReady(TorrentHandle *const torrent, const libtorrent::entry &data);
+        // The stats of the given files (relative to the save path) are added to the data before it is saved
+        void handleTorrentResumeDataReady(TorrentHandle *const torrent, const libtorrent::entry &data
+                                          , const QStringList &statFilePaths = {});
         void handleTorrentResumeDataFailed(TorrentHandle *const torrent);
-        void handleTorrentTrackerReply(TorrentHandle *const torrent, const QString &trackerUrl);
+        void handleTorrentTrackerAnnounce(TorrentHandle *const torrent, const QString &trackerUrl);
+        void handleTorrentTrackerReply(TorrentHandle *const torrent, const QString &trackerUrl, int numPeers);
         void handleTorrentTrackerWarning(TorrentHandle *const torrent, const QString &trackerUrl);
         void handleTorrentTrackerError(TorrentHandle *const torrent, const QString &trackerUrl);
         void handleTorrentTrackerAuthenticationRequired(TorrentHandle *const torrent, const QString &trackerUrl);
+        void handleTorrentPieceRead(TorrentHandle *const torrent, int index, const QByteArray &data);
 
     signals:
         void statsUpdated();
-        void torrentsUpdated();
+        // `torrents` are the ones whose status or queue position changed
+        void torrentsUpdated(const QVector<BitTorrent::TorrentHandle *> &torrents);
         void addTorrentFailed(const QString &error);
         void torrentAdded(BitTorrent::TorrentHandle *const torrent);
         void torrentNew(BitTorrent::TorrentHandle *const torrent);
@@ -552,8 +804,10 @@ namespace BitTorrent
         void torrentTagAdded(TorrentHandle *const torrent, const QString &tag);
         void torrentTagRemoved(TorrentHandle *const torrent, const QString &tag);
         void torrentSavingModeChanged(BitTorrent::TorrentHandle *const torrent);
+        void torrentPieceRead(BitTorrent::TorrentHandle *const torrent, int index, const QByteArray &data);
         void allTorrentsFinished();
         void metadataLoaded(const BitTorrent::TorrentInfo &info);
+        void metadataLoadFailed(const BitTorrent::InfoHash &hash);
         void torrentMetadataLoaded(BitTorrent::TorrentHandle *const torrent);
         void fullDiskError(BitTorrent::TorrentHandle *const torrent, const QString &msg);
         void trackerSuccess(BitTorrent::TorrentHandle *const torrent, const QString &tracker);
@@ -581,6 +835,7 @@ namespace BitTorrent
     private slots:
         void configureDeferred();
         void readAlerts();
+        void readShardAlerts(int shard);
         void refresh();
         void processShareLimits();
         void generateResumeData(bool final = false);
@@ -606,6 +861,26 @@ namespace BitTorrent
             bool requestedFileDeletion;
         };
 
+        struct PendingTorrent
+        {
+            QString source; // URL or file path
+            bool isLocalFile;
+            AddTorrentParams params;
+            TorrentInfo torrentInfo;
+        };
+
+        struct CrossSeedCheck
+        {
+            PendingTorrent torrent;
+            QString savePath; // where the files of the torrent were found
+        };
+
+        struct MetadataFetch
+        {
+            QString magnetUri;
+            InfoHash hash;
+        };
+
         explicit Session(QObject *parent = nullptr);
         ~Session();
 
@@ -620,15 +895,22 @@ namespace BitTorrent
         void configure(libtorrent::session_settings &sessionSettings);
         void adjustLimits(libtorrent::session_settings &sessionSettings);
         void applyBandwidthLimits(libtorrent::session_settings &sessionSettings);
+        void applyDiskTuning(libtorrent::session_settings &sessionSettings);
 #else
         void configure(libtorrent::settings_pack &settingsPack);
         void configurePeerClasses();
         void adjustLimits(libtorrent::settings_pack &settingsPack);
         void applyBandwidthLimits(libtorrent::settings_pack &settingsPack);
+        void applyDiskTuning(libtorrent::settings_pack &settingsPack);
         void initMetrics();
 #endif
         void adjustLimits();
         void applyBandwidthLimits();
+        void applyDiskTuning();
+        void resetDiskCacheTuner();
+        void applyBandwidthClasses();
+        void resetUploadRateController();
+        void storeBandwidthClasses();
         void processBannedIPs(libtorrent::ip_filter &filter);
         const QStringList getListeningIPs();
         void configureListeningInterface();
@@ -636,21 +918,47 @@ namespace BitTorrent
         void enableBandwidthScheduler();
         void populateAdditionalTrackers();
         void populatePublicTrackers();
+        void selectPublicTrackers();
+        void applyPublicTrackers();
+        void applyQueuedPublicTrackers();
+        void evaluatePublicTrackers();
         void enableIPFilter();
         void disableIPFilter();
         int parseOfflineFilterFile(QString ipDat, libtorrent::ip_filter &filter);
         void loadOfflineFilter();
 
+        bool restoreDormantTorrent(CreateTorrentParams params, const InfoHash &hash, const QByteArray &fastresumeData);
+        void handleFastRecheckFinished(const FastRecheckResult &result);
+        void startFastRecheck(TorrentHandle *const torrent, const QByteArray &resumeData);
+        bool startCrossSeedCheck(const PendingTorrent &pendingTorrent);
+        void indexCrossSeedFiles(const TorrentHandle *torrent);
+        void handleCrossSeedVerified(const QString &hash, bool valid);
+        bool addPendingTorrent(const PendingTorrent &pendingTorrent);
         bool addTorrent_impl(CreateTorrentParams params, const MagnetUri &magnetUri,
                              TorrentInfo torrentInfo = TorrentInfo(),
                              const QByteArray &fastresumeData = QByteArray());
         bool findIncompleteFiles(TorrentInfo &torrentInfo, QString &savePath) const;
+        bool enqueueTorrentDecoding(const QString &source, const QByteArray &data, const AddTorrentParams &params
+                                    , bool isLocalFile);
+        void handleTorrentDecoded(const TorrentDecodeResult &result);
+        void submitDecodedTorrents();
+        void saveTorrentFile(TorrentHandle *const torrent);
+        void startMetadataFetches();
+        bool startMetadataFetch(const MagnetUri &magnetUri);
+        bool removeQueuedMetadataFetch(const InfoHash &hash);
+        void checkMetadataFetchTimeouts();
+        void startStorageJobs();
+        void updateStorageJobs();
+        void handleStorageFolderTreeRemoved(int jobId);
+        void handleStorageJobMeasured(int jobId, qint64 size);
 
         void updateSeedingLimitTimer();
         void exportTorrentFile(TorrentHandle *const torrent, TorrentExportFolder folder = TorrentExportFolder::Regular);
 
         void handleAlert(libtorrent::alert *a);
         void dispatchTorrentAlert(libtorrent::alert *a);
+        void handleTorrentAlerts(const InfoHash &hash, const std::vector<libtorrent::alert *> &alerts);
+        void handleTorrentAlert(TorrentHandle *const torrent, libtorrent::alert *a);
         void handleAddTorrentAlert(libtorrent::add_torrent_alert *p);
         void handleStateUpdateAlert(libtorrent::state_update_alert *p);
         void handleMetadataReceivedAlert(const libtorrent::metadata_received_alert *p);
@@ -662,6 +970,7 @@ namespace BitTorrent
         void handlePortmapWarningAlert(libtorrent::portmap_error_alert *p);
         void handlePortmapAlert(libtorrent::portmap_alert *p);
         void handlePeerBlockedAlert(libtorrent::peer_blocked_alert *p);
+        static QString peerBlockedReason(int reason);
         void handlePeerBanAlert(libtorrent::peer_ban_alert *p);
         void handleUrlSeedAlert(libtorrent::url_seed_alert *p);
         void handleListenSucceededAlert(libtorrent::listen_succeeded_alert *p);
@@ -673,18 +982,57 @@ namespace BitTorrent
 
         void createTorrentHandle(const libtorrent::torrent_handle &nativeHandle);
 
+        void recordTransferHistory();
+
         void saveResumeData();
         void saveTorrentsQueue();
+        void scheduleTorrentsQueueSave();
+        QVector<int> torrentQueuePositions(const QStringList &hashes);
+        void refreshTorrentQueue();
+        void moveUnlistedTorrentsToBottom();
+        bool isSameNativeQueue(const TorrentHandle *left, const TorrentHandle *right) const;
+        void restoreNativeQueuePosition(TorrentHandle *const torrent);
+        void updateTorrentQueuePositions(int from, int to);
+        void setTorrentQueuePosition(TorrentHandle *const torrent, int position);
         void removeTorrentsQueue();
 
 #if LIBTORRENT_VERSION_NUM < 10100
         void dispatchAlerts(libtorrent::alert *alertPtr);
         void updateStats();
 #endif
-        void getPendingAlerts(std::vector<libtorrent::alert *> &out, ulong time = 0);
+        void getPendingAlerts(libtorrent::session *nativeSession, std::vector<libtorrent::alert *> &out, ulong time = 0);
+
+        libtorrent::session *nativeSessionFor(const InfoHash &hash) const;
+        std::vector<libtorrent::torrent_handle> nativeTorrents() const;
+        void setNativeIPFilter(const libtorrent::ip_filter &filter);
+#if LIBTORRENT_VERSION_NUM >= 10100
+        void applyNativeSettings(const libtorrent::settings_pack &settingsPack);
+        void adjustShardRateLimits(libtorrent::settings_pack &settingsPack, int shard);
+        void rebalanceShardRateLimits();
+#endif
 
         // BitTorrent
-        libtorrent::session *m_nativeSession;
+        libtorrent::session *m_nativeSession; // the first of m_nativeShards
+
+        struct NativeShard
+        {
+            libtorrent::session *session = nullptr;
+            AlertDispatcher *alertDispatcher = nullptr;
+#if LIBTORRENT_VERSION_NUM >= 10100
+            // Counters of the last stats alert, not yet summed up into m_sessionCounters
+            QVector<qint64> counters;
+            bool hasStats = false;
+            // Payload bytes at the last rebalance and the rates wanted since then
+            qint64 rebalanceDownload = 0;
+            qint64 rebalanceUpload = 0;
+            qreal downloadDemand = 0;
+            qreal uploadDemand = 0;
+            // Share of the global rate limits currently applied
+            int downloadRateLimit = 0;
+            int uploadRateLimit = 0;
+#endif
+        };
+        QVector<NativeShard> m_nativeShards;
 
         bool m_deferredConfigureScheduled;
         bool m_IPFilteringChanged;
@@ -710,6 +1058,7 @@ namespace BitTorrent
         CachedSettingValue<int> m_sendBufferWatermark;
         CachedSettingValue<int> m_sendBufferLowWatermark;
         CachedSettingValue<int> m_sendBufferWatermarkFactor;
+        CachedSettingValue<bool> m_isDiskAutoTuningEnabled;
         CachedSettingValue<bool> m_isAnonymousModeEnabled;
         CachedSettingValue<bool> m_isQueueingEnabled;
         CachedSettingValue<int> m_maxActiveDownloads;
@@ -737,9 +1086,20 @@ namespace BitTorrent
         CachedSettingValue<bool> m_isAddTrackersEnabled;
         CachedSettingValue<bool> m_isAutoUpdateTrackersEnabled;
         CachedSettingValue<QString> m_additionalTrackers;
+        CachedSettingValue<int> m_publicTrackersLimit;
+        CachedSettingValue<bool> m_isAnnounceSpreadingEnabled;
         CachedSettingValue<qreal> m_globalMaxRatio;
         CachedSettingValue<int> m_globalMaxSeedingMinutes;
         CachedSettingValue<bool> m_isAddTorrentPaused;
+        CachedSettingValue<bool> m_isDormantTorrentsEnabled;
+        CachedSettingValue<int> m_nativeSessionCount;
+        CachedSettingValue<bool> m_isFastRecheckEnabled;
+        CachedSettingValue<bool> m_isCrossSeedingEnabled;
+        CachedSettingValue<int> m_metadataCacheSize;
+        CachedSettingValue<int> m_maxActiveMetadataFetches;
+        CachedSettingValue<int> m_metadataFetchTimeout;
+        CachedSettingValue<int> m_maxStorageJobsPerDevice;
+        CachedSettingValue<int> m_storageJobRateLimit;
         CachedSettingValue<bool> m_isCreateTorrentSubfolder;
         CachedSettingValue<bool> m_isAppendExtensionEnabled;
         CachedSettingValue<uint> m_refreshInterval;
@@ -752,9 +1112,14 @@ namespace BitTorrent
         CachedSettingValue<int> m_altGlobalUploadSpeedLimit;
         CachedSettingValue<bool> m_isAltGlobalSpeedLimitEnabled;
         CachedSettingValue<bool> m_isBandwidthSchedulerEnabled;
+        CachedSettingValue<bool> m_isUploadRateControllerEnabled;
+        CachedSettingValue<int> m_uploadRateControllerTargetDelay;
+        CachedSettingValue<int> m_uploadRateControllerMinLimit;
+        CachedSettingValue<int> m_uploadRateControllerMaxLimit;
         CachedSettingValue<uint> m_saveResumeDataInterval;
         CachedSettingValue<bool> m_autoBanUnknownPeer;
         CachedSettingValue<bool> m_autoBanBTPlayerPeer;
+        CachedSettingValue<bool> m_autoBanLeecherPeer;
         CachedSettingValue<bool> m_showTrackerAuthWindow;
         CachedSettingValue<int> m_port;
         CachedSettingValue<bool> m_useRandomPort;
@@ -769,6 +1134,8 @@ namespace BitTorrent
         CachedSettingValue<SeedChokingAlgorithm> m_seedChokingAlgorithm;
         CachedSettingValue<QVariantMap> m_storedCategories;
         CachedSettingValue<QStringList> m_storedTags;
+        CachedSettingValue<QVariantMap> m_storedCategoryBandwidthClasses;
+        CachedSettingValue<QVariantMap> m_storedTagBandwidthClasses;
         CachedSettingValue<int> m_maxRatioAction;
         CachedSettingValue<QString> m_defaultSavePath;
         CachedSettingValue<QString> m_tempPath;
@@ -787,9 +1154,16 @@ namespace BitTorrent
         const bool m_wasPexEnabled;
 
         int m_numResumeData;
+        int m_alertQueueDepth = 0;
+        int m_alertShard = 0; // native session of the alerts being handled
         int m_extraLimit;
         QList<BitTorrent::TrackerEntry> m_additionalTrackerList;
         QList<BitTorrent::TrackerEntry> m_publicTrackerList;
+        QList<BitTorrent::TrackerEntry> m_selectedPublicTrackers;
+        bool m_arePublicTrackersApplied = false;
+        // Torrents still to be updated after a selection change, a few at a time
+        QQueue<InfoHash> m_publicTrackersQueue;
+        QSet<QString> m_deselectedPublicTrackers;
         QString m_resumeFolderPath;
         QFile m_resumeFolderLock;
         bool m_useProxy;
@@ -798,6 +1172,15 @@ namespace BitTorrent
         QTimer *m_seedingLimitTimer;
         QTimer *m_resumeDataTimer;
         Statistics *m_statistics;
+        TimeSeriesStore *m_transferHistory;
+        DiskCacheTuner *m_diskCacheTuner;
+        UploadRateController *m_uploadRateController;
+        PeerBehaviourTracker *m_peerBehaviourTracker;
+        TrackerHealthRegistry *m_trackerHealthRegistry;
+        AnnounceScheduler *m_announceScheduler;
+        MetadataCache *m_metadataCache;
+        StorageJobScheduler *m_storageJobScheduler;
+        CrossSeedIndex *m_crossSeedIndex;
         // IP filtering
         QPointer<FilterParserThread> m_filterParser;
         QPointer<BandwidthScheduler> m_bwScheduler;
@@ -806,15 +1189,61 @@ namespace BitTorrent
         // fastresume data writing thread
         QThread *m_ioThread;
         ResumeDataSavingManager *m_resumeDataSavingManager;
+        // data verification thread
+        QThread *m_recheckThread;
+        FastRecheckWorker *m_fastRecheckWorker;
+        // Stored resume data of the torrents waiting for up-to-date resume data to be rechecked
+        QHash<InfoHash, QByteArray> m_pendingFastRechecks;
+        // torrent loading thread
+        QThread *m_decodeThread;
+        TorrentDecoder *m_torrentDecoder;
+        // torrent files moving and deletion thread
+        QThread *m_storageThread;
+        StorageWorker *m_storageWorker;
+        QTimer *m_storageJobTimer;
+        // Torrents whose files are waiting for their turn to be deleted, by job id
+        QHash<int, libtorrent::torrent_handle> m_queuedRemovals;
+        QSet<int> m_measuringStorageJobs;
 
         QHash<InfoHash, TorrentInfo> m_loadedMetadata;
+        // Metadata fetches waiting for a free slot, by descending priority
+        QList<MetadataFetch> m_queuedMetadataFetches;
+        // start time of the running ones
+        QHash<InfoHash, qint64> m_activeMetadataFetches;
+        QElapsedTimer m_metadataFetchClock;
+        QTimer *m_metadataFetchTimer;
+        quint64 m_fetchedMetadataCount = 0;
+        quint64 m_timedOutMetadataCount = 0;
+        qint64 m_metadataFetchTime = 0;
         QHash<InfoHash, TorrentHandle *> m_torrents;
+        // Queued torrents in the order libtorrent is expected to have them
+        QVector<TorrentHandle *> m_torrentQueue;
+        bool m_isTorrentQueueDirty = true;
+        bool m_isTorrentsQueueSaveScheduled = false;
+        // Status updates of idle torrents, applied on every slow refresh tick
+        QHash<InfoHash, libtorrent::torrent_status> m_deferredStatusUpdates;
+        QSet<TorrentHandle *> m_updatedTorrents; // since the last torrentsUpdated()
+        int m_stateUpdateCount = 0;
         QHash<InfoHash, CreateTorrentParams> m_addingTorrents;
+        // Torrents being loaded by id, then the ones waiting to be added
+        QHash<int, PendingTorrent> m_decodingTorrents;
+        QQueue<PendingTorrent> m_decodedTorrents;
+        int m_lastDecodingId = 0;
+        quint64 m_addedTorrentCount = 0;
+        quint64 m_failedTorrentCount = 0;
+        // New torrents waiting for the files of other torrents to be verified
+        QHash<InfoHash, CrossSeedCheck> m_crossSeedChecks;
         QHash<QString, AddTorrentParams> m_downloadedTorrents;
         QHash<InfoHash, RemovingTorrentData> m_removingTorrents;
         TorrentStatusReport m_torrentStatusReport;
         QStringMap m_categories;
         QSet<QString> m_tags;
+        QMap<QString, BandwidthClass> m_categoryBandwidthClasses;
+        QMap<QString, BandwidthClass> m_tagBandwidthClasses;
+        QMap<QString, BandwidthClassStatus> m_categoryBandwidthStatus;
+        QMap<QString, BandwidthClassStatus> m_tagBandwidthStatus;
+        // Some torrents may have limits from the bandwidth classes
+        bool m_hasBandwidthClassLimits = false;
 
         // I/O errored torrents
         QSet<InfoHash> m_recentErroredTorrents;
@@ -827,10 +1256,13 @@ namespace BitTorrent
 #else
         SessionMetricIndices m_metricIndices;
         QElapsedTimer m_statsUpdateTimer;
+        QElapsedTimer m_shardRebalanceTimer;
 #endif
 
         SessionStatus m_status;
         CacheStatus m_cacheStatus;
+        QVector<SessionMetric> m_sessionMetrics;
+        QVector<qint64> m_sessionCounters;
 
         QNetworkConfigurationManager m_networkManager;
 
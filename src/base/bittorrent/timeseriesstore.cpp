@@ -0,0 +1,377 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "timeseriesstore.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "base/logger.h"
+#include "base/utils/fs.h"
+
+namespace
+{
+    const char FILE_MAGIC[8] = {'Q', 'B', 'T', 'T', 'S', 'D', 'B', '\0'};
+    const quint32 FILE_VERSION = 3;
+    const int KEY_NAME_SIZE = 64;
+
+    struct Archive
+    {
+        int step; // seconds
+        int rows;
+    };
+
+    const Archive ARCHIVES[] = {
+        {1, 60 * 60}, // an hour of seconds
+        {60, 7 * 24 * 60}, // a week of minutes
+        {60 * 60, 365 * 24} // a year of hours
+    };
+
+    // a category or tracker idle for that long gives its slot away
+    const qint64 KEY_EXPIRATION = 24 * 60 * 60;
+
+    const char *const GLOBAL_SERIES_NAMES[] = {
+        "upload",
+        "download",
+        "payload_upload",
+        "payload_download",
+        "overhead_upload",
+        "overhead_download",
+        "dht_upload",
+        "dht_download",
+        "tracker_upload",
+        "tracker_download",
+        "upload_limit",
+        "peers",
+        "disk_read_queue",
+        "disk_write_queue",
+        "disk_job_queue",
+        "disk_cache_size",
+        "disk_cache_used",
+        "disk_read_hit_ratio",
+        "aio_threads",
+        "send_buffer_watermark"
+    };
+
+    const char CATEGORY_PREFIX[] = "category/";
+    const char TRACKER_PREFIX[] = "tracker/";
+    const char UPLOAD_SUFFIX[] = "/upload";
+    const char DOWNLOAD_SUFFIX[] = "/download";
+
+    quint32 saturate(const quint64 value)
+    {
+        return static_cast<quint32>(std::min<quint64>(value, std::numeric_limits<quint32>::max()));
+    }
+}
+
+using namespace BitTorrent;
+
+// The layout is native-endian, the file isn't meant to be moved between machines
+struct TimeSeriesStore::FileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 rowSize;
+
+    struct
+    {
+        char name[KEY_NAME_SIZE];
+        qint64 lastSeen;
+        quint32 kind;
+        quint32 reserved;
+    } keys[MAX_KEYS];
+};
+
+struct TimeSeriesStore::Row
+{
+    qint64 timestamp;
+    quint32 samples;
+    quint32 reserved;
+    quint32 values[SERIES_COUNT];
+};
+
+TimeSeriesStore::TimeSeriesStore(const QString &path)
+    : m_file(path)
+{
+    static_assert((sizeof(GLOBAL_SERIES_NAMES) / sizeof(GLOBAL_SERIES_NAMES[0])) == GlobalSeriesCount
+                  , "GLOBAL_SERIES_NAMES doesn't match GlobalSeries");
+    static_assert((sizeof(ARCHIVES) / sizeof(ARCHIVES[0])) == ResolutionCount
+                  , "ARCHIVES doesn't match Resolution");
+
+    if (!open()) {
+        LogMsg(tr("Couldn't open transfer statistics history '%1'. Error: %2")
+               .arg(Utils::Fs::toNativePath(path), m_file.errorString()), Log::WARNING);
+        m_file.close();
+        m_data = nullptr;
+        m_header = nullptr;
+    }
+}
+
+TimeSeriesStore::~TimeSeriesStore()
+{
+    if (m_data)
+        m_file.unmap(m_data);
+}
+
+bool TimeSeriesStore::isValid() const
+{
+    return (m_data != nullptr);
+}
+
+bool TimeSeriesStore::open()
+{
+    qint64 fileSize = sizeof(FileHeader);
+    for (const Archive &archive : ARCHIVES)
+        fileSize += archive.rows * static_cast<qint64>(sizeof(Row));
+
+    if (!m_file.open(QIODevice::ReadWrite))
+        return false;
+
+    bool isCompatible = (m_file.size() == fileSize);
+    if (isCompatible) {
+        FileHeader header;
+        isCompatible = (m_file.read(reinterpret_cast<char *>(&header), sizeof(header)) == sizeof(header))
+                && (memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0)
+                && (header.version == FILE_VERSION)
+                && (header.rowSize == sizeof(Row));
+    }
+
+    // start over with a zero-filled file
+    if (!isCompatible && (!m_file.resize(0) || !m_file.resize(fileSize)))
+        return false;
+
+    m_data = m_file.map(0, fileSize);
+    if (!m_data)
+        return false;
+
+    m_header = reinterpret_cast<FileHeader *>(m_data);
+    if (!isCompatible) {
+        memcpy(m_header->magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        m_header->version = FILE_VERSION;
+        m_header->rowSize = sizeof(Row);
+    }
+
+    return true;
+}
+
+TimeSeriesStore::Row *TimeSeriesStore::row(const Resolution resolution, const qint64 timestamp) const
+{
+    qint64 offset = sizeof(FileHeader);
+    for (int i = 0; i < resolution; ++i)
+        offset += ARCHIVES[i].rows * static_cast<qint64>(sizeof(Row));
+
+    const Archive &archive = ARCHIVES[resolution];
+    return reinterpret_cast<Row *>(m_data + offset) + ((timestamp / archive.step) % archive.rows);
+}
+
+void TimeSeriesStore::addSample(const qint64 timestamp, const Sample &sample)
+{
+    if (!isValid() || (timestamp <= 0)) return;
+
+    quint32 values[SERIES_COUNT] = {};
+    for (int i = 0; i < GlobalSeriesCount; ++i)
+        values[i] = saturate(sample.values[i]);
+
+    const auto addRates = [this, timestamp, &values](const KeyKind kind, const QHash<QString, Rates> &rates)
+    {
+        for (auto it = rates.cbegin(); it != rates.cend(); ++it) {
+            const int slot = keySlot(kind, it.key(), timestamp);
+            if (slot < 0) continue;
+
+            values[GlobalSeriesCount + (2 * slot)] = saturate(it.value().first);
+            values[GlobalSeriesCount + (2 * slot) + 1] = saturate(it.value().second);
+        }
+    };
+    addRates(CategoryKey, sample.categories);
+    addRates(TrackerKey, sample.trackers);
+
+    for (int resolution = Second; resolution < ResolutionCount; ++resolution) {
+        const qint64 bucket = timestamp - (timestamp % ARCHIVES[resolution].step);
+        Row *const r = row(static_cast<Resolution>(resolution), timestamp);
+        if (r->timestamp != bucket) {
+            // the row still holds data from the previous lap
+            memset(r, 0, sizeof(Row));
+            r->timestamp = bucket;
+        }
+
+        // running average of all samples within the step
+        ++r->samples;
+        for (int i = 0; i < SERIES_COUNT; ++i) {
+            const double delta = (static_cast<double>(values[i]) - r->values[i]) / r->samples;
+            r->values[i] = static_cast<quint32>(qRound64(r->values[i] + delta));
+        }
+    }
+}
+
+int TimeSeriesStore::keySlot(const KeyKind kind, const QString &name, const qint64 timestamp)
+{
+    const QByteArray key = name.toUtf8().left(KEY_NAME_SIZE - 1);
+
+    int freeSlot = -1;
+    int oldestSlot = -1;
+    for (int slot = 0; slot < MAX_KEYS; ++slot) {
+        auto &entry = m_header->keys[slot];
+        if (entry.kind == NoKey) {
+            if (freeSlot < 0)
+                freeSlot = slot;
+            continue;
+        }
+
+        if ((entry.kind == static_cast<quint32>(kind)) && (key == entry.name)) {
+            entry.lastSeen = timestamp;
+            return slot;
+        }
+
+        if ((oldestSlot < 0) || (entry.lastSeen < m_header->keys[oldestSlot].lastSeen))
+            oldestSlot = slot;
+    }
+
+    int slot = freeSlot;
+    if ((slot < 0) && ((timestamp - m_header->keys[oldestSlot].lastSeen) > KEY_EXPIRATION)) {
+        slot = oldestSlot;
+        clearKeySeries(slot);
+    }
+    if (slot < 0)
+        return -1;
+
+    auto &entry = m_header->keys[slot];
+    memset(entry.name, 0, sizeof(entry.name));
+    memcpy(entry.name, key.constData(), key.size());
+    entry.kind = kind;
+    entry.lastSeen = timestamp;
+    return slot;
+}
+
+void TimeSeriesStore::clearKeySeries(const int slot)
+{
+    for (int resolution = Second; resolution < ResolutionCount; ++resolution) {
+        const Archive &archive = ARCHIVES[resolution];
+        Row *const first = row(static_cast<Resolution>(resolution), 0);
+        for (int i = 0; i < archive.rows; ++i) {
+            first[i].values[GlobalSeriesCount + (2 * slot)] = 0;
+            first[i].values[GlobalSeriesCount + (2 * slot) + 1] = 0;
+        }
+    }
+}
+
+int TimeSeriesStore::step(const Resolution resolution)
+{
+    return ARCHIVES[resolution].step;
+}
+
+TimeSeriesStore::Resolution TimeSeriesStore::resolutionFor(const qint64 from, const qint64 now)
+{
+    for (int resolution = Second; resolution < Hour; ++resolution) {
+        const Archive &archive = ARCHIVES[resolution];
+        if ((now - from) < (static_cast<qint64>(archive.step) * archive.rows))
+            return static_cast<Resolution>(resolution);
+    }
+    return Hour;
+}
+
+QStringList TimeSeriesStore::seriesNames() const
+{
+    QStringList names;
+    for (const char *name : GLOBAL_SERIES_NAMES)
+        names << QLatin1String(name);
+
+    if (!isValid()) return names;
+
+    for (const auto &entry : m_header->keys) {
+        if (entry.kind == NoKey) continue;
+
+        const QString key = QLatin1String((entry.kind == CategoryKey) ? CATEGORY_PREFIX : TRACKER_PREFIX)
+                + QString::fromUtf8(entry.name);
+        names << (key + QLatin1String(UPLOAD_SUFFIX)) << (key + QLatin1String(DOWNLOAD_SUFFIX));
+    }
+
+    return names;
+}
+
+int TimeSeriesStore::seriesIndex(const QString &name) const
+{
+    for (int i = 0; i < GlobalSeriesCount; ++i) {
+        if (name == QLatin1String(GLOBAL_SERIES_NAMES[i]))
+            return i;
+    }
+
+    if (!isValid()) return -1;
+
+    KeyKind kind = NoKey;
+    QString key = name;
+    if (key.startsWith(QLatin1String(CATEGORY_PREFIX)))
+        kind = CategoryKey;
+    else if (key.startsWith(QLatin1String(TRACKER_PREFIX)))
+        kind = TrackerKey;
+    else
+        return -1;
+    key.remove(0, qstrlen((kind == CategoryKey) ? CATEGORY_PREFIX : TRACKER_PREFIX));
+
+    int offset = 0;
+    if (key.endsWith(QLatin1String(DOWNLOAD_SUFFIX)))
+        offset = 1;
+    else if (!key.endsWith(QLatin1String(UPLOAD_SUFFIX)))
+        return -1;
+    key.chop(qstrlen(offset ? DOWNLOAD_SUFFIX : UPLOAD_SUFFIX));
+
+    const QByteArray keyData = key.toUtf8();
+    for (int slot = 0; slot < MAX_KEYS; ++slot) {
+        const auto &entry = m_header->keys[slot];
+        if ((entry.kind == static_cast<quint32>(kind)) && (keyData == entry.name))
+            return GlobalSeriesCount + (2 * slot) + offset;
+    }
+
+    return -1;
+}
+
+QVector<TimeSeriesStore::Point> TimeSeriesStore::query(const Resolution resolution, const qint64 from, const qint64 to
+                                                       , const QVector<int> &series) const
+{
+    QVector<Point> points;
+    if (!isValid() || (from > to)) return points;
+
+    const Archive &archive = ARCHIVES[resolution];
+    const qint64 lastBucket = to - (to % archive.step);
+    // anything older has already been overwritten
+    const qint64 firstBucket = std::max((from - (from % archive.step))
+                                        , (lastBucket - (static_cast<qint64>(archive.rows - 1) * archive.step)));
+
+    for (qint64 bucket = std::max<qint64>(firstBucket, 0); bucket <= lastBucket; bucket += archive.step) {
+        const Row *const r = row(resolution, bucket);
+        if ((r->timestamp != bucket) || (r->samples == 0)) continue;
+
+        Point point {bucket, {}};
+        point.values.reserve(series.size());
+        for (const int index : series)
+            point.values.append(((index >= 0) && (index < SERIES_COUNT)) ? r->values[index] : 0);
+        points.append(point);
+    }
+
+    return points;
+}
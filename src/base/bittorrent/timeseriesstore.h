@@ -0,0 +1,141 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace BitTorrent
+{
+    // Round-robin store of transfer statistics kept in a fixed-size memory-mapped file.
+    // Each resolution is a ring of rows indexed by (timestamp / step) % rows; a row
+    // averages all samples that fall into its step. Main thread only.
+    class TimeSeriesStore
+    {
+        Q_DECLARE_TR_FUNCTIONS(BitTorrent::TimeSeriesStore)
+        Q_DISABLE_COPY(TimeSeriesStore)
+
+    public:
+        enum Resolution
+        {
+            Second = 0,
+            Minute,
+            Hour,
+
+            ResolutionCount
+        };
+
+        // keep in sync with SpeedPlotView::GraphID
+        enum GlobalSeries
+        {
+            Upload = 0,
+            Download,
+            PayloadUpload,
+            PayloadDownload,
+            OverheadUpload,
+            OverheadDownload,
+            DHTUpload,
+            DHTDownload,
+            TrackerUpload,
+            TrackerDownload,
+            UploadLimit,
+            Peers,
+            DiskReadQueue,
+            DiskWriteQueue,
+            DiskJobQueue,
+            DiskCacheSize,
+            DiskCacheUsed,
+            DiskReadHitRatio,
+            AsyncIOThreads,
+            SendBufferWatermark,
+
+            GlobalSeriesCount
+        };
+
+        // number of categories and trackers tracked at once
+        static const int MAX_KEYS = 32;
+        static const int SERIES_COUNT = GlobalSeriesCount + (2 * MAX_KEYS);
+
+        using Rates = QPair<quint64, quint64>; // upload, download
+
+        struct Sample
+        {
+            quint64 values[GlobalSeriesCount] = {};
+            QHash<QString, Rates> categories;
+            QHash<QString, Rates> trackers;
+        };
+
+        struct Point
+        {
+            qint64 timestamp;
+            QVector<quint32> values;
+        };
+
+        explicit TimeSeriesStore(const QString &path);
+        ~TimeSeriesStore();
+
+        bool isValid() const;
+
+        void addSample(qint64 timestamp, const Sample &sample);
+
+        static int step(Resolution resolution);
+        // finest resolution still holding data at 'from'
+        static Resolution resolutionFor(qint64 from, qint64 now);
+
+        // "upload", "peers", ..., "category/<name>/upload", "tracker/<host>/download"
+        QStringList seriesNames() const;
+        int seriesIndex(const QString &name) const;
+        QVector<Point> query(Resolution resolution, qint64 from, qint64 to, const QVector<int> &series) const;
+
+    private:
+        struct FileHeader;
+        struct Row;
+
+        enum KeyKind
+        {
+            NoKey = 0,
+            CategoryKey,
+            TrackerKey
+        };
+
+        bool open();
+        Row *row(Resolution resolution, qint64 timestamp) const;
+        int keySlot(KeyKind kind, const QString &name, qint64 timestamp);
+        void clearKeySeries(int slot);
+
+        QFile m_file;
+        uchar *m_data = nullptr;
+        FileHeader *m_header = nullptr;
+    };
+}
@@ -30,7 +30,6 @@
 #include "torrenthandle.h"
 
 #include <algorithm>
-#include <type_traits>
 
 #include <QBitArray>
 #include <QByteArray>
@@ -38,11 +37,13 @@
 #include <QDir>
 #include <QFile>
 #include <QStringList>
+#include <QUrl>
 
 #include <libtorrent/address.hpp>
 #include <libtorrent/alert_types.hpp>
-#include <libtorrent/bencode.hpp>
-#include <libtorrent/create_torrent.hpp>
+#if LIBTORRENT_VERSION_NUM >= 10100
+#include <libtorrent/bdecode.hpp>
+#endif
 #include <libtorrent/entry.hpp>
 #include <libtorrent/magnet_uri.hpp>
 #if LIBTORRENT_VERSION_NUM >= 10100
@@ -57,8 +58,10 @@
 
 #include "base/global.h"
 #include "base/logger.h"
+#include "base/memoryusage.h"
 #include "base/preferences.h"
 #include "base/profile.h"
+#include "base/stringpool.h"
 #include "base/utils/fs.h"
 #include "base/utils/misc.h"
 #include "base/utils/string.h"
@@ -67,6 +70,8 @@
 #include "trackerentry.h"
 
 const QString QB_EXT {QStringLiteral(".!qB")};
+// how long a torrent stays in the fast refresh tier after it was last requested
+const int FAST_REFRESH_HOLD_TIME = 5000; // in msecs
 
 namespace libt = libtorrent;
 using namespace BitTorrent;
@@ -82,6 +87,32 @@ namespace
             entryList.emplace_back(setValue.toStdString());
         return entryList;
     }
+
+    bool hasNativeError(const libt::torrent_status &nativeStatus)
+    {
+#if LIBTORRENT_VERSION_NUM < 10100
+        return !nativeStatus.error.empty();
+#else
+        return static_cast<bool>(nativeStatus.errc);
+#endif
+    }
+
+    QString nativeErrorMessage(const libt::torrent_status &nativeStatus)
+    {
+#if LIBTORRENT_VERSION_NUM < 10100
+        return QString::fromStdString(nativeStatus.error);
+#else
+        return QString::fromStdString(nativeStatus.errc.message());
+#endif
+    }
+
+    // Rate limits below 1 mean unlimited
+    int stricterRateLimit(const int left, const int right)
+    {
+        if (left <= 0) return right;
+        if (right <= 0) return left;
+        return std::min(left, right);
+    }
 }
 
 // AddTorrentData
@@ -100,6 +131,7 @@ CreateTorrentParams::CreateTorrentParams()
     , downloadLimit(-1)
     , ratioLimit(TorrentHandle::USE_GLOBAL_RATIO)
     , seedingTimeLimit(TorrentHandle::USE_GLOBAL_SEEDING_TIME)
+    , queuePosition(0)
 {
 }
 
@@ -126,6 +158,7 @@ CreateTorrentParams::CreateTorrentParams(const AddTorrentParams &params)
     , filePriorities(params.filePriorities)
     , ratioLimit(params.ignoreShareLimits ? TorrentHandle::NO_RATIO_LIMIT : TorrentHandle::USE_GLOBAL_RATIO)
     , seedingTimeLimit(params.ignoreShareLimits ? TorrentHandle::NO_SEEDING_TIME_LIMIT : TorrentHandle::USE_GLOBAL_SEEDING_TIME)
+    , queuePosition(0)
 {
     bool useAutoTMM = (params.useAutoTMM == TriStateBool::Undefined
                        ? !Session::instance()->isAutoTMMDisabledByDefault()
@@ -147,30 +180,12 @@ const int TorrentHandle::NO_SEEDING_TIME_LIMIT = -1;
 const qreal TorrentHandle::MAX_RATIO = 9999.;
 const int TorrentHandle::MAX_SEEDING_TIME = 525600;
 
-// The new libtorrent::create_torrent constructor appeared after 1.0.11 in RC_1_0
-// and after 1.1.1 in RC_1_1. Since it fixed an ABI incompatibility with previous versions
-// distros might choose to backport it onto 1.0.11 and 1.1.1 respectively.
-// So we need a way to detect its presence without relying solely on the LIBTORRENT_VERSION_NUM.
-// Relevant links:
-// 1. https://github.com/arvidn/libtorrent/issues/1696
-// 2. https://github.com/qbittorrent/qBittorrent/issues/6406
-// The following can be removed after one or two libtorrent releases on each branch.
-namespace
-{
-    // new constructor is available
-    template<typename T, typename std::enable_if<std::is_constructible<T, libt::torrent_info, bool>::value, int>::type = 0>
-    T makeTorrentCreator(const libtorrent::torrent_info &ti)
-    {
-        return T(ti, true);
-    }
-
-    // new constructor isn't available
-    template<typename T, typename std::enable_if<!std::is_constructible<T, libt::torrent_info, bool>::value, int>::type = 0>
-    T makeTorrentCreator(const libtorrent::torrent_info &ti)
-    {
-        return T(ti);
-    }
-}
+const quint32 TorrentHandle::STATUS_QUERY_FLAGS = libt::torrent_handle::query_distributed_copies
+        | libt::torrent_handle::query_accurate_download_counters
+        | libt::torrent_handle::query_last_seen_complete
+        | libt::torrent_handle::query_torrent_file
+        | libt::torrent_handle::query_name
+        | libt::torrent_handle::query_save_path;
 
 TorrentHandle::TorrentHandle(Session *session, const libtorrent::torrent_handle &nativeHandle,
                                      const CreateTorrentParams &params)
@@ -181,9 +196,8 @@ TorrentHandle::TorrentHandle(Session *session, const libtorrent::torrent_handle
     , m_renameCount(0)
     , m_useAutoTMM(params.savePath.isEmpty())
     , m_name(params.name)
-    , m_savePath(Utils::Fs::toNativePath(params.savePath))
-    , m_category(params.category)
-    , m_tags(params.tags)
+    , m_savePath(StringPool::intern(Utils::Fs::toNativePath(params.savePath)))
+    , m_category(StringPool::intern(params.category))
     , m_hasSeedStatus(params.hasSeedStatus)
     , m_ratioLimit(params.ratioLimit)
     , m_seedingTimeLimit(params.seedingTimeLimit)
@@ -196,10 +210,14 @@ TorrentHandle::TorrentHandle(Session *session, const libtorrent::torrent_handle
     , m_pauseWhenReady(params.paused)
 {
     if (m_useAutoTMM)
-        m_savePath = Utils::Fs::toNativePath(m_session->categorySavePath(m_category));
+        m_savePath = StringPool::intern(Utils::Fs::toNativePath(m_session->categorySavePath(m_category)));
+
+    for (const QString &tag : asConst(params.tags))
+        m_tags.insert(StringPool::intern(tag));
+    m_queuePosition = params.queuePosition;
 
     updateStatus();
-    m_hash = InfoHash(m_nativeStatus.info_hash);
+    m_hash = InfoHash(m_nativeHandle.info_hash());
 
     // NB: the following two if statements are present because we don't want
     // to set either sequential download or first/last piece priority to false
@@ -234,6 +252,173 @@ TorrentHandle::TorrentHandle(Session *session, const libtorrent::torrent_handle
     }
 }
 
+TorrentHandle::TorrentHandle(Session *session, const InfoHash &hash, const CreateTorrentParams &params)
+    : QObject(session)
+    , m_session(session)
+    , m_dormantInfo(new DormantInfo)
+    , m_state(TorrentState::Unknown)
+    , m_hash(hash)
+    , m_renameCount(0)
+    , m_useAutoTMM(params.savePath.isEmpty())
+    , m_name(params.name)
+    , m_savePath(StringPool::intern(Utils::Fs::toNativePath(params.savePath)))
+    , m_category(StringPool::intern(params.category))
+    , m_hasSeedStatus(params.hasSeedStatus)
+    , m_ratioLimit(params.ratioLimit)
+    , m_seedingTimeLimit(params.seedingTimeLimit)
+    , m_tempPathDisabled(params.disableTempPath)
+    , m_fastresumeDataRejected(false)
+    , m_hasMissingFiles(false)
+    , m_hasRootFolder(params.hasRootFolder)
+    , m_needsToSetFirstLastPiecePriority(false)
+    , m_needsToStartForced(false)
+    , m_startupState(Started)
+    , m_pauseWhenReady(false)
+{
+    if (m_useAutoTMM)
+        m_savePath = StringPool::intern(Utils::Fs::toNativePath(m_session->categorySavePath(m_category)));
+
+    for (const QString &tag : asConst(params.tags))
+        m_tags.insert(StringPool::intern(tag));
+    m_queuePosition = params.queuePosition;
+}
+
+TorrentHandle *TorrentHandle::createDormant(Session *session, const InfoHash &hash
+                                            , const CreateTorrentParams &params, const QByteArray &resumeData)
+{
+#if LIBTORRENT_VERSION_NUM < 10100
+    Q_UNUSED(session);
+    Q_UNUSED(hash);
+    Q_UNUSED(params);
+    Q_UNUSED(resumeData);
+    return nullptr;
+#else
+    libt::error_code ec;
+    libt::bdecode_node root;
+    libt::bdecode(resumeData.constData(), (resumeData.constData() + resumeData.size()), root, ec);
+    if (ec || (root.type() != libt::bdecode_node::dict_t)) return nullptr;
+
+    // The metadata is saved along with the resume data (see saveResumeData()),
+    // the sizes are computed from it without building a torrent_info.
+    const libt::bdecode_node info = root.dict_find_dict("info");
+    if (info.type() != libt::bdecode_node::dict_t) return nullptr;
+
+    QVector<qint64> fileSizes;
+    const libt::bdecode_node files = info.dict_find_list("files");
+    if (files.type() == libt::bdecode_node::list_t) {
+        for (int i = 0; i < files.list_size(); ++i)
+            fileSizes.append(files.list_at(i).dict_find_int_value("length"));
+    }
+    else {
+        fileSizes.append(info.dict_find_int_value("length"));
+    }
+
+    qint64 totalSize = 0;
+    for (const qint64 fileSize : asConst(fileSizes))
+        totalSize += fileSize;
+
+    const qint64 pieceLength = info.dict_find_int_value("piece length");
+    if ((pieceLength <= 0) || (totalSize <= 0)) return nullptr;
+
+    const int piecesCount = static_cast<int>((totalSize + pieceLength - 1) / pieceLength);
+    const bool isSeedMode = root.dict_find_int_value("seed_mode");
+    const libt::bdecode_node pieces = root.dict_find_string("pieces");
+    const char *pieceBits = (pieces.type() == libt::bdecode_node::string_t) && (pieces.string_length() == piecesCount)
+            ? pieces.string_ptr() : nullptr;
+    const auto hasPiece = [isSeedMode, pieceBits](const int index)
+    {
+        return isSeedMode || (pieceBits && (pieceBits[index] & 1));
+    };
+
+    int piecesHave = 0;
+    for (int i = 0; i < piecesCount; ++i) {
+        if (hasPiece(i))
+            ++piecesHave;
+    }
+
+    const libt::bdecode_node filePriorities = root.dict_find_list("file_priority");
+    const int filePrioritiesCount = (filePriorities.type() == libt::bdecode_node::list_t) ? filePriorities.list_size() : 0;
+
+    qint64 wantedSize = 0;
+    qint64 wantedDone = 0;
+    qint64 fileOffset = 0;
+    for (int i = 0; i < fileSizes.size(); ++i) {
+        const qint64 fileSize = fileSizes[i];
+        const bool isWanted = (i >= filePrioritiesCount) || (filePriorities.list_int_value_at(i) > 0);
+        if (isWanted && (fileSize > 0)) {
+            const int firstPiece = static_cast<int>(fileOffset / pieceLength);
+            const int lastPiece = static_cast<int>((fileOffset + fileSize - 1) / pieceLength);
+            int filePiecesHave = 0;
+            for (int piece = firstPiece; piece <= lastPiece; ++piece) {
+                if (hasPiece(piece))
+                    ++filePiecesHave;
+            }
+
+            wantedSize += fileSize;
+            wantedDone += (filePiecesHave == (lastPiece - firstPiece + 1))
+                    ? fileSize : std::min(fileSize, (filePiecesHave * pieceLength));
+        }
+        fileOffset += fileSize;
+    }
+
+    TorrentHandle *const torrent = new TorrentHandle(session, hash, params);
+
+    NativeStatus &status = torrent->m_nativeStatus;
+    status.name = QString::fromStdString(info.dict_find_string_value("name"));
+    status.save_path = StringPool::intern(Utils::Fs::toNativePath(Profile::instance().fromPortablePath(
+        QString::fromStdString(root.dict_find_string_value("save_path")))));
+    status.total_done = (piecesHave == piecesCount) ? totalSize : std::min(totalSize, (piecesHave * pieceLength));
+    status.total_wanted = wantedSize;
+    status.total_wanted_done = wantedDone;
+    status.all_time_download = root.dict_find_int_value("total_downloaded");
+    status.all_time_upload = root.dict_find_int_value("total_uploaded");
+    status.added_time = root.dict_find_int_value("added_time");
+    status.completed_time = root.dict_find_int_value("completed_time");
+    status.last_seen_complete = root.dict_find_int_value("last_seen_complete");
+    status.active_time = root.dict_find_int_value("active_time");
+    status.finished_time = root.dict_find_int_value("finished_time");
+    status.seeding_time = root.dict_find_int_value("seeding_time");
+    status.num_pieces = piecesHave;
+    status.progress = (wantedSize > 0) ? (static_cast<float>(wantedDone) / wantedSize) : 0;
+    if (wantedDone < wantedSize)
+        status.state = libt::torrent_status::downloading;
+    else
+        status.state = (status.total_done == totalSize) ? libt::torrent_status::seeding : libt::torrent_status::finished;
+    status.paused = true;
+    status.auto_managed = false;
+    status.has_metadata = true;
+    status.sequential_download = params.sequential || root.dict_find_int_value("sequential_download");
+    status.super_seeding = root.dict_find_int_value("super_seeding");
+
+    DormantInfo &dormantInfo = *torrent->m_dormantInfo;
+    dormantInfo.totalSize = totalSize;
+    dormantInfo.uploadLimit = root.dict_find_int_value("upload_rate_limit", -1);
+    dormantInfo.downloadLimit = root.dict_find_int_value("download_rate_limit", -1);
+    dormantInfo.isPrivate = info.dict_find_int_value("private");
+    dormantInfo.firstLastPiecePriority = params.firstLastPiecePriority;
+    dormantInfo.pieces.resize(piecesCount);
+    for (int i = 0; i < piecesCount; ++i) {
+        if (hasPiece(i))
+            dormantInfo.pieces.setBit(i);
+    }
+
+    const libt::bdecode_node trackers = root.dict_find_list("trackers");
+    const int tiersCount = (trackers.type() == libt::bdecode_node::list_t) ? trackers.list_size() : 0;
+    for (int tier = 0; tier < tiersCount; ++tier) {
+        const libt::bdecode_node tierTrackers = trackers.list_at(tier);
+        if (tierTrackers.type() != libt::bdecode_node::list_t) continue;
+
+        for (int i = 0; i < tierTrackers.list_size(); ++i) {
+            const QString url = QString::fromStdString(tierTrackers.list_string_value_at(i));
+            dormantInfo.trackers.append({url, tier});
+        }
+    }
+
+    torrent->updateState();
+    return torrent;
+#endif
+}
+
 TorrentHandle::~TorrentHandle() {}
 
 bool TorrentHandle::isValid() const
@@ -241,6 +426,11 @@ bool TorrentHandle::isValid() const
     return m_nativeHandle.is_valid();
 }
 
+bool TorrentHandle::isDormant() const
+{
+    return !m_dormantInfo.isNull();
+}
+
 InfoHash TorrentHandle::hash() const
 {
     return m_hash;
@@ -250,9 +440,9 @@ QString TorrentHandle::name() const
 {
     QString name = m_name;
     if (name.isEmpty())
-        name = QString::fromStdString(m_nativeStatus.name);
+        name = m_torrentInfo.isValid() ? m_torrentInfo.name() : m_nativeStatus.name;
 
-    if (name.isEmpty() && hasMetadata())
+    if (name.isEmpty() && m_torrentInfo.isValid())
         name = QString::fromStdString(m_torrentInfo.nativeInfo()->orig_files().name());
 
     if (name.isEmpty())
@@ -263,26 +453,35 @@ QString TorrentHandle::name() const
 
 QDateTime TorrentHandle::creationDate() const
 {
+    loadDormantTorrentInfo();
     return m_torrentInfo.creationDate();
 }
 
 QString TorrentHandle::creator() const
 {
+    loadDormantTorrentInfo();
     return m_torrentInfo.creator();
 }
 
 QString TorrentHandle::comment() const
 {
+    loadDormantTorrentInfo();
     return m_torrentInfo.comment();
 }
 
 bool TorrentHandle::isPrivate() const
 {
+    if (isDormant())
+        return m_dormantInfo->isPrivate;
+
     return m_torrentInfo.isPrivate();
 }
 
 qlonglong TorrentHandle::totalSize() const
 {
+    if (isDormant())
+        return m_dormantInfo->totalSize;
+
     return m_torrentInfo.totalSize();
 }
 
@@ -304,6 +503,7 @@ qlonglong TorrentHandle::incompletedSize() const
 
 qlonglong TorrentHandle::pieceLength() const
 {
+    loadDormantTorrentInfo();
     return m_torrentInfo.pieceLength();
 }
 
@@ -314,7 +514,7 @@ qlonglong TorrentHandle::wastedSize() const
 
 QString TorrentHandle::currentTracker() const
 {
-    return QString::fromStdString(m_nativeStatus.current_tracker);
+    return m_nativeStatus.current_tracker;
 }
 
 QString TorrentHandle::savePath(bool actual) const
@@ -371,12 +571,21 @@ bool TorrentHandle::hasRootFolder() const
 
 QString TorrentHandle::nativeActualSavePath() const
 {
-    return QString::fromStdString(m_nativeStatus.save_path);
+    return m_nativeStatus.save_path;
 }
 
 QList<TrackerEntry> TorrentHandle::trackers() const
 {
     QList<TrackerEntry> entries;
+    if (isDormant()) {
+        for (const DormantInfo::Tracker &tracker : asConst(m_dormantInfo->trackers)) {
+            TrackerEntry entry(tracker.url);
+            entry.setTier(tracker.tier);
+            entries << entry;
+        }
+        return entries;
+    }
+
     const std::vector<libt::announce_entry> announces = m_nativeHandle.trackers();
 
     for (const libt::announce_entry &tracker : announces)
@@ -390,6 +599,35 @@ QHash<QString, TrackerInfo> TorrentHandle::trackerInfos() const
     return m_trackerInfos;
 }
 
+bool TorrentHandle::hasTracker(const QString &trackerUrl)
+{
+    if (isDormant()) {
+        for (const DormantInfo::Tracker &tracker : asConst(m_dormantInfo->trackers)) {
+            if (tracker.url == trackerUrl)
+                return true;
+        }
+        return false;
+    }
+
+    if (!m_areTrackersLookedUp)
+        lookUpTrackers();
+    return m_trackerInfos.contains(trackerUrl);
+}
+
+void TorrentHandle::lookUpTrackers()
+{
+    const std::vector<libt::announce_entry> announces = m_nativeHandle.trackers();
+    QHash<QString, TrackerInfo> trackerInfos;
+    for (int i = 0; i < static_cast<int>(announces.size()); ++i) {
+        const QString trackerUrl = QString::fromStdString(announces[i].url);
+        TrackerInfo trackerInfo = m_trackerInfos.value(trackerUrl);
+        trackerInfo.index = i;
+        trackerInfos.insert(trackerUrl, trackerInfo);
+    }
+    m_trackerInfos = trackerInfos;
+    m_areTrackersLookedUp = true;
+}
+
 void TorrentHandle::addTrackers(const QList<TrackerEntry> &trackers)
 {
     QList<TrackerEntry> addedTrackers;
@@ -404,6 +642,8 @@ void TorrentHandle::addTrackers(const QList<TrackerEntry> &trackers)
 
 void TorrentHandle::replaceTrackers(const QList<TrackerEntry> &trackers)
 {
+    if (!wakeUp()) return;
+
     QList<TrackerEntry> existingTrackers = this->trackers();
     QList<TrackerEntry> addedTrackers;
 
@@ -417,6 +657,15 @@ void TorrentHandle::replaceTrackers(const QList<TrackerEntry> &trackers)
     }
 
     m_nativeHandle.replace_trackers(announces);
+    // the list stays complete, only the indexes are looked up again
+    QHash<QString, TrackerInfo> trackerInfos;
+    for (int i = 0; i < trackers.size(); ++i) {
+        TrackerInfo trackerInfo = m_trackerInfos.value(trackers[i].url());
+        trackerInfo.index = -1;
+        trackerInfos.insert(trackers[i].url(), trackerInfo);
+    }
+    m_trackerInfos = trackerInfos;
+    m_areTrackersLookedUp = true;
     if (addedTrackers.isEmpty() && existingTrackers.isEmpty()) {
         m_session->handleTorrentTrackersChanged(this);
     }
@@ -428,18 +677,42 @@ void TorrentHandle::replaceTrackers(const QList<TrackerEntry> &trackers)
     }
 }
 
+void TorrentHandle::removeTrackers(const QStringList &trackerUrls)
+{
+    if (!wakeUp()) return;
+
+    QList<TrackerEntry> trackers = this->trackers();
+    const int count = trackers.size();
+    for (auto it = trackers.begin(); it != trackers.end();) {
+        if (trackerUrls.contains(it->url()))
+            it = trackers.erase(it);
+        else
+            ++it;
+    }
+
+    if (trackers.size() != count)
+        replaceTrackers(trackers);
+}
+
+// Unlike replacing the list, adding a tracker only announces to the new one
 bool TorrentHandle::addTracker(const TrackerEntry &tracker)
 {
-    if (trackers().contains(tracker))
+    if (!wakeUp() || hasTracker(tracker.url()))
         return false;
 
     m_nativeHandle.add_tracker(tracker.nativeEntry());
+    // the list is sorted by tier, the indexes may have moved
+    for (TrackerInfo &trackerInfo : m_trackerInfos)
+        trackerInfo.index = -1;
+    m_trackerInfos.insert(tracker.url(), {});
     return true;
 }
 
 QList<QUrl> TorrentHandle::urlSeeds() const
 {
     QList<QUrl> urlSeeds;
+    if (!wakeUp()) return urlSeeds;
+
     const std::set<std::string> seeds = m_nativeHandle.url_seeds();
 
     for (const std::string &urlSeed : seeds)
@@ -474,6 +747,8 @@ void TorrentHandle::removeUrlSeeds(const QList<QUrl> &urlSeeds)
 
 bool TorrentHandle::addUrlSeed(const QUrl &urlSeed)
 {
+    if (!wakeUp()) return false;
+
     QList<QUrl> seeds = urlSeeds();
     if (seeds.contains(urlSeed)) return false;
 
@@ -483,6 +758,8 @@ bool TorrentHandle::addUrlSeed(const QUrl &urlSeed)
 
 bool TorrentHandle::removeUrlSeed(const QUrl &urlSeed)
 {
+    if (!wakeUp()) return false;
+
     QList<QUrl> seeds = urlSeeds();
     if (!seeds.contains(urlSeed)) return false;
 
@@ -492,6 +769,8 @@ bool TorrentHandle::removeUrlSeed(const QUrl &urlSeed)
 
 bool TorrentHandle::connectPeer(const PeerAddress &peerAddress)
 {
+    if (!wakeUp()) return false;
+
     libt::error_code ec;
     libt::address addr = libt::address::from_string(peerAddress.ip.toString().toStdString(), ec);
     if (ec) return false;
@@ -503,22 +782,37 @@ bool TorrentHandle::connectPeer(const PeerAddress &peerAddress)
 
 bool TorrentHandle::needSaveResumeData() const
 {
+    if (isDormant()) return false;
+
     return m_nativeHandle.need_save_resume_data();
 }
 
 void TorrentHandle::saveResumeData()
 {
+    if (isDormant()) {
+        // libtorrent doesn't know the torrent, so our part of its stored resume data is updated in place
+        const QByteArray storedData = m_session->storedResumeData(this);
+        libt::entry resumeData = libt::bdecode(storedData.constData(), (storedData.constData() + storedData.size()));
+        if (resumeData.type() != libt::entry::dictionary_t) return;
+
+        m_session->handleTorrentSaveResumeDataRequested(this);
+        storeResumeData(resumeData);
+        return;
+    }
+
     m_nativeHandle.save_resume_data(lt::torrent_handle::save_info_dict);
     m_session->handleTorrentSaveResumeDataRequested(this);
 }
 
 int TorrentHandle::filesCount() const
 {
+    loadDormantTorrentInfo();
     return m_torrentInfo.filesCount();
 }
 
 int TorrentHandle::piecesCount() const
 {
+    loadDormantTorrentInfo();
     return m_torrentInfo.piecesCount();
 }
 
@@ -544,6 +838,13 @@ qreal TorrentHandle::progress() const
     return m_nativeStatus.progress;
 }
 
+qreal TorrentHandle::moveProgress() const
+{
+    if (!isMoveInProgress()) return 1.;
+
+    return m_session->torrentStorageMoveProgress(this);
+}
+
 QString TorrentHandle::category() const
 {
     return m_category;
@@ -581,7 +882,7 @@ bool TorrentHandle::addTag(const QString &tag)
         if (!m_session->hasTag(tag))
             if (!m_session->addTag(tag))
                 return false;
-        m_tags.insert(tag);
+        m_tags.insert(StringPool::intern(tag));
         m_session->handleTorrentTagAdded(this, tag);
         return true;
     }
@@ -620,6 +921,7 @@ int TorrentHandle::seedingTimeLimit() const
 
 QString TorrentHandle::filePath(int index) const
 {
+    loadDormantTorrentInfo();
     return m_torrentInfo.filePath(index);
 }
 
@@ -631,6 +933,7 @@ QString TorrentHandle::fileName(int index) const
 
 qlonglong TorrentHandle::fileSize(int index) const
 {
+    loadDormantTorrentInfo();
     return m_torrentInfo.fileSize(index);
 }
 
@@ -649,7 +952,7 @@ QStringList TorrentHandle::absoluteFilePaths() const
 
 QStringList TorrentHandle::absoluteFilePathsUnwanted() const
 {
-    if (!hasMetadata()) return QStringList();
+    if (!hasMetadata() || !wakeUp()) return QStringList();
 
     QDir saveDir(savePath(true));
     QStringList res;
@@ -670,6 +973,8 @@ QStringList TorrentHandle::absoluteFilePathsUnwanted() const
 
 QVector<int> TorrentHandle::filePriorities() const
 {
+    if (!wakeUp()) return QVector<int>();
+
     std::vector<int> fp;
     fp = m_nativeHandle.file_priorities();
 
@@ -678,6 +983,7 @@ QVector<int> TorrentHandle::filePriorities() const
 
 TorrentInfo TorrentHandle::info() const
 {
+    loadDormantTorrentInfo();
     return m_torrentInfo;
 }
 
@@ -785,6 +1091,9 @@ bool TorrentHandle::isSequentialDownload() const
 
 bool TorrentHandle::hasFirstLastPiecePriority() const
 {
+    if (isDormant())
+        return m_dormantInfo->firstLastPiecePriority;
+
     if (!hasMetadata())
         return m_needsToSetFirstLastPiecePriority;
 
@@ -809,7 +1118,10 @@ TorrentState TorrentHandle::state() const
 
 void TorrentHandle::updateState()
 {
-    if (m_nativeStatus.state == libt::torrent_status::checking_resume_data) {
+    if (m_isFastRechecking) {
+        m_state = m_hasSeedStatus ? TorrentState::CheckingUploading : TorrentState::CheckingDownloading;
+    }
+    else if (m_nativeStatus.state == libt::torrent_status::checking_resume_data) {
         m_state = TorrentState::CheckingResumeData;
     }
     else if (isMoveInProgress()) {
@@ -876,15 +1188,13 @@ bool TorrentHandle::hasMissingFiles() const
 
 bool TorrentHandle::hasError() const
 {
-#if LIBTORRENT_VERSION_NUM < 10100
-    return (m_nativeStatus.paused && !m_nativeStatus.error.empty());
-#else
-    return (m_nativeStatus.paused && m_nativeStatus.errc);
-#endif
+    return (m_nativeStatus.paused && !m_nativeStatus.error.isEmpty());
 }
 
 bool TorrentHandle::hasFilteredPieces() const
 {
+    if (!wakeUp()) return false;
+
     const std::vector<int> pp = m_nativeHandle.piece_priorities();
 
     for (const int priority : pp)
@@ -895,18 +1205,12 @@ bool TorrentHandle::hasFilteredPieces() const
 
 int TorrentHandle::queuePosition() const
 {
-    if (m_nativeStatus.queue_position < 0) return 0;
-
-    return m_nativeStatus.queue_position + 1;
+    return m_queuePosition;
 }
 
 QString TorrentHandle::error() const
 {
-#if LIBTORRENT_VERSION_NUM < 10100
-    return QString::fromStdString(m_nativeStatus.error);
-#else
-    return QString::fromStdString(m_nativeStatus.errc.message());
-#endif
+    return m_nativeStatus.error;
 }
 
 qlonglong TorrentHandle::totalDownload() const
@@ -974,6 +1278,31 @@ qulonglong TorrentHandle::eta() const
 
 QVector<qreal> TorrentHandle::filesProgress() const
 {
+    if (isDormant()) {
+        if (!loadDormantTorrentInfo()) return QVector<qreal>();
+
+        // Estimated from the pieces of each file, as for the progress of the torrent
+        const qlonglong pieceLength = m_torrentInfo.pieceLength();
+        QVector<qreal> result;
+        result.reserve(m_torrentInfo.filesCount());
+        for (int i = 0; i < m_torrentInfo.filesCount(); ++i) {
+            const qlonglong size = m_torrentInfo.fileSize(i);
+            const TorrentInfo::PieceRange pieces = m_torrentInfo.filePieces(i);
+            int piecesHave = 0;
+            for (int piece = pieces.first(); piece <= pieces.last(); ++piece) {
+                if (m_dormantInfo->pieces.testBit(piece))
+                    ++piecesHave;
+            }
+
+            if ((size <= 0) || (piecesHave == pieces.size()))
+                result << 1;
+            else
+                result << std::min(1.0, ((piecesHave * pieceLength) / static_cast<qreal>(size)));
+        }
+
+        return result;
+    }
+
     std::vector<boost::int64_t> fp;
     m_nativeHandle.file_progress(fp, libt::torrent_handle::piece_granularity);
 
@@ -1069,11 +1398,21 @@ int TorrentHandle::timeSinceActivity() const
 
 int TorrentHandle::downloadLimit() const
 {
+    if (isDormant())
+        return m_dormantInfo->downloadLimit;
+    if (hasBandwidthClassLimits())
+        return m_userDownloadLimit;
+
     return m_nativeHandle.download_limit();
 }
 
 int TorrentHandle::uploadLimit() const
 {
+    if (isDormant())
+        return m_dormantInfo->uploadLimit;
+    if (hasBandwidthClassLimits())
+        return m_userUploadLimit;
+
     return m_nativeHandle.upload_limit();
 }
 
@@ -1085,28 +1424,37 @@ bool TorrentHandle::superSeeding() const
 QList<PeerInfo> TorrentHandle::peers() const
 {
     QList<PeerInfo> peers;
+    if (isDormant()) return peers;
+
     std::vector<libt::peer_info> nativePeers;
 
     m_nativeHandle.get_peer_info(nativePeers);
+    const QBitArray allPieces = pieces();
 
     for (const libt::peer_info &peer : nativePeers)
-        peers << PeerInfo(this, peer);
+        peers << PeerInfo(allPieces, peer);
 
     return peers;
 }
 
 QBitArray TorrentHandle::pieces() const
 {
-    QBitArray result(m_nativeStatus.pieces.size());
+    if (isDormant()) return m_dormantInfo->pieces;
+
+    // Piece bitfield isn't a part of regular status updates
+    const libt::bitfield nativePieces = m_nativeHandle.status(libt::torrent_handle::query_pieces).pieces;
+    QBitArray result(nativePieces.size());
 
-    for (int i = 0; i < m_nativeStatus.pieces.size(); ++i)
-        result.setBit(i, m_nativeStatus.pieces.get_bit(i));
+    for (int i = 0; i < nativePieces.size(); ++i)
+        result.setBit(i, nativePieces.get_bit(i));
 
     return result;
 }
 
 QBitArray TorrentHandle::downloadingPieces() const
 {
+    if (!wakeUp()) return QBitArray();
+
     QBitArray result(piecesCount());
 
     std::vector<libt::partial_piece_info> queue;
@@ -1120,8 +1468,17 @@ QBitArray TorrentHandle::downloadingPieces() const
     return result;
 }
 
+bool TorrentHandle::havePiece(const int index) const
+{
+    if (!wakeUp()) return false;
+
+    return m_nativeHandle.have_piece(index);
+}
+
 QVector<int> TorrentHandle::pieceAvailability() const
 {
+    if (!wakeUp()) return QVector<int>();
+
     std::vector<int> avail;
     m_nativeHandle.piece_availability(avail);
 
@@ -1195,11 +1552,7 @@ int TorrentHandle::connectionsLimit() const
 
 qlonglong TorrentHandle::nextAnnounce() const
 {
-#if LIBTORRENT_VERSION_NUM < 10100
-    return m_nativeStatus.next_announce.total_seconds();
-#else
-    return libt::duration_cast<libt::seconds>(m_nativeStatus.next_announce).count();
-#endif
+    return m_nativeStatus.next_announce;
 }
 
 void TorrentHandle::setName(const QString &name)
@@ -1217,7 +1570,7 @@ bool TorrentHandle::setCategory(const QString &category)
             return false;
 
         QString oldCategory = m_category;
-        m_category = category;
+        m_category = StringPool::intern(category);
         m_session->handleTorrentCategoryChanged(this, oldCategory);
 
         if (m_useAutoTMM) {
@@ -1256,25 +1609,46 @@ void TorrentHandle::move_impl(QString path, bool overwrite)
         moveStorage(path, overwrite);
     }
     else {
-        m_savePath = path;
+        m_savePath = StringPool::intern(path);
         m_session->handleTorrentSavePathChanged(this);
     }
 }
 
 void TorrentHandle::forceReannounce(int index)
 {
+    if (!wakeUp()) return;
+
     m_nativeHandle.force_reannounce(0, index);
 }
 
+void TorrentHandle::scheduleReannounce(const QString &trackerUrl, const int seconds)
+{
+    if (isDormant()) return;
+
+    // The trackers list is only queried once, the indexes are kept until it is edited
+    if (m_trackerInfos.value(trackerUrl).index < 0)
+        lookUpTrackers();
+
+    const int index = m_trackerInfos.value(trackerUrl).index;
+    if (index >= 0)
+        m_nativeHandle.force_reannounce(seconds, index);
+}
+
 void TorrentHandle::forceDHTAnnounce()
 {
+    if (!wakeUp()) return;
+
     m_nativeHandle.force_dht_announce();
 }
 
 void TorrentHandle::forceRecheck()
 {
-    if (!hasMetadata()) return;
+    if (!hasMetadata() || !wakeUp()) return;
 
+    if (m_session->isFastRecheckEnabled() && m_session->fastRecheckTorrent(this))
+        return;
+
+    m_isFastRechecking = false;
     m_nativeHandle.force_recheck();
     m_unchecked = false;
 
@@ -1289,6 +1663,8 @@ void TorrentHandle::forceRecheck()
 
 void TorrentHandle::setSequentialDownload(bool b)
 {
+    if (!wakeUp()) return;
+
     if (b != isSequentialDownload()) {
         m_nativeHandle.set_sequential_download(b);
         m_nativeStatus.sequential_download = b; // prevent return cached value
@@ -1316,6 +1692,8 @@ void TorrentHandle::setFirstLastPiecePriorityImpl(const bool enabled, const QVec
         return;
     }
 
+    if (!wakeUp()) return;
+
     // Updating file priorities is an async operation in libtorrent, when we just updated it and immediately query it
     // we might get the old/wrong values, so we rely on `updatedFilePrio` in this case.
     const std::vector<int> filePriorities = !updatedFilePrio.isEmpty() ? updatedFilePrio.toStdVector() : nativeHandle().file_priorities();
@@ -1350,8 +1728,34 @@ void TorrentHandle::toggleFirstLastPiecePriority()
     setFirstLastPiecePriority(!hasFirstLastPiecePriority());
 }
 
+void TorrentHandle::setPieceDeadline(const int index, const int msecs)
+{
+    if (!wakeUp()) return;
+
+    m_nativeHandle.set_piece_deadline(index, msecs, libt::torrent_handle::alert_when_available);
+}
+
+void TorrentHandle::resetPieceDeadline(const int index)
+{
+    if (isDormant()) return;
+
+    m_nativeHandle.reset_piece_deadline(index);
+}
+
+void TorrentHandle::readPiece(const int index)
+{
+    if (!wakeUp()) return;
+
+    m_nativeHandle.read_piece(index);
+}
+
 void TorrentHandle::pause()
 {
+    if (m_isFastRechecking) {
+        m_pauseWhenReady = true;
+        return;
+    }
+
     if (isPaused()) return;
 
     m_nativeHandle.auto_managed(false);
@@ -1378,6 +1782,14 @@ void TorrentHandle::resume(bool forced)
 
 void TorrentHandle::resume_impl(bool forced)
 {
+    if (!wakeUp()) return;
+
+    if (m_isFastRechecking) {
+        m_pauseWhenReady = false;
+        m_needsToStartForced = forced;
+        return;
+    }
+
     if (hasError())
         m_nativeHandle.clear_error();
 
@@ -1392,6 +1804,12 @@ void TorrentHandle::resume_impl(bool forced)
 
 void TorrentHandle::moveStorage(const QString &newPath, bool overwrite)
 {
+    // The other torrents would lose their files
+    if (m_session->torrentSharesFiles(this)) {
+        LogMsg(tr("Couldn't move '%1' since other torrents use its files.").arg(name()), Log::WARNING);
+        return;
+    }
+
     if (isMoveInProgress()) {
         qDebug("enqueue move storage to %s", qUtf8Printable(newPath));
         m_moveStorageInfo.queuedPath = newPath;
@@ -1399,18 +1817,42 @@ void TorrentHandle::moveStorage(const QString &newPath, bool overwrite)
     }
     else {
         const QString oldPath = nativeActualSavePath();
-        if (QDir(oldPath) == QDir(newPath)) return;
+        if ((QDir(oldPath) == QDir(newPath)) || !wakeUp()) return;
 
-        qDebug("move storage: %s to %s", qUtf8Printable(oldPath), qUtf8Printable(newPath));
-        // Actually move the storage
-        m_nativeHandle.move_storage(newPath.toUtf8().constData()
-                                    , (overwrite ? libt::always_replace_files : libt::dont_replace));
+        qDebug("request move storage: %s to %s", qUtf8Printable(oldPath), qUtf8Printable(newPath));
+        // The session starts it once the storage devices are free
         m_moveStorageInfo.oldPath = oldPath;
         m_moveStorageInfo.newPath = newPath;
+        m_moveStorageInfo.overwrite = overwrite;
+        m_session->handleTorrentStorageMoveRequested(this, newPath);
         updateState();
     }
 }
 
+void TorrentHandle::startStorageMove()
+{
+    if (!isMoveInProgress()) return;
+
+    qDebug("move storage: %s to %s", qUtf8Printable(m_moveStorageInfo.oldPath), qUtf8Printable(m_moveStorageInfo.newPath));
+    // Actually move the storage
+    m_nativeHandle.move_storage(m_moveStorageInfo.newPath.toUtf8().constData()
+                                , (m_moveStorageInfo.overwrite ? libt::always_replace_files : libt::dont_replace));
+}
+
+void TorrentHandle::cancelStorageMove()
+{
+    if (!isMoveInProgress()) return;
+
+    LogMsg(tr("Cancelled moving torrent: '%1'.").arg(name()));
+
+    m_moveStorageInfo.newPath.clear();
+    m_moveStorageInfo.queuedPath.clear();
+    updateStatus();
+
+    while (!isMoveInProgress() && (m_renameCount == 0) && !m_moveFinishedTriggers.isEmpty())
+        m_moveFinishedTriggers.takeFirst()();
+}
+
 #if LIBTORRENT_VERSION_NUM < 10100
 void TorrentHandle::setTrackerLogin(const QString &username, const QString &password)
 {
@@ -1421,31 +1863,68 @@ void TorrentHandle::setTrackerLogin(const QString &username, const QString &pass
 
 void TorrentHandle::renameFile(int index, const QString &name)
 {
+    if (!wakeUp()) return;
+
     m_oldPath[LTFileIndex {index}].push_back(filePath(index));
     ++m_renameCount;
     qDebug() << Q_FUNC_INFO << index << name;
     m_nativeHandle.rename_file(index, Utils::Fs::toNativePath(name).toStdString());
 }
 
-bool TorrentHandle::saveTorrentFile(const QString &path)
+void TorrentHandle::handleStateUpdate(const libt::torrent_status &nativeStatus)
+{
+    updateStatus(nativeStatus);
+}
+
+bool TorrentHandle::needsFastRefresh(const libt::torrent_status &nativeStatus) const
 {
-    if (!m_torrentInfo.isValid()) return false;
+    // State transitions are never delayed
+    if ((nativeStatus.state != m_nativeStatus.state)
+        || (nativeStatus.paused != m_nativeStatus.paused)
+        || (nativeStatus.auto_managed != m_nativeStatus.auto_managed)
+        || (nativeStatus.has_metadata != m_nativeStatus.has_metadata)
+        || (hasNativeError(nativeStatus) == m_nativeStatus.error.isEmpty()))
+        return true;
 
-    libt::create_torrent torrentCreator = makeTorrentCreator<libt::create_torrent>(*(m_torrentInfo.nativeInfo()));
-    libt::entry torrentEntry = torrentCreator.generate();
+    if (nativeStatus.state == libt::torrent_status::checking_files)
+        return true;
 
-    QVector<char> out;
-    libt::bencode(std::back_inserter(out), torrentEntry);
-    QFile torrentFile(path);
-    if (!out.empty() && torrentFile.open(QIODevice::WriteOnly))
-        return (torrentFile.write(&out[0], out.size()) == out.size());
+    // Transferring torrents, including the ones which have just stopped
+    if ((nativeStatus.download_payload_rate > 0) || (nativeStatus.upload_payload_rate > 0)
+        || (m_nativeStatus.download_payload_rate > 0) || (m_nativeStatus.upload_payload_rate > 0))
+        return true;
 
-    return false;
+    return (m_fastRefreshDeadline > QDateTime::currentMSecsSinceEpoch());
 }
 
-void TorrentHandle::handleStateUpdate(const libt::torrent_status &nativeStatus)
+void TorrentHandle::handleDeferredStateUpdate(const libt::torrent_status &nativeStatus)
 {
-    updateStatus(nativeStatus);
+    m_nativeStatus.queue_position = nativeStatus.queue_position;
+}
+
+void TorrentHandle::requestFastRefresh()
+{
+    m_fastRefreshDeadline = QDateTime::currentMSecsSinceEpoch() + FAST_REFRESH_HOLD_TIME;
+}
+
+bool TorrentHandle::isQueued() const
+{
+    // libtorrent doesn't know dormant torrents, they keep the position they were restored with
+    if (isDormant())
+        return (m_queuePosition > 0);
+
+    return (m_nativeStatus.queue_position >= 0);
+}
+
+int TorrentHandle::nativeQueuePosition() const
+{
+    return m_nativeStatus.queue_position;
+}
+
+void TorrentHandle::handleQueuePositionChanged(const int position)
+{
+    // position in the session queue, -1 if the torrent left it
+    m_queuePosition = position + 1;
 }
 
 void TorrentHandle::handleStorageMovedAlert(const libtorrent::storage_moved_alert *p)
@@ -1473,10 +1952,11 @@ void TorrentHandle::handleStorageMovedAlert(const libtorrent::storage_moved_aler
         // torrent without root folder still has it in its temporary save path
         // so its temp path isn't equal to temp path root
         qDebug() << "Removing torrent temp folder:" << m_moveStorageInfo.oldPath;
-        Utils::Fs::smartRemoveEmptyFolderTree(m_moveStorageInfo.oldPath);
+        m_session->removeEmptyFolderTree(m_moveStorageInfo.oldPath);
     }
 
     m_moveStorageInfo.newPath.clear();
+    m_session->handleTorrentStorageMoveFinished(this);
     updateStatus();
 
     if (!m_moveStorageInfo.queuedPath.isEmpty()) {
@@ -1485,7 +1965,7 @@ void TorrentHandle::handleStorageMovedAlert(const libtorrent::storage_moved_aler
     }
 
     if (!useTempPath()) {
-        m_savePath = newPath;
+        m_savePath = StringPool::intern(newPath);
         m_session->handleTorrentSavePathChanged(this);
     }
 
@@ -1504,6 +1984,7 @@ void TorrentHandle::handleStorageMovedFailedAlert(const libtorrent::storage_move
         .arg(name(), QString::fromStdString(p->message())), Log::CRITICAL);
 
     m_moveStorageInfo.newPath.clear();
+    m_session->handleTorrentStorageMoveFinished(this);
     updateStatus();
 
     if (!m_moveStorageInfo.queuedPath.isEmpty()) {
@@ -1515,19 +1996,30 @@ void TorrentHandle::handleStorageMovedFailedAlert(const libtorrent::storage_move
         m_moveFinishedTriggers.takeFirst()();
 }
 
+void TorrentHandle::handleTrackerAnnounceAlert(const libtorrent::tracker_announce_alert *p)
+{
+#if LIBTORRENT_VERSION_NUM < 10100
+    const QString trackerUrl = QString::fromStdString(p->url);
+#else
+    const QString trackerUrl = p->tracker_url();
+#endif
+
+    m_session->handleTorrentTrackerAnnounce(this, trackerUrl);
+}
+
 void TorrentHandle::handleTrackerReplyAlert(const libtorrent::tracker_reply_alert *p)
 {
 #if LIBTORRENT_VERSION_NUM < 10100
-    QString trackerUrl = QString::fromStdString(p->url);
+    const QString trackerUrl = QString::fromStdString(p->url);
 #else
-    QString trackerUrl(p->tracker_url());
+    const QString trackerUrl = p->tracker_url();
 #endif
     qDebug("Received a tracker reply from %s (Num_peers = %d)", qUtf8Printable(trackerUrl), p->num_peers);
     // Connection was successful now. Remove possible old errors
     m_trackerInfos[trackerUrl].lastMessage.clear(); // Reset error/warning message
     m_trackerInfos[trackerUrl].numPeers = p->num_peers;
 
-    m_session->handleTorrentTrackerReply(this, trackerUrl);
+    m_session->handleTorrentTrackerReply(this, trackerUrl, p->num_peers);
 }
 
 void TorrentHandle::handleTrackerWarningAlert(const libtorrent::tracker_warning_alert *p)
@@ -1679,6 +2171,12 @@ void TorrentHandle::handleSaveResumeDataAlert(const libtorrent::save_resume_data
         auto savePath = resumeData.find_key("save_path")->string();
         resumeData["save_path"] = Profile::instance().toPortablePath(QString::fromStdString(savePath)).toStdString();
     }
+
+    storeResumeData(resumeData);
+}
+
+void TorrentHandle::storeResumeData(libtorrent::entry &resumeData)
+{
     resumeData["qBt-savePath"] = m_useAutoTMM ? "" : Profile::instance().toPortablePath(m_savePath).toStdString();
     resumeData["qBt-ratioLimit"] = static_cast<int>(m_ratioLimit * 1000);
     resumeData["qBt-seedingTimeLimit"] = m_seedingTimeLimit;
@@ -1687,8 +2185,18 @@ void TorrentHandle::handleSaveResumeDataAlert(const libtorrent::save_resume_data
     resumeData["qBt-name"] = m_name.toStdString();
     resumeData["qBt-seedStatus"] = m_hasSeedStatus;
     resumeData["qBt-tempPathDisabled"] = m_tempPathDisabled;
-    resumeData["qBt-queuePosition"] = (nativeHandle().queue_position() + 1); // qBt starts queue at 1
+    resumeData["qBt-queuePosition"] = queuePosition(); // qBt starts queue at 1
     resumeData["qBt-hasRootFolder"] = m_hasRootFolder;
+    if (hasBandwidthClassLimits()) {
+        // The native limits are lowered by the bandwidth classes
+        resumeData["upload_rate_limit"] = m_userUploadLimit;
+        resumeData["download_rate_limit"] = m_userDownloadLimit;
+    }
+    // The files can't be trusted while they are being verified and a dormant torrent
+    // keeps the stats it was stored with. They are stat()ed on the saving thread.
+    QStringList statFilePaths;
+    if (m_session->isFastRecheckEnabled() && hasMetadata() && !m_isFastRechecking && !isDormant())
+        statFilePaths = completeFilePaths();
 
     if (m_pauseWhenReady) {
         // We need to redefine these values when torrent starting/rechecking
@@ -1698,7 +2206,19 @@ void TorrentHandle::handleSaveResumeDataAlert(const libtorrent::save_resume_data
         resumeData["auto_managed"] = false;
     }
 
-    m_session->handleTorrentResumeDataReady(this, resumeData);
+    m_session->handleTorrentResumeDataReady(this, resumeData, statFilePaths);
+}
+
+// Only the files known to be complete are worth comparing on recheck,
+// the paths of the other ones are left empty
+QStringList TorrentHandle::completeFilePaths() const
+{
+    const QVector<qreal> fp = filesProgress();
+    QStringList filePaths;
+    filePaths.reserve(fp.size());
+    for (int i = 0; i < fp.size(); ++i)
+        filePaths.append((fp[i] == 1) ? filePath(i) : QString());
+    return filePaths;
 }
 
 void TorrentHandle::handleSaveResumeDataFailedAlert(const libtorrent::save_resume_data_failed_alert *p)
@@ -1719,6 +2239,12 @@ void TorrentHandle::handleFastResumeRejectedAlert(const libtorrent::fastresume_r
 {
     m_fastresumeDataRejected = true;
 
+    if (hasMetadata() && m_session->isFastRecheckEnabled() && m_session->fastRecheckTorrent(this)) {
+        LogMsg(tr("Fast resume data was rejected for torrent '%1'. Reason: %2. Checking changed files again...")
+            .arg(name(), QString::fromStdString(p->message())), Log::WARNING);
+        return;
+    }
+
     if (p->error.value() == libt::errors::mismatching_file_size) {
         // Mismatching file size (files were probably moved)
         m_hasMissingFiles = true;
@@ -1812,6 +2338,17 @@ void TorrentHandle::handleFileCompletedAlert(const libtorrent::file_completed_al
     }
 }
 
+void TorrentHandle::handleReadPieceAlert(const libtorrent::read_piece_alert *p)
+{
+#if LIBTORRENT_VERSION_NUM < 10100
+    if (p->ec) return;
+#else
+    if (p->error) return;
+#endif
+
+    m_session->handleTorrentPieceRead(this, p->piece, QByteArray(p->buffer.get(), p->size));
+}
+
 void TorrentHandle::handleStatsAlert(const libtorrent::stats_alert *p)
 {
     Q_ASSERT(p->interval >= 1000);
@@ -1902,6 +2439,9 @@ void TorrentHandle::handleAlert(libtorrent::alert *a)
     case libt::torrent_resumed_alert::alert_type:
         handleTorrentResumedAlert(static_cast<libt::torrent_resumed_alert*>(a));
         break;
+    case libt::tracker_announce_alert::alert_type:
+        handleTrackerAnnounceAlert(static_cast<libt::tracker_announce_alert*>(a));
+        break;
     case libt::tracker_error_alert::alert_type:
         handleTrackerErrorAlert(static_cast<libt::tracker_error_alert*>(a));
         break;
@@ -1920,6 +2460,9 @@ void TorrentHandle::handleAlert(libtorrent::alert *a)
     case libt::torrent_checked_alert::alert_type:
         handleTorrentCheckedAlert(static_cast<libt::torrent_checked_alert*>(a));
         break;
+    case libt::read_piece_alert::alert_type:
+        handleReadPieceAlert(static_cast<libt::read_piece_alert*>(a));
+        break;
     }
 }
 
@@ -1982,13 +2525,82 @@ libtorrent::torrent_handle TorrentHandle::nativeHandle() const
     return m_nativeHandle;
 }
 
-void TorrentHandle::updateTorrentInfo()
+void TorrentHandle::handleWokenUp(const libtorrent::torrent_handle &nativeHandle)
+{
+    m_nativeHandle = nativeHandle;
+    m_dormantInfo.reset();
+    updateStatus();
+}
+
+bool TorrentHandle::isFastRechecking() const
+{
+    return m_isFastRechecking;
+}
+
+void TorrentHandle::handleFastRecheckStarted()
+{
+    // The torrent is kept paused until it is added back to libtorrent
+    // with the verified pieces, then it is started as if it was restored
+    if (m_startupState == Started) {
+        m_needsToStartForced = isForced();
+        m_pauseWhenReady = isPaused();
+        m_startupState = Preparing;
+    }
+
+    m_isFastRechecking = true;
+    m_unchecked = false;
+    m_hasMissingFiles = false;
+    m_nativeHandle.auto_managed(false);
+    m_nativeHandle.pause();
+    updateState();
+}
+
+void TorrentHandle::handleFastRecheckFinished(const libtorrent::torrent_handle &nativeHandle)
+{
+    m_nativeHandle = nativeHandle;
+    m_isFastRechecking = false;
+    // The new native handle has the limits of the resume data
+    if (hasBandwidthClassLimits())
+        applyRateLimits();
+    // Stored resume data doesn't match the verified pieces
+    m_fastresumeDataRejected = true;
+    updateStatus();
+}
+
+void TorrentHandle::handleFastRecheckFailed()
+{
+    m_isFastRechecking = false;
+    m_nativeHandle.force_recheck();
+    m_nativeHandle.stop_when_ready(true);
+    m_nativeHandle.auto_managed(true);
+    updateState();
+}
+
+// Returns false if the torrent is dormant and couldn't be added to libtorrent
+bool TorrentHandle::wakeUp() const
+{
+    if (!isDormant()) return true;
+
+    // Waking up changes how the data is obtained, not the data itself
+    return m_session->wakeUpTorrent(const_cast<TorrentHandle *>(this));
+}
+
+bool TorrentHandle::loadDormantTorrentInfo() const
+{
+    if (!isDormant() || m_torrentInfo.isValid()) return m_torrentInfo.isValid();
+
+    // Same as above, it's only a cache of the metadata libtorrent would give
+    const_cast<TorrentHandle *>(this)->m_torrentInfo = m_session->storedTorrentInfo(this);
+    return m_torrentInfo.isValid();
+}
+
+void TorrentHandle::updateTorrentInfo(const libt::torrent_status &nativeStatus)
 {
     if (!hasMetadata()) return;
 #if LIBTORRENT_VERSION_NUM < 10100
-    m_torrentInfo = TorrentInfo(m_nativeStatus.torrent_file);
+    m_torrentInfo = TorrentInfo(nativeStatus.torrent_file);
 #else
-    m_torrentInfo = TorrentInfo(m_nativeStatus.torrent_file.lock());
+    m_torrentInfo = TorrentInfo(nativeStatus.torrent_file.lock());
 #endif
 }
 
@@ -2004,15 +2616,78 @@ bool TorrentHandle::useTempPath() const
 
 void TorrentHandle::updateStatus()
 {
-    updateStatus(m_nativeHandle.status());
+    updateStatus(m_nativeHandle.status(STATUS_QUERY_FLAGS));
+}
+
+void TorrentHandle::NativeStatus::assign(const libt::torrent_status &nativeStatus)
+{
+    if (!nativeStatus.has_metadata)
+        name = QString::fromStdString(nativeStatus.name);
+    else if (!name.isEmpty())
+        name.clear();
+
+    // Repeated across torrents, so it is shared through the pool once it changes
+    const QString savePath = QString::fromStdString(nativeStatus.save_path);
+    if (savePath != save_path)
+        save_path = StringPool::intern(savePath);
+    current_tracker = QString::fromStdString(nativeStatus.current_tracker);
+    if (hasNativeError(nativeStatus))
+        error = nativeErrorMessage(nativeStatus);
+    else
+        error.clear();
+
+    total_done = nativeStatus.total_done;
+    total_wanted = nativeStatus.total_wanted;
+    total_wanted_done = nativeStatus.total_wanted_done;
+    total_failed_bytes = nativeStatus.total_failed_bytes;
+    total_redundant_bytes = nativeStatus.total_redundant_bytes;
+    total_payload_download = nativeStatus.total_payload_download;
+    total_payload_upload = nativeStatus.total_payload_upload;
+    all_time_download = nativeStatus.all_time_download;
+    all_time_upload = nativeStatus.all_time_upload;
+    added_time = nativeStatus.added_time;
+    completed_time = nativeStatus.completed_time;
+    last_seen_complete = nativeStatus.last_seen_complete;
+
+    state = nativeStatus.state;
+    active_time = nativeStatus.active_time;
+    finished_time = nativeStatus.finished_time;
+    seeding_time = nativeStatus.seeding_time;
+    time_since_download = nativeStatus.time_since_download;
+    time_since_upload = nativeStatus.time_since_upload;
+#if LIBTORRENT_VERSION_NUM < 10100
+    next_announce = nativeStatus.next_announce.total_seconds();
+#else
+    next_announce = libt::duration_cast<libt::seconds>(nativeStatus.next_announce).count();
+#endif
+    download_payload_rate = nativeStatus.download_payload_rate;
+    upload_payload_rate = nativeStatus.upload_payload_rate;
+    num_seeds = nativeStatus.num_seeds;
+    num_peers = nativeStatus.num_peers;
+    num_complete = nativeStatus.num_complete;
+    num_incomplete = nativeStatus.num_incomplete;
+    list_seeds = nativeStatus.list_seeds;
+    list_peers = nativeStatus.list_peers;
+    num_pieces = nativeStatus.num_pieces;
+    num_connections = nativeStatus.num_connections;
+    connections_limit = nativeStatus.connections_limit;
+    queue_position = nativeStatus.queue_position;
+    progress = nativeStatus.progress;
+    distributed_copies = nativeStatus.distributed_copies;
+
+    paused = nativeStatus.paused;
+    auto_managed = nativeStatus.auto_managed;
+    has_metadata = nativeStatus.has_metadata;
+    sequential_download = nativeStatus.sequential_download;
+    super_seeding = nativeStatus.super_seeding;
 }
 
 void TorrentHandle::updateStatus(const libtorrent::torrent_status &nativeStatus)
 {
-    m_nativeStatus = nativeStatus;
+    m_nativeStatus.assign(nativeStatus);
 
     updateState();
-    updateTorrentInfo();
+    updateTorrentInfo(nativeStatus);
 
     // NOTE: Don't change the order of these conditionals!
     // Otherwise it will not work properly since torrent can be CheckingDownloading.
@@ -2050,32 +2725,87 @@ void TorrentHandle::setSeedingTimeLimit(int limit)
 
 void TorrentHandle::setUploadLimit(int limit)
 {
-    m_nativeHandle.set_upload_limit(limit);
+    if (!wakeUp()) return;
+
+    if (hasBandwidthClassLimits()) {
+        m_userUploadLimit = limit;
+        applyRateLimits();
+    }
+    else {
+        m_nativeHandle.set_upload_limit(limit);
+    }
 }
 
 void TorrentHandle::setDownloadLimit(int limit)
 {
-    m_nativeHandle.set_download_limit(limit);
+    if (!wakeUp()) return;
+
+    if (hasBandwidthClassLimits()) {
+        m_userDownloadLimit = limit;
+        applyRateLimits();
+    }
+    else {
+        m_nativeHandle.set_download_limit(limit);
+    }
+}
+
+void TorrentHandle::setBandwidthClassLimits(const int uploadLimit, const int downloadLimit)
+{
+    if (isDormant()) return;
+    if ((uploadLimit == m_classUploadLimit) && (downloadLimit == m_classDownloadLimit)) return;
+
+    if (!hasBandwidthClassLimits()) {
+        m_userUploadLimit = m_nativeHandle.upload_limit();
+        m_userDownloadLimit = m_nativeHandle.download_limit();
+    }
+
+    m_classUploadLimit = uploadLimit;
+    m_classDownloadLimit = downloadLimit;
+    applyRateLimits();
+}
+
+bool TorrentHandle::hasBandwidthClassLimits() const
+{
+    return ((m_classUploadLimit > 0) || (m_classDownloadLimit > 0));
+}
+
+void TorrentHandle::applyRateLimits()
+{
+    m_nativeHandle.set_upload_limit(stricterRateLimit(m_userUploadLimit, m_classUploadLimit));
+    m_nativeHandle.set_download_limit(stricterRateLimit(m_userDownloadLimit, m_classDownloadLimit));
 }
 
 void TorrentHandle::setSuperSeeding(bool enable)
 {
+    if (!wakeUp()) return;
+
     m_nativeHandle.super_seeding(enable);
 }
 
 void TorrentHandle::flushCache()
 {
+    if (isDormant()) return;
+
     m_nativeHandle.flush_cache();
 }
 
 QString TorrentHandle::toMagnetUri() const
 {
+    if (isDormant()) {
+        // the same as libtorrent makes, without waking the torrent up
+        QString magnetUri = QLatin1String("magnet:?xt=urn:btih:") + QString(m_hash)
+                + QLatin1String("&dn=") + QString::fromLatin1(QUrl::toPercentEncoding(name()));
+        for (const DormantInfo::Tracker &tracker : asConst(m_dormantInfo->trackers))
+            magnetUri += QLatin1String("&tr=") + QString::fromLatin1(QUrl::toPercentEncoding(tracker.url));
+        return magnetUri;
+    }
+
     return QString::fromStdString(libt::make_magnet_uri(m_nativeHandle));
 }
 
 void TorrentHandle::prioritizeFiles(const QVector<int> &priorities)
 {
-    if (!hasMetadata()) return;
+    if (!hasMetadata() || !wakeUp()) return;
     if (priorities.size() != filesCount()) return;
 
     // Save first/last piece first option state
@@ -2178,3 +2908,23 @@ QVector<qreal> TorrentHandle::availableFileFractions() const
     }
     return res;
 }
+
+qint64 TorrentHandle::memoryUsage() const
+{
+    qint64 usage = sizeof(*this)
+            + MemoryUsage::ofStringData(m_name)
+            + MemoryUsage::ofStringData(m_nativeStatus.name)
+            + (m_tags.size() * MemoryUsage::ofHashNode<QString>());
+
+    if (isDormant())
+        usage += sizeof(DormantInfo) + (m_dormantInfo->trackers.capacity() * sizeof(DormantInfo::Tracker))
+                + (m_dormantInfo->pieces.size() / 8);
+
+    for (const QVector<QString> &paths : m_oldPath) {
+        usage += MemoryUsage::ofHashNode<LTFileIndex, QVector<QString>>() + (paths.capacity() * sizeof(QString));
+        for (const QString &path : paths)
+            usage += MemoryUsage::ofStringData(path);
+    }
+
+    return usage;
+}
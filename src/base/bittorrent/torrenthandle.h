@@ -30,10 +30,12 @@
 #ifndef BITTORRENT_TORRENTHANDLE_H
 #define BITTORRENT_TORRENTHANDLE_H
 
+#include <QBitArray>
 #include <QDateTime>
 #include <QHash>
 #include <QObject>
 #include <QQueue>
+#include <QScopedPointer>
 #include <QSet>
 #include <QString>
 #include <QVector>
@@ -51,7 +53,6 @@
 #include "infohash.h"
 #include "torrentinfo.h"
 
-class QBitArray;
 class QStringList;
 template<typename T, typename U> struct QPair;
 
@@ -60,6 +61,7 @@ extern const QString QB_EXT;
 namespace libtorrent
 {
     class alert;
+    class entry;
     struct stats_alert;
     struct torrent_checked_alert;
     struct torrent_finished_alert;
@@ -73,10 +75,12 @@ namespace libtorrent
     struct storage_moved_failed_alert;
     struct metadata_received_alert;
     struct file_completed_alert;
+    struct tracker_announce_alert;
     struct tracker_error_alert;
     struct tracker_reply_alert;
     struct tracker_warning_alert;
     struct fastresume_rejected_alert;
+    struct read_piece_alert;
     struct torrent_status;
 }
 
@@ -111,6 +115,7 @@ namespace BitTorrent
         // for restored torrents
         qreal ratioLimit;
         int seedingTimeLimit;
+        int queuePosition;
 
         CreateTorrentParams();
         CreateTorrentParams(const AddTorrentParams &params);
@@ -120,6 +125,7 @@ namespace BitTorrent
     {
         QString lastMessage;
         quint32 numPeers = 0;
+        int index = -1; // in the trackers list, -1 if not looked up yet
     };
 
     enum class TorrentState
@@ -170,11 +176,20 @@ namespace BitTorrent
         static const qreal MAX_RATIO;
         static const int MAX_SEEDING_TIME;
 
+        // Status fields queried on regular refresh, piece bitfields are fetched on demand
+        static const quint32 STATUS_QUERY_FLAGS;
+
         TorrentHandle(Session *session, const libtorrent::torrent_handle &nativeHandle,
                           const CreateTorrentParams &params);
         ~TorrentHandle();
 
+        // Creates a paused torrent which isn't added to libtorrent until it is needed.
+        // Returns nullptr if the resume data doesn't contain the torrent metadata.
+        static TorrentHandle *createDormant(Session *session, const InfoHash &hash
+                                            , const CreateTorrentParams &params, const QByteArray &resumeData);
+
         bool isValid() const;
+        bool isDormant() const;
         InfoHash hash() const;
         QString name() const;
         QDateTime creationDate() const;
@@ -256,6 +271,8 @@ namespace BitTorrent
         int piecesCount() const;
         int piecesHave() const;
         qreal progress() const;
+        // Of the storage move, -1 while it waits for its turn
+        qreal moveProgress() const;
         QDateTime addedTime() const;
         qreal ratioLimit() const;
         int seedingTimeLimit() const;
@@ -290,6 +307,8 @@ namespace BitTorrent
         int queuePosition() const;
         QList<TrackerEntry> trackers() const;
         QHash<QString, TrackerInfo> trackerInfos() const;
+        // Answered from the cached trackers list, which is only queried once
+        bool hasTracker(const QString &trackerUrl);
         QList<QUrl> urlSeeds() const;
         QString error() const;
         qlonglong totalDownload() const;
@@ -317,6 +336,7 @@ namespace BitTorrent
         bool superSeeding() const;
         QList<PeerInfo> peers() const;
         QBitArray pieces() const;
+        bool havePiece(int index) const;
         QBitArray downloadingPieces() const;
         QVector<int> pieceAvailability() const;
         qreal distributedCopies() const;
@@ -336,17 +356,25 @@ namespace BitTorrent
         void toggleSequentialDownload();
         void setFirstLastPiecePriority(bool enabled);
         void toggleFirstLastPiecePriority();
+        // A piece with a deadline is requested from the fastest peers and
+        // its data is handed to Session::torrentPieceRead() once it is available
+        void setPieceDeadline(int index, int msecs);
+        void resetPieceDeadline(int index);
+        // The data of a downloaded piece is handed to Session::torrentPieceRead()
+        void readPiece(int index);
         void pause();
         void resume(bool forced = false);
         void move(QString path);
         void forceReannounce(int index = -1);
+        // Moves the next announce to the tracker to the given delay in secs
+        void scheduleReannounce(const QString &trackerUrl, int seconds);
         void forceDHTAnnounce();
         void forceRecheck();
 #if LIBTORRENT_VERSION_NUM < 10100
         void setTrackerLogin(const QString &username, const QString &password);
 #endif
         void renameFile(int index, const QString &name);
-        bool saveTorrentFile(const QString &path);
+        // bencoded .torrent file, empty if there is no metadata
         void prioritizeFiles(const QVector<int> &priorities);
         void setRatioLimit(qreal limit);
         void setSeedingTimeLimit(int limit);
@@ -356,9 +384,14 @@ namespace BitTorrent
         void flushCache();
         void addTrackers(const QList<TrackerEntry> &trackers);
         void replaceTrackers(const QList<TrackerEntry> &trackers);
+        // libtorrent can only remove trackers by replacing the whole list,
+        // which restarts the announces to all of them
+        void removeTrackers(const QStringList &trackerUrls);
         void addUrlSeeds(const QList<QUrl> &urlSeeds);
         void removeUrlSeeds(const QList<QUrl> &urlSeeds);
         bool connectPeer(const PeerAddress &peerAddress);
+        // Keep the torrent in the fast refresh tier for a while, e.g. while it is shown
+        void requestFastRefresh();
 
         QString toMagnetUri() const;
 
@@ -367,12 +400,30 @@ namespace BitTorrent
         // Session interface
         libtorrent::torrent_handle nativeHandle() const;
 
+        void handleWokenUp(const libtorrent::torrent_handle &nativeHandle);
+        // Limits of the bandwidth classes of the torrent, 0 if none. The native
+        // limits are the stricter of these and the ones set by the user.
+        void setBandwidthClassLimits(int uploadLimit, int downloadLimit);
+        bool isFastRechecking() const;
+        void handleFastRecheckStarted();
+        void handleFastRecheckFinished(const libtorrent::torrent_handle &nativeHandle);
+        void handleFastRecheckFailed();
         void handleAlert(libtorrent::alert *a);
         void handleStateUpdate(const libtorrent::torrent_status &nativeStatus);
+        bool needsFastRefresh(const libtorrent::torrent_status &nativeStatus) const;
+        // Applies what the session queue depends on from a status whose update is deferred
+        void handleDeferredStateUpdate(const libtorrent::torrent_status &nativeStatus);
+        // Whether libtorrent queues the torrent, the session plans its queue position
+        bool isQueued() const;
+        int nativeQueuePosition() const;
+        void handleQueuePositionChanged(int position);
         void handleTempPathChanged();
         void handleCategorySavePathChanged();
         void handleAppendExtensionToggled();
         void saveResumeData();
+        // The storage move requested to the session may start or be cancelled
+        void startStorageMove();
+        void cancelStorageMove();
 
         /**
          * @brief fraction of file pieces that are available at least from one peer
@@ -382,9 +433,14 @@ namespace BitTorrent
          */
         QVector<qreal> availableFileFractions() const;
 
+        // Heap used by this torrent, not counting the pooled strings
+        qint64 memoryUsage() const;
+
     private:
         typedef boost::function<void ()> EventTrigger;
 
+        TorrentHandle(Session *session, const InfoHash &hash, const CreateTorrentParams &params);
+
 #if (LIBTORRENT_VERSION_NUM < 10200)
         using LTFileIndex = int;
 #else
@@ -394,10 +450,16 @@ namespace BitTorrent
         void updateStatus();
         void updateStatus(const libtorrent::torrent_status &nativeStatus);
         void updateState();
-        void updateTorrentInfo();
+        void updateTorrentInfo(const libtorrent::torrent_status &nativeStatus);
+        bool wakeUp() const;
+        // Loads the metadata of a dormant torrent without waking it up
+        bool loadDormantTorrentInfo() const;
+        void storeResumeData(libtorrent::entry &resumeData);
+        QStringList completeFilePaths() const;
 
         void handleStorageMovedAlert(const libtorrent::storage_moved_alert *p);
         void handleStorageMovedFailedAlert(const libtorrent::storage_moved_failed_alert *p);
+        void handleTrackerAnnounceAlert(const libtorrent::tracker_announce_alert *p);
         void handleTrackerReplyAlert(const libtorrent::tracker_reply_alert *p);
         void handleTrackerWarningAlert(const libtorrent::tracker_warning_alert *p);
         void handleTrackerErrorAlert(const libtorrent::tracker_error_alert *p);
@@ -413,6 +475,7 @@ namespace BitTorrent
         void handleFileCompletedAlert(const libtorrent::file_completed_alert *p);
         void handleMetadataReceivedAlert(const libtorrent::metadata_received_alert *p);
         void handleStatsAlert(const libtorrent::stats_alert *p);
+        void handleReadPieceAlert(const libtorrent::read_piece_alert *p);
 
         void resume_impl(bool forced);
         bool isMoveInProgress() const;
@@ -424,13 +487,88 @@ namespace BitTorrent
         void moveStorage(const QString &newPath, bool overwrite);
         void manageIncompleteFiles();
         bool addTracker(const TrackerEntry &tracker);
+        void lookUpTrackers();
         bool addUrlSeed(const QUrl &urlSeed);
         bool removeUrlSeed(const QUrl &urlSeed);
         void setFirstLastPiecePriorityImpl(bool enabled, const QVector<int> &updatedFilePrio = {});
+        bool hasBandwidthClassLimits() const;
+        void applyRateLimits();
+
+        // The fields of libtorrent::torrent_status we actually read. A full copy is
+        // several times larger and holds heap allocated strings and bitfields.
+        struct NativeStatus
+        {
+            void assign(const libtorrent::torrent_status &nativeStatus);
+
+            QString name; // only until metadata is received
+            QString save_path;
+            QString current_tracker;
+            QString error;
+
+            qint64 total_done = 0;
+            qint64 total_wanted = 0;
+            qint64 total_wanted_done = 0;
+            qint64 total_failed_bytes = 0;
+            qint64 total_redundant_bytes = 0;
+            qint64 total_payload_download = 0;
+            qint64 total_payload_upload = 0;
+            qint64 all_time_download = 0;
+            qint64 all_time_upload = 0;
+            time_t added_time = 0;
+            time_t completed_time = 0;
+            time_t last_seen_complete = 0;
+
+            libtorrent::torrent_status::state_t state = libtorrent::torrent_status::checking_resume_data;
+            int active_time = 0;
+            int finished_time = 0;
+            int seeding_time = 0;
+            int time_since_download = -1;
+            int time_since_upload = -1;
+            int next_announce = 0; // in seconds
+            int download_payload_rate = 0;
+            int upload_payload_rate = 0;
+            int num_seeds = 0;
+            int num_peers = 0;
+            int num_complete = -1;
+            int num_incomplete = -1;
+            int list_seeds = 0;
+            int list_peers = 0;
+            int num_pieces = 0;
+            int num_connections = 0;
+            int connections_limit = 0;
+            int queue_position = -1;
+            float progress = 0;
+            float distributed_copies = 0;
+
+            bool paused = false;
+            bool auto_managed = false;
+            bool has_metadata = false;
+            bool sequential_download = false;
+            bool super_seeding = false;
+        };
+
+        // What a dormant torrent has to answer without its metadata
+        struct DormantInfo
+        {
+            qint64 totalSize = 0;
+            int uploadLimit = -1;
+            int downloadLimit = -1;
+            bool isPrivate = false;
+            bool firstLastPiecePriority = false;
+            QBitArray pieces;
+
+            struct Tracker
+            {
+                QString url;
+                int tier;
+            };
+            QVector<Tracker> trackers;
+        };
 
         Session *const m_session;
         libtorrent::torrent_handle m_nativeHandle;
-        libtorrent::torrent_status m_nativeStatus;
+        NativeStatus m_nativeStatus;
+        QScopedPointer<DormantInfo> m_dormantInfo;
         TorrentState m_state;
         TorrentInfo m_torrentInfo;
         SpeedMonitor m_speedMonitor;
@@ -441,6 +579,7 @@ namespace BitTorrent
         {
             QString oldPath;
             QString newPath;
+            bool overwrite = true;
             // queuedPath is where files should be moved to,
             // when current moving is completed
             QString queuedPath;
@@ -473,7 +612,9 @@ namespace BitTorrent
         bool m_needsToSetFirstLastPiecePriority;
         bool m_needsToStartForced;
 
+        // Every tracker of the torrent once m_areTrackersLookedUp is set
         QHash<QString, TrackerInfo> m_trackerInfos;
+        bool m_areTrackersLookedUp = false;
 
         enum StartupState
         {
@@ -487,6 +628,18 @@ namespace BitTorrent
         bool m_pauseWhenReady;
 
         bool m_unchecked = false;
+        // Data is being verified outside of libtorrent
+        bool m_isFastRechecking = false;
+        qint64 m_fastRefreshDeadline = 0;
+        // 1-based position in the queue planned by the session, 0 if not queued
+        int m_queuePosition = 0;
+
+        // The limits set by the user are only kept here while
+        // the bandwidth classes lower the native ones
+        int m_userUploadLimit = -1;
+        int m_userDownloadLimit = -1;
+        int m_classUploadLimit = 0;
+        int m_classDownloadLimit = 0;
     };
 }
 
@@ -28,6 +28,12 @@
 
 #include "torrentinfo.h"
 
+#include <iterator>
+#include <type_traits>
+
+#include <libtorrent/bencode.hpp>
+#include <libtorrent/create_torrent.hpp>
+#include <libtorrent/entry.hpp>
 #include <libtorrent/error_code.hpp>
 
 #include <QDateTime>
@@ -45,6 +51,31 @@
 namespace libt = libtorrent;
 using namespace BitTorrent;
 
+// The new libtorrent::create_torrent constructor appeared after 1.0.11 in RC_1_0
+// and after 1.1.1 in RC_1_1. Since it fixed an ABI incompatibility with previous versions
+// distros might choose to backport it onto 1.0.11 and 1.1.1 respectively.
+// So we need a way to detect its presence without relying solely on the LIBTORRENT_VERSION_NUM.
+// Relevant links:
+// 1. https://github.com/arvidn/libtorrent/issues/1696
+// 2. https://github.com/qbittorrent/qBittorrent/issues/6406
+// The following can be removed after one or two libtorrent releases on each branch.
+namespace
+{
+    // new constructor is available
+    template<typename T, typename std::enable_if<std::is_constructible<T, libt::torrent_info, bool>::value, int>::type = 0>
+    T makeTorrentCreator(const libtorrent::torrent_info &ti)
+    {
+        return T(ti, true);
+    }
+
+    // new constructor isn't available
+    template<typename T, typename std::enable_if<!std::is_constructible<T, libt::torrent_info, bool>::value, int>::type = 0>
+    T makeTorrentCreator(const libtorrent::torrent_info &ti)
+    {
+        return T(ti);
+    }
+}
+
 TorrentInfo::TorrentInfo(NativeConstPtr nativeInfo)
 {
     m_nativeInfo = boost::const_pointer_cast<libt::torrent_info>(nativeInfo);
@@ -271,6 +302,18 @@ QByteArray TorrentInfo::metadata() const
     return QByteArray(m_nativeInfo->metadata().get(), m_nativeInfo->metadata_size());
 }
 
+QByteArray TorrentInfo::torrentFileData() const
+{
+    if (!isValid()) return QByteArray();
+
+    libt::create_torrent torrentCreator = makeTorrentCreator<libt::create_torrent>(*m_nativeInfo);
+    const libt::entry torrentEntry = torrentCreator.generate();
+
+    QByteArray out;
+    libt::bencode(std::back_inserter(out), torrentEntry);
+    return out;
+}
+
 QStringList TorrentInfo::filesForPiece(int pieceIndex) const
 {
     // no checks here because fileIndicesForPiece() will return an empty list
@@ -34,6 +34,7 @@
 
 #include <QCoreApplication>
 #include <QList>
+#include <QMetaType>
 #include <QtGlobal>
 #include <QVector>
 
@@ -92,6 +93,8 @@ namespace BitTorrent
         QList<TrackerEntry> trackers() const;
         QList<QUrl> urlSeeds() const;
         QByteArray metadata() const;
+        // Bencoded .torrent file, with the trackers and URL seeds
+        QByteArray torrentFileData() const;
         QStringList filesForPiece(int pieceIndex) const;
         QVector<int> fileIndicesForPiece(int pieceIndex) const;
         QVector<QByteArray> pieceHashes() const;
@@ -117,4 +120,6 @@ namespace BitTorrent
     };
 }
 
+Q_DECLARE_METATYPE(BitTorrent::TorrentInfo)
+
 #endif // BITTORRENT_TORRENTINFO_H
@@ -33,12 +33,21 @@
 #include <QTcpSocket>
 
 #include "base/logger.h"
+#include "contentsource.h"
+#include "eventstream.h"
 #include "irequesthandler.h"
 #include "requestparser.h"
 #include "responsegenerator.h"
 
 using namespace Http;
 
+namespace
+{
+    // Streamed content is read in chunks of this size and no more than
+    // two of them are queued in the socket, so slow clients don't pile up data in memory
+    const qint64 CONTENT_CHUNK_SIZE = 64 * 1024;
+}
+
 Connection::Connection(QTcpSocket *socket, IRequestHandler *requestHandler, QObject *parent)
     : QObject(parent)
     , m_socket(socket)
@@ -57,8 +66,20 @@ Connection::~Connection()
 void Connection::read()
 {
     m_idleTimer.restart();
+
+    // pipelined requests wait in the socket until the streamed content is sent,
+    // its read buffer is limited meanwhile so the client is held back
+    if (m_contentSource)
+        return;
+
     m_receivedData.append(m_socket->readAll());
 
+    // no more requests are served once the connection carries an event stream
+    if (m_eventStream) {
+        m_receivedData.clear();
+        return;
+    }
+
     while (!m_receivedData.isEmpty()) {
         const RequestParser::ParseResult result = RequestParser::parse(m_receivedData);
 
@@ -95,13 +116,35 @@ void Connection::read()
 
                 Response resp = m_requestHandler->processRequest(result.request, env);
 
-                if (acceptsGzipEncoding(result.request.headers["accept-encoding"]))
-                    resp.headers[HEADER_CONTENT_ENCODING] = "gzip";
+                // the handler may have served a precompressed body already, or one whose
+                // validator names that representation, which a compressed body can't share
+                if (!resp.headers.contains(HEADER_CONTENT_ENCODING) && !resp.headers.contains(HEADER_ETAG)
+                    && acceptsGzipEncoding(result.request.headers[HEADER_ACCEPT_ENCODING]))
+                    compressContent(resp);
 
                 resp.headers[HEADER_CONNECTION] = "keep-alive";
 
                 sendResponse(resp);
                 m_receivedData = m_receivedData.mid(result.frameSize);
+
+                if (resp.contentSource) {
+                    m_socket->setReadBufferSize(CONTENT_CHUNK_SIZE);
+                    m_contentSource = resp.contentSource;
+                    m_contentSource->setParent(this);
+                    connect(m_contentSource, &ContentSource::readyRead, this, &Connection::sendContent);
+                    connect(m_contentSource, &ContentSource::failed, m_socket, &QTcpSocket::close);
+                    connect(m_socket, &QTcpSocket::bytesWritten, this, &Connection::sendContent);
+                    sendContent();
+                    return;
+                }
+
+                if ((resp.status.code == 200)
+                    && (resp.headers.value(HEADER_CONTENT_TYPE) == QLatin1String(CONTENT_TYPE_EVENT_STREAM))) {
+                    m_receivedData.clear();
+                    m_eventStream = new EventStream(m_socket, this);
+                    m_requestHandler->openEventStream(m_eventStream);
+                    return;
+                }
             }
             break;
 
@@ -117,54 +160,47 @@ void Connection::sendResponse(const Response &response) const
     m_socket->write(toByteArray(response));
 }
 
-bool Connection::hasExpired(const qint64 timeout) const
+void Connection::sendContent()
 {
-    return m_idleTimer.hasExpired(timeout);
-}
-
-bool Connection::isClosed() const
-{
-    return (m_socket->state() == QAbstractSocket::UnconnectedState);
-}
+    if (!m_contentSource) return;
 
-bool Connection::acceptsGzipEncoding(QString codings)
-{
-    // [rfc7231] 5.3.4. Accept-Encoding
+    while (m_contentSource->bytesLeft() > 0) {
+        if (m_socket->bytesToWrite() >= (2 * CONTENT_CHUNK_SIZE))
+            return;
 
-    const auto isCodingAvailable = [](const QStringList &list, const QString &encoding) -> bool
-    {
-        for (const QString &str : list) {
-            if (!str.startsWith(encoding))
-                continue;
+        const QByteArray data = m_contentSource->read(CONTENT_CHUNK_SIZE);
+        if (data.isEmpty())
+            return;
 
-            // without quality values
-            if (str == encoding)
-                return true;
+        m_socket->write(data);
+    }
 
-            // [rfc7231] 5.3.1. Quality Values
-            const QStringRef substr = str.midRef(encoding.size() + 3);  // ex. skip over "gzip;q="
+    finishContent();
+}
 
-            bool ok = false;
-            const double qvalue = substr.toDouble(&ok);
-            if (!ok || (qvalue <= 0.0))
-                return false;
+void Connection::finishContent()
+{
+    disconnect(m_socket, &QTcpSocket::bytesWritten, this, &Connection::sendContent);
+    // we may be called from one of its signals
+    m_contentSource->deleteLater();
+    m_contentSource = nullptr;
+    m_socket->setReadBufferSize(0);
+    m_idleTimer.restart();
 
-            return true;
-        }
-        return false;
-    };
+    if (!m_receivedData.isEmpty() || (m_socket->bytesAvailable() > 0))
+        read();
+}
 
-    const QStringList list = codings.remove(' ').remove('\t').split(',', QString::SkipEmptyParts);
-    if (list.isEmpty())
+bool Connection::hasExpired(const qint64 timeout) const
+{
+    // event streams and streamed content stay open until the client goes away
+    if (m_eventStream || m_contentSource)
         return false;
 
-    const bool canGzip = isCodingAvailable(list, QLatin1String("gzip"));
-    if (canGzip)
-        return true;
-
-    const bool canAny = isCodingAvailable(list, QLatin1String("*"));
-    if (canAny)
-        return true;
+    return m_idleTimer.hasExpired(timeout);
+}
 
-    return false;
+bool Connection::isClosed() const
+{
+    return (m_socket->state() == QAbstractSocket::UnconnectedState);
 }
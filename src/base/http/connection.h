@@ -40,6 +40,8 @@ class QTcpSocket;
 
 namespace Http
 {
+    class ContentSource;
+    class EventStream;
     class IRequestHandler;
 
     class Connection : public QObject
@@ -56,15 +58,18 @@ namespace Http
 
     private slots:
         void read();
+        void sendContent();
 
     private:
-        static bool acceptsGzipEncoding(QString codings);
         void sendResponse(const Response &response) const;
+        void finishContent();
 
         QTcpSocket *m_socket;
         IRequestHandler *m_requestHandler;
         QByteArray m_receivedData;
         QElapsedTimer m_idleTimer;
+        EventStream *m_eventStream = nullptr;
+        ContentSource *m_contentSource = nullptr;
     };
 }
 
@@ -0,0 +1,64 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+
+namespace Http
+{
+    // Body of a response that is produced while it is being sent,
+    // e.g. a file that is still being downloaded.
+    // The connection sending the response takes ownership of it.
+    class ContentSource : public QObject
+    {
+        Q_OBJECT
+        Q_DISABLE_COPY(ContentSource)
+
+    public:
+        using QObject::QObject;
+
+        // Number of body bytes that weren't read yet
+        virtual qint64 bytesLeft() const = 0;
+        // Returns at most `maxSize` next bytes or an empty array
+        // if they aren't available yet, readyRead() tells when to try again
+        virtual QByteArray read(qint64 maxSize) = 0;
+
+        // Ends the response before its body is complete
+        void abort()
+        {
+            emit failed();
+        }
+
+    signals:
+        void readyRead();
+        // The rest of the body can't be produced, the connection is closed
+        void failed();
+    };
+}
@@ -0,0 +1,79 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "eventstream.h"
+
+#include <QTcpSocket>
+
+using namespace Http;
+
+EventStream::EventStream(QTcpSocket *socket, QObject *parent)
+    : QObject {parent}
+    , m_socket {socket}
+{
+    connect(m_socket, &QTcpSocket::bytesWritten, this, &EventStream::handleBytesWritten);
+}
+
+void EventStream::sendEvent(const QByteArray &data, const QByteArray &event, const qint64 id)
+{
+    // [html5] 9.2.5 Parsing an event stream
+    QByteArray buf;
+    buf.reserve(data.size() + 64);
+
+    if (id >= 0)
+        buf += "id: " + QByteArray::number(id) + '\n';
+    if (!event.isEmpty())
+        buf += "event: " + event + '\n';
+    for (const QByteArray &line : data.split('\n'))
+        buf += "data: " + line + '\n';
+    buf += '\n';
+
+    m_socket->write(buf);
+}
+
+void EventStream::sendHeartbeat()
+{
+    // comment lines are ignored by clients but keep proxies from closing the connection
+    m_socket->write(":\n\n");
+}
+
+void EventStream::close()
+{
+    m_socket->close();
+}
+
+qint64 EventStream::pendingBytes() const
+{
+    return m_socket->bytesToWrite();
+}
+
+void EventStream::handleBytesWritten()
+{
+    if (m_socket->bytesToWrite() == 0)
+        emit drained();
+}
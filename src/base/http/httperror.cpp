@@ -70,6 +70,11 @@ UnsupportedMediaTypeHTTPError::UnsupportedMediaTypeHTTPError(const QString &mess
 {
 }
 
+RangeNotSatisfiableHTTPError::RangeNotSatisfiableHTTPError(const QString &message)
+    : HTTPError(416, QLatin1String("Range Not Satisfiable"), message)
+{
+}
+
 UnauthorizedHTTPError::UnauthorizedHTTPError(const QString &message)
     : HTTPError(401, QLatin1String("Unauthorized"), message)
 {
@@ -79,3 +84,8 @@ InternalServerErrorHTTPError::InternalServerErrorHTTPError(const QString &messag
     : HTTPError(500, QLatin1String("Internal Server Error"), message)
 {
 }
+
+ServiceUnavailableHTTPError::ServiceUnavailableHTTPError(const QString &message)
+    : HTTPError(503, QLatin1String("Service Unavailable"), message)
+{
+}
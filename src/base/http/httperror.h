@@ -73,6 +73,12 @@ public:
     explicit UnsupportedMediaTypeHTTPError(const QString &message = "");
 };
 
+class RangeNotSatisfiableHTTPError : public HTTPError
+{
+public:
+    explicit RangeNotSatisfiableHTTPError(const QString &message = "");
+};
+
 class UnauthorizedHTTPError : public HTTPError
 {
 public:
@@ -84,3 +90,9 @@ class InternalServerErrorHTTPError : public HTTPError
 public:
     explicit InternalServerErrorHTTPError(const QString &message = "");
 };
+
+class ServiceUnavailableHTTPError : public HTTPError
+{
+public:
+    explicit ServiceUnavailableHTTPError(const QString &message = "");
+};
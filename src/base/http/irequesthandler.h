@@ -33,11 +33,16 @@
 
 namespace Http
 {
+    class EventStream;
+
     class IRequestHandler
     {
     public:
         virtual ~IRequestHandler() {}
         virtual Response processRequest(const Request &request, const Environment &env) = 0;
+        // Called right after processRequest() returned a "text/event-stream" response,
+        // the handler may keep `stream` to push events until it is destroyed
+        virtual void openEventStream(EventStream *stream) { Q_UNUSED(stream); }
     };
 }
 
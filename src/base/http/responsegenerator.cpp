@@ -32,12 +32,15 @@
 #include <QDateTime>
 
 #include "base/utils/gzip.h"
+#include "contentsource.h"
 
 QByteArray Http::toByteArray(Response response)
 {
-    compressContent(response);
-
-    response.headers[HEADER_CONTENT_LENGTH] = QString::number(response.content.length());
+    // an event stream has no length, its body lasts as long as the connection
+    if (response.headers.value(HEADER_CONTENT_TYPE) != QLatin1String(CONTENT_TYPE_EVENT_STREAM)) {
+        const qint64 streamedLength = (response.contentSource ? response.contentSource->bytesLeft() : 0);
+        response.headers[HEADER_CONTENT_LENGTH] = QString::number(response.content.length() + streamedLength);
+    }
     response.headers[HEADER_DATE] = httpDate();
 
     QByteArray buf;
@@ -75,11 +78,6 @@ QString Http::httpDate()
 
 void Http::compressContent(Response &response)
 {
-    if (response.headers.value(HEADER_CONTENT_ENCODING) != QLatin1String("gzip"))
-        return;
-
-    response.headers.remove(HEADER_CONTENT_ENCODING);
-
     // for very small files, compressing them only wastes cpu cycles
     const int contentSize = response.content.size();
     if (contentSize <= 1024)  // 1 kb
@@ -103,3 +101,45 @@ void Http::compressContent(Response &response)
     response.content = compressedData;
     response.headers[HEADER_CONTENT_ENCODING] = QLatin1String("gzip");
 }
+
+bool Http::acceptsGzipEncoding(QString codings)
+{
+    // [rfc7231] 5.3.4. Accept-Encoding
+
+    const auto isCodingAvailable = [](const QStringList &list, const QString &encoding) -> bool
+    {
+        for (const QString &str : list) {
+            if (!str.startsWith(encoding))
+                continue;
+
+            // without quality values
+            if (str == encoding)
+                return true;
+
+            // [rfc7231] 5.3.1. Quality Values
+            const QStringRef substr = str.midRef(encoding.size() + 3);  // ex. skip over "gzip;q="
+
+            bool ok = false;
+            const double qvalue = substr.toDouble(&ok);
+            if (!ok || (qvalue <= 0.0))
+                return false;
+
+            return true;
+        }
+        return false;
+    };
+
+    const QStringList list = codings.remove(' ').remove('\t').split(',', QString::SkipEmptyParts);
+    if (list.isEmpty())
+        return false;
+
+    const bool canGzip = isCodingAvailable(list, QLatin1String("gzip"));
+    if (canGzip)
+        return true;
+
+    const bool canAny = isCodingAvailable(list, QLatin1String("*"));
+    if (canAny)
+        return true;
+
+    return false;
+}
@@ -38,6 +38,7 @@ namespace Http
     QByteArray toByteArray(Response response);
     QString httpDate();
     void compressContent(Response &response);
+    bool acceptsGzipEncoding(QString codings);
 }
 
 #endif // HTTP_RESPONSEGENERATOR_H
@@ -38,22 +38,31 @@
 
 namespace Http
 {
+    class ContentSource;
+
     const char METHOD_GET[] = "GET";
     const char METHOD_POST[] = "POST";
 
+    const char HEADER_ACCEPT_ENCODING[] = "accept-encoding";
+    const char HEADER_ACCEPT_RANGES[] = "accept-ranges";
     const char HEADER_CACHE_CONTROL[] = "cache-control";
     const char HEADER_CONNECTION[] = "connection";
     const char HEADER_CONTENT_DISPOSITION[] = "content-disposition";
     const char HEADER_CONTENT_ENCODING[] = "content-encoding";
     const char HEADER_CONTENT_LENGTH[] = "content-length";
+    const char HEADER_CONTENT_RANGE[] = "content-range";
     const char HEADER_CONTENT_SECURITY_POLICY[] = "content-security-policy";
     const char HEADER_CONTENT_TYPE[] = "content-type";
     const char HEADER_DATE[] = "date";
+    const char HEADER_ETAG[] = "etag";
     const char HEADER_HOST[] = "host";
+    const char HEADER_IF_NONE_MATCH[] = "if-none-match";
     const char HEADER_ORIGIN[] = "origin";
+    const char HEADER_RANGE[] = "range";
     const char HEADER_REFERER[] = "referer";
     const char HEADER_REFERRER_POLICY[] = "referrer-policy";
     const char HEADER_SET_COOKIE[] = "set-cookie";
+    const char HEADER_VARY[] = "vary";
     const char HEADER_X_CONTENT_TYPE_OPTIONS[] = "x-content-type-options";
     const char HEADER_X_FORWARDED_HOST[] = "x-forwarded-host";
     const char HEADER_X_FRAME_OPTIONS[] = "x-frame-options";
@@ -68,10 +77,13 @@ namespace Http
     const char CONTENT_TYPE_TXT[] = "text/plain";
     const char CONTENT_TYPE_JS[] = "application/javascript";
     const char CONTENT_TYPE_JSON[] = "application/json";
+    const char CONTENT_TYPE_EVENT_STREAM[] = "text/event-stream";
+    const char CONTENT_TYPE_OPENMETRICS[] = "application/openmetrics-text; version=1.0.0; charset=utf-8";
     const char CONTENT_TYPE_GIF[] = "image/gif";
     const char CONTENT_TYPE_PNG[] = "image/png";
     const char CONTENT_TYPE_FORM_ENCODED[] = "application/x-www-form-urlencoded";
     const char CONTENT_TYPE_FORM_DATA[] = "multipart/form-data";
+    const char CONTENT_TYPE_OCTET_STREAM[] = "application/octet-stream";
 
     // portability: "\r\n" doesn't guarantee mapping to the correct symbol
     const char CRLF[] = {0x0D, 0x0A, '\0'};
@@ -116,6 +128,8 @@ namespace Http
         ResponseStatus status;
         QStringMap headers;
         QByteArray content;
+        // Rest of the body, sent after `content` as it becomes available
+        ContentSource *contentSource = nullptr;
 
         Response(uint code = 200, const QString &text = "OK"): status(code, text) {}
     };
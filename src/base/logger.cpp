@@ -1,8 +1,20 @@
 #include "logger.h"
 
+#include <algorithm>
+#include <limits>
+
 #include <QDateTime>
+#include "base/global.h"
 #include "base/utils/string.h"
 
+namespace
+{
+    const int PEER_SUMMARY_INTERVAL = 60 * 1000; // ms
+    const int MAX_PEER_SUMMARIES = 100; // per interval
+    const int MAX_PEER_COUNTERS = 65536;
+    const qint64 PEER_COUNTER_EXPIRATION = 60 * 60 * 1000; // ms
+}
+
 Logger *Logger::m_instance = nullptr;
 
 Logger::Logger()
@@ -10,6 +22,8 @@ Logger::Logger()
     , m_msgCounter(0)
     , m_peerCounter(0)
 {
+    connect(&m_peerSummaryTimer, &QTimer::timeout, this, &Logger::summarizePeers);
+    m_peerSummaryTimer.start(PEER_SUMMARY_INTERVAL);
 }
 
 Logger::~Logger() {}
@@ -46,17 +60,96 @@ void Logger::addMessage(const QString &message, const Log::MsgType &type)
     emit newLogMessage(temp);
 }
 
-void Logger::addPeer(const QString &ip, bool blocked, const QString &reason)
+void Logger::addPeer(const QString &ip, bool blocked, const int reason, const PeerReasonDescriber describeReason)
 {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
     QWriteLocker locker(&m_lock);
 
-    Log::Peer temp = {m_peerCounter++, QDateTime::currentMSecsSinceEpoch(), ip.toHtmlEscaped(), blocked, reason.toHtmlEscaped()};
+    const QPair<QString, int> key {ip, reason};
+    const auto it = m_peerCounters.find(key);
+    if (it != m_peerCounters.end()) {
+        ++it->stats.count;
+        it->stats.lastSeen = now;
+        return;
+    }
+
+    if (m_peerCounters.size() >= MAX_PEER_COUNTERS) {
+        ++m_untrackedPeerAttempts;
+        return;
+    }
+
+    const QString reasonText = describeReason ? describeReason(reason) : QString();
+    m_peerCounters.insert(key, {{ip, blocked, reasonText, 1, now, now}, 1});
+    const Log::Peer peer = appendPeer(ip, blocked, reasonText, 1, now);
+    locker.unlock();
+
+    emit newLogPeer(peer);
+}
+
+// The caller emits newLogPeer() once the lock is released
+Log::Peer Logger::appendPeer(const QString &ip, bool blocked, const QString &reason, int count, qint64 timestamp)
+{
+    Log::Peer temp = {m_peerCounter++, timestamp, ip.toHtmlEscaped(), blocked, reason.toHtmlEscaped(), count};
     m_peers.push_back(temp);
 
     if (m_peers.size() >= MAX_LOG_MESSAGES)
         m_peers.pop_front();
 
-    emit newLogPeer(temp);
+    return temp;
+}
+
+void Logger::summarizePeers()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QWriteLocker locker(&m_lock);
+
+    QVector<PeerCounter *> pending;
+    for (auto it = m_peerCounters.begin(); it != m_peerCounters.end();) {
+        if (it->stats.count > it->reportedCount) {
+            pending.append(&it.value());
+            ++it;
+        }
+        else if ((now - it->stats.lastSeen) > PEER_COUNTER_EXPIRATION) {
+            it = m_peerCounters.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    // Only the busiest sources make it into the log, the rest is summed up
+    const auto newAttempts = [](const PeerCounter *counter) { return (counter->stats.count - counter->reportedCount); };
+    const int summaryCount = std::min(pending.size(), MAX_PEER_SUMMARIES);
+    std::partial_sort(pending.begin(), (pending.begin() + summaryCount), pending.end()
+        , [&newAttempts](const PeerCounter *left, const PeerCounter *right)
+    {
+        return (newAttempts(left) > newAttempts(right));
+    });
+
+    QVector<Log::Peer> summaries;
+    summaries.reserve(summaryCount);
+    qint64 foldedAttempts = m_untrackedPeerAttempts;
+    for (int i = 0; i < pending.size(); ++i) {
+        PeerCounter *const counter = pending[i];
+        if (i < summaryCount) {
+            const Log::PeerStats &stats = counter->stats;
+            summaries.append(appendPeer(stats.ip, stats.blocked, stats.reason
+                , static_cast<int>(std::min<qint64>(newAttempts(counter), std::numeric_limits<int>::max())), stats.lastSeen));
+        }
+        else {
+            foldedAttempts += newAttempts(counter);
+        }
+        counter->reportedCount = counter->stats.count;
+    }
+    m_untrackedPeerAttempts = 0;
+
+    // addMessage() takes the lock again
+    locker.unlock();
+
+    for (const Log::Peer &peer : asConst(summaries))
+        emit newLogPeer(peer);
+    if (foldedAttempts > 0)
+        addMessage(tr("%1 more connection attempts were blocked from other sources.").arg(foldedAttempts));
 }
 
 QVector<Log::Msg> Logger::getMessages(int lastKnownId) const
@@ -75,6 +168,57 @@ QVector<Log::Msg> Logger::getMessages(int lastKnownId) const
     return m_messages.mid(size - diff);
 }
 
+MemoryUsage::Usage Logger::messagesMemoryUsage() const
+{
+    QReadLocker locker(&m_lock);
+
+    MemoryUsage::Usage usage;
+    usage.items = m_messages.size();
+    usage.bytes = m_messages.capacity() * sizeof(Log::Msg);
+    for (const Log::Msg &msg : m_messages)
+        usage.bytes += MemoryUsage::ofStringData(msg.message);
+
+    return usage;
+}
+
+MemoryUsage::Usage Logger::peersMemoryUsage() const
+{
+    QReadLocker locker(&m_lock);
+
+    MemoryUsage::Usage usage;
+    usage.items = m_peers.size() + m_peerCounters.size();
+    usage.bytes = m_peers.capacity() * sizeof(Log::Peer);
+    for (const Log::Peer &peer : m_peers)
+        usage.bytes += MemoryUsage::ofStringData(peer.ip) + MemoryUsage::ofStringData(peer.reason);
+    for (auto it = m_peerCounters.cbegin(); it != m_peerCounters.cend(); ++it) {
+        // the stats share the IP string with the key
+        usage.bytes += MemoryUsage::ofHashNode<QPair<QString, int>, PeerCounter>()
+                + MemoryUsage::ofStringData(it.key().first) + MemoryUsage::ofStringData(it->stats.reason);
+    }
+
+    return usage;
+}
+
+QVector<Log::PeerStats> Logger::topPeers(const int limit) const
+{
+    QReadLocker locker(&m_lock);
+
+    QVector<Log::PeerStats> peers;
+    peers.reserve(m_peerCounters.size());
+    for (const PeerCounter &counter : m_peerCounters)
+        peers.append(counter.stats);
+
+    const int count = std::min(std::max(limit, 0), peers.size());
+    std::partial_sort(peers.begin(), (peers.begin() + count), peers.end()
+        , [](const Log::PeerStats &left, const Log::PeerStats &right)
+    {
+        return (left.count > right.count);
+    });
+    peers.resize(count);
+
+    return peers;
+}
+
 QVector<Log::Peer> Logger::getPeers(int lastKnownId) const
 {
     QReadLocker locker(&m_lock);
@@ -1,11 +1,16 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <QHash>
 #include <QObject>
+#include <QPair>
 #include <QReadWriteLock>
 #include <QString>
+#include <QTimer>
 #include <QVector>
 
+#include "memoryusage.h"
+
 const int MAX_LOG_MESSAGES = 20000;
 
 namespace Log
@@ -35,6 +40,18 @@ namespace Log
         QString ip;
         bool blocked;
         QString reason;
+        int count; // connection attempts summarized by this entry
+    };
+
+    // All attempts of a peer blocked (or banned) for the same reason
+    struct PeerStats
+    {
+        QString ip;
+        bool blocked;
+        QString reason;
+        qint64 count;
+        qint64 firstSeen;
+        qint64 lastSeen;
     };
 }
 
@@ -50,22 +67,46 @@ public:
     static void freeInstance();
     static Logger *instance();
 
+    // Gives the text of a reason code, only called for the first attempt of a source
+    typedef QString (*PeerReasonDescriber)(int reason);
+
     void addMessage(const QString &message, const Log::MsgType &type = Log::NORMAL);
-    void addPeer(const QString &ip, bool blocked, const QString &reason = QString());
+    // Peers are aggregated per IP and reason: the first attempt is logged at once,
+    // the following ones are summarized periodically
+    void addPeer(const QString &ip, bool blocked, int reason = -1, PeerReasonDescriber describeReason = nullptr);
     QVector<Log::Msg> getMessages(int lastKnownId = -1) const;
     QVector<Log::Peer> getPeers(int lastKnownId = -1) const;
+    // Sources with the most attempts first
+    QVector<Log::PeerStats> topPeers(int limit) const;
+
+    MemoryUsage::Usage messagesMemoryUsage() const;
+    MemoryUsage::Usage peersMemoryUsage() const;
 
 signals:
     void newLogMessage(const Log::Msg &message);
     void newLogPeer(const Log::Peer &peer);
 
+private slots:
+    void summarizePeers();
+
 private:
     Logger();
     ~Logger();
 
+    struct PeerCounter
+    {
+        Log::PeerStats stats;
+        qint64 reportedCount;
+    };
+
+    Log::Peer appendPeer(const QString &ip, bool blocked, const QString &reason, int count, qint64 timestamp);
+
     static Logger *m_instance;
     QVector<Log::Msg> m_messages;
     QVector<Log::Peer> m_peers;
+    QHash<QPair<QString, int>, PeerCounter> m_peerCounters;
+    qint64 m_untrackedPeerAttempts = 0;
+    QTimer m_peerSummaryTimer;
     mutable QReadWriteLock m_lock;
     int m_msgCounter;
     int m_peerCounter;
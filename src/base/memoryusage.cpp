@@ -0,0 +1,95 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "memoryusage.h"
+
+#include "base/bittorrent/session.h"
+#include "base/bittorrent/torrenthandle.h"
+#include "base/global.h"
+#include "base/logger.h"
+#include "base/rss/rss_article.h"
+#include "base/rss/rss_folder.h"
+#include "base/rss/rss_session.h"
+#include "base/stringpool.h"
+
+namespace
+{
+    qint64 articleMemoryUsage(const RSS::Article *article)
+    {
+        // the fields share their data with the raw article hash
+        qint64 usage = sizeof(RSS::Article)
+                + MemoryUsage::ofStringData(article->guid())
+                + MemoryUsage::ofStringData(article->title())
+                + MemoryUsage::ofStringData(article->author())
+                + MemoryUsage::ofStringData(article->description())
+                + MemoryUsage::ofStringData(article->torrentUrl())
+                + MemoryUsage::ofStringData(article->link());
+
+        usage += article->data().size() * MemoryUsage::ofHashNode<QString, QVariant>();
+        return usage;
+    }
+}
+
+QMap<QString, MemoryUsage::Usage> MemoryUsage::collect()
+{
+    QMap<QString, Usage> result;
+
+    if (BitTorrent::Session::instance()) {
+        Usage &torrents = result[QLatin1String("torrents")];
+        Usage &trackers = result[QLatin1String("trackers")];
+        for (const BitTorrent::TorrentHandle *torrent : asConst(BitTorrent::Session::instance()->torrents())) {
+            ++torrents.items;
+            torrents.bytes += torrent->memoryUsage();
+
+            // tracker URLs are interned, so they are accounted by the string pool
+            const QHash<QString, BitTorrent::TrackerInfo> trackerInfos = torrent->trackerInfos();
+            trackers.items += trackerInfos.size();
+            for (const BitTorrent::TrackerInfo &info : trackerInfos)
+                trackers.bytes += ofHashNode<QString, BitTorrent::TrackerInfo>() + ofStringData(info.lastMessage);
+        }
+    }
+
+    if (Logger::instance()) {
+        result[QLatin1String("logs")] = Logger::instance()->messagesMemoryUsage();
+        result[QLatin1String("peers")] = Logger::instance()->peersMemoryUsage();
+    }
+
+    if (RSS::Session::instance()) {
+        Usage &rss = result[QLatin1String("rss")];
+        for (const RSS::Article *article : asConst(RSS::Session::instance()->rootFolder()->articles())) {
+            ++rss.items;
+            rss.bytes += articleMemoryUsage(article);
+        }
+    }
+
+    Usage &strings = result[QLatin1String("strings")];
+    strings.items = StringPool::size();
+    strings.bytes = StringPool::memoryUsage();
+
+    return result;
+}
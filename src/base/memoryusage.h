@@ -0,0 +1,67 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QMap>
+#include <QString>
+
+// Rough per-subsystem accounting of the heap used by our own data structures.
+// Allocator overhead and the memory owned by libtorrent are not included,
+// the numbers are meant for comparing subsystems and builds.
+namespace MemoryUsage
+{
+    struct Usage
+    {
+        qint64 bytes = 0;
+        int items = 0;
+    };
+
+    // Keyed by subsystem: torrents, trackers, peers, logs, rss, strings
+    QMap<QString, Usage> collect();
+
+    // Heap block of a string, shared empty strings take none
+    inline qint64 ofStringData(const QString &str)
+    {
+        if (str.isEmpty()) return 0;
+        return static_cast<qint64>(sizeof(QArrayData) + ((str.capacity() + 1) * sizeof(QChar)));
+    }
+
+    inline qint64 ofString(const QString &str)
+    {
+        return static_cast<qint64>(sizeof(QString)) + ofStringData(str);
+    }
+
+    // Hash node together with its bucket slot
+    template <typename Key, typename T = QHashDummyValue>
+    qint64 ofHashNode()
+    {
+        return static_cast<qint64>(sizeof(QHashNode<Key, T>) + sizeof(void *));
+    }
+}
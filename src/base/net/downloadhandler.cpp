@@ -66,6 +66,7 @@ Net::DownloadHandler::DownloadHandler(QNetworkReply *reply, DownloadManager *man
     , m_manager(manager)
     , m_downloadRequest(downloadRequest)
 {
+    m_elapsedTimer.start();
     if (reply)
         assignNetworkReply(reply);
 }
@@ -176,29 +177,34 @@ void Net::DownloadHandler::handleRedirection(QUrl newUrl)
         this->deleteLater();
     }
     else {
-        DownloadHandler *redirected = m_manager->download(DownloadRequest(m_downloadRequest).url(newUrlString));
-        connect(redirected, &DownloadHandler::destroyed, this, &DownloadHandler::deleteLater);
-        connect(redirected, &DownloadHandler::downloadFailed, this, [this](const QString &, const QString &reason)
-        {
-            emit downloadFailed(url(), reason);
-        });
-        connect(redirected, &DownloadHandler::redirectedToMagnet, this, [this](const QString &, const QString &magnetUri)
-        {
-            emit redirectedToMagnet(url(), magnetUri);
-        });
-        connect(redirected, static_cast<void (DownloadHandler::*)(const QString &, const QString &)>(&DownloadHandler::downloadFinished)
-                , this, [this](const QString &, const QString &fileName)
-        {
-            emit downloadFinished(url(), fileName);
-        });
-        connect(redirected, static_cast<void (DownloadHandler::*)(const QString &, const QByteArray &)>(&DownloadHandler::downloadFinished)
-                , this, [this](const QString &, const QByteArray &data)
-        {
-            emit downloadFinished(url(), data);
-        });
+        follow(m_manager->download(DownloadRequest(m_downloadRequest).url(newUrlString)));
     }
 }
 
+// Reports the outcome of another download as our own
+void Net::DownloadHandler::follow(DownloadHandler *leader)
+{
+    connect(leader, &DownloadHandler::destroyed, this, &DownloadHandler::deleteLater);
+    connect(leader, &DownloadHandler::downloadFailed, this, [this](const QString &, const QString &reason)
+    {
+        emit downloadFailed(url(), reason);
+    });
+    connect(leader, &DownloadHandler::redirectedToMagnet, this, [this](const QString &, const QString &magnetUri)
+    {
+        emit redirectedToMagnet(url(), magnetUri);
+    });
+    connect(leader, static_cast<void (DownloadHandler::*)(const QString &, const QString &)>(&DownloadHandler::downloadFinished)
+            , this, [this](const QString &, const QString &fileName)
+    {
+        emit downloadFinished(url(), fileName);
+    });
+    connect(leader, static_cast<void (DownloadHandler::*)(const QString &, const QByteArray &)>(&DownloadHandler::downloadFinished)
+            , this, [this](const QString &, const QByteArray &data)
+    {
+        emit downloadFinished(url(), data);
+    });
+}
+
 QString Net::DownloadHandler::errorCodeToString(const QNetworkReply::NetworkError status)
 {
     switch (status) {
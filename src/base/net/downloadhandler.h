@@ -30,6 +30,7 @@
 #ifndef NET_DOWNLOADHANDLER_H
 #define NET_DOWNLOADHANDLER_H
 
+#include <QElapsedTimer>
 #include <QNetworkReply>
 #include <QObject>
 
@@ -67,6 +68,7 @@ namespace Net
 
     private:
         void assignNetworkReply(QNetworkReply *reply);
+        void follow(DownloadHandler *leader);
         void handleRedirection(QUrl newUrl);
 
         static QString errorCodeToString(QNetworkReply::NetworkError status);
@@ -74,6 +76,7 @@ namespace Net
         QNetworkReply *m_reply;
         DownloadManager *m_manager;
         const DownloadRequest m_downloadRequest;
+        QElapsedTimer m_elapsedTimer;
     };
 }
 
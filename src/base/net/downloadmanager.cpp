@@ -29,18 +29,24 @@
 
 #include "downloadmanager.h"
 
+#include <algorithm>
+
 #include <QDateTime>
 #include <QDebug>
+#include <QDir>
 #include <QNetworkCookie>
 #include <QNetworkCookieJar>
+#include <QNetworkDiskCache>
 #include <QNetworkProxy>
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QSslError>
+#include <QTimer>
 #include <QUrl>
 
 #include "base/global.h"
 #include "base/preferences.h"
+#include "base/profile.h"
 #include "downloadhandler.h"
 #include "proxyconfigurationmanager.h"
 
@@ -119,8 +125,24 @@ namespace
         // Accept gzip
         request.setRawHeader("Accept-Encoding", "gzip");
 
+        // Credentials (e.g. the passkey of private trackers) are often passed in the URL,
+        // such replies must not be kept in the disk cache
+        const QUrl url = request.url();
+        if (url.hasQuery() || !url.userInfo().isEmpty()) {
+            request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+            request.setAttribute(QNetworkRequest::CacheSaveControlAttribute, false);
+        }
+
         return request;
     }
+
+    // Requests with the same key would get the same result
+    QString downloadKey(const Net::DownloadRequest &downloadRequest)
+    {
+        return downloadRequest.url() + QLatin1Char('\n') + downloadRequest.userAgent()
+            + QLatin1Char('\n') + QString::number(downloadRequest.limit())
+            + QLatin1Char('\n') + QString::number(downloadRequest.handleRedirectToMagnet());
+    }
 }
 
 Net::DownloadManager *Net::DownloadManager::m_instance = nullptr;
@@ -131,11 +153,12 @@ Net::DownloadManager::DownloadManager(QObject *parent)
 #ifndef QT_NO_OPENSSL
     connect(&m_networkManager, &QNetworkAccessManager::sslErrors, this, &Net::DownloadManager::ignoreSslErrors);
 #endif
-    connect(&m_networkManager, &QNetworkAccessManager::finished, this, &DownloadManager::handleReplyFinished);
     connect(ProxyConfigurationManager::instance(), &ProxyConfigurationManager::proxyConfigurationChanged
             , this, &DownloadManager::applyProxySettings);
+    connect(Preferences::instance(), &Preferences::changed, this, &DownloadManager::configure);
     m_networkManager.setCookieJar(new NetworkCookieJar(this));
     applyProxySettings();
+    configure();
 }
 
 void Net::DownloadManager::initInstance()
@@ -160,29 +183,54 @@ Net::DownloadManager *Net::DownloadManager::instance()
 Net::DownloadHandler *Net::DownloadManager::download(const DownloadRequest &downloadRequest)
 {
     // Process download request
-    const QNetworkRequest request = createNetworkRequest(downloadRequest);
-    const ServiceID id = ServiceID::fromURL(request.url());
-    const bool isSequentialService = m_sequentialServices.contains(id);
-    if (!isSequentialService || !m_busyServices.contains(id)) {
-        qDebug("Downloading %s...", qUtf8Printable(downloadRequest.url()));
-        if (isSequentialService)
-            m_busyServices.insert(id);
-        return new DownloadHandler {
-            m_networkManager.get(request), this, downloadRequest};
+    const ServiceID id = ServiceID::fromURL(QUrl(downloadRequest.url()));
+    Service &service = m_services[id];
+    ++service.statistics.requestCount;
+
+    // Identical requests share the reply of the one in flight.
+    // Files saved to disk belong to (and may be removed by) each requester, so those aren't shared.
+    const QString key = downloadKey(downloadRequest);
+    if (!downloadRequest.saveToFile()) {
+        DownloadHandler *activeHandler = m_activeDownloads.value(key);
+        if (activeHandler) {
+            qDebug("Joining download of %s...", qUtf8Printable(downloadRequest.url()));
+            ++service.statistics.coalescedCount;
+            auto *downloadHandler = new DownloadHandler {nullptr, this, downloadRequest};
+            downloadHandler->follow(activeHandler);
+            return downloadHandler;
+        }
     }
 
     auto *downloadHandler = new DownloadHandler {nullptr, this, downloadRequest};
-    connect(downloadHandler, &DownloadHandler::destroyed, this, [this, id, downloadHandler]()
+    if (!downloadRequest.saveToFile())
+        m_activeDownloads.insert(key, downloadHandler);
+    connect(downloadHandler, &DownloadHandler::destroyed, this, [this, id, key, downloadHandler]()
     {
-        m_waitingJobs[id].removeOne(downloadHandler);
+        m_services[id].waitingJobs.removeOne(downloadHandler);
+        if (m_activeDownloads.value(key) == downloadHandler)
+            m_activeDownloads.remove(key);
     });
-    m_waitingJobs[id].enqueue(downloadHandler);
+
+    service.waitingJobs.enqueue(downloadHandler);
+    processWaitingJobs(id);
     return downloadHandler;
 }
 
 void Net::DownloadManager::registerSequentialService(const Net::ServiceID &serviceID)
 {
-    m_sequentialServices.insert(serviceID);
+    m_services[serviceID].maxConnections = 1;
+}
+
+QHash<Net::ServiceID, Net::ServiceStatistics> Net::DownloadManager::serviceStatistics() const
+{
+    QHash<ServiceID, ServiceStatistics> result;
+    for (auto it = m_services.cbegin(); it != m_services.cend(); ++it) {
+        ServiceStatistics statistics = it->statistics;
+        statistics.queuedCount = it->waitingJobs.size();
+        result[it.key()] = statistics;
+    }
+
+    return result;
 }
 
 QList<QNetworkCookie> Net::DownloadManager::cookiesForUrl(const QUrl &url) const
@@ -243,19 +291,88 @@ void Net::DownloadManager::applyProxySettings()
     m_networkManager.setProxy(proxy);
 }
 
-void Net::DownloadManager::handleReplyFinished(QNetworkReply *reply)
+void Net::DownloadManager::configure()
+{
+    const Preferences *const pref = Preferences::instance();
+    m_maxConnectionsPerHost = std::max(1, pref->getMaxConnectionsPerHost());
+    m_minRequestIntervalPerHost = std::max(0, pref->getMinRequestIntervalPerHost());
+
+    // QNetworkAccessManager does the HTTP caching (Cache-Control, ETag, Last-Modified) once it has a cache
+    const qint64 cacheSize = pref->getHttpCacheSize() * 1024LL * 1024LL;
+    if (cacheSize > 0) {
+        if (!m_diskCache) {
+            m_diskCache = new QNetworkDiskCache;
+            m_diskCache->setCacheDirectory(QDir::cleanPath(specialFolderLocation(SpecialFolder::Cache) + QLatin1String("/http")));
+            m_networkManager.setCache(m_diskCache); // takes ownership
+        }
+        m_diskCache->setMaximumCacheSize(cacheSize);
+    }
+    else if (m_diskCache) {
+        m_diskCache->clear();
+        m_networkManager.setCache(nullptr); // deletes the old cache
+        m_diskCache = nullptr;
+    }
+
+    for (auto it = m_services.cbegin(); it != m_services.cend(); ++it)
+        processWaitingJobs(it.key());
+}
+
+void Net::DownloadManager::processWaitingJobs(const ServiceID &serviceID)
 {
-    const ServiceID id = ServiceID::fromURL(reply->request().url());
-    auto waitingJobsIter = m_waitingJobs.find(id);
-    if ((waitingJobsIter == m_waitingJobs.end()) || waitingJobsIter.value().isEmpty()) {
-        m_busyServices.remove(id);
-        return;
+    Service &service = m_services[serviceID];
+    const int maxConnections = (service.maxConnections > 0) ? service.maxConnections : m_maxConnectionsPerHost;
+    const int minRequestInterval = m_minRequestIntervalPerHost;
+
+    while (!service.waitingJobs.isEmpty() && (service.statistics.activeCount < maxConnections)) {
+        if ((minRequestInterval > 0) && service.lastRequestTimer.isValid()) {
+            const qint64 timeLeft = minRequestInterval - service.lastRequestTimer.elapsed();
+            if (timeLeft > 0) {
+                if (!service.isProcessingDeferred) {
+                    service.isProcessingDeferred = true;
+                    QTimer::singleShot(timeLeft, this, [this, serviceID]()
+                    {
+                        m_services[serviceID].isProcessingDeferred = false;
+                        processWaitingJobs(serviceID);
+                    });
+                }
+                return;
+            }
+        }
+
+        startDownload(serviceID, service.waitingJobs.dequeue());
     }
+}
+
+void Net::DownloadManager::startDownload(const ServiceID &serviceID, DownloadHandler *handler)
+{
+    Service &service = m_services[serviceID];
+    ++service.statistics.activeCount;
+    service.statistics.totalQueueTime += handler->m_elapsedTimer.restart();
+    service.lastRequestTimer.start();
 
-    DownloadHandler *handler = waitingJobsIter.value().dequeue();
     qDebug("Downloading %s...", qUtf8Printable(handler->m_downloadRequest.url()));
-    handler->assignNetworkReply(m_networkManager.get(createNetworkRequest(handler->m_downloadRequest)));
-    handler->disconnect(this);
+    QNetworkReply *reply = m_networkManager.get(createNetworkRequest(handler->m_downloadRequest));
+    connect(reply, &QNetworkReply::finished, this, [this, serviceID, handler, reply]()
+    {
+        ServiceStatistics &statistics = m_services[serviceID].statistics;
+        statistics.totalLatency += handler->m_elapsedTimer.elapsed();
+        if (reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool())
+            ++statistics.cacheHitCount;
+        if (reply->error() != QNetworkReply::NoError)
+            ++statistics.failedCount;
+
+        // too late to join it, the result is about to be delivered
+        const QString key = downloadKey(handler->m_downloadRequest);
+        if (m_activeDownloads.value(key) == handler)
+            m_activeDownloads.remove(key);
+    });
+    // The reply lives until its handler is done with it, whether finished or aborted
+    connect(reply, &QObject::destroyed, this, [this, serviceID]()
+    {
+        --m_services[serviceID].statistics.activeCount;
+        processWaitingJobs(serviceID);
+    });
+    handler->assignNetworkReply(reply);
 }
 
 #ifndef QT_NO_OPENSSL
@@ -30,15 +30,16 @@
 #ifndef NET_DOWNLOADMANAGER_H
 #define NET_DOWNLOADMANAGER_H
 
+#include <QElapsedTimer>
 #include <QHash>
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
 #include <QObject>
 #include <QQueue>
-#include <QSet>
 
-class QNetworkReply;
 class QNetworkCookie;
+class QNetworkDiskCache;
+class QNetworkReply;
 class QSslError;
 class QUrl;
 
@@ -83,11 +84,25 @@ namespace Net
         static ServiceID fromURL(const QUrl &url);
     };
 
+    struct ServiceStatistics
+    {
+        int activeCount = 0;
+        int queuedCount = 0;
+        qint64 requestCount = 0;
+        qint64 coalescedCount = 0; // requests served by an identical one in flight
+        qint64 cacheHitCount = 0;
+        qint64 failedCount = 0;
+        qint64 totalQueueTime = 0; // ms
+        qint64 totalLatency = 0; // ms, from the start of the request to its reply
+    };
+
     class DownloadManager : public QObject
     {
         Q_OBJECT
         Q_DISABLE_COPY(DownloadManager)
 
+        friend class DownloadHandler;
+
     public:
         static void initInstance();
         static void freeInstance();
@@ -97,6 +112,8 @@ namespace Net
 
         void registerSequentialService(const ServiceID &serviceID);
 
+        QHash<ServiceID, ServiceStatistics> serviceStatistics() const;
+
         QList<QNetworkCookie> cookiesForUrl(const QUrl &url) const;
         bool setCookiesFromUrl(const QList<QNetworkCookie> &cookieList, const QUrl &url);
         QList<QNetworkCookie> allCookies() const;
@@ -109,17 +126,30 @@ namespace Net
     #endif
 
     private:
+        struct Service
+        {
+            int maxConnections = 0; // 0 means the default
+            QQueue<DownloadHandler *> waitingJobs;
+            QElapsedTimer lastRequestTimer;
+            bool isProcessingDeferred = false;
+            ServiceStatistics statistics;
+        };
+
         explicit DownloadManager(QObject *parent = nullptr);
 
+        void configure();
         void applyProxySettings();
-        void handleReplyFinished(QNetworkReply *reply);
+        void processWaitingJobs(const ServiceID &serviceID);
+        void startDownload(const ServiceID &serviceID, DownloadHandler *handler);
 
         static DownloadManager *m_instance;
         QNetworkAccessManager m_networkManager;
+        QNetworkDiskCache *m_diskCache = nullptr;
 
-        QSet<ServiceID> m_sequentialServices;
-        QSet<ServiceID> m_busyServices;
-        QHash<ServiceID, QQueue<DownloadHandler *>> m_waitingJobs;
+        int m_maxConnectionsPerHost;
+        int m_minRequestIntervalPerHost;
+        QHash<ServiceID, Service> m_services;
+        QHash<QString, DownloadHandler *> m_activeDownloads;
     };
 
     uint qHash(const ServiceID &serviceID, uint seed);
@@ -1483,6 +1483,36 @@ void Preferences::setNetworkCookies(const QList<QNetworkCookie> &cookies)
     setValue("Network/Cookies", rawCookies);
 }
 
+int Preferences::getMaxConnectionsPerHost() const
+{
+    return value("Network/MaxConnectionsPerHost", 6).toInt();
+}
+
+void Preferences::setMaxConnectionsPerHost(const int count)
+{
+    setValue("Network/MaxConnectionsPerHost", count);
+}
+
+int Preferences::getMinRequestIntervalPerHost() const
+{
+    return value("Network/MinRequestIntervalPerHost", 0).toInt();
+}
+
+void Preferences::setMinRequestIntervalPerHost(const int milliseconds)
+{
+    setValue("Network/MinRequestIntervalPerHost", milliseconds);
+}
+
+int Preferences::getHttpCacheSize() const
+{
+    return value("Network/HttpCacheSize", 50).toInt();
+}
+
+void Preferences::setHttpCacheSize(const int sizeInMiB)
+{
+    setValue("Network/HttpCacheSize", sizeInMiB);
+}
+
 bool Preferences::isSpeedWidgetEnabled() const
 {
     return value("SpeedWidget/Enabled", true).toBool();
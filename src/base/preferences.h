@@ -379,6 +379,12 @@ public:
     // Network
     QList<QNetworkCookie> getNetworkCookies() const;
     void setNetworkCookies(const QList<QNetworkCookie> &cookies);
+    int getMaxConnectionsPerHost() const;
+    void setMaxConnectionsPerHost(int count);
+    int getMinRequestIntervalPerHost() const;
+    void setMinRequestIntervalPerHost(int milliseconds);
+    int getHttpCacheSize() const;
+    void setHttpCacheSize(int sizeInMiB);
 
     // SpeedWidget
     bool isSpeedWidgetEnabled() const;
@@ -0,0 +1,240 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "tracer.h"
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonObject>
+
+namespace
+{
+    const int MAX_TRACE_EVENTS = 65536;
+    const int LAG_PROBE_INTERVAL = 50; // ms
+    const qint64 MIN_REPORTED_LAG = 1000000; // ns
+
+    const char CATEGORY_EVENTLOOP[] = "eventloop";
+    const char NAME_EVENTLOOP_LAG[] = "lag";
+
+    int bucketIndex(qint64 durationUs)
+    {
+        int index = 0;
+        while ((durationUs > 0) && (index < (Tracer::HISTOGRAM_BUCKETS - 1))) {
+            durationUs >>= 1;
+            ++index;
+        }
+        return index;
+    }
+}
+
+Tracer *Tracer::m_instance = nullptr;
+bool Tracer::m_enabled = false;
+
+qint64 Tracer::Histogram::percentile(const int percent) const
+{
+    if (count == 0) return 0;
+
+    // reports the upper bound of the bucket the sample falls in
+    const qint64 rank = (count * percent + 99) / 100;
+    qint64 seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank)
+            return std::min((qint64(1) << i), maxUs);
+    }
+    return maxUs;
+}
+
+Tracer::Tracer()
+{
+    m_clock.start();
+
+    m_lagProbeTimer.setTimerType(Qt::PreciseTimer);
+    m_lagProbeTimer.setInterval(LAG_PROBE_INTERVAL);
+    connect(&m_lagProbeTimer, &QTimer::timeout, this, &Tracer::probeEventLoop);
+}
+
+void Tracer::initInstance()
+{
+    if (!m_instance)
+        m_instance = new Tracer;
+}
+
+void Tracer::freeInstance()
+{
+    if (m_instance) {
+        m_enabled = false;
+        delete m_instance;
+        m_instance = nullptr;
+    }
+}
+
+Tracer *Tracer::instance()
+{
+    return m_instance;
+}
+
+void Tracer::setEnabled(const bool enabled)
+{
+    if (m_enabled == enabled) return;
+
+    m_enabled = enabled;
+    if (enabled) {
+        m_events.reserve(MAX_TRACE_EVENTS);
+        m_lastProbeNs = m_clock.nsecsElapsed();
+        m_lagProbeTimer.start();
+    }
+    else {
+        m_lagProbeTimer.stop();
+    }
+}
+
+void Tracer::reset()
+{
+    m_histograms.clear();
+    m_events.clear();
+    m_nextEvent = 0;
+}
+
+QByteArray Tracer::traceName(const char *name)
+{
+    return QByteArray::fromRawData(name, static_cast<int>(qstrlen(name)));
+}
+
+QByteArray Tracer::traceName(const QString &name)
+{
+    return name.toLatin1();
+}
+
+void Tracer::record(const char *category, const QByteArray &name, const qint64 startNs)
+{
+    // tracing may have been switched off while the scope was open
+    if (!m_enabled) return;
+
+    const qint64 durationNs = m_clock.nsecsElapsed() - startNs;
+    addSample(category, name, durationNs / 1000);
+    appendEvent({category, name, startNs, durationNs});
+}
+
+void Tracer::addSample(const char *category, const QByteArray &name, const qint64 durationUs)
+{
+    Histogram &histogram = m_histograms[traceName(category)][name];
+    ++histogram.count;
+    histogram.totalUs += durationUs;
+    histogram.maxUs = std::max(histogram.maxUs, durationUs);
+    ++histogram.buckets[bucketIndex(durationUs)];
+}
+
+void Tracer::appendEvent(const Event &event)
+{
+    if (m_events.size() < MAX_TRACE_EVENTS) {
+        m_events.append(event);
+    }
+    else {
+        m_events[m_nextEvent] = event;
+        m_nextEvent = (m_nextEvent + 1) % MAX_TRACE_EVENTS;
+    }
+}
+
+void Tracer::probeEventLoop()
+{
+    // the timer fires late by as much as the event loop was blocked
+    const qint64 now = m_clock.nsecsElapsed();
+    const qint64 lagNs = std::max<qint64>(0, (now - m_lastProbeNs) - (LAG_PROBE_INTERVAL * 1000000LL));
+    m_lastProbeNs = now;
+
+    addSample(CATEGORY_EVENTLOOP, traceName(NAME_EVENTLOOP_LAG), lagNs / 1000);
+    if (lagNs >= MIN_REPORTED_LAG)
+        appendEvent({CATEGORY_EVENTLOOP, traceName(NAME_EVENTLOOP_LAG), (now - lagNs), lagNs});
+}
+
+// Returns latency histograms grouped by category.
+// For every traced name the object holds:
+//   - "count": number of samples
+//   - "total": total time spent (microseconds)
+//   - "max", "p50", "p90", "p99": latencies (microseconds)
+//   - "buckets": sample counts, bucket N holds [2^(N-1), 2^N) microseconds
+QJsonObject Tracer::statistics() const
+{
+    QJsonObject categories;
+    for (auto categoryIt = m_histograms.cbegin(); categoryIt != m_histograms.cend(); ++categoryIt) {
+        QJsonObject names;
+        for (auto it = categoryIt->cbegin(); it != categoryIt->cend(); ++it) {
+            const Histogram &histogram = it.value();
+
+            QJsonArray buckets;
+            for (const qint64 bucket : histogram.buckets)
+                buckets.append(bucket);
+
+            names[QString::fromLatin1(it.key())] = QJsonObject {
+                {"count", histogram.count},
+                {"total", histogram.totalUs},
+                {"max", histogram.maxUs},
+                {"p50", histogram.percentile(50)},
+                {"p90", histogram.percentile(90)},
+                {"p99", histogram.percentile(99)},
+                {"buckets", buckets}
+            };
+        }
+        categories[QString::fromLatin1(categoryIt.key())] = names;
+    }
+
+    return {
+        {"enabled", m_enabled},
+        {"uptime", m_clock.elapsed()},
+        {"categories", categories}
+    };
+}
+
+// Chrome trace event format, loadable in chrome://tracing and Perfetto UI
+QJsonObject Tracer::chromeTrace() const
+{
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray traceEvents;
+    for (int i = 0; i < m_events.size(); ++i) {
+        // oldest event first
+        const Event &event = m_events[(m_nextEvent + i) % m_events.size()];
+        traceEvents.append(QJsonObject {
+            {"name", QString::fromLatin1(event.name)},
+            {"cat", QLatin1String(event.category)},
+            {"ph", "X"},
+            {"ts", event.startNs / 1000.0},
+            {"dur", event.durationNs / 1000.0},
+            {"pid", pid},
+            {"tid", 1}
+        });
+    }
+
+    return {
+        {"traceEvents", traceEvents},
+        {"displayTimeUnit", "ms"}
+    };
+}
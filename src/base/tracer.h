@@ -0,0 +1,145 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+class QJsonObject;
+
+// Lightweight instrumentation of the main event loop.
+// Scopes are timed into per-name latency histograms and kept in a ring buffer
+// that can be exported in Chrome trace (Perfetto) format. When tracing is
+// disabled a scope costs a single branch. Main thread only.
+class Tracer : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(Tracer)
+
+public:
+    // Bucket N holds durations in [2^(N-1), 2^N) microseconds, the last one is open-ended
+    static const int HISTOGRAM_BUCKETS = 25;
+
+    struct Histogram
+    {
+        qint64 count = 0;
+        qint64 totalUs = 0;
+        qint64 maxUs = 0;
+        qint64 buckets[HISTOGRAM_BUCKETS] = {};
+
+        qint64 percentile(int percent) const;
+    };
+
+    class Scope
+    {
+        Q_DISABLE_COPY(Scope)
+
+    public:
+        // 'category' must be a string literal
+        Scope(const char *category, const QByteArray &name);
+        ~Scope();
+
+    private:
+        const char *m_category;
+        QByteArray m_name;
+        qint64 m_startNs = -1;
+    };
+
+    static void initInstance();
+    static void freeInstance();
+    static Tracer *instance();
+
+    static bool isEnabled();
+    void setEnabled(bool enabled);
+    void reset();
+
+    // 'name' must outlive the tracer (string literal, alert::what())
+    static QByteArray traceName(const char *name);
+    static QByteArray traceName(const QString &name);
+
+    QJsonObject statistics() const;
+    QJsonObject chromeTrace() const;
+
+private:
+    Tracer();
+    ~Tracer() override = default;
+
+    struct Event
+    {
+        const char *category;
+        QByteArray name;
+        qint64 startNs;
+        qint64 durationNs;
+    };
+
+    void record(const char *category, const QByteArray &name, qint64 startNs);
+    void addSample(const char *category, const QByteArray &name, qint64 durationUs);
+    void appendEvent(const Event &event);
+    void probeEventLoop();
+
+    static Tracer *m_instance;
+    static bool m_enabled;
+
+    QElapsedTimer m_clock;
+    QHash<QByteArray, QHash<QByteArray, Histogram>> m_histograms;
+    QVector<Event> m_events;
+    int m_nextEvent = 0;
+    QTimer m_lagProbeTimer;
+    qint64 m_lastProbeNs = 0;
+};
+
+inline bool Tracer::isEnabled()
+{
+    return m_enabled;
+}
+
+inline Tracer::Scope::Scope(const char *category, const QByteArray &name)
+    : m_category(category)
+    , m_name(name)
+{
+    if (m_enabled && !m_name.isEmpty())
+        m_startNs = m_instance->m_clock.nsecsElapsed();
+}
+
+inline Tracer::Scope::~Scope()
+{
+    if (m_startNs >= 0)
+        m_instance->record(m_category, m_name, m_startNs);
+}
+
+#define QBT_TRACE_CONCAT_IMPL(a, b) a##b
+#define QBT_TRACE_CONCAT(a, b) QBT_TRACE_CONCAT_IMPL(a, b)
+// 'name' is only evaluated while tracing is enabled
+#define QBT_TRACE_SCOPE(category, name) \
+    const Tracer::Scope QBT_TRACE_CONCAT(traceScope, __LINE__) \
+        {category, (Tracer::isEnabled() ? Tracer::traceName(name) : QByteArray())}
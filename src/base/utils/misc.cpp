@@ -46,6 +46,7 @@
 
 #include <QByteArray>
 #include <QDebug>
+#include <QFile>
 #include <QFileInfo>
 #include <QProcess>
 #include <QRegularExpression>
@@ -560,6 +561,41 @@ QString Utils::Misc::osName()
     return name;
 }
 
+qint64 Utils::Misc::availableMemory()
+{
+#if defined(Q_OS_WIN)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (!::GlobalMemoryStatusEx(&status))
+        return -1;
+    return static_cast<qint64>(status.ullAvailPhys);
+#elif defined(Q_OS_LINUX)
+    // MemAvailable also counts the page cache that can be reclaimed
+    QFile file("/proc/meminfo");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return -1;
+
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        if (line.startsWith("MemAvailable:")) {
+            const QList<QByteArray> fields = line.simplified().split(' ');
+            bool ok = false;
+            const qint64 kibibytes = (fields.size() > 1) ? fields[1].toLongLong(&ok) : 0;
+            return ok ? (kibibytes * 1024) : -1;
+        }
+    }
+    return -1;
+#elif defined(_SC_AVPHYS_PAGES)
+    const long pages = ::sysconf(_SC_AVPHYS_PAGES);
+    const long pageSize = ::sysconf(_SC_PAGESIZE);
+    if ((pages < 0) || (pageSize < 0))
+        return -1;
+    return static_cast<qint64>(pages) * pageSize;
+#else
+    return -1;
+#endif
+}
+
 QString Utils::Misc::boostVersionString()
 {
     // static initialization for usage in signal handler
@@ -76,6 +76,8 @@ namespace Utils
         void shutdownComputer(const ShutdownDialogAction &action);
 
         QString osName();
+        // Physical memory that can be used without swapping, -1 if unknown
+        qint64 availableMemory();
         QString boostVersionString();
         QString libtorrentVersionString();
 
@@ -342,6 +342,7 @@ bool AddNewTorrentDialog::loadMagnet(const BitTorrent::MagnetUri &magnetUri)
     }
 
     connect(BitTorrent::Session::instance(), &BitTorrent::Session::metadataLoaded, this, &AddNewTorrentDialog::updateMetadata);
+    connect(BitTorrent::Session::instance(), &BitTorrent::Session::metadataLoadFailed, this, &AddNewTorrentDialog::handleMetadataLoadFailed);
 
     // Set dialog title
     QString torrentName = magnetUri.name();
@@ -350,8 +351,8 @@ bool AddNewTorrentDialog::loadMagnet(const BitTorrent::MagnetUri &magnetUri)
     setupTreeview();
     TMMChanged(m_ui->comboTTM->currentIndex());
 
-    BitTorrent::Session::instance()->loadMetadata(magnetUri);
     setMetadataProgressIndicator(true, tr("Retrieving metadata..."));
+    BitTorrent::Session::instance()->loadMetadata(magnetUri);
     m_ui->labelHashData->setText(m_hash);
 
     return true;
@@ -570,6 +571,7 @@ void AddNewTorrentDialog::updateMetadata(const BitTorrent::TorrentInfo &info)
     if (info.hash() != m_hash) return;
 
     disconnect(BitTorrent::Session::instance(), &BitTorrent::Session::metadataLoaded, this, &AddNewTorrentDialog::updateMetadata);
+    disconnect(BitTorrent::Session::instance(), &BitTorrent::Session::metadataLoadFailed, this, &AddNewTorrentDialog::handleMetadataLoadFailed);
 
     if (!info.isValid()) {
         RaisedMessageBox::critical(this, tr("I/O Error"), ("Invalid metadata."));
@@ -587,6 +589,17 @@ void AddNewTorrentDialog::updateMetadata(const BitTorrent::TorrentInfo &info)
     setMetadataProgressIndicator(false, tr("Metadata retrieval complete"));
 }
 
+void AddNewTorrentDialog::handleMetadataLoadFailed(const BitTorrent::InfoHash &hash)
+{
+    if (hash != m_hash) return;
+
+    disconnect(BitTorrent::Session::instance(), &BitTorrent::Session::metadataLoaded, this, &AddNewTorrentDialog::updateMetadata);
+    disconnect(BitTorrent::Session::instance(), &BitTorrent::Session::metadataLoadFailed, this, &AddNewTorrentDialog::handleMetadataLoadFailed);
+
+    // The torrent can still be added, it will download the metadata itself
+    setMetadataProgressIndicator(false, tr("Metadata retrieval failed"));
+}
+
 void AddNewTorrentDialog::setMetadataProgressIndicator(bool visibleIndicator, const QString &labelText)
 {
     // Always show info label when waiting for metadata
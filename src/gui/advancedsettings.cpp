@@ -62,9 +62,22 @@ enum AdvSettingsRows
     SAVE_RESUME_DATA_INTERVAL,
     CONFIRM_AUTO_BAN,
     CONFIRM_AUTO_BAN_BT_Player,
+    AUTO_BAN_LEECHER_PEER,
     SHOW_TRACKER_AUTH_WINDOW,
+    PUBLIC_TRACKERS_LIMIT,
+    ANNOUNCE_SPREADING,
     CONFIRM_RECHECK_TORRENT,
     RECHECK_COMPLETED,
+    FAST_RECHECK,
+    CROSS_SEEDING,
+#if LIBTORRENT_VERSION_NUM >= 10100
+    DORMANT_TORRENTS,
+#endif
+    METADATA_CACHE_SIZE,
+    MAX_ACTIVE_METADATA_FETCHES,
+    METADATA_FETCH_TIMEOUT,
+    MAX_STORAGE_JOBS_PER_DEVICE,
+    STORAGE_JOB_RATE_LIMIT,
 #if defined(Q_OS_WIN) || defined(Q_OS_MAC)
     UPDATE_CHECK,
 #endif
@@ -86,6 +99,7 @@ enum AdvSettingsRows
     LIBTORRENT_HEADER,
 #if LIBTORRENT_VERSION_NUM >= 10100
     ASYNC_IO_THREADS,
+    NATIVE_SESSIONS,
 #endif
     CHECKING_MEM_USAGE,
     // cache
@@ -100,12 +114,20 @@ enum AdvSettingsRows
     SEND_BUF_WATERMARK,
     SEND_BUF_LOW_WATERMARK,
     SEND_BUF_WATERMARK_FACTOR,
+    DISK_AUTO_TUNING,
     // ports
     MAX_HALF_OPEN,
     OUTGOING_PORT_MIN,
     OUTGOING_PORT_MAX,
     UTP_MIX_MODE,
     MULTI_CONNECTIONS_PER_IP,
+#if LIBTORRENT_VERSION_NUM >= 10100
+    // upload rate controller
+    UPLOAD_RATE_CONTROLLER,
+    UPLOAD_RATE_CONTROLLER_TARGET_DELAY,
+    UPLOAD_RATE_CONTROLLER_MIN_LIMIT,
+    UPLOAD_RATE_CONTROLLER_MAX_LIMIT,
+#endif
     // embedded tracker
     TRACKER_STATUS,
     TRACKER_PORT,
@@ -156,6 +178,8 @@ void AdvancedSettings::saveAdvancedSettings()
 #if LIBTORRENT_VERSION_NUM >= 10100
     // Async IO threads
     session->setAsyncIOThreads(spinBoxAsyncIOThreads.value());
+    // Native sessions
+    session->setNativeSessionCount(spinBoxNativeSessions.value());
 #endif
     // Checking Memory Usage
     session->setCheckingMemUsage(spinBoxCheckingMemUsage.value());
@@ -174,6 +198,8 @@ void AdvancedSettings::saveAdvancedSettings()
     session->setSendBufferWatermark(spinBoxSendBufferWatermark.value());
     session->setSendBufferLowWatermark(spinBoxSendBufferLowWatermark.value());
     session->setSendBufferWatermarkFactor(spinBoxSendBufferWatermarkFactor.value());
+    // Disk auto tuning
+    session->setDiskAutoTuningEnabled(checkBoxDiskAutoTuning.isChecked());
     // Save resume data interval
     session->setSaveResumeDataInterval(spinBoxSaveResumeDataInterval.value());
     // Outgoing ports
@@ -183,8 +209,28 @@ void AdvancedSettings::saveAdvancedSettings()
     session->setUtpMixedMode(static_cast<BitTorrent::MixedModeAlgorithm>(comboBoxUtpMixedMode.currentIndex()));
     // multiple connections per IP
     session->setMultiConnectionsPerIpEnabled(checkBoxMultiConnectionsPerIp.isChecked());
+#if LIBTORRENT_VERSION_NUM >= 10100
+    // upload rate controller
+    session->setUploadRateControllerEnabled(checkBoxUploadRateController.isChecked());
+    session->setUploadRateControllerTargetDelay(spinBoxUploadRateControllerTargetDelay.value());
+    session->setUploadRateControllerMinLimit(spinBoxUploadRateControllerMinLimit.value());
+    session->setUploadRateControllerMaxLimit(spinBoxUploadRateControllerMaxLimit.value());
+#endif
     // Recheck torrents on completion
     pref->recheckTorrentsOnCompletion(checkBoxRecheckCompleted.isChecked());
+    // Fast recheck
+    session->setFastRecheckEnabled(checkBoxFastRecheck.isChecked());
+    // Cross-seeding
+    session->setCrossSeedingEnabled(checkBoxCrossSeeding.isChecked());
+    // Dormant torrents
+    session->setDormantTorrentsEnabled(checkBoxDormantTorrents.isChecked());
+    // Magnet metadata
+    session->setMetadataCacheSize(spinBoxMetadataCacheSize.value());
+    session->setMaxActiveMetadataFetches(spinBoxMaxActiveMetadataFetches.value());
+    session->setMetadataFetchTimeout(spinBoxMetadataFetchTimeout.value());
+    // Moving and deleting torrent files
+    session->setMaxStorageJobsPerDevice(spinBoxMaxStorageJobsPerDevice.value());
+    session->setStorageJobRateLimit(spinBoxStorageJobRateLimit.value());
     // Transfer list refresh interval
     session->setRefreshInterval(spinBoxListRefresh.value());
     // Peer resolution
@@ -222,8 +268,14 @@ void AdvancedSettings::saveAdvancedSettings()
     session->setAutoBanUnknownPeer(cb_auto_ban_unknown_peer.isChecked());
     // Auto ban Bittorrent Media Player Peer
     session->setAutoBanBTPlayerPeer(cb_auto_ban_bt_media_player_peer.isChecked());
+    // Auto ban leeching Peer
+    session->setAutoBanLeecherPeer(cb_auto_ban_leecher_peer.isChecked());
     // Show Tracker Authenticaion Window
     session->setShowTrackerAuthWindow(cb_show_tracker_auth_window.isChecked());
+    // Public trackers added to torrents
+    session->setPublicTrackersLimit(spinBoxPublicTrackersLimit.value());
+    // Announce spreading
+    session->setAnnounceSpreadingEnabled(checkBoxAnnounceSpreading.isChecked());
 
     // Program notification
     MainWindow *const mainWindow = static_cast<Application*>(QCoreApplication::instance())->mainWindow();
@@ -337,6 +389,11 @@ void AdvancedSettings::loadAdvancedSettings()
     spinBoxAsyncIOThreads.setMaximum(1024);
     spinBoxAsyncIOThreads.setValue(session->asyncIOThreads());
     addRow(ASYNC_IO_THREADS, tr("Asynchronous I/O threads"), &spinBoxAsyncIOThreads);
+    // Native sessions
+    spinBoxNativeSessions.setMinimum(1);
+    spinBoxNativeSessions.setMaximum(16);
+    spinBoxNativeSessions.setValue(session->nativeSessionCount());
+    addRow(NATIVE_SESSIONS, tr("Number of libtorrent sessions, each applying the active torrent limits (requires restart)"), &spinBoxNativeSessions);
 #endif
 
     // Checking Memory Usage
@@ -394,6 +451,9 @@ void AdvancedSettings::loadAdvancedSettings()
     spinBoxSendBufferWatermarkFactor.setSuffix(" %");
     spinBoxSendBufferWatermarkFactor.setValue(session->sendBufferWatermarkFactor());
     addRow(SEND_BUF_WATERMARK_FACTOR, tr("Send buffer watermark factor"), &spinBoxSendBufferWatermarkFactor);
+    // Disk auto tuning
+    checkBoxDiskAutoTuning.setChecked(session->isDiskAutoTuningEnabled());
+    addRow(DISK_AUTO_TUNING, tr("Tune disk cache, I/O threads and send buffer automatically"), &checkBoxDiskAutoTuning);
     // Save resume data interval
     spinBoxSaveResumeDataInterval.setMinimum(0);
     spinBoxSaveResumeDataInterval.setMaximum(std::numeric_limits<int>::max());
@@ -417,9 +477,69 @@ void AdvancedSettings::loadAdvancedSettings()
     // multiple connections per IP
     checkBoxMultiConnectionsPerIp.setChecked(session->multiConnectionsPerIpEnabled());
     addRow(MULTI_CONNECTIONS_PER_IP, tr("Allow multiple connections from the same IP address"), &checkBoxMultiConnectionsPerIp);
+#if LIBTORRENT_VERSION_NUM >= 10100
+    // upload rate controller
+    checkBoxUploadRateController.setChecked(session->isUploadRateControllerEnabled());
+    addRow(UPLOAD_RATE_CONTROLLER, tr("Adjust upload limit to the link latency"), &checkBoxUploadRateController);
+    spinBoxUploadRateControllerTargetDelay.setMinimum(1);
+    spinBoxUploadRateControllerTargetDelay.setMaximum(1000);
+    spinBoxUploadRateControllerTargetDelay.setSuffix(tr(" ms", " milliseconds"));
+    spinBoxUploadRateControllerTargetDelay.setValue(session->uploadRateControllerTargetDelay());
+    addRow(UPLOAD_RATE_CONTROLLER_TARGET_DELAY, tr("Target queueing delay"), &spinBoxUploadRateControllerTargetDelay);
+    spinBoxUploadRateControllerMinLimit.setMinimum(1);
+    spinBoxUploadRateControllerMinLimit.setMaximum(1000000);
+    spinBoxUploadRateControllerMinLimit.setSuffix(tr(" KiB/s"));
+    spinBoxUploadRateControllerMinLimit.setValue(session->uploadRateControllerMinLimit());
+    addRow(UPLOAD_RATE_CONTROLLER_MIN_LIMIT, tr("Lowest automatic upload limit"), &spinBoxUploadRateControllerMinLimit);
+    spinBoxUploadRateControllerMaxLimit.setMinimum(0);
+    spinBoxUploadRateControllerMaxLimit.setMaximum(1000000);
+    spinBoxUploadRateControllerMaxLimit.setSuffix(tr(" KiB/s"));
+    spinBoxUploadRateControllerMaxLimit.setSpecialValueText(QString::fromUtf8(C_INFINITY));
+    spinBoxUploadRateControllerMaxLimit.setValue(session->uploadRateControllerMaxLimit());
+    addRow(UPLOAD_RATE_CONTROLLER_MAX_LIMIT, tr("Highest automatic upload limit"), &spinBoxUploadRateControllerMaxLimit);
+#endif
     // Recheck completed torrents
     checkBoxRecheckCompleted.setChecked(pref->recheckTorrentsOnCompletion());
     addRow(RECHECK_COMPLETED, tr("Recheck torrents on completion"), &checkBoxRecheckCompleted);
+    // Fast recheck
+    checkBoxFastRecheck.setChecked(session->isFastRecheckEnabled());
+    addRow(FAST_RECHECK, tr("Recheck only the files changed since they were completed"), &checkBoxFastRecheck);
+    // Cross-seeding
+    checkBoxCrossSeeding.setChecked(session->isCrossSeedingEnabled());
+    addRow(CROSS_SEEDING, tr("Use the files of completed torrents for new torrents with the same content"), &checkBoxCrossSeeding);
+    // Dormant torrents
+    checkBoxDormantTorrents.setChecked(session->isDormantTorrentsEnabled());
+#if LIBTORRENT_VERSION_NUM >= 10100
+    addRow(DORMANT_TORRENTS, tr("Keep paused torrents unloaded until needed (requires restart)"), &checkBoxDormantTorrents);
+#endif
+    // Magnet metadata
+    spinBoxMetadataCacheSize.setMinimum(0);
+    spinBoxMetadataCacheSize.setMaximum(4096);
+    spinBoxMetadataCacheSize.setSuffix(tr(" MiB"));
+    spinBoxMetadataCacheSize.setSpecialValueText(tr("Disabled"));
+    spinBoxMetadataCacheSize.setValue(session->metadataCacheSize());
+    addRow(METADATA_CACHE_SIZE, tr("Magnet metadata cache size"), &spinBoxMetadataCacheSize);
+    spinBoxMaxActiveMetadataFetches.setMinimum(1);
+    spinBoxMaxActiveMetadataFetches.setMaximum(100);
+    spinBoxMaxActiveMetadataFetches.setValue(session->maxActiveMetadataFetches());
+    addRow(MAX_ACTIVE_METADATA_FETCHES, tr("Maximum simultaneous magnet metadata downloads"), &spinBoxMaxActiveMetadataFetches);
+    spinBoxMetadataFetchTimeout.setMinimum(0);
+    spinBoxMetadataFetchTimeout.setMaximum(86400);
+    spinBoxMetadataFetchTimeout.setSuffix(tr(" s", " seconds"));
+    spinBoxMetadataFetchTimeout.setSpecialValueText(QString::fromUtf8(C_INFINITY));
+    spinBoxMetadataFetchTimeout.setValue(session->metadataFetchTimeout());
+    addRow(METADATA_FETCH_TIMEOUT, tr("Magnet metadata download timeout"), &spinBoxMetadataFetchTimeout);
+    // Moving and deleting torrent files
+    spinBoxMaxStorageJobsPerDevice.setMinimum(1);
+    spinBoxMaxStorageJobsPerDevice.setMaximum(32);
+    spinBoxMaxStorageJobsPerDevice.setValue(session->maxStorageJobsPerDevice());
+    addRow(MAX_STORAGE_JOBS_PER_DEVICE, tr("Maximum simultaneous file moves and deletions per disk"), &spinBoxMaxStorageJobsPerDevice);
+    spinBoxStorageJobRateLimit.setMinimum(0);
+    spinBoxStorageJobRateLimit.setMaximum(10000000);
+    spinBoxStorageJobRateLimit.setSuffix(tr(" KiB/s"));
+    spinBoxStorageJobRateLimit.setSpecialValueText(QString::fromUtf8(C_INFINITY));
+    spinBoxStorageJobRateLimit.setValue(session->storageJobRateLimit());
+    addRow(STORAGE_JOB_RATE_LIMIT, tr("File move rate limit between disks"), &spinBoxStorageJobRateLimit);
     // Transfer list refresh interval
     spinBoxListRefresh.setMinimum(30);
     spinBoxListRefresh.setMaximum(99999);
@@ -480,9 +600,21 @@ void AdvancedSettings::loadAdvancedSettings()
     // Auto Ban Bittorrent Media Player Peer
     cb_auto_ban_bt_media_player_peer.setChecked(session->isAutoBanBTPlayerPeerEnabled());
     addRow(CONFIRM_AUTO_BAN_BT_Player, tr("Auto Ban Bittorrent Media Player Peer"), &cb_auto_ban_bt_media_player_peer);
+    // Auto Ban leeching Peer
+    cb_auto_ban_leecher_peer.setChecked(session->isAutoBanLeecherPeerEnabled());
+    addRow(AUTO_BAN_LEECHER_PEER, tr("Auto Ban Peer whose progress doesn't match the data it gets"), &cb_auto_ban_leecher_peer);
     // Show Tracker Authenticaion Window
     cb_show_tracker_auth_window.setChecked(session->isShowTrackerAuthWindow());
     addRow(SHOW_TRACKER_AUTH_WINDOW, tr("Show Tracker Authenticaion Window"), &cb_show_tracker_auth_window);
+    // Public trackers added to torrents
+    spinBoxPublicTrackersLimit.setMinimum(0);
+    spinBoxPublicTrackersLimit.setMaximum(1000);
+    spinBoxPublicTrackersLimit.setSpecialValueText(tr("All"));
+    spinBoxPublicTrackersLimit.setValue(session->publicTrackersLimit());
+    addRow(PUBLIC_TRACKERS_LIMIT, tr("Healthiest public trackers added to torrents"), &spinBoxPublicTrackersLimit);
+    // Announce spreading
+    checkBoxAnnounceSpreading.setChecked(session->isAnnounceSpreadingEnabled());
+    addRow(ANNOUNCE_SPREADING, tr("Spread announces to trackers shared by many torrents"), &checkBoxAnnounceSpreading);
 
     // Program notifications
     const MainWindow *const mainWindow = static_cast<Application*>(QCoreApplication::instance())->mainWindow();
@@ -59,13 +59,16 @@ private:
     template <typename T> void addRow(int row, const QString &rowText, T *widget);
 
     QLabel labelQbtLink, labelLibtorrentLink;
-    QSpinBox spinBoxAsyncIOThreads, spinBoxCheckingMemUsage, spinBoxCache, spinBoxSaveResumeDataInterval, spinBoxOutgoingPortsMin, spinBoxOutgoingPortsMax, spinBoxListRefresh, spinBoxMaxHalfOpen,
+    QSpinBox spinBoxAsyncIOThreads, spinBoxNativeSessions, spinBoxCheckingMemUsage, spinBoxCache, spinBoxSaveResumeDataInterval, spinBoxOutgoingPortsMin, spinBoxOutgoingPortsMax, spinBoxListRefresh, spinBoxMaxHalfOpen,
              spinBoxTrackerPort, spinBoxCacheTTL, spinBoxSendBufferWatermark, spinBoxSendBufferLowWatermark,
-             spinBoxSendBufferWatermarkFactor, spinBoxSavePathHistoryLength;
+             spinBoxSendBufferWatermarkFactor, spinBoxSavePathHistoryLength, spinBoxUploadRateControllerTargetDelay,
+             spinBoxUploadRateControllerMinLimit, spinBoxUploadRateControllerMaxLimit, spinBoxPublicTrackersLimit,
+             spinBoxMetadataCacheSize, spinBoxMaxActiveMetadataFetches, spinBoxMetadataFetchTimeout,
+             spinBoxMaxStorageJobsPerDevice, spinBoxStorageJobRateLimit;
     QCheckBox checkBoxOsCache, checkBoxRecheckCompleted, checkBoxResolveCountries, checkBoxResolveHosts, checkBoxSuperSeeding,
               checkBoxProgramNotifications, checkBoxTorrentAddedNotifications, checkBoxTrackerFavicon, checkBoxTrackerStatus,
               checkBoxConfirmTorrentRecheck, checkBoxConfirmRemoveAllTags, checkBoxListenIPv6, checkBoxAnnounceAllTrackers, checkBoxAnnounceAllTiers,
-              checkBoxGuidedReadCache, checkBoxMultiConnectionsPerIp, checkBoxSuggestMode, checkBoxCoalesceRW, checkBoxSpeedWidgetEnabled, cb_auto_ban_unknown_peer, cb_auto_ban_bt_media_player_peer, cb_show_tracker_auth_window;
+              checkBoxGuidedReadCache, checkBoxMultiConnectionsPerIp, checkBoxSuggestMode, checkBoxCoalesceRW, checkBoxDormantTorrents, checkBoxFastRecheck, checkBoxCrossSeeding, checkBoxDiskAutoTuning, checkBoxUploadRateController, checkBoxAnnounceSpreading, checkBoxSpeedWidgetEnabled, cb_auto_ban_unknown_peer, cb_auto_ban_bt_media_player_peer, cb_auto_ban_leecher_peer, cb_show_tracker_auth_window;
     QComboBox comboBoxInterface, comboBoxInterfaceAddress, comboBoxUtpMixedMode, comboBoxChokingAlgorithm, comboBoxSeedChokingAlgorithm;
     QLineEdit lineEditAnnounceIP;
 
@@ -0,0 +1,102 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "bandwidthclassdialog.h"
+
+#include "base/bittorrent/session.h"
+#include "base/unicodestrings.h"
+#include "base/utils/misc.h"
+#include "ui_bandwidthclassdialog.h"
+
+BandwidthClassDialog::BandwidthClassDialog(QWidget *parent)
+    : QDialog {parent}
+    , m_ui {new Ui::BandwidthClassDialog}
+{
+    m_ui->setupUi(this);
+
+    const QString infinity = QString::fromUtf8(C_INFINITY);
+    m_ui->spinUploadLimit->setSpecialValueText(infinity);
+    m_ui->spinDownloadLimit->setSpecialValueText(infinity);
+}
+
+BandwidthClassDialog::~BandwidthClassDialog()
+{
+    delete m_ui;
+}
+
+void BandwidthClassDialog::editCategoryClass(QWidget *parent, const QString &category)
+{
+    using BitTorrent::Session;
+
+    BandwidthClassDialog dialog(parent);
+    dialog.setWindowTitle(tr("Bandwidth of category %1").arg(category));
+    dialog.setBandwidthClass(Session::instance()->categoryBandwidthClasses().value(category));
+    const BitTorrent::BandwidthClassStatus status = Session::instance()->categoryBandwidthStatus().value(category);
+    dialog.setStatus(status.uploadRate, status.downloadRate, status.torrentsCount);
+    if (dialog.exec() == BandwidthClassDialog::Accepted)
+        Session::instance()->setCategoryBandwidthClass(category, dialog.bandwidthClass());
+}
+
+void BandwidthClassDialog::editTagClass(QWidget *parent, const QString &tag)
+{
+    using BitTorrent::Session;
+
+    BandwidthClassDialog dialog(parent);
+    dialog.setWindowTitle(tr("Bandwidth of tag %1").arg(tag));
+    dialog.setBandwidthClass(Session::instance()->tagBandwidthClasses().value(tag));
+    const BitTorrent::BandwidthClassStatus status = Session::instance()->tagBandwidthStatus().value(tag);
+    dialog.setStatus(status.uploadRate, status.downloadRate, status.torrentsCount);
+    if (dialog.exec() == BandwidthClassDialog::Accepted)
+        Session::instance()->setTagBandwidthClass(tag, dialog.bandwidthClass());
+}
+
+BitTorrent::BandwidthClass BandwidthClassDialog::bandwidthClass() const
+{
+    BitTorrent::BandwidthClass bandwidthClass;
+    bandwidthClass.uploadLimit = m_ui->spinUploadLimit->value() * 1024;
+    bandwidthClass.downloadLimit = m_ui->spinDownloadLimit->value() * 1024;
+    bandwidthClass.minUploadShare = m_ui->spinMinUploadShare->value();
+    bandwidthClass.minDownloadShare = m_ui->spinMinDownloadShare->value();
+    return bandwidthClass;
+}
+
+void BandwidthClassDialog::setBandwidthClass(const BitTorrent::BandwidthClass &bandwidthClass)
+{
+    m_ui->spinUploadLimit->setValue(bandwidthClass.uploadLimit / 1024);
+    m_ui->spinDownloadLimit->setValue(bandwidthClass.downloadLimit / 1024);
+    m_ui->spinMinUploadShare->setValue(bandwidthClass.minUploadShare);
+    m_ui->spinMinDownloadShare->setValue(bandwidthClass.minDownloadShare);
+}
+
+void BandwidthClassDialog::setStatus(const int uploadRate, const int downloadRate, const int torrentsCount)
+{
+    m_ui->labelStatus->setText(tr("Currently: %1 up, %2 down, %3 torrent(s)")
+        .arg(Utils::Misc::friendlyUnit(uploadRate, true)
+            , Utils::Misc::friendlyUnit(downloadRate, true)
+            , QString::number(torrentsCount)));
+}
@@ -34,6 +34,7 @@
 
 #include "base/bittorrent/session.h"
 #include "base/global.h"
+#include "bandwidthclassdialog.h"
 #include "categoryfiltermodel.h"
 #include "categoryfilterproxymodel.h"
 #include "guiiconprovider.h"
@@ -128,6 +129,11 @@ void CategoryFilterWidget::showMenu(QPoint)
                     , tr("Edit category..."));
         connect(editAct, &QAction::triggered, this, &CategoryFilterWidget::editCategory);
 
+        QAction *bandwidthAct = menu.addAction(
+                    GuiIconProvider::instance()->getIcon("kt-set-max-upload-speed")
+                    , tr("Bandwidth class..."));
+        connect(bandwidthAct, &QAction::triggered, this, &CategoryFilterWidget::editBandwidthClass);
+
         QAction *removeAct = menu.addAction(
                         GuiIconProvider::instance()->getIcon("list-remove")
                         , tr("Remove category"));
@@ -218,6 +224,11 @@ void CategoryFilterWidget::editCategory()
     TorrentCategoryDialog::editCategory(this, currentCategory());
 }
 
+void CategoryFilterWidget::editBandwidthClass()
+{
+    BandwidthClassDialog::editCategoryClass(this, currentCategory());
+}
+
 void CategoryFilterWidget::removeCategory()
 {
     auto selectedRows = selectionModel()->selectedRows();
@@ -53,6 +53,7 @@ private slots:
     void addCategory();
     void addSubcategory();
     void editCategory();
+    void editBandwidthClass();
     void removeCategory();
     void removeUnusedCategories();
 
@@ -108,5 +108,8 @@ void ExecutionLogWidget::addPeerMessage(const Log::Peer &peer)
     else
         text = "<font color='grey'>" + time.toString(Qt::SystemLocaleShortDate) + "</font> - " + tr("<font color='red'>%1</font> was banned", "x.y.z.w was banned").arg(peer.ip);
 
+    if (peer.count > 1)
+        text += ' ' + tr("(%1 more attempts)", "x.y.z.w was blocked due to IP filter. (10 more attempts)").arg(peer.count);
+
     m_peerList->appendLine(text, Log::NORMAL);
 }
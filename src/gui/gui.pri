@@ -10,6 +10,7 @@ HEADERS += \
     $$PWD/addnewtorrentdialog.h \
     $$PWD/advancedsettings.h \
     $$PWD/autoexpandabledialog.h \
+    $$PWD/bandwidthclassdialog.h \
     $$PWD/banlistoptionsdialog.h \
     $$PWD/categoryfiltermodel.h \
     $$PWD/categoryfilterproxymodel.h \
@@ -70,6 +71,7 @@ SOURCES += \
     $$PWD/addnewtorrentdialog.cpp \
     $$PWD/advancedsettings.cpp \
     $$PWD/autoexpandabledialog.cpp \
+    $$PWD/bandwidthclassdialog.cpp \
     $$PWD/banlistoptionsdialog.cpp \
     $$PWD/categoryfiltermodel.cpp \
     $$PWD/categoryfilterproxymodel.cpp \
@@ -137,6 +139,7 @@ FORMS += \
     $$PWD/aboutdialog.ui \
     $$PWD/addnewtorrentdialog.ui \
     $$PWD/autoexpandabledialog.ui \
+    $$PWD/bandwidthclassdialog.ui \
     $$PWD/banlistoptionsdialog.ui \
     $$PWD/cookiesdialog.ui \
     $$PWD/deletionconfirmationdialog.ui \
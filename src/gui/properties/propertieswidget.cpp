@@ -397,6 +397,8 @@ void PropertiesWidget::loadDynamicData()
     // Refresh only if the torrent handle is valid and visible
     if (!m_torrent || (m_mainWindow->currentTabWidget() != m_transferList) || (m_state != VISIBLE)) return;
 
+    m_torrent->requestFastRefresh();
+
     // Transfer infos
     switch (m_ui->stackedProperties->currentIndex()) {
     case PropTabBar::MainTab: {
@@ -194,6 +194,11 @@ SpeedPlotView::SpeedPlotView(QWidget *parent)
     greenPen.setStyle(Qt::DotLine);
     m_properties[TRACKER_UP] = GraphProperties(tr("Tracker Upload"), bluePen);
     m_properties[TRACKER_DOWN] = GraphProperties(tr("Tracker Download"), greenPen);
+
+    QPen orangePen;
+    orangePen.setWidthF(1.5);
+    orangePen.setColor(QColor(230, 126, 34));
+    m_properties[UPLOAD_LIMIT] = GraphProperties(tr("Upload Limit"), orangePen);
 }
 
 void SpeedPlotView::setGraphEnable(GraphID id, bool enable)
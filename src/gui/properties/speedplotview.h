@@ -55,6 +55,7 @@ public:
         DHT_DOWN,
         TRACKER_UP,
         TRACKER_DOWN,
+        UPLOAD_LIMIT,
 
         NB_GRAPHS
     };
@@ -39,6 +39,8 @@
 
 #include "base/bittorrent/session.h"
 #include "base/bittorrent/sessionstatus.h"
+#include "base/bittorrent/timeseriesstore.h"
+#include "base/global.h"
 #include "base/preferences.h"
 #include "propertieswidget.h"
 
@@ -89,6 +91,7 @@ SpeedWidget::SpeedWidget(PropertiesWidget *parent)
     m_graphsMenu->addAction(tr("DHT Download"));
     m_graphsMenu->addAction(tr("Tracker Upload"));
     m_graphsMenu->addAction(tr("Tracker Download"));
+    m_graphsMenu->addAction(tr("Upload Limit"));
 
     m_graphsMenuActions = m_graphsMenu->actions();
     m_graphsSignalMapper = new QSignalMapper(this);
@@ -118,6 +121,7 @@ SpeedWidget::SpeedWidget(PropertiesWidget *parent)
     m_layout->addWidget(m_plot);
 
     loadSettings();
+    loadHistory();
 
     QTimer *localUpdateTimer = new QTimer(this);
     connect(localUpdateTimer, &QTimer::timeout, this, &SpeedWidget::update);
@@ -135,7 +139,8 @@ SpeedWidget::~SpeedWidget()
 
 void SpeedWidget::update()
 {
-    const BitTorrent::SessionStatus &btStatus = BitTorrent::Session::instance()->status();
+    const BitTorrent::Session *const session = BitTorrent::Session::instance();
+    const BitTorrent::SessionStatus &btStatus = session->status();
 
     SpeedPlotView::PointData point;
     point.x = QDateTime::currentMSecsSinceEpoch() / 1000;
@@ -149,11 +154,48 @@ void SpeedWidget::update()
     point.y[SpeedPlotView::DHT_DOWN] = btStatus.dhtDownloadRate;
     point.y[SpeedPlotView::TRACKER_UP] = btStatus.trackerUploadRate;
     point.y[SpeedPlotView::TRACKER_DOWN] = btStatus.trackerDownloadRate;
+    point.y[SpeedPlotView::UPLOAD_LIMIT] = session->effectiveUploadSpeedLimit();
 
     m_plot->pushPoint(point);
     m_plot->replot();
 }
 
+void SpeedWidget::loadHistory()
+{
+    using BitTorrent::TimeSeriesStore;
+    static_assert(static_cast<int>(SpeedPlotView::NB_GRAPHS) == (TimeSeriesStore::UploadLimit + 1)
+                  , "SpeedPlotView::GraphID doesn't match TimeSeriesStore::GlobalSeries");
+
+    const TimeSeriesStore *history = BitTorrent::Session::instance()->transferHistory();
+    const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+
+    QVector<int> series;
+    for (int id = SpeedPlotView::UP; id < SpeedPlotView::NB_GRAPHS; ++id)
+        series << id;
+
+    const auto pushPoint = [this](const TimeSeriesStore::Point &storedPoint, const qint64 x)
+    {
+        SpeedPlotView::PointData point;
+        point.x = x;
+        for (int id = SpeedPlotView::UP; id < SpeedPlotView::NB_GRAPHS; ++id)
+            point.y[id] = storedPoint.values[id];
+        m_plot->pushPoint(point);
+    };
+
+    // The graph spans a day: per-minute history is replayed once per second
+    // it covers, the last hour comes with per-second resolution
+    const int minuteStep = TimeSeriesStore::step(TimeSeriesStore::Minute);
+    const qint64 secondsFrom = (((now - (60 * 60)) / minuteStep) + 1) * minuteStep;
+    for (const TimeSeriesStore::Point &point : asConst(history->query(TimeSeriesStore::Minute, (now - (24 * 60 * 60)), (secondsFrom - 1), series))) {
+        for (int i = 0; i < minuteStep; ++i)
+            pushPoint(point, (point.timestamp + i));
+    }
+    for (const TimeSeriesStore::Point &point : asConst(history->query(TimeSeriesStore::Second, secondsFrom, now, series)))
+        pushPoint(point, point.timestamp);
+
+    m_plot->replot();
+}
+
 void SpeedWidget::onPeriodChange(int period)
 {
     m_plot->setPeriod(static_cast<SpeedPlotView::TimePeriod>(period));
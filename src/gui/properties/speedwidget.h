@@ -70,6 +70,7 @@ private slots:
 private:
     void loadSettings();
     void saveSettings() const;
+    void loadHistory();
 
     QVBoxLayout *m_layout;
     QHBoxLayout *m_hlayout;
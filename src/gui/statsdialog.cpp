@@ -108,4 +108,18 @@ void StatsDialog::update()
 
     // Total connected peers
     m_ui->labelPeers->setText(QString::number(ss.peersCount));
+
+    // Leecher detection
+    const BitTorrent::LeecherStatistics ls = BitTorrent::Session::instance()->leecherStatistics();
+    m_ui->labelLeecherFlagged->setText(QString::number(ls.flagged));
+    m_ui->labelLeecherBanned->setText(QString::number(ls.banned));
+    m_ui->labelLeecherFalsePositives->setText(QString::number(ls.falsePositives));
+
+    // File moves and deletions, the finished ones count until the queue is empty
+    const BitTorrent::StorageQueueStatus sqs = BitTorrent::Session::instance()->storageQueueStatus();
+    m_ui->labelStorageJobsQueued->setText(QString::number(sqs.queued));
+    m_ui->labelStorageJobsRunning->setText(QString::number(sqs.running));
+    m_ui->labelStorageJobsProgress->setText(tr("%1 of %2 (%3%)", "1.5 GiB of 4 GiB (37.5%)")
+        .arg(Utils::Misc::friendlyUnit(sqs.doneSize), Utils::Misc::friendlyUnit(sqs.totalSize)
+            , Utils::String::fromDouble((sqs.totalSize > 0) ? (100. * sqs.doneSize / sqs.totalSize) : 0., 1)));
 }
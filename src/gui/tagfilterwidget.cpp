@@ -37,6 +37,7 @@
 #include "base/bittorrent/session.h"
 #include "base/global.h"
 #include "autoexpandabledialog.h"
+#include "bandwidthclassdialog.h"
 #include "guiiconprovider.h"
 #include "tagfiltermodel.h"
 #include "tagfilterproxymodel.h"
@@ -119,6 +120,11 @@ void TagFilterWidget::showMenu(QPoint)
             GuiIconProvider::instance()->getIcon("list-remove")
             , tr("Remove tag"));
         connect(removeAct, &QAction::triggered, this, &TagFilterWidget::removeTag);
+
+        QAction *bandwidthAct = menu.addAction(
+            GuiIconProvider::instance()->getIcon("kt-set-max-upload-speed")
+            , tr("Bandwidth class..."));
+        connect(bandwidthAct, &QAction::triggered, this, &TagFilterWidget::editBandwidthClass);
     }
 
     QAction *removeUnusedAct = menu.addAction(
@@ -220,6 +226,11 @@ void TagFilterWidget::removeTag()
     }
 }
 
+void TagFilterWidget::editBandwidthClass()
+{
+    BandwidthClassDialog::editTagClass(this, currentTag());
+}
+
 void TagFilterWidget::removeUnusedTags()
 {
     auto session = BitTorrent::Session::instance();
@@ -52,6 +52,7 @@ private slots:
     void callUpdateGeometry();
     void addTag();
     void removeTag();
+    void editBandwidthClass();
     void removeUnusedTags();
 
 private:
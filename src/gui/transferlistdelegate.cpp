@@ -99,6 +99,13 @@ void TransferListDelegate::paint(QPainter *painter, const QStyleOptionViewItem &
     case TransferListModel::TR_STATUS: {
             const auto state = index.data().value<BitTorrent::TorrentState>();
             QString display = getStatusString(state);
+            if (state == BitTorrent::TorrentState::Moving) {
+                const qreal moveProgress = index.data(Qt::UserRole).toReal();
+                if (moveProgress == -1)
+                    display = tr("Queued for moving", "Torrent local data are waiting for their turn to be moved");
+                else if (moveProgress >= 0)
+                    display = QString::fromLatin1("%1 (%2%)").arg(display, Utils::String::fromDouble(moveProgress * 100., 1));
+            }
             QItemDelegate::drawDisplay(painter, opt, opt.rect, display);
         }
         break;
@@ -214,6 +214,9 @@ TrackerFiltersList::TrackerFiltersList(QWidget *parent, TransferListWidget *tran
 
     setCurrentRow(0, QItemSelectionModel::SelectCurrent);
     toggleFilter(Preferences::instance()->getTrackerFilterState());
+
+    connect(BitTorrent::Session::instance(), &BitTorrent::Session::statsUpdated
+            , this, &TrackerFiltersList::updateTrackerLoads);
 }
 
 TrackerFiltersList::~TrackerFiltersList()
@@ -539,6 +542,28 @@ QString TrackerFiltersList::getHost(const QString &tracker) const
     return longHost.mid(index + 1);
 }
 
+// Shows the announce rate and backlog of the trackers in their tooltips
+void TrackerFiltersList::updateTrackerLoads()
+{
+    const QHash<QString, BitTorrent::TrackerLoad> hostLoads = BitTorrent::Session::instance()->trackerLoads();
+    QHash<QString, BitTorrent::TrackerLoad> loads;
+    for (auto it = hostLoads.cbegin(); it != hostLoads.cend(); ++it) {
+        QUrl url;
+        url.setScheme(QLatin1String("http"));
+        url.setHost(it.key());
+        BitTorrent::TrackerLoad &load = loads[getHost(url.toString())];
+        load.torrents += it->torrents;
+        load.announceRate += it->announceRate;
+        load.backlog += it->backlog;
+    }
+
+    for (int i = 4; i < count(); ++i) {
+        const BitTorrent::TrackerLoad load = loads.value(trackerFromRow(i));
+        item(i)->setToolTip(tr("Announces in the last minute: %1\nWaiting for a reply: %2")
+                            .arg(load.announceRate).arg(load.backlog));
+    }
+}
+
 QStringList TrackerFiltersList::getHashes(int row)
 {
     if (row == 1)
@@ -107,6 +107,7 @@ public slots:
 private slots:
     void handleFavicoDownload(const QString &url, const QString &filePath);
     void handleFavicoFailure(const QString &url, const QString &error);
+    void updateTrackerLoads();
 
 private:
     // These 4 methods are virtual slots in the base class.
@@ -38,6 +38,7 @@
 #include "base/bittorrent/torrenthandle.h"
 #include "base/global.h"
 #include "base/torrentfilter.h"
+#include "base/tracer.h"
 #include "base/utils/fs.h"
 
 static QIcon getIconByState(BitTorrent::TorrentState state);
@@ -185,7 +186,7 @@ QVariant TransferListModel::data(const QModelIndex &index, int role) const
     case TR_PROGRESS:
         return torrent->progress();
     case TR_STATUS:
-        return QVariant::fromValue(torrent->state());
+        return (role == Qt::DisplayRole) ? QVariant::fromValue(torrent->state()) : torrent->moveProgress();
     case TR_SEEDS:
         return (role == Qt::DisplayRole) ? torrent->seedsCount() : torrent->totalSeedsCount();
     case TR_PEERS:
@@ -314,6 +315,7 @@ void TransferListModel::handleTorrentStatusUpdated(BitTorrent::TorrentHandle *co
 
 void TransferListModel::handleTorrentsUpdated()
 {
+    QBT_TRACE_SCOPE("gui", "TransferListModel::handleTorrentsUpdated");
     emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
 }
 
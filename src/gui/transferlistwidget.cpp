@@ -28,6 +28,8 @@
 
 #include "transferlistwidget.h"
 
+#include <algorithm>
+
 #include <QClipboard>
 #include <QDebug>
 #include <QFileDialog>
@@ -79,6 +81,23 @@ namespace
         return hashes;
     }
 
+    // Moves of the given torrents still waiting for their turn,
+    // removals don't show up since their torrents are already gone
+    QList<BitTorrent::StorageJob> queuedStorageMoves(const QList<BitTorrent::TorrentHandle *> &torrents)
+    {
+        QSet<BitTorrent::InfoHash> hashes;
+        for (BitTorrent::TorrentHandle *const torrent : torrents)
+            hashes.insert(torrent->hash());
+
+        QList<BitTorrent::StorageJob> jobs;
+        for (const BitTorrent::StorageJob &job : asConst(BitTorrent::Session::instance()->storageJobs())) {
+            if ((job.type == BitTorrent::StorageJob::Move) && !job.isRunning && hashes.contains(job.hash))
+                jobs << job;
+        }
+
+        return jobs;
+    }
+
     // Helper for setting style parameters when painting check box primitives.
     class CheckBoxIconHelper : public QCheckBox
     {
@@ -287,6 +306,7 @@ TransferListWidget::TransferListWidget(QWidget *parent, MainWindow *mainWindow)
     connect(header(), &QHeaderView::sectionMoved, this, &TransferListWidget::saveSettings);
     connect(header(), &QHeaderView::sectionResized, this, &TransferListWidget::saveSettings);
     connect(header(), &QHeaderView::sortIndicatorChanged, this, &TransferListWidget::saveSettings);
+    connect(BitTorrent::Session::instance(), &BitTorrent::Session::torrentsUpdated, this, &TransferListWidget::requestVisibleTorrentsRefresh);
 
     m_editHotkey = new QShortcut(Qt::Key_F2, this, nullptr, nullptr, Qt::WidgetShortcut);
     connect(m_editHotkey, &QShortcut::activated, this, &TransferListWidget::renameSelectedTorrent);
@@ -697,6 +717,35 @@ void TransferListWidget::reannounceSelectedTorrents()
         torrent->forceReannounce();
 }
 
+void TransferListWidget::cancelSelectedStorageMoves()
+{
+    BitTorrent::Session *const session = BitTorrent::Session::instance();
+    for (const BitTorrent::StorageJob &job : asConst(queuedStorageMoves(getSelectedTorrents())))
+        session->cancelStorageJob(job.id);
+}
+
+void TransferListWidget::runSelectedStorageMovesFirst()
+{
+    BitTorrent::Session *const session = BitTorrent::Session::instance();
+    int priority = 0;
+    for (const BitTorrent::StorageJob &job : asConst(session->storageJobs()))
+        priority = std::max(priority, (job.priority + 1));
+
+    for (const BitTorrent::StorageJob &job : asConst(queuedStorageMoves(getSelectedTorrents())))
+        session->setStorageJobPriority(job.id, priority);
+}
+
+void TransferListWidget::runSelectedStorageMovesLast()
+{
+    BitTorrent::Session *const session = BitTorrent::Session::instance();
+    int priority = 0;
+    for (const BitTorrent::StorageJob &job : asConst(session->storageJobs()))
+        priority = std::min(priority, (job.priority - 1));
+
+    for (const BitTorrent::StorageJob &job : asConst(queuedStorageMoves(getSelectedTorrents())))
+        session->setStorageJobPriority(job.id, priority);
+}
+
 // hide/show columns menu
 void TransferListWidget::displayDLHoSMenu(const QPoint&)
 {
@@ -819,6 +868,23 @@ void TransferListWidget::applyToSelectedTorrents(const std::function<void (BitTo
     }
 }
 
+void TransferListWidget::requestVisibleTorrentsRefresh()
+{
+    // Torrents on screen get status updates at full rate, the rest are refreshed less often
+    if (!isVisible()) return;
+
+    const QModelIndex first = indexAt(viewport()->rect().topLeft());
+    if (!first.isValid()) return;
+
+    const QModelIndex last = indexAt(viewport()->rect().bottomLeft());
+    const int lastRow = last.isValid() ? last.row() : (m_sortFilterModel->rowCount() - 1);
+    for (int i = first.row(); i <= lastRow; ++i) {
+        BitTorrent::TorrentHandle *const torrent = m_listModel->torrentHandle(mapToSource(m_sortFilterModel->index(i, 0)));
+        if (torrent)
+            torrent->requestFastRefresh();
+    }
+}
+
 void TransferListWidget::renameSelectedTorrent()
 {
     const QModelIndexList selectedIndexes = selectionModel()->selectedRows();
@@ -897,6 +963,12 @@ void TransferListWidget::displayListMenu(const QPoint&)
     connect(&actionForceRecheck, &QAction::triggered, this, &TransferListWidget::recheckSelectedTorrents);
     QAction actionForceReannounce(GuiIconProvider::instance()->getIcon("document-edit-verify"), tr("Force reannounce"), nullptr);
     connect(&actionForceReannounce, &QAction::triggered, this, &TransferListWidget::reannounceSelectedTorrents);
+    QAction actionCancelStorageMove(GuiIconProvider::instance()->getIcon("edit-delete"), tr("Cancel", "i.e. cancel the queued move of the files"), nullptr);
+    connect(&actionCancelStorageMove, &QAction::triggered, this, &TransferListWidget::cancelSelectedStorageMoves);
+    QAction actionStorageMoveFirst(GuiIconProvider::instance()->getIcon("go-top"), tr("Run first", "i.e. move the files before the other queued jobs"), nullptr);
+    connect(&actionStorageMoveFirst, &QAction::triggered, this, &TransferListWidget::runSelectedStorageMovesFirst);
+    QAction actionStorageMoveLast(GuiIconProvider::instance()->getIcon("go-bottom"), tr("Run last", "i.e. move the files after the other queued jobs"), nullptr);
+    connect(&actionStorageMoveLast, &QAction::triggered, this, &TransferListWidget::runSelectedStorageMovesLast);
     QAction actionCopyMagnetLink(GuiIconProvider::instance()->getIcon("kt-magnet"), tr("Copy magnet link"), nullptr);
     connect(&actionCopyMagnetLink, &QAction::triggered, this, &TransferListWidget::copySelectedMagnetURIs);
     QAction actionCopyName(GuiIconProvider::instance()->getIcon("edit-copy"), tr("Copy name"), nullptr);
@@ -1013,6 +1085,13 @@ void TransferListWidget::displayListMenu(const QPoint&)
     listMenu.addAction(&actionDelete);
     listMenu.addSeparator();
     listMenu.addAction(&actionSetTorrentPath);
+    if (!queuedStorageMoves(getSelectedTorrents()).isEmpty()) {
+        QMenu *storageMoveMenu = listMenu.addMenu(tr("Queued move", "i.e. the move of the files waiting for its turn"));
+        storageMoveMenu->addAction(&actionStorageMoveFirst);
+        storageMoveMenu->addAction(&actionStorageMoveLast);
+        storageMoveMenu->addSeparator();
+        storageMoveMenu->addAction(&actionCancelStorageMove);
+    }
     if (selectedIndexes.size() == 1)
         listMenu.addAction(&actionRename);
     // Category Menu
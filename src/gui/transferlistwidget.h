@@ -82,6 +82,9 @@ public slots:
     void openSelectedTorrentsFolder() const;
     void recheckSelectedTorrents();
     void reannounceSelectedTorrents();
+    void cancelSelectedStorageMoves();
+    void runSelectedStorageMovesFirst();
+    void runSelectedStorageMovesLast();
     void setDlLimitSelectedTorrents();
     void setUpLimitSelectedTorrents();
     void setMaxRatioSelectedTorrents();
@@ -123,6 +126,7 @@ private:
     void confirmRemoveAllTagsForSelection();
     QStringList askTagsForSelection(const QString &dialogTitle);
     void applyToSelectedTorrents(const std::function<void (BitTorrent::TorrentHandle *const)> &fn);
+    void requestVisibleTorrentsRefresh();
 
     TransferListDelegate *m_listDelegate;
     TransferListModel *m_listModel;
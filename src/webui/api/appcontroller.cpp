@@ -30,8 +30,11 @@
 
 #include "appcontroller.h"
 
+#include <algorithm>
+
 #include <QCoreApplication>
 #include <QDebug>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QRegularExpression>
@@ -46,6 +49,8 @@
 
 #include "base/bittorrent/session.h"
 #include "base/global.h"
+#include "base/memoryusage.h"
+#include "base/net/downloadmanager.h"
 #include "base/net/portforwarder.h"
 #include "base/net/proxyconfigurationmanager.h"
 #include "base/preferences.h"
@@ -90,6 +95,20 @@ void AppController::preferencesAction()
     data["auto_delete_mode"] = static_cast<int>(TorrentFileGuard::autoDeleteMode());
     data["preallocate_all"] = session->isPreallocationEnabled();
     data["incomplete_files_ext"] = session->isAppendExtensionEnabled();
+    data["dormant_torrents_enabled"] = session->isDormantTorrentsEnabled();
+    data["native_session_count"] = session->nativeSessionCount();
+    data["fast_recheck_enabled"] = session->isFastRecheckEnabled();
+    data["cross_seeding_enabled"] = session->isCrossSeedingEnabled();
+    data["metadata_cache_size"] = session->metadataCacheSize();
+    data["max_active_metadata_fetches"] = session->maxActiveMetadataFetches();
+    data["metadata_fetch_timeout"] = session->metadataFetchTimeout();
+    data["max_storage_jobs_per_device"] = session->maxStorageJobsPerDevice();
+    data["storage_job_rate_limit"] = session->storageJobRateLimit();
+    data["disk_auto_tuning_enabled"] = session->isDiskAutoTuningEnabled();
+    data["upload_rate_controller_enabled"] = session->isUploadRateControllerEnabled();
+    data["upload_rate_controller_target_delay"] = session->uploadRateControllerTargetDelay();
+    data["upload_rate_controller_min_limit"] = session->uploadRateControllerMinLimit();
+    data["upload_rate_controller_max_limit"] = session->uploadRateControllerMaxLimit();
     // Saving Management
     data["auto_tmm_enabled"] = !session->isAutoTMMDisabledByDefault();
     data["torrent_changed_tmm_enabled"] = !session->isDisableAutoTMMWhenCategoryChanged();
@@ -155,6 +174,7 @@ void AppController::preferencesAction()
     data["banned_IPs"] = session->bannedIPs().join("\n");
     data["auto_ban_unknown_peer"] = session->isAutoBanUnknownPeerEnabled();
     data["auto_ban_bt_player_peer"] = session->isAutoBanBTPlayerPeerEnabled();
+    data["auto_ban_leecher_peer"] = session->isAutoBanLeecherPeerEnabled();
 
     // Speed
     // Global Rate Limits
@@ -204,6 +224,8 @@ void AppController::preferencesAction()
     data["auto_update_trackers_enabled"] = session->isAutoUpdateTrackersEnabled();
     data["customize_trackers_list_url"] = pref->customizeTrackersListUrl();
     data["public_trackers"] = session->publicTrackers();
+    data["public_trackers_limit"] = session->publicTrackersLimit();
+    data["announce_spreading_enabled"] = session->isAnnounceSpreadingEnabled();
 
     // Web UI
     // Language
@@ -239,6 +261,11 @@ void AppController::preferencesAction()
     data["dyndns_password"] = pref->getDynDNSPassword();
     data["dyndns_domain"] = pref->getDynDomainName();
 
+    // Web downloads
+    data["http_max_connections_per_host"] = pref->getMaxConnectionsPerHost();
+    data["http_min_request_interval_per_host"] = pref->getMinRequestIntervalPerHost();
+    data["http_cache_size"] = pref->getHttpCacheSize();
+
     // RSS settings
     data["rss_refresh_interval"] = RSS::Session::instance()->refreshInterval();
     data["rss_max_articles_per_feed"] = RSS::Session::instance()->maxArticlesPerFeed();
@@ -270,6 +297,34 @@ void AppController::setPreferencesAction()
         session->setPreallocationEnabled(it.value().toBool());
     if ((it = m.find(QLatin1String("incomplete_files_ext"))) != m.constEnd())
         session->setAppendExtensionEnabled(it.value().toBool());
+    if ((it = m.find(QLatin1String("dormant_torrents_enabled"))) != m.constEnd())
+        session->setDormantTorrentsEnabled(it.value().toBool());
+    if ((it = m.find(QLatin1String("native_session_count"))) != m.constEnd())
+        session->setNativeSessionCount(it.value().toInt());
+    if ((it = m.find(QLatin1String("fast_recheck_enabled"))) != m.constEnd())
+        session->setFastRecheckEnabled(it.value().toBool());
+    if ((it = m.find(QLatin1String("cross_seeding_enabled"))) != m.constEnd())
+        session->setCrossSeedingEnabled(it.value().toBool());
+    if ((it = m.find(QLatin1String("metadata_cache_size"))) != m.constEnd())
+        session->setMetadataCacheSize(it.value().toInt());
+    if ((it = m.find(QLatin1String("max_active_metadata_fetches"))) != m.constEnd())
+        session->setMaxActiveMetadataFetches(it.value().toInt());
+    if ((it = m.find(QLatin1String("metadata_fetch_timeout"))) != m.constEnd())
+        session->setMetadataFetchTimeout(it.value().toInt());
+    if ((it = m.find(QLatin1String("max_storage_jobs_per_device"))) != m.constEnd())
+        session->setMaxStorageJobsPerDevice(it.value().toInt());
+    if ((it = m.find(QLatin1String("storage_job_rate_limit"))) != m.constEnd())
+        session->setStorageJobRateLimit(it.value().toInt());
+    if ((it = m.find(QLatin1String("disk_auto_tuning_enabled"))) != m.constEnd())
+        session->setDiskAutoTuningEnabled(it.value().toBool());
+    if ((it = m.find(QLatin1String("upload_rate_controller_enabled"))) != m.constEnd())
+        session->setUploadRateControllerEnabled(it.value().toBool());
+    if ((it = m.find(QLatin1String("upload_rate_controller_target_delay"))) != m.constEnd())
+        session->setUploadRateControllerTargetDelay(it.value().toInt());
+    if ((it = m.find(QLatin1String("upload_rate_controller_min_limit"))) != m.constEnd())
+        session->setUploadRateControllerMinLimit(it.value().toInt());
+    if ((it = m.find(QLatin1String("upload_rate_controller_max_limit"))) != m.constEnd())
+        session->setUploadRateControllerMaxLimit(it.value().toInt());
 
     // Saving Management
     if ((it = m.find(QLatin1String("auto_tmm_enabled"))) != m.constEnd())
@@ -410,6 +465,8 @@ void AppController::setPreferencesAction()
         session->setAutoBanUnknownPeer(m["auto_ban_unknown_peer"].toBool());
     if (m.contains("auto_ban_bt_player_peer"))
         session->setAutoBanBTPlayerPeer(m["auto_ban_bt_player_peer"].toBool());
+    if (m.contains("auto_ban_leecher_peer"))
+        session->setAutoBanLeecherPeer(m["auto_ban_leecher_peer"].toBool());
 
     // Speed
     // Global Rate Limits
@@ -489,6 +546,10 @@ void AppController::setPreferencesAction()
     session->setAutoUpdateTrackersEnabled(m["auto_update_trackers_enabled"].toBool());
     if (m.contains("customize_trackers_list_url"))
         pref->setCustomizeTrackersListUrl(m["customize_trackers_list_url"].toString());
+    if (m.contains("public_trackers_limit"))
+        session->setPublicTrackersLimit(m["public_trackers_limit"].toInt());
+    if (m.contains("announce_spreading_enabled"))
+        session->setAnnounceSpreadingEnabled(m["announce_spreading_enabled"].toBool());
 
     // Web UI
     // Language
@@ -565,6 +626,13 @@ void AppController::setPreferencesAction()
         pref->setDynDNSPassword(m["dyndns_password"].toString());
     if (m.contains("dyndns_domain"))
         pref->setDynDomainName(m["dyndns_domain"].toString());
+    // Web downloads
+    if (m.contains("http_max_connections_per_host"))
+        pref->setMaxConnectionsPerHost(m["http_max_connections_per_host"].toInt());
+    if (m.contains("http_min_request_interval_per_host"))
+        pref->setMinRequestIntervalPerHost(m["http_min_request_interval_per_host"].toInt());
+    if (m.contains("http_cache_size"))
+        pref->setHttpCacheSize(m["http_cache_size"].toInt());
 
     // Save preferences
     pref->apply();
@@ -583,3 +651,60 @@ void AppController::defaultSavePathAction()
 {
     setResult(BitTorrent::Session::instance()->defaultSavePath());
 }
+
+// Returns the web download statistics per host in JSON format.
+// The return value is an array of dictionaries.
+// The dictionary keys are:
+//   - "host": host name and port
+//   - "active": requests in progress
+//   - "queued": requests waiting for a free connection or their turn
+//   - "requests": requests made since startup
+//   - "coalesced": requests that joined an identical one in flight
+//   - "cache_hits": replies served from the HTTP cache
+//   - "failed": failed requests
+//   - "avg_queue_time": average time spent in the queue (ms)
+//   - "avg_latency": average time from the start of a request to its reply (ms)
+void AppController::networkStatisticsAction()
+{
+    QJsonArray result;
+
+    const auto statistics = Net::DownloadManager::instance()->serviceStatistics();
+    for (auto it = statistics.cbegin(); it != statistics.cend(); ++it) {
+        const Net::ServiceStatistics &stats = it.value();
+        const qint64 startedCount = std::max<qint64>(1, stats.requestCount - stats.coalescedCount);
+        result << QJsonObject {
+            {"host", QString::fromLatin1("%1:%2").arg(it.key().hostName).arg(it.key().port)},
+            {"active", stats.activeCount},
+            {"queued", stats.queuedCount},
+            {"requests", stats.requestCount},
+            {"coalesced", stats.coalescedCount},
+            {"cache_hits", stats.cacheHitCount},
+            {"failed", stats.failedCount},
+            {"avg_queue_time", (stats.totalQueueTime / startedCount)},
+            {"avg_latency", (stats.totalLatency / startedCount)}
+        };
+    }
+
+    setResult(result);
+}
+
+// Returns the estimated memory usage per subsystem in JSON format.
+// The return value is a dictionary keyed by subsystem
+// ("torrents", "trackers", "peers", "logs", "rss", "strings").
+// The values are dictionaries with keys:
+//   - "bytes": estimated heap usage
+//   - "items": number of accounted items
+void AppController::memoryUsageAction()
+{
+    QJsonObject result;
+
+    const QMap<QString, MemoryUsage::Usage> usage = MemoryUsage::collect();
+    for (auto it = usage.cbegin(); it != usage.cend(); ++it) {
+        result[it.key()] = QJsonObject {
+            {"bytes", it.value().bytes},
+            {"items", it.value().items}
+        };
+    }
+
+    setResult(result);
+}
@@ -47,4 +47,6 @@ private slots:
     void preferencesAction();
     void setPreferencesAction();
     void defaultSavePathAction();
+    void networkStatisticsAction();
+    void memoryUsageAction();
 };
@@ -41,6 +41,9 @@ const char KEY_LOG_MSG_MESSAGE[] = "message";
 const char KEY_LOG_PEER_IP[] = "ip";
 const char KEY_LOG_PEER_BLOCKED[] = "blocked";
 const char KEY_LOG_PEER_REASON[] = "reason";
+const char KEY_LOG_PEER_COUNT[] = "count";
+const char KEY_LOG_PEER_FIRST_SEEN[] = "first_seen";
+const char KEY_LOG_PEER_LAST_SEEN[] = "last_seen";
 
 // Returns the log in JSON format.
 // The return value is an array of dictionaries.
@@ -97,6 +100,7 @@ void LogController::mainAction()
 //   - "ip": IP of the peer
 //   - "blocked": whether or not the peer was blocked
 //   - "reason": reason of the block
+//   - "count": connection attempts summarized by the message
 // GET params:
 //   - last_known_id (int): exclude messages with id <= 'last_known_id' (default -1)
 void LogController::peersAction()
@@ -118,6 +122,40 @@ void LogController::peersAction()
         map[KEY_LOG_PEER_IP] = peer.ip;
         map[KEY_LOG_PEER_BLOCKED] = peer.blocked;
         map[KEY_LOG_PEER_REASON] = peer.reason;
+        map[KEY_LOG_PEER_COUNT] = peer.count;
+        peerList.append(map);
+    }
+
+    setResult(QJsonArray::fromVariantList(peerList));
+}
+
+// Returns the sources with the most blocked connection attempts in JSON format.
+// The return value is an array of dictionaries.
+// The dictionary keys are:
+//   - "ip": IP of the peer
+//   - "blocked": whether the peer was blocked (or banned)
+//   - "reason": reason of the block
+//   - "count": number of attempts
+//   - "first_seen": milliseconds since epoch
+//   - "last_seen": milliseconds since epoch
+// GET params:
+//   - limit (int): maximum number of sources (default 100)
+void LogController::blockedPeersAction()
+{
+    bool ok = false;
+    int limit = params()["limit"].toInt(&ok);
+    if (!ok)
+        limit = 100;
+
+    QVariantList peerList;
+    for (const Log::PeerStats &peer : asConst(Logger::instance()->topPeers(limit))) {
+        QVariantMap map;
+        map[KEY_LOG_PEER_IP] = peer.ip.toHtmlEscaped();
+        map[KEY_LOG_PEER_BLOCKED] = peer.blocked;
+        map[KEY_LOG_PEER_REASON] = peer.reason.toHtmlEscaped();
+        map[KEY_LOG_PEER_COUNT] = peer.count;
+        map[KEY_LOG_PEER_FIRST_SEEN] = peer.firstSeen;
+        map[KEY_LOG_PEER_LAST_SEEN] = peer.lastSeen;
         peerList.append(map);
     }
 
@@ -41,4 +41,5 @@ public:
 private slots:
     void mainAction();
     void peersAction();
+    void blockedPeersAction();
 };
@@ -28,6 +28,9 @@
 
 #include "synccontroller.h"
 
+#include <algorithm>
+
+#include <QJsonDocument>
 #include <QJsonObject>
 #include <QMetaObject>
 #include <QThread>
@@ -36,6 +39,7 @@
 #include "base/bittorrent/session.h"
 #include "base/bittorrent/torrenthandle.h"
 #include "base/global.h"
+#include "base/http/eventstream.h"
 #include "base/net/geoipmanager.h"
 #include "base/preferences.h"
 #include "base/utils/fs.h"
@@ -102,13 +106,51 @@ const char KEY_SUFFIX_REMOVED[] = "_removed";
 
 const int FREEDISKSPACE_CHECK_TIMEOUT = 30000;
 
+const int EVENT_FLUSH_DELAY = 500; // ms, coalesces bursts of session signals into one delta
+const int EVENT_HEARTBEAT_INTERVAL = 15000;
+const int EVENT_FULL_SYNC_INTERVAL = 30000; // ms, picks up the changes no signal tells about
+const int EVENT_HISTORY_SIZE = 64; // deltas kept to resume reconnecting clients
+const qint64 EVENT_STREAM_MAX_PENDING_SIZE = 512 * 1024;
+
 namespace
 {
     void processMap(const QVariantMap &prevData, const QVariantMap &data, QVariantMap &syncData);
     void processHash(QVariantHash prevData, const QVariantHash &data, QVariantMap &syncData, QVariantList &removedItems);
     void processList(QVariantList prevData, const QVariantList &data, QVariantList &syncData, QVariantList &removedItems);
+    void mergeSyncData(QVariantMap &syncData, const QVariantMap &newerSyncData);
     QVariantMap generateSyncData(int acceptedResponseId, const QVariantMap &data, QVariantMap &lastAcceptedData, QVariantMap &lastData);
 
+    QVariantMap torrentData(const BitTorrent::TorrentHandle &torrent, const QVariantMap &lastTorrent)
+    {
+        QVariantMap map = serialize(torrent);
+        map.remove(KEY_TORRENT_HASH);
+
+        // Calculated last activity time can differ from actual value by up to 10 seconds (this is a libtorrent issue).
+        // So we don't need unnecessary updates of last activity time in response.
+        if (lastTorrent.contains(KEY_TORRENT_LAST_ACTIVITY_TIME)) {
+            uint lastValue = lastTorrent[KEY_TORRENT_LAST_ACTIVITY_TIME].toUInt();
+            if (qAbs(static_cast<int>(lastValue - map[KEY_TORRENT_LAST_ACTIVITY_TIME].toUInt())) < 15)
+                map[KEY_TORRENT_LAST_ACTIVITY_TIME] = lastValue;
+        }
+
+        return map;
+    }
+
+    QVariantHash categoriesData()
+    {
+        QVariantHash categories;
+        const auto categoriesList = BitTorrent::Session::instance()->categories();
+        for (auto it = categoriesList.cbegin(); it != categoriesList.cend(); ++it) {
+            const auto key = it.key();
+            categories[key] = QVariantMap {
+                {"name", key},
+                {"savePath", it.value()}
+            };
+        }
+
+        return categories;
+    }
+
     QVariantMap getTranserInfo()
     {
         QVariantMap map;
@@ -286,6 +328,57 @@ namespace
         }
     }
 
+    // Fold a newer delta (newerSyncData) into an older one (syncData),
+    // so that a client which missed several deltas gets a single update.
+    void mergeSyncData(QVariantMap &syncData, const QVariantMap &newerSyncData)
+    {
+        for (auto i = newerSyncData.cbegin(); i != newerSyncData.cend(); ++i) {
+            const QString &key = i.key();
+            const QVariant &value = i.value();
+
+            if (key.endsWith(QLatin1String(KEY_SUFFIX_REMOVED))) {
+                // pending changes of removed items are no longer relevant
+                const QString itemsKey = key.left(key.size() - int(qstrlen(KEY_SUFFIX_REMOVED)));
+                QVariantMap items = syncData.value(itemsKey).toMap();
+                QVariantList removedItems = syncData.value(key).toList();
+                for (const QVariant &item : asConst(value.toList())) {
+                    items.remove(item.toString());
+                    if (!removedItems.contains(item))
+                        removedItems << item;
+                }
+
+                if (items.isEmpty())
+                    syncData.remove(itemsKey);
+                else
+                    syncData[itemsKey] = items;
+                syncData[key] = removedItems;
+            }
+            else if (value.type() == QVariant::Map) {
+                const QVariantMap newerMap = value.toMap();
+
+                // items added again after being removed
+                const QString removedKey = key + QLatin1String(KEY_SUFFIX_REMOVED);
+                if (syncData.contains(removedKey)) {
+                    QVariantList removedItems = syncData[removedKey].toList();
+                    for (auto it = newerMap.cbegin(); it != newerMap.cend(); ++it)
+                        removedItems.removeAll(it.key());
+
+                    if (removedItems.isEmpty())
+                        syncData.remove(removedKey);
+                    else
+                        syncData[removedKey] = removedItems;
+                }
+
+                QVariantMap map = syncData.value(key).toMap();
+                mergeSyncData(map, newerMap);
+                syncData[key] = map;
+            }
+            else {
+                syncData[key] = value;
+            }
+        }
+    }
+
     QVariantMap generateSyncData(int acceptedResponseId, const QVariantMap &data, QVariantMap &lastAcceptedData, QVariantMap &lastData)
     {
         QVariantMap syncData;
@@ -333,6 +426,58 @@ SyncController::SyncController(ISessionManager *sessionManager, QObject *parent)
     m_freeDiskSpaceThread->start();
     invokeChecker();
     m_freeDiskSpaceElapsedTimer.start();
+
+    m_eventFlushTimer.setSingleShot(true);
+    m_eventFlushTimer.setInterval(EVENT_FLUSH_DELAY);
+    connect(&m_eventFlushTimer, &QTimer::timeout, this, &SyncController::flushEvents);
+    m_eventHeartbeatTimer.setInterval(EVENT_HEARTBEAT_INTERVAL);
+    connect(&m_eventHeartbeatTimer, &QTimer::timeout, this, &SyncController::sendHeartbeat);
+
+    const BitTorrent::Session *const session = BitTorrent::Session::instance();
+    connect(session, &BitTorrent::Session::torrentsUpdated, this, [this](const QVector<BitTorrent::TorrentHandle *> &torrents)
+    {
+        for (BitTorrent::TorrentHandle *const torrent : torrents)
+            markTorrentChanged(torrent);
+    });
+    connect(session, &BitTorrent::Session::torrentAdded, this, &SyncController::markTorrentChanged);
+    connect(session, &BitTorrent::Session::torrentSavePathChanged, this, &SyncController::markTorrentChanged);
+    connect(session, &BitTorrent::Session::torrentCategoryChanged, this, &SyncController::markTorrentChanged);
+    connect(session, &BitTorrent::Session::torrentTagAdded, this, &SyncController::markTorrentChanged);
+    connect(session, &BitTorrent::Session::torrentTagRemoved, this, &SyncController::markTorrentChanged);
+    connect(session, &BitTorrent::Session::torrentSavingModeChanged, this, &SyncController::markTorrentChanged);
+    connect(session, &BitTorrent::Session::torrentMetadataLoaded, this, &SyncController::markTorrentChanged);
+    connect(session, &BitTorrent::Session::trackersAdded, this, &SyncController::markTorrentChanged);
+    connect(session, &BitTorrent::Session::trackersRemoved, this, &SyncController::markTorrentChanged);
+    connect(session, &BitTorrent::Session::trackersChanged, this, &SyncController::markTorrentChanged);
+    connect(session, &BitTorrent::Session::torrentAboutToBeRemoved, this, [this](BitTorrent::TorrentHandle *const torrent)
+    {
+        m_eventChangedTorrents.remove(torrent);
+        if (m_eventClients.isEmpty()) return;
+
+        m_eventRemovedTorrents.append(torrent->hash());
+        scheduleEventFlush();
+    });
+    connect(session, &BitTorrent::Session::categoryAdded, this, [this]()
+    {
+        m_isEventCategoriesChanged = true;
+        scheduleEventFlush();
+    });
+    connect(session, &BitTorrent::Session::categoryRemoved, this, [this]()
+    {
+        m_isEventCategoriesChanged = true;
+        scheduleEventFlush();
+    });
+    connect(session, &BitTorrent::Session::statsUpdated, this, [this]()
+    {
+        m_isEventServerStateChanged = true;
+        scheduleEventFlush();
+    });
+    connect(session, &BitTorrent::Session::speedLimitModeChanged, this, [this]()
+    {
+        m_isEventServerStateChanged = true;
+        scheduleEventFlush();
+    });
+    connect(session, &BitTorrent::Session::trackerError, this, &SyncController::sendTrackerError);
 }
 
 SyncController::~SyncController()
@@ -406,47 +551,7 @@ void SyncController::maindataAction()
     auto lastResponse = sessionManager()->session()->getData(QLatin1String("syncMainDataLastResponse")).toMap();
     auto lastAcceptedResponse = sessionManager()->session()->getData(QLatin1String("syncMainDataLastAcceptedResponse")).toMap();
 
-    QVariantMap data;
-    QVariantHash torrents;
-
-    BitTorrent::Session *const session = BitTorrent::Session::instance();
-
-    for (BitTorrent::TorrentHandle *const torrent : asConst(session->torrents())) {
-        QVariantMap map = serialize(*torrent);
-        map.remove(KEY_TORRENT_HASH);
-
-        // Calculated last activity time can differ from actual value by up to 10 seconds (this is a libtorrent issue).
-        // So we don't need unnecessary updates of last activity time in response.
-        if (lastResponse.contains("torrents") && lastResponse["torrents"].toHash().contains(torrent->hash()) &&
-                lastResponse["torrents"].toHash()[torrent->hash()].toMap().contains(KEY_TORRENT_LAST_ACTIVITY_TIME)) {
-            uint lastValue = lastResponse["torrents"].toHash()[torrent->hash()].toMap()[KEY_TORRENT_LAST_ACTIVITY_TIME].toUInt();
-            if (qAbs(static_cast<int>(lastValue - map[KEY_TORRENT_LAST_ACTIVITY_TIME].toUInt())) < 15)
-                map[KEY_TORRENT_LAST_ACTIVITY_TIME] = lastValue;
-        }
-
-        torrents[torrent->hash()] = map;
-    }
-
-    data["torrents"] = torrents;
-
-    QVariantHash categories;
-    const auto categoriesList = session->categories();
-    for (auto it = categoriesList.cbegin(); it != categoriesList.cend(); ++it) {
-        const auto key = it.key();
-        categories[key] = QVariantMap {
-            {"name", key},
-            {"savePath", it.value()}
-        };
-    }
-
-    data["categories"] = categories;
-
-    QVariantMap serverState = getTranserInfo();
-    serverState[KEY_TRANSFER_FREESPACEONDISK] = getFreeDiskSpace();
-    serverState[KEY_SYNC_MAINDATA_QUEUEING] = session->isQueueingSystemEnabled();
-    serverState[KEY_SYNC_MAINDATA_USE_ALT_SPEED_LIMITS] = session->isAltGlobalSpeedLimitEnabled();
-    serverState[KEY_SYNC_MAINDATA_REFRESH_INTERVAL] = session->refreshInterval();
-    data["server_state"] = serverState;
+    const QVariantMap data = mainData(lastResponse);
 
     const int acceptedResponseId {params()["rid"].toInt()};
     setResult(QJsonObject::fromVariantMap(generateSyncData(acceptedResponseId, data, lastAcceptedResponse, lastResponse)));
@@ -468,6 +573,8 @@ void SyncController::torrentPeersAction()
     if (!torrent)
         throw APIError(APIErrorType::NotFound);
 
+    torrent->requestFastRefresh();
+
     QVariantMap data;
     QVariantHash peers;
     const QList<BitTorrent::PeerInfo> peersList = torrent->peers();
@@ -538,3 +645,240 @@ void SyncController::invokeChecker() const
     QMetaObject::invokeMethod(m_freeDiskSpaceChecker, "check", Qt::QueuedConnection);
 #endif
 }
+
+QVariantMap SyncController::mainData(const QVariantMap &lastData)
+{
+    QVariantMap data;
+    QVariantHash torrents;
+
+    BitTorrent::Session *const session = BitTorrent::Session::instance();
+
+    const QVariantHash lastTorrents = lastData.value("torrents").toHash();
+    for (BitTorrent::TorrentHandle *const torrent : asConst(session->torrents()))
+        torrents[torrent->hash()] = torrentData(*torrent, lastTorrents.value(torrent->hash()).toMap());
+
+    data["torrents"] = torrents;
+    data["categories"] = categoriesData();
+    data["server_state"] = serverState();
+
+    return data;
+}
+
+QVariantMap SyncController::serverState()
+{
+    const BitTorrent::Session *const session = BitTorrent::Session::instance();
+
+    QVariantMap serverState = getTranserInfo();
+    serverState[KEY_TRANSFER_FREESPACEONDISK] = getFreeDiskSpace();
+    serverState[KEY_SYNC_MAINDATA_QUEUEING] = session->isQueueingSystemEnabled();
+    serverState[KEY_SYNC_MAINDATA_USE_ALT_SPEED_LIMITS] = session->isAltGlobalSpeedLimitEnabled();
+    serverState[KEY_SYNC_MAINDATA_REFRESH_INTERVAL] = session->refreshInterval();
+    return serverState;
+}
+
+// Event streams carry the same deltas as "maindata" (as "maindata" events), except that
+// the server keeps track of what each client has already received. Session signals are
+// coalesced into one delta per EVENT_FLUSH_DELAY, and nothing is computed while no
+// stream is open or sent while nothing changed. Only the torrents the session reports
+// as changed are serialized again, the server state and the categories only when they
+// may have changed. Everything is compared once per EVENT_FULL_SYNC_INTERVAL, for the
+// changes that come without a signal (e.g. new share limits).
+// A client whose connection can't keep up is skipped and later gets all the deltas it
+// missed merged into one. Reconnecting clients pass the last seen "rid" (or the
+// Last-Event-ID header) to resume, they get a full update if it is too old.
+// Tracker errors are sent as separate "tracker_error" events and aren't replayed.
+void SyncController::addEventStream(Http::EventStream *stream, const int acceptedResponseId)
+{
+    // the snapshot isn't updated while nobody listens
+    if (m_eventClients.isEmpty()) {
+        m_isEventFullSyncNeeded = true;
+        flushEvents();
+        m_eventHeartbeatTimer.start();
+    }
+
+    connect(stream, &QObject::destroyed, this, [this, stream]()
+    {
+        m_eventClients.erase(std::remove_if(m_eventClients.begin(), m_eventClients.end()
+            , [stream](const EventClient &client) { return (client.stream.isNull() || (client.stream.data() == stream)); })
+            , m_eventClients.end());
+
+        if (m_eventClients.isEmpty()) {
+            m_eventFlushTimer.stop();
+            m_eventHeartbeatTimer.stop();
+            m_eventChangedTorrents.clear();
+            m_eventRemovedTorrents.clear();
+        }
+    });
+    connect(stream, &Http::EventStream::drained, this, [this, stream]()
+    {
+        for (EventClient &client : m_eventClients) {
+            if (client.stream.data() == stream)
+                sendPendingEvents(client);
+        }
+    });
+
+    m_eventClients.append({stream, acceptedResponseId});
+    sendPendingEvents(m_eventClients.last());
+}
+
+void SyncController::scheduleEventFlush()
+{
+    if (!m_eventClients.isEmpty() && !m_eventFlushTimer.isActive())
+        m_eventFlushTimer.start();
+}
+
+void SyncController::markTorrentChanged(BitTorrent::TorrentHandle *const torrent)
+{
+    if (m_eventClients.isEmpty()) return;
+
+    m_eventChangedTorrents.insert(torrent);
+    scheduleEventFlush();
+}
+
+void SyncController::flushEvents()
+{
+    QVariantMap syncData;
+    if (m_isEventFullSyncNeeded || m_eventFullSyncTimer.hasExpired(EVENT_FULL_SYNC_INTERVAL)) {
+        const QVariantMap data = mainData(m_eventLastData);
+        processMap(m_eventLastData, data, syncData);
+        m_eventLastData = data;
+        m_isEventFullSyncNeeded = false;
+        m_eventFullSyncTimer.start();
+    }
+    else {
+        if (!m_eventChangedTorrents.isEmpty() || !m_eventRemovedTorrents.isEmpty()) {
+            // taken out, so that it isn't copied when modified
+            QVariantHash torrents = m_eventLastData.take(QLatin1String("torrents")).toHash();
+            QVariantMap changedTorrents;
+            for (BitTorrent::TorrentHandle *const torrent : asConst(m_eventChangedTorrents)) {
+                const QString hash = torrent->hash();
+                const QVariantMap lastTorrent = torrents.value(hash).toMap();
+                const QVariantMap map = torrentData(*torrent, lastTorrent);
+                if (lastTorrent.isEmpty()) {
+                    changedTorrents[hash] = map;
+                }
+                else {
+                    QVariantMap changes;
+                    processMap(lastTorrent, map, changes);
+                    if (!changes.isEmpty())
+                        changedTorrents[hash] = changes;
+                }
+                torrents[hash] = map;
+            }
+
+            QVariantList removedTorrents;
+            for (const QString &hash : asConst(m_eventRemovedTorrents)) {
+                if (torrents.remove(hash) > 0)
+                    removedTorrents << hash;
+            }
+
+            m_eventLastData[QLatin1String("torrents")] = torrents;
+            if (!changedTorrents.isEmpty())
+                syncData[QLatin1String("torrents")] = changedTorrents;
+            if (!removedTorrents.isEmpty())
+                syncData[QLatin1String("torrents") + QLatin1String(KEY_SUFFIX_REMOVED)] = removedTorrents;
+        }
+
+        if (m_isEventCategoriesChanged) {
+            const QVariantHash categories = categoriesData();
+            QVariantMap changedCategories;
+            QVariantList removedCategories;
+            processHash(m_eventLastData.value(QLatin1String("categories")).toHash(), categories, changedCategories, removedCategories);
+            m_eventLastData[QLatin1String("categories")] = categories;
+            if (!changedCategories.isEmpty())
+                syncData[QLatin1String("categories")] = changedCategories;
+            if (!removedCategories.isEmpty())
+                syncData[QLatin1String("categories") + QLatin1String(KEY_SUFFIX_REMOVED)] = removedCategories;
+        }
+
+        if (m_isEventServerStateChanged) {
+            const QVariantMap serverState = this->serverState();
+            QVariantMap changedServerState;
+            processMap(m_eventLastData.value(QLatin1String("server_state")).toMap(), serverState, changedServerState);
+            m_eventLastData[QLatin1String("server_state")] = serverState;
+            if (!changedServerState.isEmpty())
+                syncData[QLatin1String("server_state")] = changedServerState;
+        }
+    }
+
+    m_eventChangedTorrents.clear();
+    m_eventRemovedTorrents.clear();
+    m_isEventCategoriesChanged = false;
+    m_isEventServerStateChanged = false;
+    if (syncData.isEmpty())
+        return;
+
+    m_eventResponseId = m_eventResponseId % 1000000 + 1;  // cycle between 1 and 1000000
+    syncData[KEY_RESPONSE_ID] = m_eventResponseId;
+    m_eventHistory.append(syncData);
+    if (m_eventHistory.size() > EVENT_HISTORY_SIZE)
+        m_eventHistory.removeFirst();
+
+    for (EventClient &client : m_eventClients)
+        sendPendingEvents(client);
+}
+
+void SyncController::sendPendingEvents(EventClient &client)
+{
+    if (!client.stream || (client.responseId == m_eventResponseId))
+        return;
+
+    // backpressure, the client will catch up once its connection is drained
+    if (client.stream->pendingBytes() > EVENT_STREAM_MAX_PENDING_SIZE)
+        return;
+
+    int first = -1;
+    if (client.responseId > 0) {
+        for (int i = 0; i < m_eventHistory.size(); ++i) {
+            const int responseId = m_eventHistory[i][KEY_RESPONSE_ID].toInt();
+            if (responseId == client.responseId) {
+                first = i + 1;
+                break;
+            }
+            if (responseId == (client.responseId % 1000000 + 1)) {
+                first = i;
+                break;
+            }
+        }
+    }
+
+    QVariantMap syncData;
+    if (first >= 0) {
+        for (int i = first; i < m_eventHistory.size(); ++i)
+            mergeSyncData(syncData, m_eventHistory[i]);
+    }
+    else {
+        syncData = m_eventLastData;
+        syncData[KEY_FULL_UPDATE] = true;
+    }
+    syncData[KEY_RESPONSE_ID] = m_eventResponseId;
+
+    client.stream->sendEvent(QJsonDocument(QJsonObject::fromVariantMap(syncData)).toJson(QJsonDocument::Compact)
+                             , QByteArrayLiteral("maindata"), m_eventResponseId);
+    client.responseId = m_eventResponseId;
+}
+
+void SyncController::sendTrackerError(BitTorrent::TorrentHandle *const torrent, const QString &tracker)
+{
+    if (m_eventClients.isEmpty())
+        return;
+
+    const QJsonObject event {
+        {KEY_TORRENT_HASH, QString(torrent->hash())},
+        {KEY_TORRENT_TRACKER, tracker}
+    };
+    const QByteArray data = QJsonDocument(event).toJson(QJsonDocument::Compact);
+
+    for (const EventClient &client : asConst(m_eventClients)) {
+        if (client.stream && (client.stream->pendingBytes() <= EVENT_STREAM_MAX_PENDING_SIZE))
+            client.stream->sendEvent(data, QByteArrayLiteral("tracker_error"));
+    }
+}
+
+void SyncController::sendHeartbeat()
+{
+    for (const EventClient &client : asConst(m_eventClients)) {
+        if (client.stream)
+            client.stream->sendHeartbeat();
+    }
+}
@@ -29,6 +29,11 @@
 #pragma once
 
 #include <QElapsedTimer>
+#include <QPointer>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
 
 #include "apicontroller.h"
 
@@ -38,6 +43,16 @@ class QThread;
 
 class FreeDiskSpaceChecker;
 
+namespace BitTorrent
+{
+    class TorrentHandle;
+}
+
+namespace Http
+{
+    class EventStream;
+}
+
 class SyncController : public APIController
 {
     Q_OBJECT
@@ -49,6 +64,9 @@ public:
     explicit SyncController(ISessionManager *sessionManager, QObject *parent = nullptr);
     ~SyncController() override;
 
+    // Pushes "maindata" deltas to `stream` as they happen, starting after `acceptedResponseId`
+    void addEventStream(Http::EventStream *stream, int acceptedResponseId);
+
 private slots:
     void maindataAction();
     void torrentPeersAction();
@@ -57,9 +75,39 @@ private slots:
 private:
     qint64 getFreeDiskSpace();
     void invokeChecker() const;
+    QVariantMap mainData(const QVariantMap &lastData);
+    QVariantMap serverState();
+
+    // Event streams
+    struct EventClient
+    {
+        QPointer<Http::EventStream> stream;
+        int responseId;
+    };
+
+    void scheduleEventFlush();
+    void markTorrentChanged(BitTorrent::TorrentHandle *torrent);
+    void flushEvents();
+    void sendPendingEvents(EventClient &client);
+    void sendTrackerError(BitTorrent::TorrentHandle *torrent, const QString &tracker);
+    void sendHeartbeat();
 
     qint64 m_freeDiskSpace = 0;
     FreeDiskSpaceChecker *m_freeDiskSpaceChecker = nullptr;
     QThread *m_freeDiskSpaceThread = nullptr;
     QElapsedTimer m_freeDiskSpaceElapsedTimer;
+
+    QVector<EventClient> m_eventClients;
+    QVector<QVariantMap> m_eventHistory; // recent deltas, oldest first
+    QVariantMap m_eventLastData;
+    // what may have changed since the last delta
+    QSet<BitTorrent::TorrentHandle *> m_eventChangedTorrents;
+    QStringList m_eventRemovedTorrents;
+    bool m_isEventCategoriesChanged = false;
+    bool m_isEventServerStateChanged = false;
+    bool m_isEventFullSyncNeeded = true;
+    QElapsedTimer m_eventFullSyncTimer;
+    int m_eventResponseId = 0;
+    QTimer m_eventFlushTimer;
+    QTimer m_eventHeartbeatTimer;
 };
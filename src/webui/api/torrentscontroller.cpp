@@ -196,6 +196,25 @@ namespace
 
         return QVariantList {dht, pex, lsd};
     }
+
+    QJsonObject bandwidthClassesToJson(const QMap<QString, BitTorrent::BandwidthClass> &classes
+                                       , const QMap<QString, BitTorrent::BandwidthClassStatus> &statuses)
+    {
+        QJsonObject result;
+        for (auto it = classes.cbegin(); it != classes.cend(); ++it) {
+            const BitTorrent::BandwidthClassStatus status = statuses.value(it.key());
+            result[it.key()] = QJsonObject {
+                {"up_limit", it.value().uploadLimit},
+                {"dl_limit", it.value().downloadLimit},
+                {"min_up_share", it.value().minUploadShare},
+                {"min_dl_share", it.value().minDownloadShare},
+                {"up_speed", status.uploadRate},
+                {"dl_speed", status.downloadRate},
+                {"torrents", status.torrentsCount}
+            };
+        }
+        return result;
+    }
 }
 
 // Returns all the torrents in JSON format.
@@ -314,6 +333,8 @@ void TorrentsController::propertiesAction()
     if (!torrent)
         throw APIError(APIErrorType::NotFound);
 
+    torrent->requestFastRefresh();
+
     dataDict[KEY_PROP_TIME_ELAPSED] = torrent->activeTime();
     dataDict[KEY_PROP_SEEDING_TIME] = torrent->seedingTime();
     dataDict[KEY_PROP_ETA] = torrent->eta();
@@ -510,6 +531,8 @@ void TorrentsController::pieceStatesAction()
     if (!torrent)
         throw APIError(APIErrorType::NotFound);
 
+    torrent->requestFastRefresh();
+
     const QBitArray states = torrent->pieces();
     pieceStates.reserve(states.size());
     for (int i = 0; i < states.size(); ++i)
@@ -1038,3 +1061,36 @@ void TorrentsController::categoriesAction()
 
     setResult(categories);
 }
+
+// Returns the bandwidth classes of the categories and tags with their current throughput
+void TorrentsController::bandwidthClassesAction()
+{
+    const BitTorrent::Session *const session = BitTorrent::Session::instance();
+    setResult(QJsonObject {
+        {"categories", bandwidthClassesToJson(session->categoryBandwidthClasses(), session->categoryBandwidthStatus())},
+        {"tags", bandwidthClassesToJson(session->tagBandwidthClasses(), session->tagBandwidthStatus())}
+    });
+}
+
+// Sets the bandwidth class of a category or a tag, limits in bytes per second
+// and minimum shares in percent of the global limits. Omitted values are 0 (none).
+void TorrentsController::setBandwidthClassAction()
+{
+    const QString category {params()["category"].trimmed()};
+    const QString tag {params()["tag"].trimmed()};
+    if (category.isEmpty() == tag.isEmpty())
+        throw APIError(APIErrorType::BadParams, tr("Either a category or a tag is expected"));
+
+    BitTorrent::BandwidthClass bandwidthClass;
+    bandwidthClass.uploadLimit = params()["upLimit"].toInt();
+    bandwidthClass.downloadLimit = params()["dlLimit"].toInt();
+    bandwidthClass.minUploadShare = params()["minUpShare"].toInt();
+    bandwidthClass.minDownloadShare = params()["minDlShare"].toInt();
+
+    BitTorrent::Session *const session = BitTorrent::Session::instance();
+    const bool result = category.isEmpty()
+        ? session->setTagBandwidthClass(tag, bandwidthClass)
+        : session->setCategoryBandwidthClass(category, bandwidthClass);
+    if (!result)
+        throw APIError(APIErrorType::Conflict, tr("Unable to set bandwidth class"));
+}
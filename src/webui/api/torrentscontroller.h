@@ -56,6 +56,8 @@ private slots:
     void editCategoryAction();
     void removeCategoriesAction();
     void categoriesAction();
+    void bandwidthClassesAction();
+    void setBandwidthClassAction();
     void addAction();
     void deleteAction();
     void addTrackersAction();
@@ -0,0 +1,69 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "tracecontroller.h"
+
+#include <QJsonObject>
+
+#include "base/tracer.h"
+#include "base/utils/string.h"
+
+// Returns the latency histograms collected while tracing was enabled.
+// The return value is a dictionary:
+//   - "enabled": whether tracing is currently enabled
+//   - "uptime": milliseconds since the tracer was started
+//   - "categories": dictionary of categories ("session", "alert", "webapi", "gui", "eventloop"),
+//     each mapping traced names to "count", "total", "max", "p50", "p90", "p99" (microseconds)
+//     and "buckets" (log2 histogram of microseconds)
+void TraceController::statisticsAction()
+{
+    setResult(Tracer::instance()->statistics());
+}
+
+// Returns the most recent traced scopes in Chrome trace event format.
+// The result can be loaded in chrome://tracing or the Perfetto UI.
+void TraceController::exportAction()
+{
+    setResult(Tracer::instance()->chromeTrace());
+}
+
+// Enables or disables tracing. Collected data is kept.
+// POST params:
+//   - enabled (bool): new tracing state
+void TraceController::setEnabledAction()
+{
+    checkParams({"enabled"});
+
+    Tracer::instance()->setEnabled(Utils::String::parseBool(params()["enabled"], false));
+}
+
+// Discards all collected histograms and trace events
+void TraceController::resetAction()
+{
+    Tracer::instance()->reset();
+}
@@ -28,10 +28,16 @@
 
 #include "transfercontroller.h"
 
+#include <QDateTime>
+#include <QJsonArray>
 #include <QJsonObject>
+#include <QUrl>
 
+#include "base/global.h"
 #include "base/logger.h"
 #include "base/bittorrent/session.h"
+#include "base/bittorrent/timeseriesstore.h"
+#include "apierror.h"
 
 const char KEY_TRANSFER_DLSPEED[] = "dl_info_speed";
 const char KEY_TRANSFER_DLDATA[] = "dl_info_data";
@@ -146,3 +152,199 @@ void TransferController::resetIPFilterAction()
     BitTorrent::Session::instance()->eraseIPFilter();
     setResult(QLatin1String("Erased."));
 }
+
+// Returns the recorded transfer history in JSON format.
+// The return value is a JSON-formatted dictionary.
+// The dictionary keys are:
+//   - "step": seconds covered by each point
+//   - "series": names of the returned series
+//   - "points": array of [timestamp, value...] in the order of "series",
+//     rates are in bytes/s, timestamps in seconds since epoch
+// GET params:
+//   - from (int): start of the range (default one hour ago)
+//   - to (int): end of the range (default now)
+//   - resolution (string): "second", "minute" or "hour" (default the finest one covering "from")
+//   - series (string): series names separated by '|' (default all of them),
+//     e.g. "upload", "peers", "category/<name>/download", "tracker/<host>/upload"
+void TransferController::historyAction()
+{
+    using BitTorrent::TimeSeriesStore;
+
+    const TimeSeriesStore *history = BitTorrent::Session::instance()->transferHistory();
+    const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+
+    bool ok = false;
+    qint64 to = params()["to"].toLongLong(&ok);
+    if (!ok)
+        to = now;
+    qint64 from = params()["from"].toLongLong(&ok);
+    if (!ok)
+        from = to - 3600;
+
+    TimeSeriesStore::Resolution resolution = TimeSeriesStore::resolutionFor(from, now);
+    const QString resolutionParam = params()["resolution"];
+    if (resolutionParam == QLatin1String("second"))
+        resolution = TimeSeriesStore::Second;
+    else if (resolutionParam == QLatin1String("minute"))
+        resolution = TimeSeriesStore::Minute;
+    else if (resolutionParam == QLatin1String("hour"))
+        resolution = TimeSeriesStore::Hour;
+    else if (!resolutionParam.isEmpty())
+        throw APIError(APIErrorType::BadParams, tr("Unknown resolution"));
+
+    const QStringList seriesNames = params()["series"].isEmpty()
+            ? history->seriesNames()
+            : params()["series"].split('|', QString::SkipEmptyParts);
+
+    QVector<int> series;
+    series.reserve(seriesNames.size());
+    for (const QString &name : seriesNames) {
+        const int index = history->seriesIndex(name);
+        if (index < 0)
+            throw APIError(APIErrorType::NotFound, tr("Unknown series: %1").arg(name));
+        series.append(index);
+    }
+
+    QJsonArray points;
+    for (const TimeSeriesStore::Point &point : asConst(history->query(resolution, from, to, series))) {
+        QJsonArray values {point.timestamp};
+        for (const quint32 value : point.values)
+            values.append(static_cast<qint64>(value));
+        points.append(values);
+    }
+
+    setResult(QJsonObject {
+        {"step", TimeSeriesStore::step(resolution)},
+        {"series", QJsonArray::fromStringList(seriesNames)},
+        {"points", points}
+    });
+}
+
+// Returns the health of the trackers announced to by the torrents in JSON format.
+// The return value is a JSON-formatted array of dictionaries.
+// The dictionary keys are:
+//   - "url": Tracker URL
+//   - "replies": Number of successful announces
+//   - "failures": Number of failed announces
+//   - "success_rate": Smoothed share of the latest announces that succeeded
+//   - "latency": Smoothed announce time in ms, -1 if unknown
+//   - "peers": Smoothed number of peers per reply
+//   - "score": Score used to select the public trackers, 0 if dead
+//   - "dead": Whether the tracker keeps failing for hours
+//   - "selected": Whether the tracker is added to the public torrents
+//   - "host": Tracker host
+//   - "host_announce_rate": Announces to the host in the last minute
+//   - "host_backlog": Announces to the host waiting for a reply
+void TransferController::trackersAction()
+{
+    const BitTorrent::Session *const session = BitTorrent::Session::instance();
+    const QStringList selectedTrackers = session->selectedPublicTrackers();
+    const QHash<QString, BitTorrent::TrackerHealth> trackers = session->trackerHealth();
+    const QHash<QString, BitTorrent::TrackerLoad> hostLoads = session->trackerLoads();
+
+    QJsonArray result;
+    for (auto it = trackers.cbegin(); it != trackers.cend(); ++it) {
+        const BitTorrent::TrackerHealth &health = it.value();
+        const QString host = QUrl(it.key()).host();
+        const BitTorrent::TrackerLoad hostLoad = hostLoads.value(host);
+        result.append(QJsonObject {
+            {"url", it.key()},
+            {"replies", static_cast<qint64>(health.replies)},
+            {"failures", static_cast<qint64>(health.failures)},
+            {"success_rate", health.successRate},
+            {"latency", health.latency},
+            {"peers", health.peers},
+            {"score", health.score},
+            {"dead", health.isDead},
+            {"selected", selectedTrackers.contains(it.key())},
+            {"host", host},
+            {"host_announce_rate", hostLoad.announceRate},
+            {"host_backlog", hostLoad.backlog}
+        });
+    }
+
+    setResult(result);
+}
+
+// Returns the moves and deletions of torrent files in JSON format.
+// The return value is a JSON-formatted dictionary.
+// The dictionary keys are:
+//   - "queued": Number of jobs waiting for their turn
+//   - "running": Number of running jobs
+//   - "total_size": Bytes of the jobs, including the ones finished since the queue was last empty
+//   - "done_size": Bytes already moved or deleted
+//   - "jobs": array of dictionaries, in the order the jobs were queued, with keys:
+//       - "id": Job ID
+//       - "type": "move" or "removal"
+//       - "hash": Torrent hash
+//       - "name": Torrent name
+//       - "source": Path of the files
+//       - "destination": Path the files are moved to, empty for removals
+//       - "size": Bytes of the files
+//       - "done_size": Bytes already moved, measured from the files at the destination
+//       - "priority": Jobs of higher priority run first
+//       - "running": Whether the job is running
+void TransferController::storageJobsAction()
+{
+    const BitTorrent::Session *const session = BitTorrent::Session::instance();
+    const BitTorrent::StorageQueueStatus status = session->storageQueueStatus();
+
+    QJsonArray jobs;
+    for (const BitTorrent::StorageJob &job : asConst(session->storageJobs())) {
+        jobs.append(QJsonObject {
+            {"id", job.id},
+            {"type", (job.type == BitTorrent::StorageJob::Move) ? QLatin1String("move") : QLatin1String("removal")},
+            {"hash", QString(job.hash)},
+            {"name", job.name},
+            {"source", job.sourcePath},
+            {"destination", job.destinationPath},
+            {"size", job.size},
+            {"done_size", job.doneSize},
+            {"priority", job.priority},
+            {"running", job.isRunning}
+        });
+    }
+
+    setResult(QJsonObject {
+        {"queued", status.queued},
+        {"running", status.running},
+        {"total_size", status.totalSize},
+        {"done_size", status.doneSize},
+        {"jobs", jobs}
+    });
+}
+
+// POST params:
+//   - id (int): Job ID, only queued jobs can be cancelled
+//     and a cancelled removal keeps the files on disk
+void TransferController::cancelStorageJobAction()
+{
+    checkParams({"id"});
+
+    bool ok = false;
+    const int id = params()["id"].toInt(&ok);
+    if (!ok)
+        throw APIError(APIErrorType::BadParams, tr("Job ID must be an integer"));
+
+    if (!BitTorrent::Session::instance()->cancelStorageJob(id))
+        throw APIError(APIErrorType::Conflict, tr("Job is running or doesn't exist"));
+}
+
+// POST params:
+//   - id (int): Job ID
+//   - priority (int): Jobs of higher priority run first, 0 by default
+void TransferController::setStorageJobPriorityAction()
+{
+    checkParams({"id", "priority"});
+
+    bool ok = false;
+    const int id = params()["id"].toInt(&ok);
+    if (!ok)
+        throw APIError(APIErrorType::BadParams, tr("Job ID must be an integer"));
+    const int priority = params()["priority"].toInt(&ok);
+    if (!ok)
+        throw APIError(APIErrorType::BadParams, tr("Priority must be an integer"));
+
+    if (!BitTorrent::Session::instance()->setStorageJobPriority(id, priority))
+        throw APIError(APIErrorType::NotFound);
+}
@@ -48,4 +48,9 @@ private slots:
     void setDownloadLimitAction();
     void tempblockPeerAction();
     void resetIPFilterAction();
+    void historyAction();
+    void trackersAction();
+    void storageJobsAction();
+    void cancelStorageJobAction();
+    void setStorageJobPriorityAction();
 };
@@ -0,0 +1,229 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "metricsexporter.h"
+
+#include <QtGlobal>
+
+#include "base/bittorrent/session.h"
+#include "torrentfilestream.h"
+
+namespace
+{
+    const int BUFFER_SIZE = 128 * 1024;
+
+    // Upper bounds of the request duration buckets, in microseconds
+    const qint64 REQUEST_BUCKETS[] = {1000, 5000, 10000, 50000, 100000, 500000, 1000000};
+    const char *const REQUEST_BUCKET_LABELS[] = {
+        "le=\"0.001\"", "le=\"0.005\"", "le=\"0.01\"", "le=\"0.05\"", "le=\"0.1\"", "le=\"0.5\"", "le=\"1\""
+    };
+    const int REQUEST_BUCKET_COUNT = sizeof(REQUEST_BUCKETS) / sizeof(REQUEST_BUCKETS[0]);
+}
+
+MetricsExporter::MetricsExporter()
+    : m_requestBuckets(REQUEST_BUCKET_COUNT, 0)
+{
+    m_buffer.reserve(BUFFER_SIZE);
+}
+
+void MetricsExporter::addWebAPIRequest(const qint64 elapsedMicroseconds)
+{
+    for (int i = 0; i < REQUEST_BUCKET_COUNT; ++i) {
+        if (elapsedMicroseconds <= REQUEST_BUCKETS[i])
+            ++m_requestBuckets[i];
+    }
+    ++m_requestCount;
+    m_requestTimeSum += elapsedMicroseconds;
+}
+
+const QByteArray &MetricsExporter::render()
+{
+    const BitTorrent::Session *const session = BitTorrent::Session::instance();
+
+    // keeps the reserved capacity, so no reallocation happens once the buffer is large enough
+    m_buffer.resize(0);
+
+    const BitTorrent::TorrentStatusReport report = session->torrentStatusReport();
+    appendFamily("qbittorrent_torrents", "gauge", "Number of torrents by status.");
+    appendValue("qbittorrent_torrents", "status=\"all\"", qint64(session->torrents().size()));
+    appendValue("qbittorrent_torrents", "status=\"downloading\"", qint64(report.nbDownloading));
+    appendValue("qbittorrent_torrents", "status=\"seeding\"", qint64(report.nbSeeding));
+    appendValue("qbittorrent_torrents", "status=\"completed\"", qint64(report.nbCompleted));
+    appendValue("qbittorrent_torrents", "status=\"resumed\"", qint64(report.nbResumed));
+    appendValue("qbittorrent_torrents", "status=\"paused\"", qint64(report.nbPaused));
+    appendValue("qbittorrent_torrents", "status=\"active\"", qint64(report.nbActive));
+    appendValue("qbittorrent_torrents", "status=\"inactive\"", qint64(report.nbInactive));
+    appendValue("qbittorrent_torrents", "status=\"errored\"", qint64(report.nbErrored));
+
+    appendFamily("qbittorrent_alert_queue_depth", "gauge", "Number of alerts handled in the last batch.");
+    appendValue("qbittorrent_alert_queue_depth", nullptr, qint64(session->alertQueueDepth()));
+
+    const BitTorrent::AlertStatistics alertStatistics = session->alertStatistics();
+    appendFamily("qbittorrent_alerts", "counter", "Number of alerts popped from libtorrent.");
+    appendValue("qbittorrent_alerts_total", "outcome=\"handled\"", qint64(alertStatistics.received - alertStatistics.collapsed));
+    appendValue("qbittorrent_alerts_total", "outcome=\"collapsed\"", qint64(alertStatistics.collapsed));
+    appendFamily("qbittorrent_alert_batches", "counter", "Number of alert batches handed to the main thread.");
+    appendValue("qbittorrent_alert_batches_total", nullptr, qint64(alertStatistics.batches));
+    appendFamily("qbittorrent_alert_batch_size_max", "gauge", "Largest alert batch popped from libtorrent.");
+    appendValue("qbittorrent_alert_batch_size_max", nullptr, qint64(alertStatistics.largestBatch));
+
+    const BitTorrent::AddTorrentPipelineStatus pipelineStatus = session->addTorrentPipelineStatus();
+    appendFamily("qbittorrent_adding_torrents", "gauge", "Number of torrents on their way into the session.");
+    appendValue("qbittorrent_adding_torrents", "stage=\"decoding\"", qint64(pipelineStatus.decoding));
+    appendValue("qbittorrent_adding_torrents", "stage=\"waiting\"", qint64(pipelineStatus.waiting));
+    appendValue("qbittorrent_adding_torrents", "stage=\"adding\"", qint64(pipelineStatus.adding));
+    appendValue("qbittorrent_adding_torrents", "stage=\"verifying\"", qint64(pipelineStatus.verifying));
+    appendFamily("qbittorrent_torrent_files_pending", "gauge", "Number of torrent file backups and exports not written yet.");
+    appendValue("qbittorrent_torrent_files_pending", nullptr, qint64(pipelineStatus.writing));
+    appendFamily("qbittorrent_torrent_additions", "counter", "Number of new torrents added or refused.");
+    appendValue("qbittorrent_torrent_additions_total", "outcome=\"added\"", qint64(pipelineStatus.added));
+    appendValue("qbittorrent_torrent_additions_total", "outcome=\"failed\"", qint64(pipelineStatus.failed));
+
+    const BitTorrent::StorageQueueStatus storageQueueStatus = session->storageQueueStatus();
+    appendFamily("qbittorrent_storage_jobs", "gauge", "Number of torrent file moves and deletions.");
+    appendValue("qbittorrent_storage_jobs", "state=\"queued\"", qint64(storageQueueStatus.queued));
+    appendValue("qbittorrent_storage_jobs", "state=\"running\"", qint64(storageQueueStatus.running));
+    appendFamily("qbittorrent_storage_job_bytes", "gauge", "Bytes of the torrent file moves and deletions since their queue was last empty.");
+    appendValue("qbittorrent_storage_job_bytes", "state=\"total\"", storageQueueStatus.totalSize);
+    appendValue("qbittorrent_storage_job_bytes", "state=\"done\"", storageQueueStatus.doneSize);
+
+    appendFamily("qbittorrent_resume_data_pending", "gauge", "Number of torrents waiting for their resume data to be saved.");
+    appendValue("qbittorrent_resume_data_pending", nullptr, qint64(session->pendingResumeDataCount()));
+
+    appendFamily("qbittorrent_banned_ips", "gauge", "Number of banned IP addresses.");
+    appendValue("qbittorrent_banned_ips", "kind=\"manual\"", qint64(session->bannedIPs().size()));
+    appendValue("qbittorrent_banned_ips", "kind=\"temporary\"", qint64(session->temporaryBannedIPsCount()));
+
+    const BitTorrent::LeecherStatistics leecherStatistics = session->leecherStatistics();
+    appendFamily("qbittorrent_leecher_tracked_peers", "gauge", "Number of peers watched by the leecher detection.");
+    appendValue("qbittorrent_leecher_tracked_peers", nullptr, qint64(leecherStatistics.trackedPeers));
+    appendFamily("qbittorrent_leecher_detections", "counter", "Number of peers whose progress didn't match the data they got.");
+    appendValue("qbittorrent_leecher_detections_total", "outcome=\"flagged\"", qint64(leecherStatistics.flagged));
+    appendValue("qbittorrent_leecher_detections_total", "outcome=\"banned\"", qint64(leecherStatistics.banned));
+    appendValue("qbittorrent_leecher_detections_total", "outcome=\"false_positive\"", qint64(leecherStatistics.falsePositives));
+
+    const BitTorrent::MetadataStatistics metadataStatistics = session->metadataStatistics();
+    appendFamily("qbittorrent_metadata_cache_lookups", "counter", "Number of magnet links looked up in the metadata cache.");
+    appendValue("qbittorrent_metadata_cache_lookups_total", "outcome=\"hit\"", qint64(metadataStatistics.cacheHits));
+    appendValue("qbittorrent_metadata_cache_lookups_total", "outcome=\"miss\"", qint64(metadataStatistics.cacheMisses));
+    appendFamily("qbittorrent_metadata_cache_entries", "gauge", "Number of torrents in the metadata cache.");
+    appendValue("qbittorrent_metadata_cache_entries", nullptr, qint64(metadataStatistics.cachedTorrents));
+    appendFamily("qbittorrent_metadata_cache_bytes", "gauge", "Size of the metadata cache.");
+    appendValue("qbittorrent_metadata_cache_bytes", nullptr, metadataStatistics.cacheSize);
+    appendFamily("qbittorrent_metadata_fetches", "gauge", "Number of magnet links waiting for their metadata.");
+    appendValue("qbittorrent_metadata_fetches", "state=\"active\"", qint64(metadataStatistics.activeFetches));
+    appendValue("qbittorrent_metadata_fetches", "state=\"queued\"", qint64(metadataStatistics.queuedFetches));
+    appendFamily("qbittorrent_metadata_fetch_timeouts", "counter", "Number of metadata downloads given up after the timeout.");
+    appendValue("qbittorrent_metadata_fetch_timeouts_total", nullptr, qint64(metadataStatistics.timedOut));
+    appendFamily("qbittorrent_metadata_fetch_seconds", "summary", "Time taken to download the metadata of magnet links.");
+    appendValue("qbittorrent_metadata_fetch_seconds_count", nullptr, qint64(metadataStatistics.fetched));
+    appendValue("qbittorrent_metadata_fetch_seconds_sum", nullptr, (metadataStatistics.fetchTime / 1e3));
+
+    appendFamily("qbittorrent_webapi_request_duration_seconds", "histogram", "Time spent handling WebAPI requests.");
+    for (int i = 0; i < REQUEST_BUCKET_COUNT; ++i)
+        appendValue("qbittorrent_webapi_request_duration_seconds_bucket", REQUEST_BUCKET_LABELS[i], m_requestBuckets[i]);
+    appendValue("qbittorrent_webapi_request_duration_seconds_bucket", "le=\"+Inf\"", m_requestCount);
+    appendValue("qbittorrent_webapi_request_duration_seconds_count", nullptr, m_requestCount);
+    appendValue("qbittorrent_webapi_request_duration_seconds_sum", nullptr, (m_requestTimeSum / 1e6));
+
+    const TorrentFileStream::Statistics &streamStatistics = TorrentFileStream::statistics();
+    appendFamily("qbittorrent_streams", "counter", "Number of torrent file streams opened.");
+    appendValue("qbittorrent_streams_total", nullptr, streamStatistics.streams);
+    appendFamily("qbittorrent_stream_sent_bytes", "counter", "Number of bytes sent by torrent file streams.");
+    appendValue("qbittorrent_stream_sent_bytes_total", nullptr, streamStatistics.sentBytes);
+    appendFamily("qbittorrent_stream_first_byte_seconds", "summary", "Time from opening a torrent file stream to its first byte.");
+    appendValue("qbittorrent_stream_first_byte_seconds_count", nullptr, streamStatistics.firstBytes);
+    appendValue("qbittorrent_stream_first_byte_seconds_sum", nullptr, (streamStatistics.firstByteTime / 1e6));
+    appendFamily("qbittorrent_stream_stall_seconds", "summary", "Time torrent file streams spent waiting for pieces after their first byte.");
+    appendValue("qbittorrent_stream_stall_seconds_count", nullptr, streamStatistics.stalls);
+    appendValue("qbittorrent_stream_stall_seconds_sum", nullptr, (streamStatistics.stallTime / 1e6));
+
+    const QVector<BitTorrent::SessionMetric> &metrics = session->sessionMetrics();
+    if (m_sessionMetricPrefixes.size() != metrics.size())
+        prepareSessionMetrics();
+
+    const QVector<qint64> &counters = session->sessionCounters();
+    for (int i = 0; i < metrics.size(); ++i) {
+        const int index = metrics[i].valueIndex;
+        if ((index < 0) || (index >= counters.size()))
+            continue;
+
+        char value[32];
+        const int length = qsnprintf(value, sizeof(value), "%lld\n", static_cast<long long>(counters[index]));
+        m_buffer.append(m_sessionMetricPrefixes[i]);
+        m_buffer.append(value, length);
+    }
+
+    m_buffer.append("# EOF\n");
+    return m_buffer;
+}
+
+void MetricsExporter::prepareSessionMetrics()
+{
+    const QVector<BitTorrent::SessionMetric> &metrics = BitTorrent::Session::instance()->sessionMetrics();
+
+    m_sessionMetricPrefixes.clear();
+    m_sessionMetricPrefixes.reserve(metrics.size());
+    for (const BitTorrent::SessionMetric &metric : metrics) {
+        // "net.sent_bytes" -> "libtorrent_net_sent_bytes"
+        QByteArray name = "libtorrent_" + metric.name;
+        name.replace('.', '_');
+
+        QByteArray prefix = "# TYPE " + name + (metric.isGauge ? " gauge\n" : " counter\n");
+        prefix += name + (metric.isGauge ? " " : "_total ");
+        m_sessionMetricPrefixes.append(prefix);
+    }
+}
+
+void MetricsExporter::appendFamily(const char *name, const char *type, const char *help)
+{
+    m_buffer.append("# TYPE ").append(name).append(' ').append(type).append('\n');
+    m_buffer.append("# HELP ").append(name).append(' ').append(help).append('\n');
+}
+
+void MetricsExporter::appendValue(const char *name, const char *labels, const qint64 value)
+{
+    char text[32];
+    const int length = qsnprintf(text, sizeof(text), " %lld\n", static_cast<long long>(value));
+
+    m_buffer.append(name);
+    if (labels)
+        m_buffer.append('{').append(labels).append('}');
+    m_buffer.append(text, length);
+}
+
+void MetricsExporter::appendValue(const char *name, const char *labels, const double value)
+{
+    char text[48];
+    const int length = qsnprintf(text, sizeof(text), " %.6f\n", value);
+
+    m_buffer.append(name);
+    if (labels)
+        m_buffer.append('{').append(labels).append('}');
+    m_buffer.append(text, length);
+}
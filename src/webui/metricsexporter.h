@@ -0,0 +1,59 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QVector>
+
+// Renders application and libtorrent statistics in the OpenMetrics text format.
+// The output buffer and the constant parts of the text are prepared once
+// and reused by every scrape.
+class MetricsExporter
+{
+public:
+    MetricsExporter();
+
+    const QByteArray &render();
+    void addWebAPIRequest(qint64 elapsedMicroseconds);
+
+private:
+    void prepareSessionMetrics();
+    void appendFamily(const char *name, const char *type, const char *help);
+    void appendValue(const char *name, const char *labels, qint64 value);
+    void appendValue(const char *name, const char *labels, double value);
+
+    QByteArray m_buffer;
+    // "# TYPE ...\n<name> " for each libtorrent metric, in Session::sessionMetrics() order
+    QVector<QByteArray> m_sessionMetricPrefixes;
+
+    // WebAPI request duration histogram
+    QVector<qint64> m_requestBuckets;
+    qint64 m_requestCount = 0;
+    qint64 m_requestTimeSum = 0; // microseconds
+};
@@ -0,0 +1,296 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "torrentfilestream.h"
+
+#include <algorithm>
+
+#include <QDir>
+
+#include "base/bittorrent/session.h"
+#include "base/bittorrent/torrenthandle.h"
+#include "base/bittorrent/torrentinfo.h"
+#include "base/global.h"
+#include "base/utils/fs.h"
+
+namespace
+{
+    // Amount of data following the read position that is requested with deadlines
+    const qint64 READ_AHEAD_SIZE = 16 * 1024 * 1024;
+    const int MIN_READ_AHEAD_PIECES = 2;
+    // Deadline increment between consecutive pieces of the read-ahead window
+    const int DEADLINE_STEP = 500; // milliseconds
+    // Files are renamed when they complete, so failed disk reads are retried.
+    // Pending pieces of a stalled stream are re-checked as often.
+    const int RETRY_INTERVAL = 500; // milliseconds
+
+    TorrentFileStream::Statistics streamStatistics;
+
+    // Streams of the same torrent may wait for the same pieces,
+    // so a deadline is only reset once no stream holds it anymore
+    QHash<BitTorrent::TorrentHandle *, QHash<int, int>> deadlineHolders;
+
+    void holdDeadline(BitTorrent::TorrentHandle *torrent, const int piece, const int msecs)
+    {
+        torrent->setPieceDeadline(piece, msecs);
+        ++deadlineHolders[torrent][piece];
+    }
+
+    void releaseDeadline(BitTorrent::TorrentHandle *torrent, const int piece, const bool reset)
+    {
+        const auto torrentIter = deadlineHolders.find(torrent);
+        if (torrentIter == deadlineHolders.end()) return;
+
+        const auto pieceIter = torrentIter->find(piece);
+        if (pieceIter == torrentIter->end()) return;
+        if (--(*pieceIter) > 0) return;
+
+        torrentIter->erase(pieceIter);
+        if (torrentIter->isEmpty())
+            deadlineHolders.erase(torrentIter);
+        if (reset)
+            torrent->resetPieceDeadline(piece);
+    }
+}
+
+TorrentFileStream::TorrentFileStream(BitTorrent::TorrentHandle *torrent, const int fileIndex
+                                     , const qint64 from, const qint64 to, QObject *parent)
+    : Http::ContentSource {parent}
+    , m_torrent {torrent}
+    , m_fileIndex {fileIndex}
+    , m_fileOffset {torrent->info().fileOffset(fileIndex)}
+    , m_pieceLength {torrent->pieceLength()}
+    , m_readAheadPieces {static_cast<int>(std::max<qint64>(MIN_READ_AHEAD_PIECES, (READ_AHEAD_SIZE / m_pieceLength)))}
+    , m_position {from}
+    , m_end {to + 1}
+    , m_lastPiece {static_cast<int>((m_fileOffset + std::max(m_end, qint64(1)) - 1) / m_pieceLength)}
+    , m_havePieces {torrent->pieces()}
+{
+    ++streamStatistics.streams;
+    m_firstByteTimer.start();
+
+    m_retryTimer.setSingleShot(true);
+    m_retryTimer.setInterval(RETRY_INTERVAL);
+    connect(&m_retryTimer, &QTimer::timeout, this, &TorrentFileStream::checkPendingPieces);
+
+    const BitTorrent::Session *const session = BitTorrent::Session::instance();
+    connect(session, &BitTorrent::Session::torrentPieceRead, this, &TorrentFileStream::handlePieceRead);
+    connect(session, &BitTorrent::Session::torrentAboutToBeRemoved, this, &TorrentFileStream::handleTorrentAboutToBeRemoved);
+}
+
+TorrentFileStream::~TorrentFileStream()
+{
+    if (m_stallTimer.isValid()) {
+        ++streamStatistics.stalls;
+        streamStatistics.stallTime += m_stallTimer.nsecsElapsed() / 1000;
+    }
+
+    resetDeadlines();
+}
+
+qint64 TorrentFileStream::bytesLeft() const
+{
+    return (m_end - m_position);
+}
+
+QByteArray TorrentFileStream::read(const qint64 maxSize)
+{
+    if (!m_torrent || (m_position >= m_end)) return {};
+
+    const qint64 torrentOffset = m_fileOffset + m_position;
+    const int piece = static_cast<int>(torrentOffset / m_pieceLength);
+    const qint64 pieceOffset = torrentOffset - (piece * m_pieceLength);
+    const qint64 size = std::min({maxSize, bytesLeft(), (m_pieceLength - pieceOffset)});
+
+    updateReadAhead(piece);
+
+    QByteArray data;
+    const auto pieceDataIter = m_pieceData.constFind(piece);
+    if (pieceDataIter != m_pieceData.constEnd())
+        data = pieceDataIter->mid(pieceOffset, size);
+    else if (isPieceOnDisk(piece))
+        data = readFromDisk(size);
+
+    if (data.isEmpty()) {
+        // waiting for the first byte isn't a stall
+        if (m_isFirstByteSent && !m_stallTimer.isValid())
+            m_stallTimer.start();
+        if (!m_deadlinePieces.isEmpty() && !m_retryTimer.isActive())
+            m_retryTimer.start();
+        return {};
+    }
+
+    if (!m_isFirstByteSent) {
+        m_isFirstByteSent = true;
+        ++streamStatistics.firstBytes;
+        streamStatistics.firstByteTime += m_firstByteTimer.nsecsElapsed() / 1000;
+    }
+    if (m_stallTimer.isValid()) {
+        ++streamStatistics.stalls;
+        streamStatistics.stallTime += m_stallTimer.nsecsElapsed() / 1000;
+        m_stallTimer.invalidate();
+    }
+
+    m_position += data.size();
+    streamStatistics.sentBytes += data.size();
+    if ((pieceOffset + data.size()) >= m_pieceLength)
+        m_pieceData.remove(piece);
+
+    return data;
+}
+
+const TorrentFileStream::Statistics &TorrentFileStream::statistics()
+{
+    return streamStatistics;
+}
+
+void TorrentFileStream::handlePieceRead(BitTorrent::TorrentHandle *torrent, const int index, const QByteArray &data)
+{
+    if ((torrent != m_torrent) || !m_deadlinePieces.contains(index)) return;
+
+    m_deadlinePieces.remove(index);
+    m_readPieces.remove(index);
+    releaseDeadline(m_torrent, index, false);
+    m_pieceData[index] = data;
+    emit readyRead();
+}
+
+void TorrentFileStream::handleTorrentAboutToBeRemoved(BitTorrent::TorrentHandle *torrent)
+{
+    if (torrent != m_torrent) return;
+
+    deadlineHolders.remove(m_torrent);
+    m_torrent = nullptr;
+    m_deadlinePieces.clear();
+    m_readPieces.clear();
+    emit failed();
+}
+
+void TorrentFileStream::checkPendingPieces()
+{
+    if (!m_torrent) return;
+
+    for (auto i = m_deadlinePieces.begin(); i != m_deadlinePieces.end();) {
+        const int piece = *i;
+        if (!m_torrent->havePiece(piece)) {
+            // another stream or a recheck may have dropped the deadline
+            m_torrent->setPieceDeadline(piece, (std::max(0, (piece - m_windowStart)) * DEADLINE_STEP));
+            ++i;
+        }
+        else if (!m_readPieces.contains(piece)) {
+            // the piece is complete but its data never arrived
+            m_readPieces.insert(piece);
+            m_torrent->readPiece(piece);
+            ++i;
+        }
+        else {
+            // reading it through libtorrent failed as well, try the file itself
+            if (piece < m_havePieces.size())
+                m_havePieces.setBit(piece);
+            m_readPieces.remove(piece);
+            releaseDeadline(m_torrent, piece, false);
+            i = m_deadlinePieces.erase(i);
+        }
+    }
+
+    emit readyRead();
+}
+
+void TorrentFileStream::updateReadAhead(const int currentPiece)
+{
+    if (currentPiece == m_windowStart) return;
+    m_windowStart = currentPiece;
+
+    // pieces behind the read position aren't needed anymore
+    for (auto i = m_deadlinePieces.begin(); i != m_deadlinePieces.end();) {
+        if (*i < currentPiece) {
+            m_readPieces.remove(*i);
+            releaseDeadline(m_torrent, *i, true);
+            i = m_deadlinePieces.erase(i);
+        }
+        else {
+            ++i;
+        }
+    }
+    for (auto i = m_pieceData.begin(); i != m_pieceData.end();) {
+        if (i.key() < currentPiece)
+            i = m_pieceData.erase(i);
+        else
+            ++i;
+    }
+
+    const int windowEnd = std::min(m_lastPiece, (currentPiece + m_readAheadPieces - 1));
+    for (int piece = currentPiece; piece <= windowEnd; ++piece) {
+        if (isPieceOnDisk(piece) || m_deadlinePieces.contains(piece) || m_pieceData.contains(piece))
+            continue;
+
+        // the closer to the read position the sooner it's needed
+        holdDeadline(m_torrent, piece, ((piece - currentPiece) * DEADLINE_STEP));
+        m_deadlinePieces.insert(piece);
+    }
+}
+
+bool TorrentFileStream::isPieceOnDisk(const int index) const
+{
+    return ((index < m_havePieces.size()) && m_havePieces.testBit(index));
+}
+
+QByteArray TorrentFileStream::readFromDisk(const qint64 size)
+{
+    const QString path = Utils::Fs::expandPathAbs(QDir(m_torrent->savePath(true)).absoluteFilePath(m_torrent->filePath(m_fileIndex)));
+    if (m_file.fileName() != path) {
+        m_file.close();
+        m_file.setFileName(path);
+    }
+
+    if (!m_file.isOpen() && !m_file.open(QIODevice::ReadOnly)) {
+        m_retryTimer.start();
+        return {};
+    }
+
+    QByteArray data(size, Qt::Uninitialized);
+    const qint64 readSize = m_file.seek(m_position) ? m_file.read(data.data(), size) : -1;
+    if (readSize <= 0) {
+        m_file.close();
+        m_retryTimer.start();
+        return {};
+    }
+
+    data.resize(readSize);
+    return data;
+}
+
+void TorrentFileStream::resetDeadlines()
+{
+    if (!m_torrent) return;
+
+    for (const int piece : asConst(m_deadlinePieces))
+        releaseDeadline(m_torrent, piece, true);
+    m_deadlinePieces.clear();
+    m_readPieces.clear();
+}
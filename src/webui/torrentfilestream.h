@@ -0,0 +1,104 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2018  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QBitArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+
+#include "base/http/contentsource.h"
+
+namespace BitTorrent
+{
+    class TorrentHandle;
+}
+
+// Sends a byte range of a torrent file while the torrent downloads.
+// Pieces of a read-ahead window following the read position get libtorrent deadlines.
+// Pieces libtorrent already had when the stream started are read from disk,
+// the ones completed later are sent from the data libtorrent hands over.
+// A stalled stream re-checks its pending pieces, since libtorrent may never
+// hand over a piece, e.g. after a read error.
+class TorrentFileStream : public Http::ContentSource
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(TorrentFileStream)
+
+public:
+    struct Statistics
+    {
+        qint64 streams = 0;
+        qint64 firstBytes = 0;
+        qint64 firstByteTime = 0; // microseconds
+        qint64 stalls = 0;
+        qint64 stallTime = 0; // microseconds
+        qint64 sentBytes = 0;
+    };
+
+    // `from` and `to` are offsets within the file, both inclusive
+    TorrentFileStream(BitTorrent::TorrentHandle *torrent, int fileIndex, qint64 from, qint64 to, QObject *parent = nullptr);
+    ~TorrentFileStream() override;
+
+    qint64 bytesLeft() const override;
+    QByteArray read(qint64 maxSize) override;
+
+    // Totals of all the streams so far
+    static const Statistics &statistics();
+
+private:
+    void handlePieceRead(BitTorrent::TorrentHandle *torrent, int index, const QByteArray &data);
+    void handleTorrentAboutToBeRemoved(BitTorrent::TorrentHandle *torrent);
+    void checkPendingPieces();
+    void updateReadAhead(int currentPiece);
+    bool isPieceOnDisk(int index) const;
+    QByteArray readFromDisk(qint64 size);
+    void resetDeadlines();
+
+    BitTorrent::TorrentHandle *m_torrent; // null once the torrent is removed
+    const int m_fileIndex;
+    const qint64 m_fileOffset; // within the torrent
+    const qint64 m_pieceLength;
+    const int m_readAheadPieces;
+    qint64 m_position;
+    const qint64 m_end;
+    const int m_lastPiece;
+    int m_windowStart = -1;
+    QBitArray m_havePieces; // when the stream started
+    QHash<int, QByteArray> m_pieceData;
+    QSet<int> m_deadlinePieces;
+    QSet<int> m_readPieces; // pending pieces requested again with TorrentHandle::readPiece()
+    QFile m_file;
+    QTimer m_retryTimer;
+    QElapsedTimer m_firstByteTimer;
+    QElapsedTimer m_stallTimer;
+    bool m_isFirstByteSent = false;
+};
@@ -34,8 +34,10 @@
 #include <stdexcept>
 #include <vector>
 
+#include <QCryptographicHash>
 #include <QDateTime>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QJsonDocument>
@@ -44,13 +46,20 @@
 #include <QRegExp>
 #include <QUrl>
 
+#include "base/bittorrent/session.h"
+#include "base/bittorrent/torrenthandle.h"
 #include "base/global.h"
+#include "base/http/contentsource.h"
+#include "base/http/eventstream.h"
 #include "base/http/httperror.h"
+#include "base/http/responsegenerator.h"
 #include "base/iconprovider.h"
 #include "base/logger.h"
 #include "base/preferences.h"
+#include "base/tracer.h"
 #include "base/utils/bytearray.h"
 #include "base/utils/fs.h"
+#include "base/utils/gzip.h"
 #include "base/utils/misc.h"
 #include "base/utils/random.h"
 #include "base/utils/string.h"
@@ -62,9 +71,15 @@
 #include "api/searchcontroller.h"
 #include "api/synccontroller.h"
 #include "api/torrentscontroller.h"
+#include "api/tracecontroller.h"
 #include "api/transfercontroller.h"
+#include "torrentfilestream.h"
 
 constexpr int MAX_ALLOWED_FILESIZE = 10 * 1024 * 1024;
+constexpr int MAX_EVENT_STREAMS = 32;
+// An alternative UI can have any number of files
+constexpr int MAX_CACHED_FILES = 256;
+constexpr qint64 MAX_CACHED_FILES_SIZE = 32 * 1024 * 1024;
 
 const QString PATH_PREFIX_IMAGES {QStringLiteral("/images/")};
 const QString WWW_FOLDER {QStringLiteral(":/www")};
@@ -113,6 +128,74 @@ namespace
 
         return QLatin1String("no-store");
     }
+
+    bool parseByteRange(const QString &value, const qint64 size, qint64 &from, qint64 &to)
+    {
+        // [rfc7233] 2.1. Byte Ranges
+        // only the first range of a set is served
+        if (!value.startsWith(QLatin1String("bytes=")))
+            return false;
+
+        QStringRef spec = value.midRef(6);
+        const int commaPos = spec.indexOf(QLatin1Char(','));
+        if (commaPos >= 0)
+            spec = spec.left(commaPos);
+
+        const int dashPos = spec.indexOf(QLatin1Char('-'));
+        if (dashPos < 0)
+            return false;
+
+        const QStringRef first = spec.left(dashPos).trimmed();
+        const QStringRef last = spec.mid(dashPos + 1).trimmed();
+        bool ok = false;
+
+        if (first.isEmpty()) {
+            // suffix range, i.e. the last N bytes
+            const qint64 length = last.toLongLong(&ok);
+            if (!ok || (length <= 0) || (size <= 0))
+                return false;
+
+            from = std::max<qint64>(0, (size - length));
+            to = size - 1;
+            return true;
+        }
+
+        from = first.toLongLong(&ok);
+        if (!ok || (from < 0) || (from >= size))
+            return false;
+
+        if (last.isEmpty()) {
+            to = size - 1;
+            return true;
+        }
+
+        to = last.toLongLong(&ok);
+        if (!ok || (to < from))
+            return false;
+
+        to = std::min(to, (size - 1));
+        return true;
+    }
+
+    // Records how long an API call took, whether it succeeded or not
+    class WebAPIRequestTimer
+    {
+    public:
+        explicit WebAPIRequestTimer(MetricsExporter &metricsExporter)
+            : m_metricsExporter(metricsExporter)
+        {
+            m_timer.start();
+        }
+
+        ~WebAPIRequestTimer()
+        {
+            m_metricsExporter.addWebAPIRequest(m_timer.nsecsElapsed() / 1000);
+        }
+
+    private:
+        MetricsExporter &m_metricsExporter;
+        QElapsedTimer m_timer;
+    };
 }
 
 WebApplication::WebApplication(QObject *parent)
@@ -123,12 +206,22 @@ WebApplication::WebApplication(QObject *parent)
     registerAPIController(QLatin1String("log"), new LogController(this, this));
     registerAPIController(QLatin1String("rss"), new RSSController(this, this));
     registerAPIController(QLatin1String("search"), new SearchController(this, this));
-    registerAPIController(QLatin1String("sync"), new SyncController(this, this));
+    m_syncController = new SyncController(this, this);
+    registerAPIController(QLatin1String("sync"), m_syncController);
     registerAPIController(QLatin1String("torrents"), new TorrentsController(this, this));
+    registerAPIController(QLatin1String("trace"), new TraceController(this, this));
     registerAPIController(QLatin1String("transfer"), new TransferController(this, this));
 
     declarePublicAPI(QLatin1String("auth/login"));
 
+    // Files of an alternative UI may be edited while we serve them
+    connect(&m_cachedFilesWatcher, &QFileSystemWatcher::fileChanged, this, &WebApplication::removeCachedFile);
+
+    // Long-lived connections (i.e. event streams) don't wait for a request to notice it
+    m_sessionExpiryTimer.setInterval(60 * 1000);
+    connect(&m_sessionExpiryTimer, &QTimer::timeout, this, &WebApplication::removeExpiredSessions);
+    m_sessionExpiryTimer.start();
+
     configure();
     connect(Preferences::instance(), &Preferences::changed, this, &WebApplication::configure);
 }
@@ -362,6 +455,14 @@ void WebApplication::doProcessRequest()
             return;
         }
 
+        if (request().path == QLatin1String("/metrics")) {
+            if (!session())
+                throw ForbiddenHTTPError();
+
+            print(m_metricsExporter.render(), Http::CONTENT_TYPE_OPENMETRICS);
+            return;
+        }
+
         if (request().path == QLatin1String("/version/qbittorrent")) {
             print(QString(QBT_VERSION), Http::CONTENT_TYPE_TXT);
             return;
@@ -373,11 +474,32 @@ void WebApplication::doProcessRequest()
         if (!session() && !isPublicAPI(scope, action))
             throw ForbiddenHTTPError();
 
+        if ((scope == QLatin1String("torrents")) && (action == QLatin1String("stream"))) {
+            streamTorrentFile();
+            return;
+        }
+
+        if ((scope == QLatin1String("sync")) && (action == QLatin1String("events"))) {
+            if (m_eventStreams.size() >= MAX_EVENT_STREAMS)
+                throw ServiceUnavailableHTTPError(tr("Too many event streams are open"));
+
+            // the stream itself is handed over in openEventStream() once the response head is sent
+            const QString lastEventId {request().headers.value(QLatin1String("last-event-id"))};
+            m_eventStreamResponseId = (!lastEventId.isEmpty() ? lastEventId : m_params["rid"]).toInt();
+            m_isEventStreamPending = true;
+            m_eventStreamSessionId = session()->id();
+            header(Http::HEADER_CACHE_CONTROL, QLatin1String("no-store"));
+            print(QByteArray(), Http::CONTENT_TYPE_EVENT_STREAM);
+            return;
+        }
+
         DataMap data;
         for (const Http::UploadedFile &torrent : request().files)
             data[torrent.filename] = torrent.data;
 
+        const WebAPIRequestTimer requestTimer {m_metricsExporter};
         try {
+            QBT_TRACE_SCOPE("webapi", QString(scope + QLatin1Char('/') + action));
             const QVariant result = controller->run(action, m_params, data);
             switch (result.userType()) {
             case QMetaType::QString:
@@ -421,7 +543,7 @@ void WebApplication::configure()
     if ((isAltUIUsed != m_isAltUIUsed) || (rootFolder != m_rootFolder)) {
         m_isAltUIUsed = isAltUIUsed;
         m_rootFolder = rootFolder;
-        m_translatedFiles.clear();
+        clearCachedFiles();
         if (!m_isAltUIUsed)
             LogMsg(tr("Using built-in Web UI."));
         else
@@ -431,7 +553,7 @@ void WebApplication::configure()
     const QString newLocale = pref->getLocale();
     if (m_currentLocale != newLocale) {
         m_currentLocale = newLocale;
-        m_translatedFiles.clear();
+        clearCachedFiles();
 
         m_translationFileLoaded = m_translator.load(m_rootFolder + QLatin1String("/translations/webui_") + newLocale);
         if (m_translationFileLoaded) {
@@ -478,46 +600,165 @@ void WebApplication::declarePublicAPI(const QString &apiPath)
 
 void WebApplication::sendFile(const QString &path)
 {
-    const QDateTime lastModified {QFileInfo(path).lastModified()};
+    auto it = m_cachedFiles.find(path);
+    if (it == m_cachedFiles.end()) {
+        QFile file {path};
+        if (!file.open(QIODevice::ReadOnly)) {
+            qDebug("File %s was not found!", qUtf8Printable(path));
+            throw NotFoundHTTPError();
+        }
 
-    // find translated file in cache
-    auto it = m_translatedFiles.constFind(path);
-    if ((it != m_translatedFiles.constEnd()) && (lastModified <= (*it).lastModified)) {
-        const QString mimeName {QMimeDatabase().mimeTypeForFileNameAndData(path, (*it).data).name()};
-        print((*it).data, mimeName);
-        header(Http::HEADER_CACHE_CONTROL, getCachingInterval(mimeName));
-        return;
+        if (file.size() > MAX_ALLOWED_FILESIZE) {
+            qWarning("%s: exceeded the maximum allowed file size!", qUtf8Printable(path));
+            throw InternalServerErrorHTTPError(tr("Exceeded the maximum allowed file size (%1)!")
+                                               .arg(Utils::Misc::friendlyUnit(MAX_ALLOWED_FILESIZE)));
+        }
+
+        CachedFile cachedFile;
+        cachedFile.data = file.readAll();
+        file.close();
+
+        const QMimeType mimeType {QMimeDatabase().mimeTypeForFileNameAndData(path, cachedFile.data)};
+        cachedFile.mimeType = mimeType.name();
+
+        // Translate the file
+        if (mimeType.inherits(QLatin1String("text/plain"))) {
+            QString dataStr {cachedFile.data};
+            translateDocument(dataStr);
+            cachedFile.data = dataStr.toUtf8();
+        }
+
+        // Compress ahead of time with the best ratio, so that it is paid once per file instead of per request
+        if (!cachedFile.mimeType.startsWith(QLatin1String("image/")) && (cachedFile.data.size() > 1024)) {
+            bool ok = false;
+            const QByteArray compressedData = Utils::Gzip::compress(cachedFile.data, 9, &ok);
+            if (ok && (compressedData.size() < cachedFile.data.size()))
+                cachedFile.gzipData = compressedData;
+        }
+
+        // Strong validators: the translated content already depends on locale and version,
+        // the gzip body is another representation so it gets its own tag
+        const QString hash = QString::fromLatin1(QCryptographicHash::hash(cachedFile.data, QCryptographicHash::Sha1).toHex());
+        cachedFile.etag = QLatin1Char('"') + hash + QLatin1Char('"');
+        cachedFile.gzipETag = QLatin1Char('"') + hash + QLatin1String("-gz\"");
+
+        // Make room for it by dropping the least recently used ones, any file is cheap to load again
+        const qint64 cachedFileSize = cachedFile.data.size() + cachedFile.gzipData.size();
+        while (!m_cachedFiles.isEmpty() && ((m_cachedFiles.size() >= MAX_CACHED_FILES)
+            || ((m_cachedFilesSize + cachedFileSize) > MAX_CACHED_FILES_SIZE))) {
+            auto evictedIt = m_cachedFiles.constBegin();
+            for (auto candidateIt = m_cachedFiles.constBegin(); candidateIt != m_cachedFiles.constEnd(); ++candidateIt) {
+                if (candidateIt->lastUse < evictedIt->lastUse)
+                    evictedIt = candidateIt;
+            }
+            removeCachedFile(evictedIt.key());
+        }
+
+        // Files of the built-in UI come from resources and never change at runtime
+        if (m_isAltUIUsed && !path.startsWith(QLatin1Char(':')))
+            m_cachedFilesWatcher.addPath(path);
+
+        it = m_cachedFiles.insert(path, cachedFile);
+        m_cachedFilesSize += cachedFileSize;
     }
 
-    QFile file {path};
-    if (!file.open(QIODevice::ReadOnly)) {
-        qDebug("File %s was not found!", qUtf8Printable(path));
-        throw NotFoundHTTPError();
+    it->lastUse = ++m_cachedFilesUseCount;
+    const CachedFile &cachedFile = *it;
+    const bool sendsGzip = (!cachedFile.gzipData.isEmpty()
+        && Http::acceptsGzipEncoding(request().headers.value(Http::HEADER_ACCEPT_ENCODING)));
+    const QString &etag = (sendsGzip ? cachedFile.gzipETag : cachedFile.etag);
+
+    // A versioned URL (e.g. "style.css?v=4.1.5") changes together with its content
+    const bool isVersioned = (request().query.value(QLatin1String("v")) == QBT_VERSION);
+    header(Http::HEADER_CACHE_CONTROL, (isVersioned
+        ? QLatin1String("public, max-age=31536000, immutable")
+        : getCachingInterval(cachedFile.mimeType)));
+    header(Http::HEADER_ETAG, etag);
+    header(Http::HEADER_VARY, QLatin1String("Accept-Encoding"));
+
+    const QStringList clientETags = request().headers.value(Http::HEADER_IF_NONE_MATCH).split(',', QString::SkipEmptyParts);
+    for (const QString &clientETag : clientETags) {
+        const QString tag = clientETag.trimmed();
+        if ((tag == etag) || (tag == QLatin1String("*"))) {
+            status(304, QLatin1String("Not Modified"));
+            return;
+        }
     }
 
-    if (file.size() > MAX_ALLOWED_FILESIZE) {
-        qWarning("%s: exceeded the maximum allowed file size!", qUtf8Printable(path));
-        throw InternalServerErrorHTTPError(tr("Exceeded the maximum allowed file size (%1)!")
-                                           .arg(Utils::Misc::friendlyUnit(MAX_ALLOWED_FILESIZE)));
+    if (sendsGzip) {
+        print(cachedFile.gzipData, cachedFile.mimeType);
+        header(Http::HEADER_CONTENT_ENCODING, QLatin1String("gzip"));
+        return;
     }
 
-    QByteArray data {file.readAll()};
-    file.close();
+    print(cachedFile.data, cachedFile.mimeType);
+}
+
+void WebApplication::removeCachedFile(const QString &path)
+{
+    const auto it = m_cachedFiles.find(path);
+    if (it == m_cachedFiles.end()) return;
+
+    m_cachedFilesSize -= (it->data.size() + it->gzipData.size());
+    m_cachedFiles.erase(it);
+    m_cachedFilesWatcher.removePath(path);
+}
 
-    const QMimeType mimeType {QMimeDatabase().mimeTypeForFileNameAndData(path, data)};
-    const bool isTranslatable {mimeType.inherits(QLatin1String("text/plain"))};
+void WebApplication::clearCachedFiles()
+{
+    m_cachedFiles.clear();
+    m_cachedFilesSize = 0;
 
-    // Translate the file
-    if (isTranslatable) {
-        QString dataStr {data};
-        translateDocument(dataStr);
-        data = dataStr.toUtf8();
+    const QStringList watchedFiles = m_cachedFilesWatcher.files();
+    if (!watchedFiles.isEmpty())
+        m_cachedFilesWatcher.removePaths(watchedFiles);
+}
 
-        m_translatedFiles[path] = {data, lastModified}; // caching translated file
+void WebApplication::streamTorrentFile()
+{
+    const QString hash {m_params[QLatin1String("hash")]};
+    bool ok = false;
+    const int fileIndex = m_params[QLatin1String("id")].toInt(&ok);
+    if (hash.isEmpty() || !ok)
+        throw BadRequestHTTPError();
+
+    BitTorrent::TorrentHandle *const torrent = BitTorrent::Session::instance()->findTorrent(hash);
+    if (!torrent)
+        throw NotFoundHTTPError();
+    if (!torrent->hasMetadata())
+        throw ConflictHTTPError(tr("Torrent's metadata has not yet downloaded"));
+    if ((fileIndex < 0) || (fileIndex >= torrent->filesCount()))
+        throw ConflictHTTPError(tr("File ID is not valid"));
+
+    const qint64 fileSize = torrent->fileSize(fileIndex);
+    qint64 from = 0;
+    qint64 to = fileSize - 1;
+
+    const QString range {request().headers.value(QLatin1String(Http::HEADER_RANGE))};
+    if (!range.isEmpty()) {
+        if (!parseByteRange(range, fileSize, from, to)) {
+            header(QLatin1String(Http::HEADER_CONTENT_RANGE), QString::fromLatin1("bytes */%1").arg(fileSize));
+            throw RangeNotSatisfiableHTTPError();
+        }
+
+        status(206, QLatin1String("Partial Content"));
+        header(QLatin1String(Http::HEADER_CONTENT_RANGE), QString::fromLatin1("bytes %1-%2/%3").arg(from).arg(to).arg(fileSize));
     }
 
-    print(data, mimeType.name());
-    header(Http::HEADER_CACHE_CONTROL, getCachingInterval(mimeType.name()));
+    QString fileName = torrent->fileName(fileIndex);
+    if (fileName.endsWith(QB_EXT))
+        fileName.chop(QB_EXT.size());
+    const QMimeType mimeType {QMimeDatabase().mimeTypeForFile(fileName, QMimeDatabase::MatchExtension)};
+    header(QLatin1String(Http::HEADER_ACCEPT_RANGES), QLatin1String("bytes"));
+    header(QLatin1String(Http::HEADER_CACHE_CONTROL), QLatin1String("no-store"));
+    TorrentFileStream *const fileStream = new TorrentFileStream(torrent, fileIndex, from, to);
+    const QString sid = session()->id();
+    m_contentStreams.insert(sid, fileStream);
+    connect(fileStream, &QObject::destroyed, this, [this, sid, fileStream]()
+    {
+        m_contentStreams.remove(sid, fileStream);
+    });
+    stream(fileStream, (mimeType.isDefault() ? QLatin1String(Http::CONTENT_TYPE_OCTET_STREAM) : mimeType.name()));
 }
 
 Http::Response WebApplication::processRequest(const Http::Request &request, const Http::Environment &env)
@@ -526,6 +767,7 @@ Http::Response WebApplication::processRequest(const Http::Request &request, cons
     m_request = request;
     m_env = env;
     m_params.clear();
+    m_isEventStreamPending = false;
 
     if (m_request.method == Http::METHOD_GET) {
         for (auto iter = m_request.query.cbegin(); iter != m_request.query.cend(); ++iter)
@@ -569,6 +811,21 @@ Http::Response WebApplication::processRequest(const Http::Request &request, cons
     return response();
 }
 
+void WebApplication::openEventStream(Http::EventStream *stream)
+{
+    if (!m_isEventStreamPending)
+        return;
+
+    m_isEventStreamPending = false;
+    const QString sid = m_eventStreamSessionId;
+    m_eventStreams.insert(sid, stream);
+    connect(stream, &QObject::destroyed, this, [this, sid, stream]()
+    {
+        m_eventStreams.remove(sid, stream);
+    });
+    m_syncController->addEventStream(stream, m_eventStreamResponseId);
+}
+
 QString WebApplication::clientId() const
 {
     return env().clientAddress.toString();
@@ -588,7 +845,7 @@ void WebApplication::sessionInitialize()
             const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
             if ((now - m_currentSession->m_timestamp) > INACTIVE_TIME) {
                 // session is outdated - removing it
-                delete m_sessions.take(sessionId);
+                removeSession(sessionId);
                 m_currentSession = nullptr;
             }
             else {
@@ -640,13 +897,7 @@ void WebApplication::sessionStart()
 {
     Q_ASSERT(!m_currentSession);
 
-    // remove outdated sessions
-    const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
-    const QMap<QString, WebSession *> sessionsCopy {m_sessions};
-    for (const auto session : sessionsCopy) {
-        if ((now - session->timestamp()) > INACTIVE_TIME)
-            delete m_sessions.take(session->id());
-    }
+    removeExpiredSessions();
 
     m_currentSession = new WebSession(generateSid());
     m_sessions[m_currentSession->id()] = m_currentSession;
@@ -668,12 +919,37 @@ void WebApplication::sessionEnd()
     cookie.setPath(QLatin1String("/"));
     cookie.setExpirationDate(QDateTime::currentDateTime().addDays(-1));
 
-    delete m_sessions.take(m_currentSession->id());
+    removeSession(m_currentSession->id());
     m_currentSession = nullptr;
 
     header(Http::HEADER_SET_COOKIE, cookie.toRawForm());
 }
 
+void WebApplication::removeSession(const QString &sid)
+{
+    if (m_currentSession && (m_currentSession->id() == sid))
+        m_currentSession = nullptr;
+    delete m_sessions.take(sid);
+
+    // what they send is only for the clients of this session
+    const QList<Http::EventStream *> eventStreams = m_eventStreams.values(sid);
+    for (Http::EventStream *stream : eventStreams)
+        stream->close();
+    const QList<Http::ContentSource *> contentStreams = m_contentStreams.values(sid);
+    for (Http::ContentSource *stream : contentStreams)
+        stream->abort();
+}
+
+void WebApplication::removeExpiredSessions()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+    const QMap<QString, WebSession *> sessionsCopy {m_sessions};
+    for (const auto session : sessionsCopy) {
+        if ((now - session->timestamp()) > INACTIVE_TIME)
+            removeSession(session->id());
+    }
+}
+
 bool WebApplication::isCrossSiteRequest(const Http::Request &request) const
 {
     // https://www.owasp.org/index.php/Cross-Site_Request_Forgery_(CSRF)_Prevention_Cheat_Sheet#Verifying_Same_Origin_with_Standard_Headers
@@ -29,11 +29,14 @@
 #pragma once
 
 #include <QDateTime>
+#include <QFileSystemWatcher>
 #include <QHash>
 #include <QMap>
+#include <QMultiHash>
 #include <QObject>
 #include <QRegularExpression>
 #include <QSet>
+#include <QTimer>
 #include <QTranslator>
 
 #include "api/isessionmanager.h"
@@ -42,12 +45,14 @@
 #include "base/http/types.h"
 #include "base/utils/net.h"
 #include "base/utils/version.h"
+#include "metricsexporter.h"
 
-constexpr Utils::Version<int, 3, 2> API_VERSION {2, 2, 1};
+constexpr Utils::Version<int, 3, 2> API_VERSION {2, 13, 0};
 constexpr int COMPAT_API_VERSION = 24;
 constexpr int COMPAT_API_VERSION_MIN = 23;
 
 class APIController;
+class SyncController;
 class WebApplication;
 
 constexpr char C_SID[] = "SID"; // name of session id cookie
@@ -91,6 +96,7 @@ public:
     ~WebApplication() override;
 
     Http::Response processRequest(const Http::Request &request, const Http::Environment &env) override;
+    void openEventStream(Http::EventStream *stream) override;
 
     QString clientId() const override;
     WebSession *session() override;
@@ -109,6 +115,9 @@ private:
 
     void sendFile(const QString &path);
     void sendWebUIFile();
+    void streamTorrentFile();
+    void removeCachedFile(const QString &path);
+    void clearCachedFiles();
 
     void translateDocument(QString &data);
 
@@ -117,33 +126,52 @@ private:
     void sessionInitialize();
     bool isAuthNeeded();
     bool isPublicAPI(const QString &scope, const QString &action) const;
+    void removeSession(const QString &sid);
+    void removeExpiredSessions();
 
     bool isCrossSiteRequest(const Http::Request &request) const;
     bool validateHostHeader(const QStringList &domains) const;
 
     // Persistent data
     QMap<QString, WebSession *> m_sessions;
+    QTimer m_sessionExpiryTimer;
 
     // Current data
     WebSession *m_currentSession = nullptr;
     Http::Request m_request;
     Http::Environment m_env;
     QMap<QString, QString> m_params;
+    bool m_isEventStreamPending = false;
+    int m_eventStreamResponseId = 0;
+    QString m_eventStreamSessionId;
+    // Open event streams and file streams by session id, they end with their session
+    QMultiHash<QString, Http::EventStream *> m_eventStreams;
+    QMultiHash<QString, Http::ContentSource *> m_contentStreams;
 
     const QRegularExpression m_apiPathPattern {(QLatin1String("^/api/v2/(?<scope>[A-Za-z_][A-Za-z_0-9]*)/(?<action>[A-Za-z_][A-Za-z_0-9]*)$"))};
     const QRegularExpression m_apiLegacyPathPattern {QLatin1String("^/(?<action>((sync|command|query)/[A-Za-z_][A-Za-z_0-9]*|login|logout))(/(?<hash>[^/]+))?$")};
 
     QHash<QString, APIController *> m_apiControllers;
+    SyncController *m_syncController = nullptr;
+    MetricsExporter m_metricsExporter;
     QSet<QString> m_publicAPIs;
     bool m_isAltUIUsed = false;
     QString m_rootFolder;
 
-    struct TranslatedFile
+    // Static files are kept ready to send: translated, gzipped and hashed once
+    struct CachedFile
     {
         QByteArray data;
-        QDateTime lastModified;
+        QByteArray gzipData; // empty if compression isn't worth it
+        QString mimeType;
+        QString etag;
+        QString gzipETag;
+        quint64 lastUse = 0;
     };
-    QMap<QString, TranslatedFile> m_translatedFiles;
+    QHash<QString, CachedFile> m_cachedFiles;
+    qint64 m_cachedFilesSize = 0;
+    quint64 m_cachedFilesUseCount = 0;
+    QFileSystemWatcher m_cachedFilesWatcher;
     QString m_currentLocale;
     QTranslator m_translator;
     bool m_translationFileLoaded = false;
@@ -10,8 +10,11 @@ HEADERS += \
     $$PWD/api/searchcontroller.h \
     $$PWD/api/synccontroller.h \
     $$PWD/api/torrentscontroller.h \
+    $$PWD/api/tracecontroller.h \
     $$PWD/api/transfercontroller.h \
     $$PWD/api/serialize/serialize_torrent.h \
+    $$PWD/metricsexporter.h \
+    $$PWD/torrentfilestream.h \
     $$PWD/webapplication.h \
     $$PWD/webui.h
 
@@ -26,8 +29,11 @@ SOURCES += \
     $$PWD/api/searchcontroller.cpp \
     $$PWD/api/synccontroller.cpp \
     $$PWD/api/torrentscontroller.cpp \
+    $$PWD/api/tracecontroller.cpp \
     $$PWD/api/transfercontroller.cpp \
     $$PWD/api/serialize/serialize_torrent.cpp \
+    $$PWD/metricsexporter.cpp \
+    $$PWD/torrentfilestream.cpp \
     $$PWD/webapplication.cpp \
     $$PWD/webui.cpp
 